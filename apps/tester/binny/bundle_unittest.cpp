@@ -2,8 +2,11 @@
 #include "core/core.h"
 #include "binny/bundle.h"
 #include "binny/bundlewriter.h"
+#include "binny/inplacebundle.h"
 #include <vector>
 #include <string_view>
+#include <sstream>
+#include <cstring>
 
 TEST_CASE( "Bundle chunks write/read", "[Binny]" )
 {
@@ -82,3 +85,52 @@ TEST_CASE( "Bundle chunks write/read", "[Binny]" )
 	auto result = testRead.read(""sv, handlers);
 	REQUIRE(result.first != Bundle::ErrorCode::Okay);
 }
+
+TEST_CASE( "Bundle pointers to the end of a chunk are fixed up", "[Binny]" )
+{
+	using namespace Binny;
+	using namespace std::string_view_literals;
+	BundleWriter writer;
+	writer.setStoreUncompressed();
+	writer.addChunk( "end_chunk", "ENDP"_bundle_id, 0, 0,
+					 0, {},
+					 []( WriteHelper& o )
+					 {
+						 o.use_label( "payloadEnd", "", true );
+						 o.write_as<uint64_t>( 42 );
+						 o.write_label( "payloadEnd", false );
+					 } );
+
+	std::vector<uint8_t> out;
+	REQUIRE( writer.build( 0, out ));
+
+	int loads = 0;
+	std::vector<Bundle::ChunkHandler> handlers = {
+		{{	"ENDP"_bundle_id, 0, 0,
+				 [&loads](std::string_view, int, uint16_t, uint16_t, size_t, std::shared_ptr<void> ptr_) -> bool
+			{
+				// an empty range ends where the data does
+				uint8_t const* const* end = (uint8_t const* const*) ptr_.get();
+				REQUIRE( end[0] == (uint8_t const*) ptr_.get() + 2 * sizeof(uint64_t) );
+				REQUIRE( ((uint64_t const*) ptr_.get())[1] == 42 );
+				loads++;
+				return true;
+			},
+			[](int, void*) -> void
+			{
+			}
+	 	}}
+	};
+
+	std::string outStr( out.begin(), out.end());
+	std::istringstream in( outStr );
+	Bundle streamRead( &malloc, &free, &malloc, &free, in );
+	REQUIRE( streamRead.read( ""sv, handlers ).first == Bundle::ErrorCode::Okay );
+
+	std::shared_ptr<void> memory( malloc( out.size()), &free );
+	std::memcpy( memory.get(), out.data(), out.size());
+	InPlaceBundle inPlaceRead( &malloc, &free, memory, (uint8_t*) memory.get(), out.size());
+	REQUIRE( inPlaceRead.read( ""sv, handlers ).first == Bundle::ErrorCode::Okay );
+	REQUIRE( inPlaceRead.getInPlaceChunkCount() == 1 );
+	REQUIRE( loads == 2 );
+}
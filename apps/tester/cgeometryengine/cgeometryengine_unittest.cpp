@@ -0,0 +1,158 @@
+#include "tester/catch.hpp"
+
+#include "core/core.h"
+#include "core/sharedtasks.h"
+#include "meshops/platonicsolids.h"
+#include "meshops/convexhullcomputer.h"
+#include "cgeometryengine.h"
+#include <vector>
+
+namespace {
+
+// a grid of quads split into triangles with bumpy heights, big enough for the writes to use the task threads
+void CreateGrid(uint32_t const width_, std::vector<float>& positions_, std::vector<uint32_t>& indices_)
+{
+	positions_.clear();
+	indices_.clear();
+	for(auto z = 0u; z < width_; ++z)
+	{
+		for(auto x = 0u; x < width_; ++x)
+		{
+			positions_.insert(positions_.end(), { float(x), float((x * z) % 7) - 3.0f, float(z) });
+		}
+	}
+	for(auto z = 0u; z + 1 < width_; ++z)
+	{
+		for(auto x = 0u; x + 1 < width_; ++x)
+		{
+			uint32_t const i = z * width_ + x;
+			indices_.insert(indices_.end(), { i, i + width_, i + 1, i + 1, i + width_, i + width_ + 1 });
+		}
+	}
+}
+
+}
+
+TEST_CASE("Mesh views and simple mesh writes round trip", "[CGeometryEngine/SimpleMesh]")
+{
+	Core::InitSharedTasks();
+	auto* cge = CGeometryEngine();
+
+	uint32_t const width = 256;
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	CreateGrid(width, positions, indices);
+	SimpleMesh simpleMesh{ uint32_t(positions.size() / 3), positions.data(), uint32_t(indices.size() / 3), indices.data() };
+
+	MeshViewHandle const view = cge->CGE_CreateMeshView(&simpleMesh);
+	REQUIRE(view != MeshInvalidHandle);
+	float bounds[6];
+	REQUIRE(cge->CGE_MeshViewAABB(view, bounds));
+	REQUIRE(bounds[0] == 0.0f);
+	REQUIRE(bounds[1] == -3.0f);
+	REQUIRE(bounds[2] == 0.0f);
+	REQUIRE(bounds[3] == float(width - 1));
+	REQUIRE(bounds[4] == 3.0f);
+	REQUIRE(bounds[5] == float(width - 1));
+
+	// a mesh made from the view or the arrays writes back exactly what it was made from
+	MeshHandle const meshes[] = {
+			TakeOwnershipOfMesh(MeshFromView(view)),
+			cge->CGE_CreateMeshFromSimpleMesh(0, nullptr, &simpleMesh),
+	};
+	cge->CGE_DeleteMeshView(view);
+	for(MeshHandle const mesh : meshes)
+	{
+		REQUIRE(mesh != MeshInvalidHandle);
+		uint32_t positionCount = 0, triangleCount = 0;
+		REQUIRE(cge->CGE_GetSimpleMeshSize(mesh, &positionCount, &triangleCount));
+		REQUIRE(positionCount == simpleMesh.positionCount);
+		REQUIRE(triangleCount == simpleMesh.triangleCount);
+
+		// bigger than needed, the counts come back as what was written
+		std::vector<float> outPositions((positionCount + 1) * 3, -1.0f);
+		std::vector<uint32_t> outIndices((triangleCount + 1) * 3, ~0u);
+		SimpleMesh out{ positionCount + 1, outPositions.data(), triangleCount + 1, outIndices.data() };
+		REQUIRE(cge->CGE_WriteSimpleMesh(mesh, &out));
+		REQUIRE(out.positionCount == positionCount);
+		REQUIRE(out.triangleCount == triangleCount);
+		REQUIRE(std::equal(positions.begin(), positions.end(), outPositions.begin()));
+		REQUIRE(std::equal(indices.begin(), indices.end(), outIndices.begin()));
+		REQUIRE(outPositions.back() == -1.0f);
+		REQUIRE(outIndices.back() == ~0u);
+
+		// and a view of the output sees the same mesh
+		MeshViewHandle const outView = cge->CGE_CreateMeshView(&out);
+		REQUIRE(outView != MeshInvalidHandle);
+		float outBounds[6];
+		REQUIRE(cge->CGE_MeshViewAABB(outView, outBounds));
+		REQUIRE(std::equal(bounds, bounds + 6, outBounds));
+		cge->CGE_DeleteMeshView(outView);
+
+		// too little room is refused
+		SimpleMesh tooSmall{ positionCount, outPositions.data(), triangleCount - 1, outIndices.data() };
+		REQUIRE(!cge->CGE_WriteSimpleMesh(mesh, &tooSmall));
+		cge->CGE_DeleteMesh(mesh);
+	}
+
+	// quads are fanned into two triangles each
+	MeshHandle const cube = TakeOwnershipOfMesh(MeshOps::PlatonicSolids::CreateCube());
+	uint32_t cubePositions = 0, cubeTriangles = 0;
+	REQUIRE(cge->CGE_GetSimpleMeshSize(cube, &cubePositions, &cubeTriangles));
+	REQUIRE(cubeTriangles == 12);
+	std::vector<float> cubeOutPositions(cubePositions * 3);
+	std::vector<uint32_t> cubeOutIndices(cubeTriangles * 3);
+	SimpleMesh cubeOut{ cubePositions, cubeOutPositions.data(), cubeTriangles, cubeOutIndices.data() };
+	REQUIRE(cge->CGE_WriteSimpleMesh(cube, &cubeOut));
+	for(uint32_t const index : cubeOutIndices)
+	{
+		REQUIRE(index < cubePositions);
+	}
+	cge->CGE_DeleteMesh(cube);
+
+	// indices past the positions don't make a view
+	indices[5] = simpleMesh.positionCount;
+	REQUIRE(cge->CGE_CreateMeshView(&simpleMesh) == MeshInvalidHandle);
+}
+
+TEST_CASE("Async convex hulls from meshes and views agree", "[CGeometryEngine/ConvexHulls]")
+{
+	auto* cge = CGeometryEngine();
+
+	// a closed cube, already convex so vhacd gives back one hull of its corners
+	std::vector<float> positions = {
+			0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0,
+			0, 0, 1, 1, 0, 1, 1, 1, 1, 0, 1, 1,
+	};
+	std::vector<uint32_t> indices = {
+			0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7,
+			0, 1, 5, 0, 5, 4, 3, 6, 2, 3, 7, 6,
+			0, 4, 7, 0, 7, 3, 1, 2, 6, 1, 6, 5,
+	};
+	SimpleMesh simpleMesh{ 8, positions.data(), 12, indices.data() };
+	MeshHandle const mesh = cge->CGE_CreateMeshFromSimpleMesh(0, nullptr, &simpleMesh);
+	REQUIRE(mesh != MeshInvalidHandle);
+	MeshViewHandle const view = cge->CGE_CreateMeshView(&simpleMesh);
+	REQUIRE(view != MeshInvalidHandle);
+
+	MeshOps::ConvexHullParameters params;
+	params.resolution = 10000;
+	ConvexHullGeneratorHandle const fromMesh = cge->CGE_CreateConvexHullsAsync(mesh, &params);
+	ConvexHullGeneratorHandle const fromView = cge->CGE_CreateConvexHullsAsyncFromView(view, &params);
+	// both have their own copy of the arrays by now
+	cge->CGE_DeleteMeshView(view);
+	cge->CGE_DeleteMesh(mesh);
+
+	for(ConvexHullGeneratorHandle const generator : { fromMesh, fromView })
+	{
+		MeshHandle hulls[16];
+		REQUIRE(cge->CGE_ConvexHullAsyncGetResults(generator, hulls) == 1);
+		REQUIRE(cge->CGE_ConvexHullAsyncIsReady(generator));
+		uint32_t positionCount = 0, triangleCount = 0;
+		REQUIRE(cge->CGE_GetSimpleMeshSize(hulls[0], &positionCount, &triangleCount));
+		REQUIRE(positionCount == 8);
+		REQUIRE(triangleCount == 12);
+		cge->CGE_DeleteMesh(hulls[0]);
+		cge->CGE_DestroyConvexHullsAsync(generator);
+	}
+}
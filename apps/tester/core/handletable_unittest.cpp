@@ -0,0 +1,110 @@
+#include "../catch.hpp"
+
+#include "core/core.h"
+#include "core/handletable.h"
+#include <thread>
+#include <vector>
+
+TEST_CASE("HandleTable<int>", "[core/handletable]")
+{
+	using namespace Core;
+	using Table = HandleTable<int, 4, 4>;
+	Table table;
+	REQUIRE(table.empty());
+	REQUIRE(!table.get(0));
+	REQUIRE(!table.get(Table::InvalidHandle));
+
+	auto h0 = table.add(std::make_shared<int>(10));
+	auto h1 = table.add(std::make_shared<int>(20));
+	REQUIRE(h0 != 0);
+	REQUIRE(h0 != h1);
+	REQUIRE(table.size() == 2);
+	REQUIRE(*table.get(h0) == 10);
+	REQUIRE(*table.get(h1) == 20);
+
+	// erased handles go stale even after their slot is reused
+	REQUIRE(table.erase(h0));
+	REQUIRE(!table.erase(h0));
+	REQUIRE(!table.get(h0));
+	auto h2 = table.add(std::make_shared<int>(30));
+	REQUIRE((h2 & 0xFFFFFFFF) == (h0 & 0xFFFFFFFF));
+	REQUIRE(h2 != h0);
+	REQUIRE(!table.get(h0));
+	REQUIRE(*table.get(h2) == 30);
+
+	REQUIRE(table.replace(h2, std::make_shared<int>(40)));
+	REQUIRE(*table.get(h2) == 40);
+	REQUIRE(!table.replace(h0, std::make_shared<int>(50)));
+
+	// grows past the first page
+	std::vector<Table::Handle> handles;
+	for(int i = 0; i < 10; ++i)
+	{
+		handles.push_back(table.add(std::make_shared<int>(i)));
+	}
+	for(int i = 0; i < 10; ++i)
+	{
+		REQUIRE(*table.get(handles[i]) == i);
+	}
+	REQUIRE(table.size() == 12);
+
+	table.clear();
+	REQUIRE(table.empty());
+	REQUIRE(!table.get(h1));
+	REQUIRE(!table.get(h2));
+	REQUIRE(!table.get(handles[9]));
+	auto h3 = table.add(std::make_shared<int>(60));
+	REQUIRE((h3 & 0xFFFFFFFF) == 0);
+	REQUIRE(*table.get(h3) == 60);
+
+	// all 16 slots are full then it refuses
+	for(int i = 0; i < 15; ++i)
+	{
+		REQUIRE(table.add(std::make_shared<int>(i)) != Table::InvalidHandle);
+	}
+}
+
+TEST_CASE("HandleTable<int> MT", "[core/handletable]")
+{
+	using namespace Core;
+	constexpr int ThreadCount = 16;
+	constexpr int Iterations = 2000;
+	HandleTable<int, 64> table;
+	std::vector<std::thread> threads;
+	std::vector<int> failures(ThreadCount, 0);
+
+	// each thread churns its own handles while the others reuse the same slots
+	for(int t = 0; t < ThreadCount; ++t)
+	{
+		threads.emplace_back([&table, &failures, t]()
+		{
+			std::vector<HandleTable<int, 64>::Handle> mine;
+			for(int i = 0; i < Iterations; ++i)
+			{
+				int const value = (t * Iterations) + i;
+				auto handle = table.add(std::make_shared<int>(value));
+				auto got = table.get(handle);
+				if(!got || *got != value) failures[t]++;
+				if(i & 1)
+				{
+					if(!table.erase(handle)) failures[t]++;
+					if(table.get(handle)) failures[t]++;
+				} else
+				{
+					mine.push_back(handle);
+				}
+			}
+			for(auto handle : mine)
+			{
+				if(!table.erase(handle)) failures[t]++;
+			}
+		});
+	}
+	for(auto& thread : threads) thread.join();
+
+	for(auto const failure : failures)
+	{
+		REQUIRE(failure == 0);
+	}
+	REQUIRE(table.empty());
+}
@@ -0,0 +1,23 @@
+#include "../catch.hpp"
+
+#include "core/core.h"
+#include "math/vector_math.h"
+
+TEST_CASE( "Octahedral normal round trip", "[math]" )
+{
+	Math::vec3 const tests[] = {
+			{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+			Math::Normalise(Math::vec3(1, 2, 3)), Math::Normalise(Math::vec3(-3, 1, -2)),
+			Math::Normalise(Math::vec3(0.1f, -0.7f, -0.2f))
+	};
+	for(auto const& n : tests)
+	{
+		auto const oct = Math::EncodeOctahedral(n);
+		Math::vec3 const r = Math::DecodeOctahedral(oct[0], oct[1]);
+		REQUIRE( Math::Length(r - n) < 1e-3f );
+	}
+
+	auto const zero = Math::EncodeOctahedral(Math::vec3(0, 0, 0));
+	REQUIRE( zero[0] == 0 );
+	REQUIRE( zero[1] == 0 );
+}
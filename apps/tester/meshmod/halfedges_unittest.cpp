@@ -0,0 +1,122 @@
+#include "tester/catch.hpp"
+
+#include "core/core.h"
+#include "core/sharedtasks.h"
+#include "meshmod/mesh.h"
+#include "meshmod/vertices.h"
+#include "meshmod/polygons.h"
+#include "meshmod/halfedges.h"
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+using namespace MeshMod;
+
+// quads big enough that connectPairs splits across the task threads
+constexpr uint32_t GridSize = 100;
+
+auto CreateGrid() -> std::unique_ptr<Mesh>
+{
+	// no point reps, they repack which resets the pair tracking updatePairs needs
+	auto mesh = std::make_unique<Mesh>("grid", false, true);
+	auto& vertices = mesh->getVertices();
+	auto& polygons = mesh->getPolygons();
+	for(auto y = 0u; y <= GridSize; ++y)
+	{
+		for(auto x = 0u; x <= GridSize; ++x)
+		{
+			vertices.add(float(x), float(y), 0.0f);
+		}
+	}
+	for(auto y = 0u; y < GridSize; ++y)
+	{
+		for(auto x = 0u; x < GridSize; ++x)
+		{
+			VertexIndex const v0 = VertexIndex(y * (GridSize + 1) + x);
+			VertexIndex const v1 = VertexIndex(size_t(v0) + 1);
+			VertexIndex const v2 = VertexIndex(size_t(v0) + GridSize + 2);
+			VertexIndex const v3 = VertexIndex(size_t(v0) + GridSize + 1);
+			polygons.addPolygon({ v0, v1, v2, v3 });
+		}
+	}
+	mesh->updateEditState(Mesh::TopologyEdits);
+	mesh->updateFromEdits();
+	return mesh;
+}
+
+auto GetPairs(Mesh const& mesh_) -> std::vector<HalfEdgeIndex>
+{
+	auto const& halfEdges = mesh_.getHalfEdges();
+	std::vector<HalfEdgeIndex> pairs(halfEdges.getCount(), InvalidHalfEdgeIndex);
+	halfEdges.forEachValid([&pairs, &halfEdges](HalfEdgeIndex i_)
+	{
+		pairs[size_t(i_)] = halfEdges.halfEdge(i_).pair;
+	});
+	return pairs;
+}
+
+// a full rebuild on a thread that can't submit, so it runs serially
+auto SerialPairs(Mesh const& mesh_) -> std::vector<HalfEdgeIndex>
+{
+	std::unique_ptr<Mesh> serial = mesh_.clone();
+	std::lock_guard<std::recursive_mutex> lock(Core::SharedTasksMutex);
+	std::thread([&serial]()
+	{
+		serial->getHalfEdges().breakPairs();
+		serial->getHalfEdges().connectPairs();
+	}).join();
+	return GetPairs(*serial);
+}
+}
+
+TEST_CASE("HalfEdges parallel connectPairs matches serial", "[MeshMod/HalfEdges]")
+{
+	Core::InitSharedTasks();
+
+	auto mesh = CreateGrid();
+	auto& halfEdges = mesh->getHalfEdges();
+	halfEdges.breakPairs();
+	halfEdges.connectPairs();
+	auto const pairs = GetPairs(*mesh);
+	REQUIRE(pairs == SerialPairs(*mesh));
+
+	// interior edges are paired both ways, the border ones aren't
+	size_t paired = 0;
+	for(auto i = 0u; i < pairs.size(); ++i)
+	{
+		if(pairs[i] == InvalidHalfEdgeIndex) continue;
+		REQUIRE(pairs[size_t(pairs[i])] == HalfEdgeIndex(i));
+		++paired;
+	}
+	REQUIRE(paired == pairs.size() - 4 * GridSize);
+}
+
+TEST_CASE("HalfEdges updatePairs matches a serial rebuild", "[MeshMod/HalfEdges]")
+{
+	Core::InitSharedTasks();
+
+	auto mesh = CreateGrid();
+	auto& polygons = mesh->getPolygons();
+
+	// punch a few holes and fill one of them back in, small enough to be incremental
+	VertexIndexContainer refill;
+	for(auto const p : { 0u, 57u, 5050u, 9999u })
+	{
+		if(p == 5050u) polygons.getVertexIndices(PolygonIndex(p), refill);
+		polygons.remove(PolygonIndex(p));
+	}
+	polygons.addPolygon(refill);
+	mesh->updateEditState(Mesh::TopologyEdits);
+	mesh->updateFromEdits();
+	REQUIRE(GetPairs(*mesh) == SerialPairs(*mesh));
+
+	// lots changed so it falls back to a full rebuild
+	for(auto p = 0u; p < GridSize * GridSize; p += 2)
+	{
+		polygons.remove(PolygonIndex(p));
+	}
+	mesh->updateEditState(Mesh::TopologyEdits);
+	mesh->updateFromEdits();
+	REQUIRE(GetPairs(*mesh) == SerialPairs(*mesh));
+}
@@ -0,0 +1,166 @@
+#include "tester/catch.hpp"
+
+#include "core/core.h"
+#include "core/quick_hash.h"
+#include "meshmod/vertexdata/vertexcontainers.h"
+#include "meshmod/vertexdata/positionvertex.h"
+#include "meshmod/vertexdata/normalvertex.h"
+#include "meshmod/vertexdata/uvvertex.h"
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("VariContainer slot lookup", "[MeshMod/VariContainer]")
+{
+	using namespace MeshMod;
+	using Slots = ElementSlots<Elements<Vertex_>>;
+
+	// keys come from the name so are the same in every binary that links meshmod
+	REQUIRE(Slots::get<VertexData::Position>() == Core::QuickHash(VertexData::Position::getName()));
+	REQUIRE(Slots::get<VertexData::Normal>() == Core::QuickHash(VertexData::Normal::getName()));
+	REQUIRE(Slots::get<VertexData::Position>() != Slots::get<VertexData::Normal>());
+
+	// add order doesn't matter
+	VerticesElementsContainer a;
+	a.addElements<VertexData::Normals>();
+	a.addElements<VertexData::Positions>();
+	VerticesElementsContainer b;
+	b.addElements<VertexData::Positions>();
+	b.addElements<VertexData::UVs>();
+	b.addElements<VertexData::Normals>();
+	for(auto* container : { &a, &b })
+	{
+		auto* positions = container->getElementPtr<VertexData::Positions>();
+		auto* normals = container->getElementPtr<VertexData::Normals>();
+		REQUIRE(positions != nullptr);
+		REQUIRE(normals != nullptr);
+		REQUIRE(positions->name == VertexData::Position::getName());
+		REQUIRE(normals->name == VertexData::Normal::getName());
+		REQUIRE(container->getElement<VertexData::Normals>().get() == normals);
+	}
+	REQUIRE(a.getElementPtr<VertexData::UVs>() == nullptr);
+	REQUIRE(b.getElementPtr<VertexData::UVs>() != nullptr);
+
+	// lookups follow adds and removes
+	b.removeElements<VertexData::Normals>();
+	REQUIRE(b.getElementPtr<VertexData::Normals>() == nullptr);
+	REQUIRE(b.getElementPtr<VertexData::Positions>() != nullptr);
+	REQUIRE(b.getElementPtr<VertexData::UVs>() != nullptr);
+
+	// a clone has its own elements
+	VerticesElementsContainer c;
+	a.cloneTo(c);
+	REQUIRE(c.getElementPtr<VertexData::Positions>() != nullptr);
+	REQUIRE(c.getElementPtr<VertexData::Positions>() != a.getElementPtr<VertexData::Positions>());
+}
+
+namespace {
+using namespace std::literals;
+// FNV-1a gives these two names the same slot key
+struct ClashA
+{
+	float value;
+	static constexpr std::string_view const getName() { return "Clash6918"sv; }
+};
+struct ClashB
+{
+	uint32_t value;
+	static constexpr std::string_view const getName() { return "Clash1380004"sv; }
+};
+using ClashAs = MeshMod::BaseElements<ClashA, MeshMod::Vertex_, false, MeshMod::DerivedType::NotDerived>;
+using ClashBs = MeshMod::BaseElements<ClashB, MeshMod::Vertex_, false, MeshMod::DerivedType::NotDerived>;
+}
+
+TEST_CASE("VariContainer slot key clashes", "[MeshMod/VariContainer]")
+{
+	using namespace MeshMod;
+	REQUIRE(VerticesElementsContainer::slotOf<ClashAs>() == VerticesElementsContainer::slotOf<ClashBs>());
+
+	// each name still finds its own element whichever was added first
+	VerticesElementsContainer a;
+	a.addElements<ClashAs>();
+	REQUIRE(a.getElementPtr<ClashBs>() == nullptr);
+	a.addElements<ClashBs>();
+	VerticesElementsContainer b;
+	b.addElements<ClashBs>();
+	b.addElements<VertexData::Positions>();
+	b.addElements<ClashAs>();
+	for(auto* container : { &a, &b })
+	{
+		REQUIRE(container->getElementPtr<ClashAs>() != nullptr);
+		REQUIRE(container->getElementPtr<ClashBs>() != nullptr);
+		REQUIRE(container->getElementPtr<ClashAs>()->name == ClashA::getName());
+		REQUIRE(container->getElement<ClashBs>()->name == ClashB::getName());
+	}
+	b.removeElements<ClashBs>();
+	REQUIRE(b.getElementPtr<ClashBs>() == nullptr);
+	REQUIRE(b.getElementPtr<ClashAs>() != nullptr);
+}
+
+TEST_CASE("VariContainer validity", "[MeshMod/VariContainer]")
+{
+	using namespace MeshMod;
+	VerticesElementsContainer container;
+	container.addElements<VertexData::Positions>();
+	container.resize(130);
+	REQUIRE(container.size() == 130);
+	REQUIRE(container.getValidCount() == 130);
+
+	container.setValid(VertexIndex(0), false);
+	container.setValid(VertexIndex(64), false);
+	container.setValid(VertexIndex(129), false);
+	REQUIRE_FALSE(container.isValid(VertexIndex(0)));
+	REQUIRE(container.isValid(VertexIndex(1)));
+	REQUIRE_FALSE(container.isValid(VertexIndex(129)));
+	REQUIRE(container.getValidCount() == 127);
+
+	// new items are valid and clones copy the flag
+	VertexIndex const cloned = container.cloneElement(VertexIndex(64));
+	REQUIRE(size_t(cloned) == 130);
+	REQUIRE_FALSE(container.isValid(cloned));
+	container.resize(140);
+	REQUIRE(container.isValid(VertexIndex(139)));
+	REQUIRE(container.getValidCount() == 136);
+
+	REQUIRE_FALSE(container.isValid(VertexIndex(~0u)));
+	REQUIRE_THROWS_AS(container.isValid(VertexIndex(140)), std::out_of_range);
+	REQUIRE_THROWS_AS(container.setValid(VertexIndex(140), true), std::out_of_range);
+
+	container.resetValidFlags();
+	REQUIRE(container.getValidCount() == 140);
+}
+
+TEST_CASE("VariContainer forEachValid", "[MeshMod/VariContainer]")
+{
+	using namespace MeshMod;
+	VerticesElementsContainer container;
+	container.addElements<VertexData::Positions>();
+	container.resize(200);
+	for(auto i = 0u; i < 200; ++i)
+	{
+		if((i % 3) == 0 || (i >= 64 && i < 128)) container.setValid(VertexIndex(i), false);
+	}
+
+	auto const expected = [&container](size_t begin_, size_t end_)
+	{
+		std::vector<VertexIndex> out;
+		for(size_t i = begin_; i < end_; ++i)
+		{
+			if(container.isValid(VertexIndex(i))) out.push_back(VertexIndex(i));
+		}
+		return out;
+	};
+
+	std::vector<VertexIndex> all;
+	container.forEachValid([&all](VertexIndex i_) { all.push_back(i_); });
+	REQUIRE(all == expected(0, 200));
+	REQUIRE(all.size() == container.getValidCount());
+
+	// ranges that start and end mid word, in an empty word and across words
+	for(auto const& range : { std::make_pair(5, 60), std::make_pair(60, 70), std::make_pair(70, 120),
+							 std::make_pair(63, 129), std::make_pair(130, 200), std::make_pair(50, 50) })
+	{
+		std::vector<VertexIndex> got;
+		container.forEachValidInRange(range.first, range.second, [&got](VertexIndex i_) { got.push_back(i_); });
+		REQUIRE(got == expected(range.first, range.second));
+	}
+}
@@ -0,0 +1,145 @@
+#include "tester/catch.hpp"
+
+#include "core/core.h"
+#include "core/sharedtasks.h"
+#include "meshmod/mesh.h"
+#include "meshmod/vertices.h"
+#include "meshmod/polygons.h"
+#include "meshmod/vertexdata/normalvertex.h"
+#include "meshmod/polygonsdata/polygoncontainers.h"
+#include "meshops/basicmeshops.h"
+#include "meshops/platonicsolids.h"
+#include "geometry/aabb.h"
+#include <cstring>
+
+TEST_CASE("Vertex normals - stale items after a small edit", "[MeshOps/BasicMeshOps]")
+{
+	using namespace MeshMod;
+	std::shared_ptr<Mesh> mesh = MeshOps::PlatonicSolids::CreateIcosahedron();
+	REQUIRE(mesh);
+	MeshOps::BasicMeshOps::computeVertexNormals(mesh);
+
+	auto& positions = mesh->getVertices().positions();
+	positions[VertexIndex(0)].x += 0.25f;
+	positions[VertexIndex(0)].y -= 0.5f;
+	mesh->markPositionEdited(VertexIndex(0));
+	mesh->updateFromEdits();
+
+	auto const& normals = mesh->getVertices().getAttribute<VertexData::Normals>();
+	auto const& planeEqs = mesh->getPolygons().getAttribute<PolygonData::PlaneEquations>();
+	REQUIRE(normals.isStale());
+	REQUIRE(planeEqs.isStale());
+	// only the vertex, its ring and the polygons around it
+	REQUIRE(normals.staleItems.size() < mesh->getVertices().getCount());
+	REQUIRE(planeEqs.staleItems.size() < mesh->getPolygons().getCount());
+
+	MeshOps::BasicMeshOps::computeVertexNormals(mesh, false);
+	REQUIRE_FALSE(normals.isStale());
+	REQUIRE_FALSE(planeEqs.isStale());
+
+	// must match a full recompute
+	std::shared_ptr<Mesh> full = mesh->clone();
+	full->updateEditState(Mesh::PositionEdits);
+	MeshOps::BasicMeshOps::computeVertexNormals(full);
+	auto const& fullNormals = full->getVertices().getAttribute<VertexData::Normals>();
+	for(auto i = 0u; i < mesh->getVertices().getCount(); ++i)
+	{
+		VertexIndex const vi = VertexIndex(i);
+		REQUIRE(normals[vi].x == Approx(fullNormals[vi].x));
+		REQUIRE(normals[vi].y == Approx(fullNormals[vi].y));
+		REQUIRE(normals[vi].z == Approx(fullNormals[vi].z));
+	}
+}
+
+TEST_CASE("Vertex normals - edits are picked up by the real callers", "[MeshOps/BasicMeshOps]")
+{
+	using namespace MeshMod;
+	auto const requireMatchesFull = [](std::shared_ptr<Mesh> const& mesh_)
+	{
+		std::shared_ptr<Mesh> full = mesh_->clone();
+		MeshOps::BasicMeshOps::computeVertexNormals(full);
+		auto const& normals = mesh_->getVertices().getAttribute<VertexData::Normals>();
+		auto const& fullNormals = full->getVertices().getAttribute<VertexData::Normals>();
+		REQUIRE_FALSE(normals.isStale());
+		for(auto i = 0u; i < mesh_->getVertices().getCount(); ++i)
+		{
+			VertexIndex const vi = VertexIndex(i);
+			REQUIRE(normals[vi].x == Approx(fullNormals[vi].x).margin(1e-5));
+			REQUIRE(normals[vi].y == Approx(fullNormals[vi].y).margin(1e-5));
+			REQUIRE(normals[vi].z == Approx(fullNormals[vi].z).margin(1e-5));
+		}
+	};
+
+	// a pending edit with no updateFromEdits from the caller (the cooker path)
+	std::shared_ptr<Mesh> mesh = MeshOps::PlatonicSolids::CreateIcosahedron();
+	MeshOps::BasicMeshOps::computeVertexNormals(mesh);
+	mesh->getVertices().positions()[VertexIndex(3)].z += 0.5f;
+	mesh->markPositionEdited(VertexIndex(3));
+	MeshOps::BasicMeshOps::computeVertexNormals(mesh, false);
+	requireMatchesFull(mesh);
+
+	// Ex doesn't keep the old normals just because there are some (the renderer path)
+	std::shared_ptr<Mesh> meshEx = MeshOps::PlatonicSolids::CreateIcosahedron();
+	MeshOps::BasicMeshOps::computeVertexNormalsEx(meshEx);
+	auto const before = meshEx->getVertices().getAttribute<VertexData::Normals>()[VertexIndex(3)];
+	meshEx->getVertices().positions()[VertexIndex(3)].z += 0.5f;
+	meshEx->markPositionEdited(VertexIndex(3));
+	MeshOps::BasicMeshOps::computeVertexNormalsEx(meshEx, false);
+	auto const after = meshEx->getVertices().getAttribute<VertexData::Normals>()[VertexIndex(3)];
+	REQUIRE_FALSE(meshEx->getVertices().getAttribute<VertexData::Normals>().isStale());
+	REQUIRE(std::abs(after.z - before.z) > 1e-3f);
+
+	// spherize moves every vertex so the normals are rebuilt
+	std::shared_ptr<Mesh> sphere = MeshOps::PlatonicSolids::CreateIcosahedron();
+	MeshOps::BasicMeshOps::transform(sphere, Math::scale(Math::identity<Math::mat4x4>(), Math::vec3(1.0f, 1.0f, 0.25f)));
+	MeshOps::BasicMeshOps::computeVertexNormals(sphere);
+	MeshOps::BasicMeshOps::spherize(sphere, 1.0f);
+	MeshOps::BasicMeshOps::computeVertexNormals(sphere, false);
+	requireMatchesFull(sphere);
+}
+
+TEST_CASE("Parallel chunks match serial", "[MeshOps/BasicMeshOps]")
+{
+	using namespace MeshMod;
+	Core::InitSharedTasks();
+
+	// 20 * 4^5 triangles, plenty of chunks
+	std::shared_ptr<Mesh const> base = MeshOps::PlatonicSolids::CreateIcosahedron();
+	for(int i = 0; i < 5; ++i) base = MeshOps::BasicMeshOps::tesselate4(base);
+	REQUIRE(base->getPolygons().getCount() == 20 * 1024);
+
+	auto const run = [&base](bool parallel_, Geometry::AABB& aabb_) -> std::shared_ptr<Mesh>
+	{
+		bool const wasParallel = MeshOps::BasicMeshOps::isParallel();
+		MeshOps::BasicMeshOps::setParallel(parallel_);
+		std::shared_ptr<Mesh> mesh = base->clone();
+		MeshOps::BasicMeshOps::spherize(mesh, 0.5f);
+		MeshOps::BasicMeshOps::transform(mesh, Math::scale(Math::identity<Math::mat4x4>(), Math::vec3(2.0f, 1.0f, 0.5f)));
+		MeshOps::BasicMeshOps::computeVertexNormalsEx(mesh);
+		MeshOps::BasicMeshOps::computeAABB(mesh, aabb_);
+		MeshOps::BasicMeshOps::setParallel(wasParallel);
+		return mesh;
+	};
+
+	Geometry::AABB serialBox;
+	Geometry::AABB parallelBox;
+	std::shared_ptr<Mesh> serial = run(false, serialBox);
+	std::shared_ptr<Mesh> parallel = run(true, parallelBox);
+
+	REQUIRE(std::memcmp(&serialBox.getMinExtent(), &parallelBox.getMinExtent(), sizeof(Math::vec3)) == 0);
+	REQUIRE(std::memcmp(&serialBox.getMaxExtent(), &parallelBox.getMaxExtent(), sizeof(Math::vec3)) == 0);
+
+	auto const& sp = serial->getVertices().positions();
+	auto const& pp = parallel->getVertices().positions();
+	auto const& sn = serial->getVertices().getAttribute<VertexData::Normals>();
+	auto const& pn = parallel->getVertices().getAttribute<VertexData::Normals>();
+	REQUIRE(sp.size() == pp.size());
+	REQUIRE(sn.size() == pn.size());
+	REQUIRE(std::memcmp(sp.data(), pp.data(), sp.size() * sizeof(VertexData::Position)) == 0);
+	REQUIRE(std::memcmp(sn.data(), pn.data(), sn.size() * sizeof(VertexData::Normal)) == 0);
+
+	auto const& se = serial->getPolygons().getAttribute<PolygonData::PlaneEquations>();
+	auto const& pe = parallel->getPolygons().getAttribute<PolygonData::PlaneEquations>();
+	REQUIRE(se.size() == pe.size());
+	REQUIRE(std::memcmp(se.data(), pe.data(), se.size() * sizeof(PolygonData::PlaneEquation)) == 0);
+}
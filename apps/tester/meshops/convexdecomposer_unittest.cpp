@@ -0,0 +1,214 @@
+#include "tester/catch.hpp"
+
+#include "core/core.h"
+#include "core/filesystem.h"
+#include "meshmod/mesh.h"
+#include "meshmod/vertices.h"
+#include "meshmod/polygons.h"
+#include "meshops/basicmeshops.h"
+#include "meshops/platonicsolids.h"
+#include "meshops/convexdecomposer.h"
+#include "core/sharedtasks.h"
+#include "resourcemanager/derivedcache.h"
+#include <atomic>
+
+namespace {
+std::shared_ptr<MeshMod::Mesh> TriangulatedSolid(std::unique_ptr<MeshMod::Mesh> solid_)
+{
+	std::shared_ptr<MeshMod::Mesh> mesh(std::move(solid_));
+	MeshOps::BasicMeshOps::triangulate(mesh);
+	return mesh;
+}
+}
+
+TEST_CASE("Convex decomposer batch and cache", "[MeshOps/ConvexDecomposer]")
+{
+	using namespace MeshOps;
+	auto cube = TriangulatedSolid(PlatonicSolids::CreateCube());
+	auto octahedron = TriangulatedSolid(PlatonicSolids::CreateOctahedron());
+
+	ConvexHullParameters params;
+	params.resolution = 10000;
+
+	ConvexDecomposer decomposer(2);
+	REQUIRE(decomposer.getWorkerCount() == 2);
+
+	std::atomic<int> calls{ 0 };
+	std::atomic<int> bad{ 0 };
+	// the octahedrons hull comes back from the voxels with extra vertices, so 0 skips the count
+	auto const check = [&calls, &bad](uint32_t vertexCount_)
+	{
+		return [&calls, &bad, vertexCount_](uint64_t, ConvexDecomposer::Hulls const& hulls_)
+		{
+			calls++;
+			if(hulls_.size() != 1) bad++;
+			else if(vertexCount_ != 0 && hulls_[0]->getVertices().getCount() != vertexCount_) bad++;
+		};
+	};
+	uint64_t const cubeKey = decomposer.submit(cube, params, 0, check(8));
+	uint64_t const cubeKey2 = decomposer.submit(cube, params, 0, check(8));
+	uint64_t const octKey = decomposer.submit(octahedron, params, 0, check(0));
+	decomposer.waitForAll();
+
+	REQUIRE(calls == 3);
+	REQUIRE(bad == 0);
+	// identical inputs share a result, different parameters don't
+	REQUIRE(cubeKey == cubeKey2);
+	REQUIRE(cubeKey != octKey);
+	REQUIRE(decomposer.getCacheSize() == 2);
+	// meshes hand their arrays to the job, the key is the same as copying them from pointers
+	std::vector<float> points;
+	std::vector<uint32_t> triangles;
+	ConvexHullComputer::gatherTriangles(*cube, points, triangles);
+	REQUIRE(ConvexDecomposer::computeKey(points.data(), uint32_t(points.size() / 3),
+										 triangles.data(), uint32_t(triangles.size() / 3), params) == cubeKey);
+	ConvexHullParameters other = params;
+	other.concavity *= 2.0f;
+	uint64_t const otherKey = decomposer.submit(cube, other, 0, nullptr);
+	REQUIRE(otherKey != cubeKey);
+	decomposer.waitForAll();
+	REQUIRE(decomposer.getCacheSize() == 3);
+
+	auto cached = decomposer.getCached(cubeKey);
+	REQUIRE(cached.size() == 1);
+	REQUIRE(cached[0]->getPolygons().getCount() == 12);
+	decomposer.clearCache();
+	REQUIRE(decomposer.getCached(cubeKey).empty());
+	REQUIRE(decomposer.getCacheBytes() == 0);
+
+	// room for the cube and octahedron only, the least recently used goes when another arrives
+	decomposer.submit(cube, params, 0, nullptr);
+	decomposer.waitForAll();
+	size_t const cubeBytes = decomposer.getCacheBytes();
+	decomposer.submit(octahedron, params, 0, nullptr);
+	decomposer.waitForAll();
+	REQUIRE(decomposer.getCacheBytes() > cubeBytes);
+	decomposer.setMaxCacheBytes(decomposer.getCacheBytes());
+	REQUIRE(decomposer.getCacheSize() == 2);
+	REQUIRE(!decomposer.getCached(cubeKey).empty());
+	decomposer.submit(cube, other, 0, nullptr);
+	decomposer.waitForAll();
+	REQUIRE(decomposer.getCacheSize() == 2);
+	REQUIRE(decomposer.getCached(octKey).empty());
+	REQUIRE(!decomposer.getCached(cubeKey).empty());
+	REQUIRE(!decomposer.getCached(otherKey).empty());
+
+	// too small for anything but the newest
+	decomposer.setMaxCacheBytes(1);
+	REQUIRE(decomposer.getCacheSize() == 0);
+	decomposer.submit(cube, params, 0, nullptr);
+	decomposer.submit(octahedron, params, 0, nullptr);
+	decomposer.waitForAll();
+	REQUIRE(decomposer.getCacheSize() == 1);
+}
+
+TEST_CASE("Convex decomposer priorities", "[MeshOps/ConvexDecomposer]")
+{
+	using namespace MeshOps;
+	auto cube = TriangulatedSolid(PlatonicSolids::CreateCube());
+	std::vector<float> points;
+	std::vector<uint32_t> triangles;
+	ConvexHullComputer::gatherTriangles(*cube, points, triangles);
+
+	// one runner and one batch so the highest priority waiting always goes next
+	ConvexDecomposer decomposer(1);
+	std::mutex orderMutex;
+	std::vector<int32_t> order;
+	std::vector<ConvexDecomposer::Request> batch(4);
+	int32_t const priorities[] = { 1, 5, -2, 3 };
+	for(auto i = 0u; i < batch.size(); ++i)
+	{
+		auto& request = batch[i];
+		request.points = points.data();
+		request.pointCount = uint32_t(points.size() / 3);
+		request.triangles = triangles.data();
+		request.triangleCount = uint32_t(triangles.size() / 3);
+		request.parameters.resolution = 10000;
+		request.priority = priorities[i];
+		request.onComplete = [&orderMutex, &order, i, &priorities](uint64_t, ConvexDecomposer::Hulls const&)
+		{
+			std::lock_guard<std::mutex> lock(orderMutex);
+			order.push_back(priorities[i]);
+		};
+	}
+	auto keys = decomposer.submit(batch);
+	decomposer.waitForAll();
+
+	REQUIRE(keys.size() == 4);
+	REQUIRE(order == std::vector<int32_t>{ 5, 3, 1, -2 });
+	REQUIRE(decomposer.getCacheSize() == 1);
+}
+
+TEST_CASE("Convex decomposer submits from task threads", "[MeshOps/ConvexDecomposer]")
+{
+	using namespace MeshOps;
+	Core::InitSharedTasks();
+	auto cube = TriangulatedSolid(PlatonicSolids::CreateCube());
+	ConvexHullParameters params;
+	params.resolution = 10000;
+
+	// the runners are on the same threads as whoever submits, so they can each submit in turn
+	ConvexDecomposer decomposer(2);
+	std::atomic<int> calls{ 0 };
+	uint32_t const submitters = 8;
+	enki::TaskSet task(submitters, [&](enki::TaskSetPartition range_, uint32_t)
+	{
+		for(auto i = range_.start; i < range_.end; ++i)
+		{
+			ConvexHullParameters p = params;
+			p.concavity += float(i) * 0.001f;
+			decomposer.submit(cube, p, 0, [&calls](uint64_t, ConvexDecomposer::Hulls const& hulls_)
+			{
+				if(hulls_.size() == 1) calls++;
+			});
+		}
+	});
+	{
+		std::lock_guard<std::recursive_mutex> lock(Core::SharedTasksMutex);
+		g_EnkiTS.AddTaskSetToPipe(&task);
+		g_EnkiTS.WaitforTask(&task);
+	}
+	decomposer.waitForAll();
+	REQUIRE(calls == int(submitters));
+	REQUIRE(decomposer.getCacheSize() == submitters);
+}
+
+TEST_CASE("Convex decomposer disk cache", "[MeshOps/ConvexDecomposer]")
+{
+	using namespace MeshOps;
+	using namespace ResourceManager;
+	auto const directory = (std::filesystem::temp_directory_path() / "wyrd_hull_ddc_test").string();
+	std::error_code ec;
+	std::filesystem::remove_all(directory, ec);
+	auto disk = std::make_shared<DerivedDataCache>(directory, 0);
+
+	auto cube = TriangulatedSolid(PlatonicSolids::CreateCube());
+	ConvexHullParameters params;
+	params.resolution = 10000;
+
+	{
+		ConvexDecomposer decomposer(1);
+		decomposer.setDiskCache(disk);
+		decomposer.submit(cube, params, 0, nullptr);
+		decomposer.waitForAll();
+	}
+	std::vector<float> points;
+	std::vector<uint32_t> triangles;
+	ConvexHullComputer::gatherTriangles(*cube, points, triangles);
+	auto const diskKey = ConvexDecomposer::computeDiskKey(points.data(), uint32_t(points.size() / 3),
+														  triangles.data(), uint32_t(triangles.size() / 3), params);
+	REQUIRE(diskKey.opId == ConvexDecomposer::DiskCacheOpId);
+	REQUIRE(disk->contains(diskKey));
+	REQUIRE(disk->getSize() != 0);
+
+	// a fresh decomposer (i.e. next session) gets it from disk
+	ConvexDecomposer decomposer(1);
+	decomposer.setDiskCache(disk);
+	size_t polygonCount = 0;
+	decomposer.submit(cube, params, 0, [&polygonCount](uint64_t, ConvexDecomposer::Hulls const& hulls_)
+	{
+		if(hulls_.size() == 1) polygonCount = hulls_[0]->getPolygons().getCount();
+	});
+	decomposer.waitForAll();
+	REQUIRE(polygonCount == 12);
+}
@@ -0,0 +1,81 @@
+#include "tester/catch.hpp"
+
+#include "core/core.h"
+#include "meshmod/mesh.h"
+#include "meshmod/vertices.h"
+#include "meshmod/polygons.h"
+#include "meshmod/vertexdata/normalvertex.h"
+#include "meshops/meshcooker.h"
+#include "meshops/platonicsolids.h"
+#include <sstream>
+
+TEST_CASE("Cook a cube", "[MeshOps/MeshCooker]")
+{
+	using namespace MeshOps;
+	std::shared_ptr<MeshMod::Mesh> mesh = PlatonicSolids::CreateCube();
+	REQUIRE(mesh);
+
+	size_t const polygonCount = mesh->getPolygons().getCount();
+	bool const hadNormals = mesh->getVertices().hasAttribute<MeshMod::VertexData::Normals>();
+
+	MeshCooker::CookedData data;
+	REQUIRE(MeshCooker::process(mesh, MeshCookerParameters(), data));
+	// the cooker works on a copy, the quads and attributes given to it are untouched
+	REQUIRE(mesh->getPolygons().getCount() == polygonCount);
+	REQUIRE(mesh->getVertices().hasAttribute<MeshMod::VertexData::Normals>() == hadNormals);
+	// the cube's smooth normals let all the corners weld
+	REQUIRE(data.vertices.size() == 8);
+	REQUIRE(data.indices.size() == 36);
+	REQUIRE(data.index16);
+	// vertex fetch order is first use order
+	REQUIRE(data.indices[0] == 0);
+
+	std::vector<uint8_t> bytes;
+	REQUIRE(MeshCooker::saveTo(data, 0, bytes));
+	std::istringstream in(std::string((char const*) bytes.data(), bytes.size()));
+	std::vector<std::shared_ptr<CookedMesh>> cooked;
+	REQUIRE(CookedMesh::createFromStream(in, cooked));
+	REQUIRE(cooked.size() == 1);
+
+	auto const& cmesh = cooked[0];
+	REQUIRE(cmesh->getVertexCount() == 8);
+	REQUIRE(cmesh->getIndexCount() == 36);
+	REQUIRE(cmesh->is16BitIndices());
+	for(uint32_t i = 0; i < cmesh->getIndexCount(); ++i)
+	{
+		REQUIRE(cmesh->getIndex(i) == data.indices[i]);
+	}
+	for(uint32_t i = 0; i < cmesh->getVertexCount(); ++i)
+	{
+		Math::vec3 const p = cmesh->decodePosition(cmesh->getVertices()[i]);
+		REQUIRE(std::abs(std::abs(p.x) - 1.0f) < 1e-4f);
+		REQUIRE(std::abs(std::abs(p.y) - 1.0f) < 1e-4f);
+		REQUIRE(std::abs(std::abs(p.z) - 1.0f) < 1e-4f);
+	}
+}
+
+TEST_CASE("Cooked meshes are used where they are loaded", "[MeshOps/MeshCooker]")
+{
+	using namespace MeshOps;
+	std::shared_ptr<MeshMod::Mesh const> mesh = PlatonicSolids::CreateIcosahedron();
+	std::vector<uint8_t> bytes;
+	REQUIRE(MeshCooker::cook(mesh, MeshCookerParameters(), 0, bytes));
+
+	auto memory = std::make_shared<std::vector<uint8_t>>(bytes);
+	uint8_t const* begin = memory->data();
+	uint8_t const* end = begin + memory->size();
+	std::vector<std::shared_ptr<CookedMesh>> cooked;
+	REQUIRE(CookedMesh::createFromMemory(memory, memory->data(), memory->size(), cooked));
+	REQUIRE(cooked.size() == 1);
+
+	auto const& cmesh = cooked[0];
+	REQUIRE((uint8_t const*) cmesh.get() >= begin);
+	REQUIRE((uint8_t const*) cmesh->getVertices() >= begin);
+	REQUIRE((uint8_t const*) cmesh->getIndexData() + cmesh->getIndexDataSize() <= end);
+	REQUIRE(cmesh->getVertexCount() == 12);
+	REQUIRE(cmesh->getIndexCount() == 60);
+
+	// the memory stays alive with the mesh
+	memory.reset();
+	REQUIRE(cmesh->getIndex(0) < cmesh->getVertexCount());
+}
@@ -0,0 +1,116 @@
+#include "tester/catch.hpp"
+
+#include "core/core.h"
+#include "ncoproxy.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+// spins until pred_ is true or a second has gone, returns pred_
+template<typename Pred>
+bool WaitFor(Pred&& pred_)
+{
+	auto const end = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+	while(!pred_() && std::chrono::steady_clock::now() < end)
+	{
+		std::this_thread::yield();
+	}
+	return pred_();
+}
+}
+
+TEST_CASE("Reload drains calls in flight", "[NCOProxy]")
+{
+	// without Init there are no modules, so a reload is just the drain and publish
+	InterfaceTable const* table = GetInterfaceTable();
+	REQUIRE(table != nullptr);
+	REQUIRE(table->moduleCount == 0);
+
+	uint32_t const version = BeginCalls();
+	REQUIRE((version & 1) == 0);
+
+	std::atomic<bool> reloaded{ false };
+	std::thread reloader([&reloaded]()
+	{
+		bool const okay = Reload();
+		reloaded.store(okay);
+	});
+
+	// the version goes odd as soon as the reload starts but it waits for us to leave
+	REQUIRE(WaitFor([table, version]() { return table->version.load() == version + 1; }));
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	REQUIRE(!reloaded.load());
+
+	// and nobody else gets in while its waiting
+	std::atomic<uint32_t> enteredVersion{ ~0u };
+	std::thread caller([&enteredVersion]()
+	{
+		enteredVersion.store(BeginCalls());
+		EndCalls();
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	REQUIRE(enteredVersion.load() == ~0u);
+	REQUIRE(table->version.load() == version + 1);
+
+	EndCalls();
+	reloader.join();
+	caller.join();
+	REQUIRE(reloaded.load());
+	// even again and different, so cached interface pointers get refetched
+	REQUIRE(table->version.load() == version + 2);
+	REQUIRE(enteredVersion.load() == version + 2);
+	REQUIRE(GetModuleIndex("CUtils") == -1);
+
+	// with nothing in flight a reload doesn't wait
+	REQUIRE(Reload());
+	REQUIRE(table->version.load() == version + 4);
+}
+
+TEST_CASE("Reloads are one at a time and not from inside a call", "[NCOProxy]")
+{
+	InterfaceTable const* table = GetInterfaceTable();
+
+	// reloading from inside a call would wait for itself forever
+	uint32_t const version = BeginCalls();
+	REQUIRE(!Reload());
+	REQUIRE(table->version.load() == version);
+	EndCalls();
+
+	// each reload bumps the version twice, so overlapping ones would leave it odd or short
+	uint32_t const reloaders = 4;
+	uint32_t const reloadsEach = 50;
+	std::atomic<uint32_t> failed{ 0 };
+	std::atomic<bool> stop{ false };
+	std::atomic<uint32_t> oddCalls{ 0 };
+	// a caller in the middle of it all only ever sees finished tables
+	std::thread caller([&stop, &oddCalls]()
+	{
+		while(!stop.load())
+		{
+			if(BeginCalls() & 1) oddCalls++;
+			EndCalls();
+		}
+	});
+	std::vector<std::thread> threads;
+	for(auto i = 0u; i < reloaders; ++i)
+	{
+		threads.emplace_back([&failed]()
+		{
+			for(auto j = 0u; j < reloadsEach; ++j)
+			{
+				if(!Reload()) failed++;
+			}
+		});
+	}
+	for(auto& thread : threads)
+	{
+		thread.join();
+	}
+	stop.store(true);
+	caller.join();
+	REQUIRE(failed == 0);
+	REQUIRE(oddCalls == 0);
+	REQUIRE(table->version.load() == version + 2 * reloaders * reloadsEach);
+}
@@ -0,0 +1,178 @@
+#include "../catch.hpp"
+
+#include "core/core.h"
+#include "render/generictextureformat.h"
+#include "render/gtfcracker.h"
+#include "render/image.h"
+#include "render/pixelconverter.h"
+#include <string>
+#include <vector>
+
+namespace {
+using namespace Render;
+
+// odd so the SIMD kernels leave a tail
+constexpr uint32_t PixelCount = 37;
+constexpr auto Rgba32F = GenericTextureFormat::R32G32B32A32_SFLOAT;
+
+auto IsTestable(GenericTextureFormat fmt_) -> bool
+{
+	if(fmt_ == GenericTextureFormat::UNDEFINED) return false;
+	if(GtfCracker::isCompressed(fmt_)) return false;
+	return GtfCracker::channelCount(fmt_) > 0 && GtfCracker::bitWidth(fmt_) >= 8;
+}
+
+// a spread of in range values written with the per pixel reference
+auto MakeSource(GenericTextureFormat fmt_) -> std::vector<uint8_t>
+{
+	uint32_t const bytesPerPixel = GtfCracker::bitWidth(fmt_) / 8;
+	std::vector<uint8_t> src(PixelCount * bytesPerPixel, 0);
+	for(auto i = 0u; i < PixelCount; ++i)
+	{
+		double values[4];
+		for(auto c = 0u; c < 4; ++c)
+		{
+			double const t = double((i * 7 + c * 13) % 32) / 31.0;
+			if(GtfCracker::isFloat(fmt_))
+			{
+				values[c] = t * 100.0 - 50.0;
+			} else if(GtfCracker::isNormalised(fmt_) || GtfCracker::isSRGB(fmt_))
+			{
+				values[c] = GtfCracker::isSigned(fmt_) ? t * 2.0 - 1.0 : t;
+			} else
+			{
+				// small enough to be exact as a float
+				double const lo = std::max(GtfCracker::min(fmt_, Channel(c)), -double(1 << 20));
+				double const hi = std::min(GtfCracker::max(fmt_, Channel(c)), double(1 << 20));
+				values[c] = std::floor(lo + t * (hi - lo));
+			}
+		}
+		GenericImage::putPixel(fmt_, {values[0], values[1], values[2], values[3]}, src.data() + i * bytesPerPixel);
+	}
+	return src;
+}
+
+// how far an encode can be from the reference, in decoded units
+auto Tolerance(GenericTextureFormat fmt_, Channel channel_, double value_) -> double
+{
+	if(GtfCracker::isSRGB(fmt_)) return 0.01;
+	if(GtfCracker::isFloat(fmt_))
+	{
+		double const relative = (GtfCracker::bitWidth(fmt_) / GtfCracker::channelCount(fmt_) <= 16) ? 1e-3 : 1e-6;
+		return relative * std::max(1.0, std::abs(value_));
+	}
+	if(GtfCracker::isNormalised(fmt_)) return 1.0 / GtfCracker::max(fmt_, channel_) + 1e-6;
+	return 1e-6 * std::max(1.0, std::abs(value_));
+}
+
+auto RequireClose(GenericImage::Pixel const& a_, GenericImage::Pixel const& b_, double const tolerance_[4]) -> void
+{
+	REQUIRE(std::abs(a_.r - b_.r) <= tolerance_[0]);
+	REQUIRE(std::abs(a_.g - b_.g) <= tolerance_[1]);
+	REQUIRE(std::abs(a_.b - b_.b) <= tolerance_[2]);
+	REQUIRE(std::abs(a_.a - b_.a) <= tolerance_[3]);
+}
+}
+
+TEST_CASE("PixelConverter matches the per pixel path", "[render]")
+{
+	for(auto f = 0u; f < GenericTextureFormatEnumCount; ++f)
+	{
+		auto const fmt = GenericTextureFormat(f);
+		if(!IsTestable(fmt)) continue;
+		std::string const name(GtfCracker::name(fmt));
+		CAPTURE(name);
+		uint32_t const bytesPerPixel = GtfCracker::bitWidth(fmt) / 8;
+		auto const src = MakeSource(fmt);
+
+		// decode
+		PixelConverter toFloat(fmt, Rgba32F);
+		REQUIRE(toFloat.isValid());
+		std::vector<float> rgba(PixelCount * 4);
+		REQUIRE(toFloat.convert(src.data(), src.size(), (uint8_t*) rgba.data(), rgba.size() * sizeof(float),
+								PixelCount, 1));
+		for(auto i = 0u; i < PixelCount; ++i)
+		{
+			auto const expected = GenericImage::fetchPixel(fmt, src.data() + i * bytesPerPixel);
+			GenericImage::Pixel const got = {rgba[i * 4 + 0], rgba[i * 4 + 1], rgba[i * 4 + 2], rgba[i * 4 + 3]};
+			double const tolerance[4] = {
+					1e-5 * std::max(1.0, std::abs(expected.r)), 1e-5 * std::max(1.0, std::abs(expected.g)),
+					1e-5 * std::max(1.0, std::abs(expected.b)), 1e-5 * std::max(1.0, std::abs(expected.a))
+			};
+			RequireClose(got, expected, tolerance);
+		}
+
+		// encode what was decoded, should read back as the source did
+		std::vector<uint8_t> dst(src.size(), 0xCD);
+		REQUIRE(PixelConverter::Convert(Rgba32F, (uint8_t const*) rgba.data(), rgba.size() * sizeof(float),
+										fmt, dst.data(), dst.size(), PixelCount, 1));
+		for(auto i = 0u; i < PixelCount; ++i)
+		{
+			auto const expected = GenericImage::fetchPixel(fmt, src.data() + i * bytesPerPixel);
+			auto const got = GenericImage::fetchPixel(fmt, dst.data() + i * bytesPerPixel);
+			double const tolerance[4] = {
+					Tolerance(fmt, Channel::R, expected.r), Tolerance(fmt, Channel::G, expected.g),
+					Tolerance(fmt, Channel::B, expected.b), Tolerance(fmt, Channel::A, expected.a)
+			};
+			RequireClose(got, expected, tolerance);
+		}
+	}
+}
+
+TEST_CASE("PixelConverter swizzles and strides", "[render]")
+{
+	auto const rgba8 = MakeSource(GenericTextureFormat::R8G8B8A8_UNORM);
+
+	// RGBA8 <-> BGRA8 is a direct byte shuffle so is exact
+	std::vector<uint8_t> bgra8(rgba8.size());
+	REQUIRE(PixelConverter::Convert(GenericTextureFormat::R8G8B8A8_UNORM, rgba8.data(), rgba8.size(),
+									GenericTextureFormat::B8G8R8A8_UNORM, bgra8.data(), bgra8.size(), PixelCount, 1));
+	for(auto i = 0u; i < PixelCount; ++i)
+	{
+		REQUIRE(bgra8[i * 4 + 0] == rgba8[i * 4 + 2]);
+		REQUIRE(bgra8[i * 4 + 1] == rgba8[i * 4 + 1]);
+		REQUIRE(bgra8[i * 4 + 2] == rgba8[i * 4 + 0]);
+		REQUIRE(bgra8[i * 4 + 3] == rgba8[i * 4 + 3]);
+	}
+
+	// unorm8 -> fp16 -> unorm8 round trips to within the truncation
+	std::vector<uint8_t> half(PixelCount * 8);
+	std::vector<uint8_t> back(rgba8.size());
+	REQUIRE(PixelConverter::Convert(GenericTextureFormat::B8G8R8A8_UNORM, bgra8.data(), bgra8.size(),
+									GenericTextureFormat::R16G16B16A16_SFLOAT, half.data(), half.size(), PixelCount, 1));
+	REQUIRE(PixelConverter::Convert(GenericTextureFormat::R16G16B16A16_SFLOAT, half.data(), half.size(),
+									GenericTextureFormat::R8G8B8A8_UNORM, back.data(), back.size(), PixelCount, 1));
+	for(auto i = 0u; i < rgba8.size(); ++i)
+	{
+		REQUIRE(std::abs(int(back[i]) - int(rgba8[i])) <= 1);
+	}
+
+	// 3 rows of 5 pixels out of the middle of a padded image, the padding is left alone
+	uint32_t const width = 5;
+	uint32_t const rows = 3;
+	size_t const dstStride = width * 4 * sizeof(float) + 12;
+	std::vector<uint8_t> dst(dstStride * rows, 0xCD);
+	PixelConverter converter(GenericTextureFormat::A2B10G10R10_UNORM_PACK32, Rgba32F);
+	auto const packed = MakeSource(GenericTextureFormat::A2B10G10R10_UNORM_PACK32);
+	size_t const srcStride = 12 * 4;
+	REQUIRE(converter.convert(packed.data() + 4, srcStride, dst.data(), dstStride, width, rows));
+	for(auto y = 0u; y < rows; ++y)
+	{
+		for(auto x = 0u; x < width; ++x)
+		{
+			auto const expected = GenericImage::fetchPixel(GenericTextureFormat::A2B10G10R10_UNORM_PACK32,
+														   packed.data() + 4 + y * srcStride + x * 4);
+			float const* got = (float const*) (dst.data() + y * dstStride) + x * 4;
+			REQUIRE(got[0] == Approx(expected.r));
+			REQUIRE(got[1] == Approx(expected.g));
+			REQUIRE(got[2] == Approx(expected.b));
+			REQUIRE(got[3] == Approx(expected.a));
+		}
+		for(auto i = width * 4 * sizeof(float); i < dstStride; ++i)
+		{
+			REQUIRE(dst[y * dstStride + i] == 0xCD);
+		}
+	}
+
+	REQUIRE(!PixelConverter(GenericTextureFormat::BC1_RGB_UNORM_BLOCK, Rgba32F).isValid());
+}
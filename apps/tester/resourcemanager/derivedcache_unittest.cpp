@@ -0,0 +1,101 @@
+#include "../catch.hpp"
+#include "core/core.h"
+#include "core/filesystem.h"
+#include "binny/bundle.h"
+#include "binny/bundlewriter.h"
+#include "resourcemanager/derivedcache.h"
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace {
+std::string CleanCacheDirectory(char const* name_)
+{
+	auto const path = std::filesystem::temp_directory_path() / name_;
+	std::error_code ec;
+	std::filesystem::remove_all(path, ec);
+	return path.string();
+}
+
+bool AddPayload(Binny::BundleWriter& writer_, size_t size_, uint8_t fill_)
+{
+	using namespace Binny;
+	return writer_.addRawBinaryChunk("payload", "TEST"_bundle_id, 0, 0, 0, {}, std::vector<uint8_t>(size_, fill_));
+}
+}
+
+TEST_CASE("DerivedDataCache put/get", "[ResourceManager/DerivedDataCache]")
+{
+	using namespace ResourceManager;
+	using namespace Binny;
+	std::string const directory = CleanCacheDirectory("wyrd_ddc_test");
+	DerivedDataCache cache(directory, 0);
+	REQUIRE(cache.getSize() == 0);
+
+	DerivedDataCache::Key const key{ "HULL"_bundle_id, 1, 0x1234, 0x5678 };
+	DerivedDataCache::Key const otherVersion{ "HULL"_bundle_id, 2, 0x1234, 0x5678 };
+	REQUIRE(DerivedDataCache::getKeyId(key) != DerivedDataCache::getKeyId(otherVersion));
+
+	std::vector<uint8_t> bundle;
+	REQUIRE(!cache.get(key, bundle));
+	REQUIRE(cache.put(key, [](Binny::BundleWriter& writer_) { return AddPayload(writer_, 100, 7); }));
+	REQUIRE(cache.contains(key));
+	REQUIRE(!cache.contains(otherVersion));
+	REQUIRE(cache.get(key, bundle));
+	REQUIRE(Binny::Bundle::PeekAtHeader(bundle.data(), bundle.size()).second == DerivedDataCache::getKeyId(key));
+
+	// a bundle made for another key is refused
+	REQUIRE(!cache.put(otherVersion, bundle));
+
+	// another instance on the same directory sees it
+	DerivedDataCache cache2(directory, 0);
+	REQUIRE(cache2.getSize() == cache.getSize());
+	std::vector<uint8_t> bundle2;
+	REQUIRE(cache2.get(key, bundle2));
+	REQUIRE(bundle2 == bundle);
+
+	// a damaged entry reads as a miss and is removed
+	{
+		std::ofstream out(directory + "/junk", std::ofstream::binary);
+	}
+	for(auto const& file : std::filesystem::directory_iterator(directory))
+	{
+		if(file.path().extension() != ".ddc") continue;
+		std::ofstream out(file.path().string(), std::ofstream::binary | std::ofstream::trunc);
+		out << "not a bundle at all, just some junk text";
+	}
+	REQUIRE(!cache.get(key, bundle));
+	REQUIRE(!cache.contains(key));
+}
+
+TEST_CASE("DerivedDataCache lru trim", "[ResourceManager/DerivedDataCache]")
+{
+	using namespace ResourceManager;
+	using namespace Binny;
+	using namespace std::chrono_literals;
+	std::string const directory = CleanCacheDirectory("wyrd_ddc_trim_test");
+	DerivedDataCache cache(directory, 0);
+
+	std::vector<DerivedDataCache::Key> keys;
+	for(uint64_t i = 0; i < 4; ++i)
+	{
+		keys.push_back({ "TEST"_bundle_id, 1, i, 0 });
+		REQUIRE(cache.put(keys.back(), [i](Binny::BundleWriter& writer_) { return AddPayload(writer_, 4096, uint8_t(i)); }));
+		// file times can be coarse
+		std::this_thread::sleep_for(20ms);
+	}
+	uint64_t const full = cache.getSize();
+
+	// reading the oldest makes it the newest
+	std::vector<uint8_t> bundle;
+	REQUIRE(cache.get(keys[0], bundle));
+	cache.trim(full / 2);
+	REQUIRE(cache.getSize() <= full / 2);
+	REQUIRE(cache.contains(keys[0]));
+	REQUIRE(!cache.contains(keys[1]));
+	REQUIRE(cache.contains(keys[3]));
+
+	cache.trim(0);
+	REQUIRE(cache.getSize() == 0);
+	REQUIRE(!cache.contains(keys[0]));
+}
@@ -0,0 +1,1154 @@
+#include "tester/catch.hpp"
+
+#include "core/core.h"
+#include "meshmod/mesh.h"
+#include "meshmod/vertices.h"
+#include "meshmod/polygons.h"
+#include "tacticalmap/tacticalmap.h"
+#include "tacticalmap/stitcher.h"
+#include "tacticalmap/builder.h"
+#include "geometry/watertightray.h"
+#include "core/sharedtasks.h"
+#include "cityhash/city.h"
+#include <sstream>
+#include <set>
+#include <thread>
+#include <cmath>
+
+namespace {
+
+auto CreateGround(float const halfSize_) -> std::shared_ptr<MeshMod::Mesh>
+{
+	using namespace MeshMod;
+	auto mesh = std::make_shared<Mesh>("ground", true, true);
+	auto& vertices = mesh->getVertices();
+	vertices.add(-halfSize_, 0, -halfSize_);
+	vertices.add(-halfSize_, 0, halfSize_);
+	vertices.add(halfSize_, 0, halfSize_);
+	vertices.add(halfSize_, 0, -halfSize_);
+	VertexIndexContainer quad{ VertexIndex(0), VertexIndex(1), VertexIndex(2), VertexIndex(3) };
+	mesh->getPolygons().addPolygon(quad);
+	mesh->updateFromEdits();
+	return mesh;
+}
+
+// a single quad, which the builder triangulates
+auto CreateQuad(Math::vec3 const& a_, Math::vec3 const& b_, Math::vec3 const& c_, Math::vec3 const& d_) -> std::shared_ptr<MeshMod::Mesh>
+{
+	using namespace MeshMod;
+	auto mesh = std::make_shared<Mesh>("quad", true, true);
+	auto& vertices = mesh->getVertices();
+	for(auto const& p : { a_, b_, c_, d_ })
+	{
+		vertices.add(p.x, p.y, p.z);
+	}
+	VertexIndexContainer quad{ VertexIndex(0), VertexIndex(1), VertexIndex(2), VertexIndex(3) };
+	mesh->getPolygons().addPolygon(quad);
+	mesh->updateFromEdits();
+	return mesh;
+}
+
+auto SaveMap(std::shared_ptr<TacticalMap> const& map_) -> std::vector<uint8_t>
+{
+	std::vector<uint8_t> bytes;
+	REQUIRE(map_->saveTo(0, bytes));
+	return bytes;
+}
+
+}
+
+TEST_CASE("Incremental build matches a full build", "[TacticalMap/Builder]")
+{
+	Core::InitSharedTasks();
+
+	TacticalMapLevelDataHeader levelData{};
+	levelData.nameCrc = 1;
+	Math::mat4x4 const identity(1.0f);
+	auto const ground = CreateGround(15.0f);
+	Geometry::AABB const boxes[] = {
+			Geometry::AABB(Math::vec3(-4, 0, -4), Math::vec3(-2, 2, -2)),
+			Geometry::AABB(Math::vec3(3, 0, 1), Math::vec3(5, 4, 2)),
+			Geometry::AABB(Math::vec3(-1, 3, 5), Math::vec3(2, 4, 9)),
+	};
+	Math::mat4x4 const moved = Math::translate(identity, Math::vec3(-6.5f, 0.5f, 3.0f));
+
+	auto builder = TacticalMap::allocateBuilder(Math::vec2(-16, -16), 32, 32, "incremental");
+	builder->setRegionSize(8);
+	builder->addMeshAt(ground, &levelData, identity);
+	uint32_t boxIds[3];
+	for(int i = 0; i < 3; ++i)
+	{
+		boxIds[i] = builder->addBoxAt(boxes[i], &levelData, identity);
+	}
+	auto const firstMap = builder->build();
+	REQUIRE(firstMap);
+
+	builder->removeSolid(boxIds[0]);
+	builder->updateSolidTransform(boxIds[2], moved);
+	auto const editedMap = builder->build();
+	REQUIRE(editedMap);
+
+	auto full = TacticalMap::allocateBuilder(Math::vec2(-16, -16), 32, 32, "incremental");
+	full->addMeshAt(ground, &levelData, identity);
+	full->addBoxAt(boxes[1], &levelData, identity);
+	full->addBoxAt(boxes[2], &levelData, moved);
+	auto const fullMap = full->build();
+	REQUIRE(fullMap);
+
+	REQUIRE(SaveMap(editedMap) == SaveMap(fullMap));
+	REQUIRE(SaveMap(firstMap) != SaveMap(fullMap));
+}
+
+TEST_CASE("Any region size builds the same map as one region", "[TacticalMap/Builder]")
+{
+	Core::InitSharedTasks();
+
+	TacticalMapLevelDataHeader levelData{};
+	levelData.nameCrc = 1;
+	Math::mat4x4 const identity(1.0f);
+	auto const ground = CreateGround(15.0f);
+	Geometry::AABB const boxes[] = {
+			Geometry::AABB(Math::vec3(-4, 0, -4), Math::vec3(-2, 2, -2)),
+			Geometry::AABB(Math::vec3(3, 0, 1), Math::vec3(5, 4, 2)),
+			Geometry::AABB(Math::vec3(-1, 3, 5), Math::vec3(2, 4, 9)),
+			Geometry::AABB(Math::vec3(-9, 0, 6), Math::vec3(-6, 1, 12)),
+	};
+
+	// hashed uncompressed like tacticalmapbench so a mismatch isn't hidden by the compressor
+	auto const buildHash = [&](uint32_t const regionSize_, TacticalMapBuildStats& stats_) -> uint64_t
+	{
+		auto builder = TacticalMap::allocateBuilder(Math::vec2(-16, -16), 32, 32, "regions");
+		builder->setRegionSize(regionSize_);
+		builder->addMeshAt(ground, &levelData, identity);
+		for(auto const& box : boxes)
+		{
+			builder->addBoxAt(box, &levelData, identity);
+		}
+		auto const map = builder->build();
+		REQUIRE(map);
+		stats_ = builder->getBuildStats();
+
+		std::vector<uint8_t> bytes;
+		REQUIRE(map->saveTo(0, bytes, false));
+		REQUIRE(!bytes.empty());
+
+		// nothing changed so a rebuild regenerates no regions and makes the same map
+		auto const rebuilt = builder->build();
+		REQUIRE(rebuilt);
+		REQUIRE(builder->getBuildStats().regionsBuilt == 0);
+		std::vector<uint8_t> rebuiltBytes;
+		REQUIRE(rebuilt->saveTo(0, rebuiltBytes, false));
+		REQUIRE(rebuiltBytes == bytes);
+
+		return CityHash::Hash64((char const*) bytes.data(), bytes.size());
+	};
+
+	TacticalMapBuildStats wholeStats;
+	uint64_t const wholeHash = buildHash(32, wholeStats);
+	REQUIRE(wholeStats.regionsBuilt == 1);
+
+	for(uint32_t const regionSize : {4u, 7u, 16u})
+	{
+		TacticalMapBuildStats stats;
+		REQUIRE(buildHash(regionSize, stats) == wholeHash);
+
+		uint32_t const regionsWide = (32 + regionSize - 1) / regionSize;
+		REQUIRE(stats.regionsBuilt == regionsWide * regionsWide);
+		REQUIRE(stats.threadBusy.size() == std::max(g_EnkiTS.GetNumTaskThreads(), 1u));
+		REQUIRE(stats.peakFragmentBytes > 0);
+
+		REQUIRE(stats.fragments >= 0.0);
+		REQUIRE(stats.smoothing >= 0.0);
+		REQUIRE(stats.planes >= 0.0);
+		REQUIRE(stats.destruction >= 0.0);
+		double busy = 0;
+		for(double const threadBusy : stats.threadBusy)
+		{
+			REQUIRE(threadBusy >= 0.0);
+			busy += threadBusy;
+		}
+		REQUIRE(busy >= stats.fragments + stats.smoothing + stats.planes + stats.destruction - 1e-6);
+
+		double const phases = stats.binTriangles + stats.insertSolidBoxes + stats.structuralBoxes + stats.layers + stats.writeMap;
+		REQUIRE(stats.total > 0.0);
+		REQUIRE(stats.total >= phases - 1e-6);
+	}
+}
+
+TEST_CASE("Binned triangles include every triangle a tiles rays hit", "[TacticalMap/Builder]")
+{
+	// binning is split across the shared task threads
+	Core::InitSharedTasks();
+
+	TacticalMapLevelDataHeader levelData{};
+	levelData.nameCrc = 1;
+	Math::mat4x4 const identity(1.0f);
+
+	// a sloped roof turned 45 degrees, a diagonal wall and a roof whose corners are on tile corners
+	auto builder = TacticalMap::allocateBuilder(Math::vec2(-16, -16), 32, 32, "binning");
+	builder->addMeshAt(CreateGround(16.0f), &levelData, identity);
+	builder->addMeshAt(CreateQuad(Math::vec3(-14, 2, 0), Math::vec3(0, 2, 14), Math::vec3(14, 6, 0), Math::vec3(0, 6, -14)),
+					   &levelData, identity);
+	builder->addMeshAt(CreateQuad(Math::vec3(-12, 0, -12), Math::vec3(12, 0, 12), Math::vec3(12, 4, 12), Math::vec3(-12, 4, -12)),
+					   &levelData, identity);
+	builder->addMeshAt(CreateQuad(Math::vec3(-8, 8, -8), Math::vec3(-8, 8, 5), Math::vec3(5, 9, 5), Math::vec3(5, 9, -8)),
+					   &levelData, identity);
+	REQUIRE(builder->build());
+
+	// the same rays the fragment phase fires, against every triangle
+	using namespace MeshMod;
+	auto const& tmb = static_cast<TacticalMapBuilder const&>(*builder);
+	size_t binnedCount = 0;
+	size_t rectangleCount = 0;
+	size_t hitCount = 0;
+	size_t missedHits = 0;
+	VertexIndexContainer indices;
+	for(auto z = 0; z < tmb.getHeight(); ++z)
+	{
+		for(auto x = 0; x < tmb.getWidth(); ++x)
+		{
+			std::set<std::pair<size_t, uint32_t>> binned;
+			tmb.visitTileTriangles(tmb.tileBuilders[z * tmb.getWidth() + x], [&binned](size_t solidIndex_, PolygonIndex polygonIndex_)
+			{
+				binned.emplace(solidIndex_, uint32_t(polygonIndex_));
+			});
+			binnedCount += binned.size();
+
+			Math::vec2 const lb = tmb.getBottomLeft() + Math::vec2(float(x), float(z));
+			for(size_t solidIndex = 0; solidIndex < tmb.solids.size(); ++solidIndex)
+			{
+				auto const& mesh = tmb.solids[solidIndex].mesh;
+				if(!mesh) continue;
+				Polygons const& polygons = mesh->getPolygons();
+				for(uint32_t p = 0; p < polygons.getCount(); ++p)
+				{
+					indices.clear();
+					polygons.getVertexIndices(PolygonIndex(p), indices);
+					Math::vec3 const v0 = mesh->getVertices().position(indices[0]).getVec3();
+					Math::vec3 const v1 = mesh->getVertices().position(indices[1]).getVec3();
+					Math::vec3 const v2 = mesh->getVertices().position(indices[2]).getVec3();
+					Math::vec3 const lo = Math::min(v0, Math::min(v1, v2));
+					Math::vec3 const hi = Math::max(v0, Math::max(v1, v2));
+					if(lo.x <= lb.x + 1 && hi.x >= lb.x && lo.z <= lb.y + 1 && hi.z >= lb.y) rectangleCount++;
+
+					for(int sz = 0; sz < fragmentSubSamples; ++sz)
+					{
+						for(int sx = 0; sx < fragmentSubSamples; ++sx)
+						{
+							Math::vec3 const origin(lb.x + float(sx) / fragmentSubSamples, -100.0f, lb.y + float(sz) / fragmentSubSamples);
+							Geometry::WaterTightRay const ray(origin, Math::vec3(0, 1, 0));
+							float u, v, t;
+							if(!ray.intersectsTriangle(v0, v1, v2, u, v, t)) continue;
+							hitCount++;
+							if(binned.count({ solidIndex, p }) == 0) missedHits++;
+						}
+					}
+				}
+			}
+		}
+	}
+	REQUIRE(hitCount > 0);
+	REQUIRE(missedHits == 0);
+	// the diagonals don't touch most of the tiles in their rectangles
+	REQUIRE(binnedCount < rectangleCount * 3 / 4);
+}
+
+TEST_CASE("Analytic box fragments match ray casting", "[TacticalMap/Builder]")
+{
+	Core::InitSharedTasks();
+
+	TacticalMapLevelDataHeader levelData{};
+	levelData.nameCrc = 1;
+	Math::mat4x4 const identity(1.0f);
+	Math::mat4x4 const turned = Math::translate(identity, Math::vec3(3.3f, 0.5f, -2.7f)) *
+								Math::rotate(identity, Math::degreesToRadians(90.0f), Math::vec3(0, 1, 0));
+
+	// off and on the sample grid, stacked, slivers thinner than a sample and a turned box
+	std::pair<Geometry::AABB, Math::mat4x4> const boxes[] = {
+			{ Geometry::AABB(Math::vec3(-12, -1, -12), Math::vec3(12, 0, 12)), identity },
+			{ Geometry::AABB(Math::vec3(-3.3f, 0.2f, -7.9f), Math::vec3(4.05f, 2.5f, -1.5f)), identity },
+			{ Geometry::AABB(Math::vec3(-2, 2.5f, -6), Math::vec3(2.5f, 3.75f, -2.0625f)), identity },
+			{ Geometry::AABB(Math::vec3(5.01f, 0, 5.01f), Math::vec3(5.03f, 4, 9.7f)), identity },
+			{ Geometry::AABB(Math::vec3(-1, 0, -2), Math::vec3(1, 1.5f, 3)), turned },
+			{ Geometry::AABB(Math::vec3(-10.5f, 1, 6.25f), Math::vec3(-4.125f, 5, 10.5f)), identity },
+	};
+
+	std::shared_ptr<TacticalMap> maps[2];
+	for(int i = 0; i < 2; ++i)
+	{
+		auto builder = TacticalMap::allocateBuilder(Math::vec2(-12, -12), 24, 24, "boxes");
+		builder->setValidateBoxFragments(i == 1);
+		for(auto const& [box, transform] : boxes)
+		{
+			builder->addBoxAt(box, &levelData, transform);
+		}
+		maps[i] = builder->build();
+		REQUIRE(maps[i]);
+		REQUIRE(static_cast<TacticalMapBuilder const&>(*builder).getBoxFragmentMismatches() == 0);
+	}
+	// validating only checks, it doesn't change the map
+	REQUIRE(SaveMap(maps[0]) == SaveMap(maps[1]));
+}
+
+TEST_CASE("Height fragments are compact and pooled per thread", "[TacticalMap/Builder]")
+{
+	Core::InitSharedTasks();
+
+	// an octahedral normal, the height and a 32 bit solid index
+	REQUIRE(sizeof(TMapTBHeightFragment) == 12);
+	Math::vec3 const normals[] = { { 0, 1, 0 }, { 0, -1, 0 }, Math::Normalise(Math::vec3(0.3f, 0.8f, -0.2f)),
+								   Math::Normalise(Math::vec3(-0.6f, -0.5f, 0.6f)) };
+	for(auto const& n : normals)
+	{
+		TMapTBHeightFragment const fragment(n, -3.25f, 70000);
+		REQUIRE(Math::Length(fragment.normal() - n) < 1e-3f);
+		REQUIRE(fragment.t == -3.25f);
+		REQUIRE(fragment.solidIndex == 70000);
+	}
+
+	// blocks never move, so everything handed out stays put and intact until reset
+	TMapTBFragmentArena arena;
+	std::vector<std::pair<uint8_t*, size_t>> allocs;
+	for(size_t i = 0; i < 5000; ++i)
+	{
+		size_t const size = 1 + (i * 7919) % 4093;
+		uint8_t* ptr = arena.alloc(size);
+		REQUIRE(((uintptr_t) ptr & 3) == 0);
+		std::memset(ptr, int(i & 0xFF), size);
+		allocs.emplace_back(ptr, size);
+	}
+	uint8_t* const big = arena.alloc(TMapTBFragmentArena::BlockSize + 5);
+	std::memset(big, 0xAB, TMapTBFragmentArena::BlockSize + 5);
+	for(size_t i = 0; i < allocs.size(); ++i)
+	{
+		auto const [ptr, size] = allocs[i];
+		REQUIRE(ptr[0] == uint8_t(i & 0xFF));
+		REQUIRE(ptr[size - 1] == uint8_t(i & 0xFF));
+	}
+	REQUIRE(arena.getAllocatedBytes() > TMapTBFragmentArena::BlockSize * 2);
+	arena.reset();
+	REQUIRE(arena.getAllocatedBytes() == 0);
+
+	// fragments only live while their region is built
+	TacticalMapLevelDataHeader levelData{};
+	levelData.nameCrc = 1;
+	Math::mat4x4 const identity(1.0f);
+	auto builder = TacticalMap::allocateBuilder(Math::vec2(-8, -8), 16, 16, "pooled");
+	builder->setValidateBoxFragments(true);
+	builder->addMeshAt(CreateGround(8.0f), &levelData, identity);
+	builder->addMeshAt(CreateQuad(Math::vec3(-6, 2, -6), Math::vec3(-6, 3, 6), Math::vec3(6, 3, 6), Math::vec3(6, 2, -6)),
+					   &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(-2, 0, -2), Math::vec3(3, 1.5f, 1)), &levelData, identity);
+	REQUIRE(builder->build());
+	auto const& tmb = static_cast<TacticalMapBuilder const&>(*builder);
+	REQUIRE(tmb.getBoxFragmentMismatches() == 0);
+	REQUIRE(builder->getBuildStats().peakFragmentBytes > 0);
+	for(auto const& tileBuilder : tmb.tileBuilders)
+	{
+		REQUIRE(tileBuilder.fragmentStarts == nullptr);
+		REQUIRE(tileBuilder.fragments == nullptr);
+	}
+}
+
+TEST_CASE("Region builds match a whole map build", "[TacticalMap/Builder]")
+{
+	// regions are scheduled across the shared task threads
+	Core::InitSharedTasks();
+
+	TacticalMapLevelDataHeader levelData{};
+	levelData.nameCrc = 1;
+	Math::mat4x4 const identity(1.0f);
+
+	// things smooth across region edges and a size that doesn't split evenly
+	auto const build = [&](uint32_t regionSize_)
+	{
+		auto builder = TacticalMap::allocateBuilder(Math::vec2(-15, -13), 30, 26, "regions");
+		builder->setRegionSize(regionSize_);
+		builder->addMeshAt(CreateQuad(Math::vec3(-15, 0, -13), Math::vec3(-15, 3, 13), Math::vec3(15, 1, 13), Math::vec3(15, -2, -13)),
+						   &levelData, identity);
+		builder->addMeshAt(CreateQuad(Math::vec3(-9, 6, 0), Math::vec3(0, 6, 9), Math::vec3(9, 8, 0), Math::vec3(0, 8, -9)),
+						   &levelData, identity);
+		builder->addBoxAt(Geometry::AABB(Math::vec3(-4.5f, 2, -6.5f), Math::vec3(7.5f, 2.5f, 2.5f)), &levelData, identity);
+		builder->addBoxAt(Geometry::AABB(Math::vec3(-12, 3, 4), Math::vec3(-7, 4.5f, 11)), &levelData, identity);
+		auto const map = builder->build();
+		REQUIRE(map);
+		uint32_t const regionsWide = (30 + regionSize_ - 1) / regionSize_;
+		uint32_t const regionsHigh = (26 + regionSize_ - 1) / regionSize_;
+		REQUIRE(builder->getBuildStats().regionsBuilt == regionsWide * regionsHigh);
+		return SaveMap(map);
+	};
+
+	auto const whole = build(64);
+	for(uint32_t const regionSize : { 1u, 3u, 7u, 16u })
+	{
+		REQUIRE(build(regionSize) == whole);
+	}
+}
+
+TEST_CASE("Rebuilds with the same level counts leave earlier maps alone", "[TacticalMap/Builder]")
+{
+	Core::InitSharedTasks();
+
+	TacticalMapLevelDataHeader levelData{};
+	levelData.nameCrc = 1;
+	Math::mat4x4 const identity(1.0f);
+	Geometry::AABB const box(Math::vec3(-3, 0, -3), Math::vec3(3, 2, 3));
+	Math::mat4x4 const raised = Math::scale(identity, Math::vec3(1, 1.25f, 1));
+
+	auto builder = TacticalMap::allocateBuilder(Math::vec2(-8, -8), 16, 16, "rebuild");
+	builder->addMeshAt(CreateGround(8.0f), &levelData, identity);
+	uint32_t const boxId = builder->addBoxAt(box, &levelData, identity);
+	auto const first = builder->build();
+	REQUIRE(first);
+	auto const firstBytes = SaveMap(first);
+
+	// a damaged version shares the first maps levels
+	Geometry::AABB const blast(Math::vec3(-1, 1, -1), Math::vec3(1, 3, 1));
+	auto const damaged = TacticalMap::damageStructures(first, &blast, 1);
+	REQUIRE(damaged);
+	auto const damagedBytes = SaveMap(damaged);
+
+	// a taller box changes heights but not how many levels any tile has
+	builder->updateSolidTransform(boxId, raised);
+	auto const second = builder->build();
+	REQUIRE(second);
+	REQUIRE(second.get() != first.get());
+	for(auto z = 0; z < 16; ++z)
+	{
+		for(auto x = 0; x < 16; ++x)
+		{
+			REQUIRE(second->getTile(x, z).levelCount == first->getTile(x, z).levelCount);
+		}
+	}
+
+	REQUIRE(SaveMap(first) == firstBytes);
+	REQUIRE(SaveMap(damaged) == damagedBytes);
+	TacticalMapVolume volume{};
+	REQUIRE(first->lookupVolumeAtWorld(Math::vec3(0, 2, -1), 1.0f, ~0u, &volume));
+	REQUIRE(volume.levelHeight == Approx(2.0f));
+	REQUIRE(second->lookupVolumeAtWorld(Math::vec3(0, 2.5f, -1), 1.0f, ~0u, &volume));
+	REQUIRE(volume.levelHeight == Approx(2.5f));
+
+	// and the rebuild is what a fresh builder makes
+	auto full = TacticalMap::allocateBuilder(Math::vec2(-8, -8), 16, 16, "rebuild");
+	full->addMeshAt(CreateGround(8.0f), &levelData, identity);
+	full->addBoxAt(box, &levelData, raised);
+	REQUIRE(SaveMap(second) == SaveMap(full->build()));
+}
+
+TEST_CASE("Morton tile layout gives the same lookups as row major", "[TacticalMap/Builder]")
+{
+	Core::InitSharedTasks();
+
+	TacticalMapLevelDataHeader levelData{};
+	levelData.nameCrc = 1;
+	Math::mat4x4 const identity(1.0f);
+	auto const ground = CreateGround(10.0f);
+	Geometry::AABB const box(Math::vec3(-3, 0, -1), Math::vec3(2, 3, 4));
+
+	// 21 tiles doesn't fill the last morton blocks
+	std::shared_ptr<TacticalMap> maps[2];
+	for(int i = 0; i < 2; ++i)
+	{
+		auto builder = TacticalMap::allocateBuilder(Math::vec2(-10.5f, -10.5f), 21, 21, "layout");
+		builder->setTileLayout(i == 0 ? TacticalMapTileLayout::RowMajor : TacticalMapTileLayout::MortonBlocks);
+		builder->addMeshAt(ground, &levelData, identity);
+		builder->addBoxAt(box, &levelData, identity);
+		maps[i] = builder->build();
+		REQUIRE(maps[i]);
+	}
+	REQUIRE(maps[1]->getTileLayout() == TacticalMapTileLayout::MortonBlocks);
+	REQUIRE(maps[1]->getTileCount() == 24 * 24);
+
+	for(float z = -10.0f; z < 10.0f; z += 0.5f)
+	{
+		for(float x = -10.0f; x < 10.0f; x += 0.5f)
+		{
+			for(float y : { 0.0f, 3.0f })
+			{
+				TacticalMapVolume rowMajor{}, morton{};
+				bool const rowMajorHit = maps[0]->lookupVolumeAtWorld(Math::vec3(x, y, z), 1.0f, ~0u, &rowMajor);
+				bool const mortonHit = maps[1]->lookupVolumeAtWorld(Math::vec3(x, y, z), 1.0f, ~0u, &morton);
+				REQUIRE(rowMajorHit == mortonHit);
+				if(!rowMajorHit) continue;
+				REQUIRE(rowMajor.levelHeight == morton.levelHeight);
+				REQUIRE(rowMajor.roofHeight == morton.roofHeight);
+			}
+		}
+	}
+}
+
+TEST_CASE("Tactical map loads in place from memory", "[TacticalMap/Builder]")
+{
+	Core::InitSharedTasks();
+
+	TacticalMapLevelDataHeader levelData{};
+	levelData.nameCrc = 1;
+	Math::mat4x4 const identity(1.0f);
+	auto builder = TacticalMap::allocateBuilder(Math::vec2(-8, -8), 16, 16, "inplace");
+	builder->addMeshAt(CreateGround(8.0f), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(-2, 0, -2), Math::vec3(3, 2, 1)), &levelData, identity);
+	auto const map = builder->build();
+	REQUIRE(map);
+
+	// uncompressed so the map is used where it lies
+	std::vector<uint8_t> bytes;
+	REQUIRE(map->saveTo(0, bytes, false));
+	std::shared_ptr<void> memory(malloc(bytes.size()), &free);
+	std::memcpy(memory.get(), bytes.data(), bytes.size());
+
+	std::vector<std::shared_ptr<TacticalMap>> loaded;
+	REQUIRE(TacticalMap::createFromMemory(memory, (uint8_t*) memory.get(), bytes.size(), loaded));
+	REQUIRE(loaded.size() == 1);
+	REQUIRE(SaveMap(loaded[0]) == SaveMap(map));
+
+	// the map keeps the memory alive
+	memory.reset();
+	TacticalMapVolume volume{};
+	REQUIRE(loaded[0]->lookupVolumeAtWorld(Math::vec3(0, 2, -1), 1.0f, ~0u, &volume));
+	REQUIRE(volume.levelHeight == Approx(2.0f));
+}
+
+TEST_CASE("Heights a map can't hold fail the build and level flags keep all their bits", "[TacticalMap/Builder]")
+{
+	Core::InitSharedTasks();
+
+	TacticalMapLevelDataHeader levelData{};
+	levelData.nameCrc = 1;
+	Math::mat4x4 const identity(1.0f);
+
+	// tile base heights cover +-32768 and levels 2048 above them
+	auto low = TacticalMap::allocateBuilder(Math::vec2(-4, -4), 8, 8, "low");
+	low->addBoxAt(Geometry::AABB(Math::vec3(-2, -40001, -2), Math::vec3(2, -40000, 2)), &levelData, identity);
+	REQUIRE(!low->build());
+	auto tall = TacticalMap::allocateBuilder(Math::vec2(-4, -4), 8, 8, "tall");
+	tall->addBoxAt(Geometry::AABB(Math::vec3(-2, 0, -2), Math::vec3(2, 1, 2)), &levelData, identity);
+	tall->addBoxAt(Geometry::AABB(Math::vec3(-2, 2100, -2), Math::vec3(2, 2101, 2)), &levelData, identity);
+	REQUIRE(!tall->build());
+
+	auto high = TacticalMap::allocateBuilder(Math::vec2(-4, -4), 8, 8, "high");
+	high->addBoxAt(Geometry::AABB(Math::vec3(-2, 899, -2), Math::vec3(2, 900, 2)), &levelData, identity);
+	auto const map = high->build();
+	REQUIRE(map);
+	TacticalMapVolume volume{};
+	REQUIRE(map->lookupVolumeAtWorld(Math::vec3(0, 900, 0), 1.0f, ~0u, &volume));
+	REQUIRE(volume.levelHeight == Approx(900.0f));
+
+	// far from the origin is fine as long as each tile is less than 2048 tall
+	auto far = TacticalMap::allocateBuilder(Math::vec2(-4, -4), 8, 8, "far");
+	far->addBoxAt(Geometry::AABB(Math::vec3(-4, -5001, -4), Math::vec3(-1, -5000.25f, 4)), &levelData, identity);
+	far->addBoxAt(Geometry::AABB(Math::vec3(1, 12000, -4), Math::vec3(4, 12000.5f, 4)), &levelData, identity);
+	auto const farMap = far->build();
+	REQUIRE(farMap);
+	REQUIRE(farMap->lookupVolumeAtWorld(Math::vec3(-2, -5000.25f, 0), 1.0f, ~0u, &volume));
+	REQUIRE(volume.levelHeight == Approx(-5000.25f));
+	REQUIRE(farMap->lookupVolumeAtWorld(Math::vec3(2, 12000.5f, 0), 1.0f, ~0u, &volume));
+	REQUIRE(volume.levelHeight == Approx(12000.5f));
+
+	// flags above the first byte survive a save and load
+	auto const [level, data] = map->mutateLookupAtWorld(Math::vec3(0, 900, 0), 1.0f, ~0u);
+	REQUIRE(level != nullptr);
+	level->flags |= Core::Bit(20);
+	uint32_t const layer = level->layer;
+	std::vector<uint8_t> bytes;
+	REQUIRE(map->saveTo(0, bytes, false));
+	std::shared_ptr<void> memory(malloc(bytes.size()), &free);
+	std::memcpy(memory.get(), bytes.data(), bytes.size());
+	std::vector<std::shared_ptr<TacticalMap>> loaded;
+	REQUIRE(TacticalMap::createFromMemory(memory, (uint8_t*) memory.get(), bytes.size(), loaded));
+	REQUIRE(loaded.size() == 1);
+	auto const found = loaded[0]->lookupAtWorld(Math::vec3(0, 900, 0), 1.0f, ~0u);
+	REQUIRE(found.first != nullptr);
+	REQUIRE((found.first->flags & Core::Bit(20)) != 0);
+	REQUIRE(found.first->layer == layer);
+}
+
+TEST_CASE("Damaged versions leave the map they came from untouched", "[TacticalMap/Builder]")
+{
+	Core::InitSharedTasks();
+
+	TacticalMapLevelDataHeader levelData{};
+	levelData.nameCrc = 1;
+	Math::mat4x4 const identity(1.0f);
+
+	// enough levels for several level data pages
+	auto builder = TacticalMap::allocateBuilder(Math::vec2(-20, -20), 40, 40, "damage");
+	builder->addMeshAt(CreateGround(20.0f), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(-6, 0, -6), Math::vec3(6, 2, 6)), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(10, 0, 10), Math::vec3(14, 2, 14)), &levelData, identity);
+	auto const built = builder->build();
+	REQUIRE(built);
+
+	// box tops become floors that take one hit without collapsing
+	for(float z = -20.0f; z < 20.0f; z += 1.0f)
+	{
+		for(float x = -20.0f; x < 20.0f; x += 1.0f)
+		{
+			auto const [level, data] = built->mutateLookupAtWorld(Math::vec3(x, 2, z), 0.5f, ~0u);
+			if(level == nullptr) continue;
+			data->structuralType = StructuralType::Floor;
+			data->structuralIntegrity = 3;
+		}
+	}
+	std::shared_ptr<TacticalMap const> const map = built;
+	auto const original = SaveMap(built);
+
+	Geometry::AABB const blasts[] = {
+			Geometry::AABB(Math::vec3(-2, 2, -2), Math::vec3(1, 4, 1)),
+			Geometry::AABB(Math::vec3(0, 2, 0), Math::vec3(2, 4, 2)),
+	};
+	auto const damaged = TacticalMap::damageStructures(map, blasts, 2);
+	REQUIRE(damaged);
+	REQUIRE(SaveMap(damaged) != original);
+	REQUIRE(SaveMap(built) == original);
+
+	// the order of the boxes doesn't matter
+	Geometry::AABB const reversed[] = { blasts[1], blasts[0] };
+	REQUIRE(SaveMap(TacticalMap::damageStructures(map, reversed, 2)) == SaveMap(damaged));
+
+	// a tile both blasts hit is only damaged once, and ones in neither aren't touched
+	auto const integrityAt = [](std::shared_ptr<TacticalMap const> const& map_, float x_, float z_)
+	{
+		TacticalMapLevelDataHeader data{};
+		REQUIRE(map_->lookupLevelDataAtWorld(Math::vec3(x_, 2, z_), 0.25f, ~0u, &data));
+		return data.structuralIntegrity;
+	};
+	REQUIRE(integrityAt(damaged, -1.0f, -1.0f) == 2);
+	REQUIRE(integrityAt(damaged, 1.0f, 1.0f) == 2);
+	REQUIRE(integrityAt(damaged, 0.0f, 0.0f) == 2);
+	REQUIRE(integrityAt(damaged, 1.0f, -1.0f) == 3);
+	REQUIRE(integrityAt(damaged, -1.0f, 1.0f) == 3);
+
+	// versions of versions only change the new one, and match the same damage done in place
+	auto const damagedBytes = SaveMap(damaged);
+	std::string const bytes(damagedBytes.begin(), damagedBytes.end());
+	std::istringstream in(bytes);
+	std::vector<std::shared_ptr<TacticalMap>> copies;
+	REQUIRE(TacticalMap::createFromStream(in, copies));
+	Geometry::AABB const second(Math::vec3(11, 2, 11), Math::vec3(12, 4, 12));
+	auto const damagedAgain = TacticalMap::damageStructures(damaged, &second, 1);
+	copies[0]->damageStructure(second);
+	REQUIRE(SaveMap(damagedAgain) == SaveMap(copies[0]));
+	REQUIRE(SaveMap(damaged) == damagedBytes);
+
+	REQUIRE(integrityAt(map, 11.0f, 11.0f) == 3);
+	REQUIRE(integrityAt(damagedAgain, 11.0f, 11.0f) == 2);
+}
+
+TEST_CASE("Pathfinder goes around gaps and repairs after damage", "[TacticalMap/Pathfinder]")
+{
+	Core::InitSharedTasks();
+
+	TacticalMapLevelDataHeader levelData{};
+	levelData.nameCrc = 1;
+	Math::mat4x4 const identity(1.0f);
+
+	// ground with a trench across it, bridged at its north end
+	auto builder = TacticalMap::allocateBuilder(Math::vec2(-24, -24), 48, 48, "paths");
+	builder->addBoxAt(Geometry::AABB(Math::vec3(-24, -1, -24), Math::vec3(-2, 0, 24)), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(2, -1, -24), Math::vec3(24, 0, 24)), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(-2, -1, 10), Math::vec3(2, 0, 24)), &levelData, identity);
+	auto const built = builder->build();
+	REQUIRE(built);
+
+	// a strip of weak ground the far side of the wall
+	for(float z = -24.0f; z < 24.0f; z += 1.0f)
+	{
+		for(float x = 14.0f; x < 16.0f; x += 1.0f)
+		{
+			auto const [level, data] = built->mutateLookupAtWorld(Math::vec3(x, 0, z), 0.5f, ~0u);
+			if(level == nullptr) continue;
+			data->structuralType = StructuralType::Floor;
+			data->structuralIntegrity = 2;
+		}
+	}
+	std::shared_ptr<TacticalMap const> const map = built;
+
+	TacticalMapPathSettings settings;
+	settings.clusterSize = 8;
+	auto pathfinder = TacticalMap::allocatePathfinder(map, settings);
+	REQUIRE(pathfinder->getPortalCount() > 0);
+
+	TacticalMapPathQuery const queries[] = {
+			{Math::vec3(-10, 0, -10), Math::vec3(10, 0, -10)},
+			{Math::vec3(-10, 0, -10), Math::vec3(20, 0, -10)},
+			{Math::vec3(-20, 0, -20), Math::vec3(-18, 0, -17)},
+	};
+	TacticalMapPath paths[3];
+	for(int i = 0; i < 3; ++i)
+	{
+		REQUIRE(pathfinder->findPath(queries[i], paths[i]));
+	}
+	REQUIRE(paths[0].cost > 20.0f);
+	REQUIRE(paths[2].cost == Approx(1.0f + 2.0f * 1.41421356f));
+	for(auto const& point : paths[0].points)
+	{
+		bool const inTrench = point.x > -1.5f && point.x < 1.5f && point.z < 9.5f;
+		REQUIRE(!inTrench);
+	}
+	REQUIRE(paths[0].points.front().x == Approx(-10.0f));
+	REQUIRE(paths[0].points.back().x == Approx(10.0f));
+
+	TacticalMapPath batchPaths[3];
+	auto batch = pathfinder->findPathsAsync(queries, 3, batchPaths);
+	batch->wait();
+	REQUIRE(batch->isComplete());
+	for(int i = 0; i < 3; ++i)
+	{
+		REQUIRE(batchPaths[i].found);
+		REQUIRE(batchPaths[i].cost == paths[i].cost);
+		REQUIRE(batchPaths[i].points.size() == paths[i].points.size());
+	}
+
+	// the same map rebuilds nothing, collapsing the strip only rebuilds the clusters it's in
+	REQUIRE(pathfinder->updateMap(map) == 0);
+	Geometry::AABB const blast(Math::vec3(13.5f, 0, -24), Math::vec3(15.5f, 2, 24));
+	auto const damaged = TacticalMap::damageStructures(map, &blast, 1);
+	REQUIRE(damaged);
+	uint32_t const rebuilt = pathfinder->updateMap(damaged);
+	REQUIRE(rebuilt > 0);
+	REQUIRE(rebuilt < 36);
+
+	// repaired portals match a pathfinder made from scratch
+	auto fresh = TacticalMap::allocatePathfinder(damaged, settings);
+	REQUIRE(fresh->getPortalCount() == pathfinder->getPortalCount());
+	TacticalMapPath path, freshPath;
+	REQUIRE(pathfinder->findPath(queries[0], path));
+	REQUIRE(fresh->findPath(queries[0], freshPath));
+	REQUIRE(path.cost == Approx(freshPath.cost));
+	REQUIRE(!pathfinder->findPath(queries[1], path));
+
+	// batches keep searching the map they started with while another thread updates the pathfinder,
+	// single queries during the update see one map or the other
+	Core::InitSharedTasks();
+	auto shared = TacticalMap::allocatePathfinder(map, settings);
+	std::vector<TacticalMapPathQuery> const crossings(256, queries[1]);
+	std::vector<TacticalMapPath> crossingPaths(crossings.size());
+	auto crossingBatch = shared->findPathsAsync(crossings.data(), crossings.size(), crossingPaths.data());
+	int torn = 0;
+	std::thread reader([&]()
+	{
+		for(int i = 0; i < 64; ++i)
+		{
+			TacticalMapPath readerPath;
+			bool const found = shared->findPath(queries[1], readerPath);
+			if(found && readerPath.cost != paths[1].cost) torn++;
+		}
+	});
+	std::thread updater([&]() { shared->updateMap(damaged); });
+	updater.join();
+	reader.join();
+	crossingBatch->wait();
+	REQUIRE(torn == 0);
+	for(auto const& crossingPath : crossingPaths)
+	{
+		REQUIRE(crossingPath.found);
+		REQUIRE(crossingPath.cost == paths[1].cost);
+	}
+	REQUIRE(shared->getPortalCount() == fresh->getPortalCount());
+	REQUIRE(!shared->findPath(queries[1], path));
+}
+
+TEST_CASE("Virtual stitches look up the same as built ones", "[TacticalMap/Stitcher]")
+{
+	Core::InitSharedTasks();
+
+	TacticalMapLevelDataHeader levelData{};
+	levelData.nameCrc = 1;
+	Math::mat4x4 const identity(1.0f);
+
+	auto builder = TacticalMap::allocateBuilder(Math::vec2(-8, -8), 16, 16, "parcel");
+	builder->addBoxAt(Geometry::AABB(Math::vec3(-8, -1, -8), Math::vec3(8, 0, 8)), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(-6, 2, -3), Math::vec3(1, 3, 5)), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(2, 0, 2), Math::vec3(5, 4, 7)), &levelData, identity);
+	std::shared_ptr<TacticalMap const> const parcel = builder->build();
+	REQUIRE(parcel);
+
+	// every quarter turn and an instance overlapping the others
+	auto stitcher = TacticalMap::allocateStitcher("stitched");
+	int const rotations[] = {0, 90, 180, 270, -90, 450};
+	for(int i = 0; i < 6; ++i)
+	{
+		stitcher->addTacticalMapInstance(parcel, Math::vec3((i % 3) * 16, 0, (i / 3) * 16), rotations[i], i + 1);
+	}
+	stitcher->addTacticalMapInstance(parcel, Math::vec3(8, 0, 8), 90, 7);
+	auto const built = stitcher->build();
+	auto const stitched = stitcher->buildVirtual();
+	REQUIRE(built);
+	REQUIRE(stitched);
+	REQUIRE(stitched->getWidth() == built->getWidth());
+	REQUIRE(stitched->getHeight() == built->getHeight());
+
+	Math::vec2 const bottomLeft = built->getBottomLeft();
+	for(float z = bottomLeft.y - 1; z < bottomLeft.y + built->getHeight() + 1; z += 0.7f)
+	{
+		for(float x = bottomLeft.x - 1; x < bottomLeft.x + built->getWidth() + 1; x += 0.7f)
+		{
+			for(float y = -1; y < 6; y += 1.5f)
+			{
+				TacticalMapVolume volume, virtualVolume;
+				TacticalMapLevelDataHeader data{}, virtualData{};
+				bool const found = built->lookupVolumeAtWorld(Math::vec3(x, y, z), 1.0f, ~0u, &volume);
+				REQUIRE(stitched->lookupVolumeAtWorld(Math::vec3(x, y, z), 1.0f, ~0u, &virtualVolume) == found);
+				REQUIRE(built->lookupLevelDataAtWorld(Math::vec3(x, y, z), 1.0f, ~0u, &data) == found);
+				REQUIRE(stitched->lookupLevelDataAtWorld(Math::vec3(x, y, z), 1.0f, ~0u, &virtualData) == found);
+				if(!found) continue;
+
+				REQUIRE(volume.levelHeight == virtualVolume.levelHeight);
+				REQUIRE(volume.roofHeight == virtualVolume.roofHeight);
+				REQUIRE(data.instance == virtualData.instance);
+				REQUIRE(data.levelNum == virtualData.levelNum);
+			}
+		}
+	}
+}
+
+TEST_CASE("Line of sight and cover through tactical map levels", "[TacticalMap/Sight]")
+{
+	Core::InitSharedTasks();
+
+	TacticalMapLevelDataHeader levelData{};
+	levelData.nameCrc = 1;
+	TacticalMapLevelDataHeader slabData = levelData;
+	slabData.layer = 1;
+	Math::mat4x4 const identity(1.0f);
+
+	// ground either side of a tall wall with gaps at both ends, a low wall and a slab floating over the ground
+	auto builder = TacticalMap::allocateBuilder(Math::vec2(-24, -24), 48, 48, "sight");
+	builder->addBoxAt(Geometry::AABB(Math::vec3(-24, -1, -24), Math::vec3(-2, 0, 24)), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(-2, -1, -10), Math::vec3(2, 3, 10)), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(-2, -1, -24), Math::vec3(2, 0, -10)), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(-2, -1, 10), Math::vec3(2, 0, 24)), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(2, -1, -24), Math::vec3(10, 0, 24)), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(10, -1, -24), Math::vec3(11, 1, 24)), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(11, -1, -24), Math::vec3(24, 0, 24)), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(14, 2.5f, -24), Math::vec3(18, 3, -14)), &slabData, identity);
+	auto const map = builder->build();
+	REQUIRE(map);
+
+	uint32_t const all = ~0u;
+	REQUIRE(map->traceLineOfSight(Math::vec3(-10, 1.5f, 0), Math::vec3(-5, 1.5f, 0), all));
+	float blockedAt = -1.0f;
+	REQUIRE(!map->traceLineOfSight(Math::vec3(-10, 1.5f, 0), Math::vec3(6, 1.5f, 0), all, &blockedAt));
+	REQUIRE(blockedAt > 0.3f);
+	REQUIRE(blockedAt < 0.6f);
+	REQUIRE(map->traceLineOfSight(Math::vec3(-10, 5, 0), Math::vec3(6, 5, 0), all));
+	REQUIRE(map->traceLineOfSight(Math::vec3(-10, 1.5f, 15), Math::vec3(6, 1.5f, 15), all));
+	REQUIRE(!map->traceLineOfSight(Math::vec3(-10, -0.5f, 15), Math::vec3(-5, -0.5f, 15), all));
+	// off the map is open
+	REQUIRE(map->traceLineOfSight(Math::vec3(-40, 1.5f, 0), Math::vec3(-30, 1.5f, 30), all));
+
+	// under, through and over the slab, which doesn't block when masked out
+	REQUIRE(map->traceLineOfSight(Math::vec3(12, 1, -20), Math::vec3(20, 1, -20), all));
+	REQUIRE(!map->traceLineOfSight(Math::vec3(12, 2.75f, -20), Math::vec3(20, 2.75f, -20), all));
+	REQUIRE(map->traceLineOfSight(Math::vec3(12, 4, -20), Math::vec3(20, 4, -20), all));
+	REQUIRE(map->traceLineOfSight(Math::vec3(12, 2.75f, -20), Math::vec3(20, 2.75f, -20), ~Core::Bit(1)));
+
+	REQUIRE(map->queryCover(Math::vec3(-10, 0, 15), Math::vec3(-5, 1.5f, 15), 1.8f, all) == 0.0f);
+	REQUIRE(map->queryCover(Math::vec3(-6, 0, 0), Math::vec3(6, 1.5f, 0), 1.8f, all) == 1.0f);
+	float const lowCover = map->queryCover(Math::vec3(12, 0, 0), Math::vec3(4, 1.5f, 0), 1.8f, all);
+	REQUIRE(lowCover > 0.0f);
+	REQUIRE(lowCover < 1.0f);
+
+	// batches match the single queries, enough of them to be split across threads
+	std::vector<TacticalMapSightQuery> queries(3000);
+	srand(42);
+	auto const randomPoint = []()
+	{
+		return Math::vec3((rand() % 5200) / 100.0f - 26.0f, (rand() % 500) / 100.0f - 0.5f, (rand() % 5200) / 100.0f - 26.0f);
+	};
+	for(auto& query : queries)
+	{
+		query.from = randomPoint();
+		query.to = randomPoint();
+	}
+	std::vector<uint8_t> visible(queries.size());
+	std::vector<float> cover(queries.size());
+	size_t const visibleCount = map->traceLineOfSightBatch(queries.data(), queries.size(), all, visible.data());
+	size_t const hiddenCount = map->queryCoverBatch(queries.data(), queries.size(), 1.8f, all, cover.data());
+	REQUIRE(visibleCount > 0);
+	REQUIRE(visibleCount < queries.size());
+	size_t singleVisible = 0, singleHidden = 0;
+	for(size_t i = 0; i < queries.size(); ++i)
+	{
+		bool const clear = map->traceLineOfSight(queries[i].from, queries[i].to, all);
+		REQUIRE(visible[i] == (clear ? 1 : 0));
+		float const single = map->queryCover(queries[i].to, queries[i].from, 1.8f, all);
+		REQUIRE(cover[i] == single);
+		if(clear) singleVisible++;
+		if(single >= 1.0f) singleHidden++;
+	}
+	REQUIRE(visibleCount == singleVisible);
+	REQUIRE(hiddenCount == singleHidden);
+
+	// a slab worn through by damage stops blocking in the damaged version only
+	for(float z = -24.0f; z < -14.0f; z += 1.0f)
+	{
+		for(float x = 14.0f; x < 18.0f; x += 1.0f)
+		{
+			auto const [level, data] = map->mutateLookupAtWorld(Math::vec3(x, 3, z), 0.25f, Core::Bit(1));
+			if(level == nullptr) continue;
+			data->structuralType = StructuralType::Floor;
+			data->structuralIntegrity = 2;
+		}
+	}
+	Geometry::AABB const blast(Math::vec3(14, 3, -24), Math::vec3(18, 5, -14));
+	auto const damaged = TacticalMap::damageStructures(map, &blast, 1);
+	REQUIRE(damaged);
+	REQUIRE(damaged->traceLineOfSight(Math::vec3(12, 2.75f, -20), Math::vec3(20, 2.75f, -20), all));
+	REQUIRE(damaged->traceLineOfSight(Math::vec3(12, 1, -20), Math::vec3(20, 4, -20), all));
+	REQUIRE(!map->traceLineOfSight(Math::vec3(12, 2.75f, -20), Math::vec3(20, 2.75f, -20), all));
+	REQUIRE(!map->traceLineOfSight(Math::vec3(12, 1, -20), Math::vec3(20, 4, -20), all));
+	REQUIRE(!damaged->traceLineOfSight(Math::vec3(-10, 1.5f, 0), Math::vec3(6, 1.5f, 0), all));
+
+	// levels flagged destroyed don't block either
+	for(float z = -24.0f; z < -14.0f; z += 1.0f)
+	{
+		for(float x = 14.0f; x < 18.0f; x += 1.0f)
+		{
+			auto const [level, data] = map->mutateLookupAtWorld(Math::vec3(x, 3, z), 0.25f, Core::Bit(1));
+			if(level != nullptr) level->flags |= TacticalMapLevelFlags::Destroyed;
+		}
+	}
+	REQUIRE(map->traceLineOfSight(Math::vec3(12, 2.75f, -20), Math::vec3(20, 2.75f, -20), all));
+}
+
+TEST_CASE("Batches match single queries from any thread", "[TacticalMap/Sight]")
+{
+	Core::InitSharedTasks();
+
+	TacticalMapLevelDataHeader levelData{};
+	levelData.nameCrc = 1;
+	TacticalMapLevelDataHeader slabData = levelData;
+	slabData.layer = 1;
+	Math::mat4x4 const identity(1.0f);
+
+	auto builder = TacticalMap::allocateBuilder(Math::vec2(-24, -24), 48, 48, "batches");
+	builder->addBoxAt(Geometry::AABB(Math::vec3(-24, -1, -24), Math::vec3(-2, 0, 24)), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(-2, -1, -10), Math::vec3(2, 3, 10)), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(2, -1, -24), Math::vec3(24, 0, 24)), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(14, 2.5f, -24), Math::vec3(18, 3, -14)), &slabData, identity);
+	std::shared_ptr<TacticalMap const> const map = builder->build();
+	REQUIRE(map);
+	TacticalMapPathSettings settings;
+	settings.clusterSize = 8;
+	auto pathfinder = TacticalMap::allocatePathfinder(map, settings);
+
+	// enough of each to be split across the task threads
+	srand(7);
+	auto const randomPoint = []()
+	{
+		return Math::vec3((rand() % 5200) / 100.0f - 26.0f, (rand() % 400) / 100.0f - 0.5f, (rand() % 5200) / 100.0f - 26.0f);
+	};
+	std::vector<Math::vec3> points(5000);
+	for(auto& point : points) point = randomPoint();
+	std::vector<TacticalMapSightQuery> sights(3000);
+	for(auto& sight : sights)
+	{
+		sight.from = randomPoint();
+		sight.to = randomPoint();
+	}
+	std::vector<TacticalMapPathQuery> pathQueries(64);
+	for(auto& query : pathQueries)
+	{
+		query.start = Math::vec3((rand() % 4400) / 100.0f - 22.0f, 0, (rand() % 4400) / 100.0f - 22.0f);
+		query.goal = Math::vec3((rand() % 4400) / 100.0f - 22.0f, 0, (rand() % 4400) / 100.0f - 22.0f);
+	}
+
+	auto const checkBatches = [&]()
+	{
+		std::vector<TacticalMap::ConstLevelDataPair> pairs(points.size());
+		std::vector<TacticalMapVolume> volumes(points.size());
+		std::vector<uint8_t> visible(sights.size());
+		std::vector<TacticalMapPath> paths(pathQueries.size());
+		map->lookupAtWorldBatch(points.data(), points.size(), 0.5f, ~0u, pairs.data());
+		size_t const hits = map->lookupVolumeAtWorldBatch(points.data(), points.size(), 0.5f, ~0u, volumes.data());
+		map->traceLineOfSightBatch(sights.data(), sights.size(), ~0u, visible.data());
+		pathfinder->findPathsAsync(pathQueries.data(), pathQueries.size(), paths.data())->wait();
+
+		size_t singleHits = 0;
+		size_t mismatches = 0;
+		for(size_t i = 0; i < points.size(); ++i)
+		{
+			if(pairs[i] != map->lookupAtWorld(points[i], 0.5f, ~0u)) mismatches++;
+			TacticalMapVolume volume;
+			if(map->lookupVolumeAtWorld(points[i], 0.5f, ~0u, &volume))
+			{
+				singleHits++;
+				if(volume.levelHeight != volumes[i].levelHeight || volume.roofHeight != volumes[i].roofHeight) mismatches++;
+			}
+			else if(!std::isnan(volumes[i].levelHeight)) mismatches++;
+		}
+		for(size_t i = 0; i < sights.size(); ++i)
+		{
+			if(visible[i] != (map->traceLineOfSight(sights[i].from, sights[i].to, ~0u) ? 1 : 0)) mismatches++;
+		}
+		for(size_t i = 0; i < pathQueries.size(); ++i)
+		{
+			TacticalMapPath path;
+			bool const found = pathfinder->findPath(pathQueries[i], path);
+			if(found != paths[i].found || path.cost != paths[i].cost) mismatches++;
+		}
+		// catch isn't thread safe so everything is counted and checked back on this thread
+		if(hits != singleHits || hits == 0) mismatches++;
+		return mismatches;
+	};
+
+	// on the main thread, which gets to submit to the task threads
+	REQUIRE(checkBatches() == 0);
+
+	// from another thread while this one has the scheduler, so they fall back to running there
+	size_t lockedMismatches = ~size_t(0);
+	{
+		std::lock_guard<std::recursive_mutex> lock(Core::SharedTasksMutex);
+		std::thread other([&]() { lockedMismatches = checkBatches(); });
+		other.join();
+	}
+	REQUIRE(lockedMismatches == 0);
+
+	// and from two threads at once, one of them submits and the other runs its own
+	size_t mismatches[2] = { ~size_t(0), ~size_t(0) };
+	std::thread first([&]() { mismatches[0] = checkBatches(); });
+	std::thread second([&]() { mismatches[1] = checkBatches(); });
+	first.join();
+	second.join();
+	REQUIRE(mismatches[0] == 0);
+	REQUIRE(mismatches[1] == 0);
+}
+
+TEST_CASE("Area summaries match the tiles and follow damage", "[TacticalMap/Summary]")
+{
+	Core::InitSharedTasks();
+
+	TacticalMapLevelDataHeader levelData{};
+	levelData.nameCrc = 1;
+	TacticalMapLevelDataHeader slabData = levelData;
+	slabData.layer = 1;
+	Math::mat4x4 const identity(1.0f);
+
+	// ground with a trench across it and a slab floating over one side, not a multiple of the block size
+	auto builder = TacticalMap::allocateBuilder(Math::vec2(-20, -20), 43, 37, "summary");
+	builder->addBoxAt(Geometry::AABB(Math::vec3(-20, -1, -20), Math::vec3(-2, 0, 17)), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(2, -1, -20), Math::vec3(23, 0, 17)), &levelData, identity);
+	builder->addBoxAt(Geometry::AABB(Math::vec3(8, 2.5f, -12), Math::vec3(14, 3, 4)), &slabData, identity);
+	auto const built = builder->build();
+	REQUIRE(built);
+
+	for(float z = -20.0f; z < 17.0f; z += 1.0f)
+	{
+		for(float x = 14.0f; x < 16.0f; x += 1.0f)
+		{
+			auto const [level, data] = built->mutateLookupAtWorld(Math::vec3(x, 0, z), 0.5f, ~0u);
+			if(level == nullptr) continue;
+			data->structuralType = StructuralType::Floor;
+			data->structuralIntegrity = 2;
+		}
+	}
+	built->updateSummary(built->getAABB());
+	std::shared_ptr<TacticalMap const> const map = built;
+
+	// the same answers by looking at every tile
+	auto const bruteForce = [](TacticalMap const& map_, Geometry::AABB const& box_, uint32_t const levelMask_,
+							   TacticalMapAreaSummary& summary_, bool& any_)
+	{
+		float const highest = std::numeric_limits<float>::max();
+		float const lowest = std::numeric_limits<float>::lowest();
+		summary_ = TacticalMapAreaSummary{ highest, lowest, highest, lowest, 0, 0, 0 };
+		any_ = false;
+		for(auto z = 0; z < map_.getHeight(); ++z)
+		{
+			for(auto x = 0; x < map_.getWidth(); ++x)
+			{
+				Math::vec3 const centre = map_.localToWorld(x, z) + Math::vec3(0.5f, 0, 0.5f);
+				if(centre.x + 0.5f <= box_.getMinExtent().x || centre.x - 0.5f > box_.getMaxExtent().x) continue;
+				if(centre.z + 0.5f <= box_.getMinExtent().z || centre.z - 0.5f > box_.getMaxExtent().z) continue;
+
+				TacticalMapTile const& tile = map_.getTile(x, z);
+				for(auto levelIndex = 0u; levelIndex < tile.levelCount; ++levelIndex)
+				{
+					summary_.levelCount++;
+					if(map_.isLevelDestroyed(tile, levelIndex))
+					{
+						summary_.destroyedCount++;
+						continue;
+					}
+					TacticalMapTileLevel const& level = map_.getLevel(tile, levelIndex);
+					float const floor = TacticalMap::getLevelHeight(tile, level);
+					float const roof = std::min(TacticalMap::getRoofHeight(tile, level), highest);
+					summary_.minFloor = std::min(summary_.minFloor, floor);
+					summary_.maxFloor = std::max(summary_.maxFloor, floor);
+					summary_.minRoof = std::min(summary_.minRoof, roof);
+					summary_.maxRoof = std::max(summary_.maxRoof, roof);
+					summary_.layerMask |= Core::Bit(level.layer);
+					any_ |= (Core::Bit(level.layer) & levelMask_) != 0 &&
+							floor >= box_.getMinExtent().y && floor <= box_.getMaxExtent().y;
+				}
+			}
+		}
+	};
+
+	std::vector<Geometry::AABB> areas;
+	areas.push_back(map->getAABB());
+	srand(43);
+	for(int i = 0; i < 200; ++i)
+	{
+		Math::vec3 const a((rand() % 5000) / 100.0f - 25.0f, (rand() % 600) / 100.0f - 2.0f, (rand() % 4400) / 100.0f - 22.0f);
+		Math::vec3 const b((rand() % 5000) / 100.0f - 25.0f, (rand() % 600) / 100.0f - 2.0f, (rand() % 4400) / 100.0f - 22.0f);
+		areas.push_back(Geometry::AABB(Math::min(a, b), Math::max(a, b)));
+	}
+
+	uint32_t const levelMasks[] = { ~0u, Core::Bit(0), Core::Bit(1), Core::Bit(5) };
+	auto const checkAreas = [&areas, &levelMasks, &bruteForce](TacticalMap const& map_)
+	{
+		for(auto const& area : areas)
+		{
+			for(uint32_t const levelMask : levelMasks)
+			{
+				TacticalMapAreaSummary expected;
+				bool expectedAny;
+				bruteForce(map_, area, levelMask, expected, expectedAny);
+				REQUIRE(map_.anyLevelInArea(area, levelMask) == expectedAny);
+				if(levelMask != ~0u) continue;
+
+				TacticalMapAreaSummary const summary = map_.summariseArea(area);
+				REQUIRE(summary.minFloor == expected.minFloor);
+				REQUIRE(summary.maxFloor == expected.maxFloor);
+				REQUIRE(summary.minRoof == expected.minRoof);
+				REQUIRE(summary.maxRoof == expected.maxRoof);
+				REQUIRE(summary.layerMask == expected.layerMask);
+				REQUIRE(summary.levelCount == expected.levelCount);
+				REQUIRE(summary.destroyedCount == expected.destroyedCount);
+			}
+		}
+	};
+	checkAreas(*map);
+	TacticalMapAreaSummary const whole = map->summariseArea(map->getAABB());
+	REQUIRE(whole.layerMask == (Core::Bit(0) | Core::Bit(1)));
+	REQUIRE(whole.destroyedCount == 0);
+	REQUIRE(!map->anyLevelInArea(Geometry::AABB(Math::vec3(-1, -2, -20), Math::vec3(1, 4, 17)), ~0u));
+
+	// versions get their own summaries, the map they came from keeps its
+	Geometry::AABB const blast(Math::vec3(14, 0, -4), Math::vec3(16, 2, 4));
+	auto const damaged = TacticalMap::damageStructures(map, &blast, 1);
+	REQUIRE(damaged->summariseArea(damaged->getAABB()).destroyedCount > 0);
+	REQUIRE(map->summariseArea(map->getAABB()).destroyedCount == 0);
+	checkAreas(*damaged);
+	checkAreas(*map);
+
+	// in place damage and loading, with and without the summary chunk being used where it lies
+	built->damageStructure(blast);
+	checkAreas(*built);
+	for(bool const compress : { false, true })
+	{
+		std::vector<uint8_t> bytes;
+		REQUIRE(built->saveTo(0, bytes, compress));
+		std::shared_ptr<void> memory(malloc(bytes.size()), &free);
+		std::memcpy(memory.get(), bytes.data(), bytes.size());
+		std::vector<std::shared_ptr<TacticalMap>> loaded;
+		REQUIRE(TacticalMap::createFromMemory(memory, (uint8_t*) memory.get(), bytes.size(), loaded));
+		REQUIRE(loaded.size() == 1);
+		checkAreas(*loaded[0]);
+		loaded[0]->damageStructure(blast);
+		checkAreas(*loaded[0]);
+	}
+}
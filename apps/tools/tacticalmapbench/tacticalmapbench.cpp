@@ -0,0 +1,599 @@
+#include "core/core.h"
+#include "clipp/clipp.h"
+#include "shell/interface.h"
+#include "meshmod/mesh.h"
+#include "meshmod/vertices.h"
+#include "meshmod/polygons.h"
+#include "tacticalmap/tacticalmap.h"
+#include "enkiTS/src/TaskScheduler.h"
+#include "cityhash/city.h"
+#include "picojson/picojson.h"
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <sstream>
+#if PLATFORM == POSIX || PLATFORM == APPLE_MAC
+#include <sys/resource.h>
+#endif
+
+extern enki::TaskScheduler g_EnkiTS;
+
+namespace {
+
+// a query trace file is a QueryTraceHeader followed by frameCount frames.
+// each frame is a QueryTraceFrame followed by queryCount points of 3 floats
+struct QueryTraceHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t frameCount;
+};
+
+struct QueryTraceFrame
+{
+	uint32_t queryCount;
+	float range;
+	uint32_t levelMask;
+};
+
+static uint32_t const QueryTraceMagic = 'T' | ('M' << 8) | ('Q' << 16) | ('T' << 24);
+static uint32_t const QueryTraceVersion = 1;
+
+struct QueryTrace
+{
+	struct Frame
+	{
+		float range;
+		uint32_t levelMask;
+		std::vector<Math::vec3> points;
+	};
+	std::vector<Frame> frames;
+};
+
+auto LoadTrace(std::string const& fileName_, QueryTrace& out_) -> bool
+{
+	std::ifstream in(fileName_, std::ifstream::in | std::ifstream::binary);
+	if(!in) return false;
+
+	QueryTraceHeader header;
+	in.read((char*) &header, sizeof(header));
+	if(!in || header.magic != QueryTraceMagic || header.version != QueryTraceVersion) return false;
+
+	out_.frames.resize(header.frameCount);
+	for(auto& frame : out_.frames)
+	{
+		QueryTraceFrame frameHeader;
+		in.read((char*) &frameHeader, sizeof(frameHeader));
+		if(!in) return false;
+
+		frame.range = frameHeader.range;
+		frame.levelMask = frameHeader.levelMask;
+		frame.points.resize(frameHeader.queryCount);
+		in.read((char*) frame.points.data(), sizeof(Math::vec3) * frame.points.size());
+		if(!in) return false;
+	}
+	return true;
+}
+
+auto SaveTrace(std::string const& fileName_, QueryTrace const& trace_) -> bool
+{
+	std::ofstream out(fileName_, std::ofstream::out | std::ofstream::binary);
+	if(!out) return false;
+
+	QueryTraceHeader const header{ QueryTraceMagic, QueryTraceVersion, (uint32_t) trace_.frames.size() };
+	out.write((char const*) &header, sizeof(header));
+	for(auto const& frame : trace_.frames)
+	{
+		QueryTraceFrame const frameHeader{ (uint32_t) frame.points.size(), frame.range, frame.levelMask };
+		out.write((char const*) &frameHeader, sizeof(frameHeader));
+		out.write((char const*) frame.points.data(), sizeof(Math::vec3) * frame.points.size());
+	}
+	return (bool) out;
+}
+
+// agents move in squads, each squad random walks around the map a little each frame
+auto SynthesiseTrace(TacticalMap const& map_, uint32_t agents_, uint32_t frames_, uint32_t seed_) -> QueryTrace
+{
+	static uint32_t const SquadSize = 8;
+
+	std::mt19937 rng(seed_);
+	Geometry::AABB const aabb = map_.getAABB();
+	Math::vec3 const lo = aabb.getMinExtent();
+	Math::vec3 hi = aabb.getMaxExtent();
+	// the map is open to the sky if any level has no roof
+	hi.y = std::min(hi.y, lo.y + 20.0f);
+
+	std::uniform_real_distribution<float> x(lo.x, hi.x);
+	std::uniform_real_distribution<float> y(lo.y, hi.y);
+	std::uniform_real_distribution<float> z(lo.z, hi.z);
+	std::uniform_real_distribution<float> spread(-3.0f, 3.0f);
+	std::uniform_real_distribution<float> step(-0.5f, 0.5f);
+
+	std::vector<Math::vec3> squads((agents_ + SquadSize - 1) / SquadSize);
+	for(auto& squad : squads)
+	{
+		squad = Math::vec3(x(rng), y(rng), z(rng));
+	}
+	std::vector<Math::vec3> offsets(agents_);
+	for(auto& offset : offsets)
+	{
+		offset = Math::vec3(spread(rng), 0, spread(rng));
+	}
+
+	QueryTrace trace;
+	trace.frames.resize(frames_);
+	for(auto& frame : trace.frames)
+	{
+		for(auto& squad : squads)
+		{
+			squad = Math::clamp(squad + Math::vec3(step(rng), 0, step(rng)), lo, hi);
+		}
+		frame.range = 2.0f;
+		frame.levelMask = ~0u;
+		frame.points.resize(agents_);
+		for(uint32_t i = 0; i < agents_; ++i)
+		{
+			frame.points[i] = Math::clamp(squads[i / SquadSize] + offsets[i], lo, hi);
+		}
+	}
+	return trace;
+}
+
+// a ground plane with random boxes on it
+auto BuildTestMap(int size_, uint32_t boxes_, uint32_t seed_, TacticalMapTileLayout layout_) -> std::shared_ptr<TacticalMap>
+{
+	using namespace MeshMod;
+	float const half = float(size_ / 2) - 1.0f;
+
+	auto ground = std::make_shared<Mesh>("ground", true, true);
+	auto& vertices = ground->getVertices();
+	vertices.add(-half, 0, -half);
+	vertices.add(-half, 0, half);
+	vertices.add(half, 0, half);
+	vertices.add(half, 0, -half);
+	VertexIndexContainer quad{ VertexIndex(0), VertexIndex(1), VertexIndex(2), VertexIndex(3) };
+	ground->getPolygons().addPolygon(quad);
+	ground->updateFromEdits();
+
+	TacticalMapLevelDataHeader levelData{};
+	levelData.nameCrc = 1;
+	Math::mat4x4 const identity(1.0f);
+
+	auto builder = TacticalMap::allocateBuilder(Math::vec2(-size_ / 2, -size_ / 2),
+												(TacticalMap::TileCoord_t) size_,
+												(TacticalMap::TileCoord_t) size_,
+												"tacticalmapbench");
+	builder->setTileLayout(layout_);
+	builder->addMeshAt(ground, &levelData, identity);
+
+	std::mt19937 rng(seed_);
+	std::uniform_real_distribution<float> xz(-half, half);
+	std::uniform_real_distribution<float> y(0.0f, 10.0f);
+	std::uniform_real_distribution<float> extent(0.1f, 3.0f);
+	for(uint32_t i = 0; i < boxes_; ++i)
+	{
+		Math::vec3 const centre(xz(rng), y(rng), xz(rng));
+		Math::vec3 const halfLength(extent(rng), extent(rng), extent(rng));
+		builder->addBoxAt(Geometry::AABB(centre - halfLength, centre + halfLength), &levelData, identity);
+	}
+
+	return builder->build();
+}
+
+auto SameVolume(TacticalMapVolume const& a_, TacticalMapVolume const& b_) -> bool
+{
+	return a_.floorNormal == b_.floorNormal &&
+		   a_.levelHeight == b_.levelHeight &&
+		   a_.roofNormal == b_.roofNormal &&
+		   a_.roofHeight == b_.roofHeight;
+}
+
+// build bench scenes. mt19937s output is fixed by the standard but the distributions aren't,
+// so scenes use this to be the same (and hash the same) with any standard library
+auto RandomRange(std::mt19937& rng_, float lo_, float hi_) -> float
+{
+	return lo_ + (hi_ - lo_) * float(double(rng_()) / 4294967296.0);
+}
+
+enum class BuildScene
+{
+	City,
+	Terrain,
+	Boxes,
+};
+
+auto BuildSceneName(BuildScene scene_) -> char const*
+{
+	switch(scene_)
+	{
+		case BuildScene::City: return "city";
+		case BuildScene::Terrain: return "terrain";
+		case BuildScene::Boxes: return "boxes";
+		default: return "unknown";
+	}
+}
+
+// blocks of buildings with a few storeys each, floors are slabs with gaps between them and the walls
+void AddCity(ITacticalMapBuilder& builder_, int size_, std::mt19937& rng_, TacticalMapLevelDataHeader const* levelData_)
+{
+	static float const BlockSize = 16.0f;
+	static float const StreetWidth = 4.0f;
+	static float const StoreyHeight = 3.0f;
+	static float const SlabThickness = 0.25f;
+	static float const WallThickness = 0.5f;
+
+	Math::mat4x4 const identity(1.0f);
+	float const half = float(size_ / 2);
+	builder_.addBoxAt(Geometry::AABB(Math::vec3(-half, -1.0f, -half), Math::vec3(half, 0.0f, half)), levelData_, identity);
+
+	for(float bz = -half + StreetWidth; bz + BlockSize <= half; bz += BlockSize + StreetWidth)
+	{
+		for(float bx = -half + StreetWidth; bx + BlockSize <= half; bx += BlockSize + StreetWidth)
+		{
+			int const storeys = 1 + int(RandomRange(rng_, 0.0f, 5.0f));
+			float const inset = RandomRange(rng_, 0.0f, 3.0f);
+			Math::vec3 const lo(bx + inset, 0.0f, bz + inset);
+			Math::vec3 const hi(bx + BlockSize - inset, float(storeys) * StoreyHeight, bz + BlockSize - inset);
+
+			for(int storey = 1; storey <= storeys; ++storey)
+			{
+				float const y = float(storey) * StoreyHeight;
+				builder_.addBoxAt(Geometry::AABB(Math::vec3(lo.x + WallThickness, y - SlabThickness, lo.z + WallThickness),
+												 Math::vec3(hi.x - WallThickness, y, hi.z - WallThickness)),
+								  levelData_, identity);
+			}
+			// walls with a door in the south one
+			float const door = (lo.x + hi.x) * 0.5f;
+			builder_.addBoxAt(Geometry::AABB(Math::vec3(lo.x, 0.5f, lo.z), Math::vec3(door - 1.0f, hi.y, lo.z + WallThickness)), levelData_, identity);
+			builder_.addBoxAt(Geometry::AABB(Math::vec3(door + 1.0f, 0.5f, lo.z), Math::vec3(hi.x, hi.y, lo.z + WallThickness)), levelData_, identity);
+			builder_.addBoxAt(Geometry::AABB(Math::vec3(lo.x, 0.5f, hi.z - WallThickness), Math::vec3(hi.x, hi.y, hi.z)), levelData_, identity);
+			builder_.addBoxAt(Geometry::AABB(Math::vec3(lo.x, 0.5f, lo.z + WallThickness), Math::vec3(lo.x + WallThickness, hi.y, hi.z - WallThickness)), levelData_, identity);
+			builder_.addBoxAt(Geometry::AABB(Math::vec3(hi.x - WallThickness, 0.5f, lo.z + WallThickness), Math::vec3(hi.x, hi.y, hi.z - WallThickness)), levelData_, identity);
+		}
+	}
+}
+
+// rolling hills as a mesh with a quad every 2 tiles
+void AddTerrain(ITacticalMapBuilder& builder_, int size_, std::mt19937& rng_, TacticalMapLevelDataHeader const* levelData_)
+{
+	using namespace MeshMod;
+	static int const QuadSize = 2;
+
+	float const half = float(size_ / 2) - 1.0f;
+	int const quads = std::max(1, int(2.0f * half) / QuadSize);
+	float const phaseX = RandomRange(rng_, 0.0f, 6.0f);
+	float const phaseZ = RandomRange(rng_, 0.0f, 6.0f);
+	auto const heightAt = [phaseX, phaseZ](float x_, float z_)
+	{
+		return (2.0f * std::sin(x_ * 0.05f + phaseX) * std::cos(z_ * 0.07f + phaseZ)) +
+			   (0.5f * std::sin((x_ + z_) * 0.21f));
+	};
+
+	auto terrain = std::make_shared<Mesh>("terrain", true, true);
+	auto& vertices = terrain->getVertices();
+	for(int z = 0; z <= quads; ++z)
+	{
+		for(int x = 0; x <= quads; ++x)
+		{
+			float const wx = -half + float(x * QuadSize);
+			float const wz = -half + float(z * QuadSize);
+			vertices.add(wx, heightAt(wx, wz), wz);
+		}
+	}
+	auto& polygons = terrain->getPolygons();
+	for(int z = 0; z < quads; ++z)
+	{
+		for(int x = 0; x < quads; ++x)
+		{
+			uint32_t const i = uint32_t(z * (quads + 1) + x);
+			uint32_t const row = uint32_t(quads + 1);
+			VertexIndexContainer quad{ VertexIndex(i), VertexIndex(i + 1), VertexIndex(i + row + 1), VertexIndex(i + row) };
+			polygons.addPolygon(quad);
+		}
+	}
+	terrain->updateFromEdits();
+	builder_.addMeshAt(terrain, levelData_, Math::mat4x4(1.0f));
+}
+
+// a ground slab with a random box for every 64 tiles
+void AddBoxField(ITacticalMapBuilder& builder_, int size_, std::mt19937& rng_, TacticalMapLevelDataHeader const* levelData_)
+{
+	Math::mat4x4 const identity(1.0f);
+	float const half = float(size_ / 2) - 1.0f;
+	builder_.addBoxAt(Geometry::AABB(Math::vec3(-half, -1.0f, -half), Math::vec3(half, 0.0f, half)), levelData_, identity);
+
+	uint32_t const boxes = uint32_t(size_ * size_) / 64;
+	for(uint32_t i = 0; i < boxes; ++i)
+	{
+		Math::vec3 const centre(RandomRange(rng_, -half, half), RandomRange(rng_, 0.0f, 10.0f), RandomRange(rng_, -half, half));
+		Math::vec3 const halfLength(RandomRange(rng_, 0.1f, 3.0f), RandomRange(rng_, 0.1f, 3.0f), RandomRange(rng_, 0.1f, 3.0f));
+		builder_.addBoxAt(Geometry::AABB(centre - halfLength, centre + halfLength), levelData_, identity);
+	}
+}
+
+auto CreateSceneBuilder(BuildScene scene_, int size_, uint32_t seed_) -> ITacticalMapBuilder::Ptr
+{
+	TacticalMapLevelDataHeader levelData{};
+	levelData.nameCrc = 1;
+
+	auto builder = TacticalMap::allocateBuilder(Math::vec2(-size_ / 2, -size_ / 2),
+												(TacticalMap::TileCoord_t) size_,
+												(TacticalMap::TileCoord_t) size_,
+												BuildSceneName(scene_));
+	std::mt19937 rng(seed_);
+	switch(scene_)
+	{
+		case BuildScene::City: AddCity(*builder, size_, rng, &levelData); break;
+		case BuildScene::Terrain: AddTerrain(*builder, size_, rng, &levelData); break;
+		case BuildScene::Boxes: AddBoxField(*builder, size_, rng, &levelData); break;
+	}
+	return builder;
+}
+
+// the most memory the process has had resident so far, 0 where it isn't known
+auto PeakResidentBytes() -> size_t
+{
+#if PLATFORM == POSIX || PLATFORM == APPLE_MAC
+	struct rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if PLATFORM == APPLE_MAC
+	return size_t(usage.ru_maxrss);
+#else
+	return size_t(usage.ru_maxrss) * 1024;
+#endif
+#else
+	return 0;
+#endif
+}
+
+// builds every scene at every scale repeats_ times, each from a fresh builder. the saved maps are
+// hashed so a faster builder can be shown to make the same maps, repeats must all hash the same
+auto RunBuildBench(std::vector<int> const& sizes_, uint32_t repeats_, uint32_t seed_, std::string const& jsonFileName_) -> int
+{
+	picojson::array runs;
+	bool deterministic = true;
+
+	for(BuildScene const scene : { BuildScene::City, BuildScene::Terrain, BuildScene::Boxes })
+	{
+		for(int const size : sizes_)
+		{
+			uint64_t firstHash = 0;
+			for(uint32_t repeat = 0; repeat < repeats_; ++repeat)
+			{
+				auto builder = CreateSceneBuilder(scene, size, seed_);
+				auto const map = builder->build();
+				TacticalMapBuildStats const& stats = builder->getBuildStats();
+
+				// uncompressed so the hash doesn't depend on the compressor
+				std::vector<uint8_t> bytes;
+				if(!map || !map->saveTo(0, bytes, false))
+				{
+					LOG_F(ERROR, "Unable to build and save %s at %d", BuildSceneName(scene), size);
+					return 10;
+				}
+				uint64_t const hash = CityHash::Hash64((char const*) bytes.data(), bytes.size());
+				if(repeat == 0) firstHash = hash;
+				else if(hash != firstHash)
+				{
+					LOG_F(ERROR, "%s at %d built a different map on repeat %u", BuildSceneName(scene), size, repeat);
+					deterministic = false;
+				}
+
+				std::ostringstream hashText;
+				hashText << std::hex << hash;
+
+				picojson::array threadUtilisation;
+				for(double const busy : stats.threadBusy)
+				{
+					threadUtilisation.emplace_back(stats.layers > 0.0 ? busy / stats.layers : 0.0);
+				}
+
+				picojson::object seconds;
+				seconds["binTriangles"] = picojson::value(stats.binTriangles);
+				seconds["insertSolidBoxes"] = picojson::value(stats.insertSolidBoxes);
+				seconds["structuralBoxes"] = picojson::value(stats.structuralBoxes);
+				seconds["layers"] = picojson::value(stats.layers);
+				seconds["writeMap"] = picojson::value(stats.writeMap);
+				seconds["total"] = picojson::value(stats.total);
+
+				// summed over the task threads
+				picojson::object layerSeconds;
+				layerSeconds["fragments"] = picojson::value(stats.fragments);
+				layerSeconds["smoothing"] = picojson::value(stats.smoothing);
+				layerSeconds["planes"] = picojson::value(stats.planes);
+				layerSeconds["destruction"] = picojson::value(stats.destruction);
+
+				picojson::object run;
+				run["scene"] = picojson::value(BuildSceneName(scene));
+				run["size"] = picojson::value(double(size));
+				run["repeat"] = picojson::value(double(repeat));
+				run["hash"] = picojson::value(hashText.str());
+				run["seconds"] = picojson::value(seconds);
+				run["layerThreadSeconds"] = picojson::value(layerSeconds);
+				run["threadUtilisation"] = picojson::value(threadUtilisation);
+				run["regionsBuilt"] = picojson::value(double(stats.regionsBuilt));
+				run["peakFragmentBytes"] = picojson::value(double(stats.peakFragmentBytes));
+				run["peakResidentBytes"] = picojson::value(double(PeakResidentBytes()));
+				runs.emplace_back(run);
+
+				LOG_F(INFO, "%s %d: %.3fs (bin %.3f boxes %.3f structure %.3f layers %.3f write %.3f) hash %s",
+					  BuildSceneName(scene), size, stats.total,
+					  stats.binTriangles, stats.insertSolidBoxes, stats.structuralBoxes, stats.layers, stats.writeMap,
+					  hashText.str().c_str());
+				LOG_F(INFO, "  layer thread seconds: fragments %.3f smoothing %.3f planes %.3f destruction %.3f",
+					  stats.fragments, stats.smoothing, stats.planes, stats.destruction);
+			}
+		}
+	}
+
+	if(!jsonFileName_.empty())
+	{
+		picojson::object result;
+		result["seed"] = picojson::value(double(seed_));
+		result["threads"] = picojson::value(double(g_EnkiTS.GetNumTaskThreads()));
+		result["deterministic"] = picojson::value(deterministic);
+		result["runs"] = picojson::value(runs);
+
+		std::ofstream out(jsonFileName_);
+		out << picojson::value(result).serialize(true);
+		if(!out)
+		{
+			LOG_F(ERROR, "Unable to write %s", jsonFileName_.c_str());
+			return 10;
+		}
+	}
+	return deterministic ? 0 : 10;
+}
+
+}
+
+int Main(Shell::ShellInterface& shell_)
+{
+	using namespace std::string_literals;
+
+	std::string mapFileName;
+	std::string traceFileName;
+	std::string saveTraceFileName;
+	int mapSize = 256;
+	uint32_t boxCount = 500;
+	uint32_t agentCount = 2000;
+	uint32_t frameCount = 100;
+	uint32_t seed = 1;
+	bool morton = false;
+	bool buildBench = false;
+	std::vector<int> buildSizes;
+	uint32_t buildRepeats = 1;
+	std::string jsonFileName;
+	bool showHelp = false;
+
+	auto cli = clipp::with_prefixes_short_long(
+			"-", "--",
+			clipp::option("m", "map") & clipp::value("map file", mapFileName),
+			clipp::option("t", "trace") & clipp::value("trace file", traceFileName),
+			clipp::option("s", "save-trace") & clipp::value("trace file", saveTraceFileName),
+			clipp::option("size") & clipp::value("tiles", mapSize),
+			clipp::option("boxes") & clipp::value("count", boxCount),
+			clipp::option("agents") & clipp::value("count", agentCount),
+			clipp::option("frames") & clipp::value("count", frameCount),
+			clipp::option("seed") & clipp::value("seed", seed),
+			clipp::option("morton").set(morton).doc("build the map with the morton tile layout"),
+			clipp::option("build").set(buildBench).doc("time the builder on synthetic cities, terrain and box fields instead"),
+			clipp::option("build-sizes") & clipp::values("tiles", buildSizes),
+			clipp::option("repeats") & clipp::value("count", buildRepeats),
+			clipp::option("json") & clipp::value("json file", jsonFileName),
+			clipp::option("h", "help").set(showHelp).doc("show the help")
+	);
+	clipp::parse(shell_.getArguments().cbegin(), shell_.getArguments().cend(), cli);
+
+	if(showHelp)
+	{
+		LOG_S(INFO) << clipp::make_man_page(cli, shell_.getArguments()[0]);
+		return 0;
+	}
+
+	bool okay = shell_.init({
+									"Tactical Map Bench",
+									true,
+									false,
+									false,
+									{},
+							});
+	if(!okay) return 10;
+
+	if(g_EnkiTS.GetNumTaskThreads() == 0) g_EnkiTS.Initialize();
+
+	if(buildBench)
+	{
+		if(buildSizes.empty()) buildSizes = { 64, 128, 256 };
+		return RunBuildBench(buildSizes, std::max(buildRepeats, 1u), seed, jsonFileName);
+	}
+
+	// without a map file a synthetic one is built
+	std::shared_ptr<TacticalMap> map;
+	if(!mapFileName.empty())
+	{
+		std::vector<std::shared_ptr<TacticalMap>> maps;
+		if(!TacticalMap::createFromFile(mapFileName.c_str(), maps) || maps.empty())
+		{
+			LOG_F(ERROR, "Unable to load tactical map %s", mapFileName.c_str());
+			return 10;
+		}
+		map = maps[0];
+	} else
+	{
+		map = BuildTestMap(mapSize, boxCount, seed,
+						   morton ? TacticalMapTileLayout::MortonBlocks : TacticalMapTileLayout::RowMajor);
+	}
+
+	// without a recorded trace agents are simulated
+	QueryTrace trace;
+	if(!traceFileName.empty())
+	{
+		if(!LoadTrace(traceFileName, trace))
+		{
+			LOG_F(ERROR, "Unable to load query trace %s", traceFileName.c_str());
+			return 10;
+		}
+	} else
+	{
+		trace = SynthesiseTrace(*map, agentCount, frameCount, seed);
+	}
+	if(!saveTraceFileName.empty() && !SaveTrace(saveTraceFileName, trace))
+	{
+		LOG_F(ERROR, "Unable to save query trace %s", saveTraceFileName.c_str());
+		return 10;
+	}
+
+	using Clock = std::chrono::high_resolution_clock;
+	Clock::duration singleTime{};
+	Clock::duration batchTime{};
+	size_t queryCount = 0;
+	size_t hitCount = 0;
+	size_t mismatchCount = 0;
+
+	std::vector<TacticalMapVolume> singleVolumes;
+	std::vector<uint8_t> singleHits;
+	std::vector<TacticalMapVolume> batchVolumes;
+	for(auto const& frame : trace.frames)
+	{
+		size_t const count = frame.points.size();
+		singleVolumes.resize(count);
+		singleHits.resize(count);
+		batchVolumes.resize(count);
+
+		auto const singleStart = Clock::now();
+		for(size_t i = 0; i < count; ++i)
+		{
+			singleHits[i] = map->lookupVolumeAtWorld(frame.points[i], frame.range, frame.levelMask, &singleVolumes[i]);
+		}
+		auto const batchStart = Clock::now();
+		hitCount += map->lookupVolumeAtWorldBatch(frame.points.data(), count, frame.range, frame.levelMask, batchVolumes.data());
+		auto const batchEnd = Clock::now();
+
+		singleTime += batchStart - singleStart;
+		batchTime += batchEnd - batchStart;
+		queryCount += count;
+
+		for(size_t i = 0; i < count; ++i)
+		{
+			bool const batchHit = !std::isnan(batchVolumes[i].levelHeight);
+			if(batchHit != (singleHits[i] != 0) || (batchHit && !SameVolume(batchVolumes[i], singleVolumes[i])))
+			{
+				mismatchCount++;
+			}
+		}
+	}
+
+	using Nanoseconds = std::chrono::duration<double, std::nano>;
+	double const singleNs = Nanoseconds(singleTime).count() / double(std::max<size_t>(queryCount, 1));
+	double const batchNs = Nanoseconds(batchTime).count() / double(std::max<size_t>(queryCount, 1));
+
+	LOG_F(INFO, "%zu frames %zu queries %zu hits", trace.frames.size(), queryCount, hitCount);
+	LOG_F(INFO, "single %.1f ns/query batch %.1f ns/query (%.2fx)", singleNs, batchNs, singleNs / std::max(batchNs, 1e-3));
+	if(mismatchCount > 0)
+	{
+		LOG_F(ERROR, "%zu batch results differ from single lookups", mismatchCount);
+		return 10;
+	}
+	return 0;
+}
@@ -0,0 +1,217 @@
+#pragma once
+#ifndef CORE_HANDLETABLE_H_
+#define CORE_HANDLETABLE_H_ 1
+
+#include <array>
+#include <cassert>
+#include <atomic>
+#include <memory>
+
+namespace Core {
+
+// MT safe table of shared_ptrs handed out as 64 bit handles
+// the low 32 bits of a handle are its slot and the high 32 bits the slots generation, erasing bumps the
+// generation so a stale handle fails lookups rather than finding whatever reuses the slot.
+// slots live in pages that never move or get freed until the table dies, so adding, erasing and lookups
+// never lock or wait on each other (the shared_ptr atomics are whatever the std library gives us)
+template<typename Type, uint32_t PageSize = 1024, uint32_t MaxPages = 4096>
+class HandleTable
+{
+public:
+	using Handle = uint64_t;
+	using Ptr = std::shared_ptr<Type>;
+	static constexpr Handle InvalidHandle = ~Handle(0);
+
+	HandleTable()
+	{
+		for(auto& page : pages)
+		{
+			page.store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	~HandleTable()
+	{
+		for(auto& page : pages)
+		{
+			delete[] page.load(std::memory_order_relaxed);
+		}
+	}
+
+	HandleTable(HandleTable const&) = delete;
+	HandleTable& operator=(HandleTable const&) = delete;
+
+	// returns InvalidHandle if the table is full
+	Handle add(Ptr const& value_)
+	{
+		uint32_t index = popFree();
+		if(index == InvalidIndex)
+		{
+			index = highWater.fetch_add(1);
+			if(index >= PageSize * MaxPages)
+			{
+				highWater.fetch_sub(1);
+				assert(false && "handle table full");
+				return InvalidHandle;
+			}
+		}
+
+		Slot& slot = getOrAddSlot(index);
+		std::atomic_store(&slot.value, value_);
+		liveCount.fetch_add(1, std::memory_order_relaxed);
+		return MakeHandle(index, slot.generation.load());
+	}
+
+	// returns a null ptr if the handle isn't valid (never was, erased or from before a clear)
+	Ptr get(Handle const handle_) const
+	{
+		Slot* slot = getSlot(handle_);
+		if(slot == nullptr) return {};
+
+		uint32_t const generation = slot->generation.load();
+		if(generation != GenerationOf(handle_)) return {};
+		Ptr value = std::atomic_load(&slot->value);
+		// erase bumps the generation before it touches the value, so if it hasn't moved this is still ours
+		if(slot->generation.load() != generation) return {};
+		return value;
+	}
+
+	// swaps what a valid handle points at, returns false for an invalid handle
+	// callers racing to replace the same handle need to order themselves
+	bool replace(Handle const handle_, Ptr const& value_)
+	{
+		Slot* slot = getSlot(handle_);
+		if(slot == nullptr) return false;
+		if(slot->generation.load() != GenerationOf(handle_)) return false;
+		std::atomic_store(&slot->value, value_);
+		return true;
+	}
+
+	// returns false if the handle wasn't valid, so double erases are harmless
+	bool erase(Handle const handle_)
+	{
+		Slot* slot = getSlot(handle_);
+		if(slot == nullptr) return false;
+
+		uint32_t generation = GenerationOf(handle_);
+		if(!slot->generation.compare_exchange_strong(generation, NextGeneration(generation))) return false;
+
+		std::atomic_store(&slot->value, Ptr());
+		liveCount.fetch_sub(1, std::memory_order_relaxed);
+		pushFree(IndexOf(handle_));
+		return true;
+	}
+
+	// NOT MT safe, every handle given out so far goes stale
+	void clear()
+	{
+		uint32_t const count = highWater.load();
+		freeHead.store(InvalidIndex);
+		for(uint32_t i = count; i > 0; --i)
+		{
+			Slot& slot = *getSlot(i - 1);
+			if(slot.value)
+			{
+				slot.value.reset();
+				slot.generation.store(NextGeneration(slot.generation.load()));
+			}
+			// pushed in reverse so the lowest slots get reused first
+			pushFree(i - 1);
+		}
+		liveCount.store(0);
+	}
+
+	// number of valid handles, only a hint while other threads are adding or erasing
+	size_t size() const { return liveCount.load(std::memory_order_relaxed); }
+
+	bool empty() const { return size() == 0; }
+
+private:
+	static constexpr uint32_t InvalidIndex = ~0u;
+
+	struct Slot
+	{
+		Ptr value;
+		// generations start at 1 and skip ~0, so handles are never 0 or InvalidHandle
+		std::atomic<uint32_t> generation{ 1 };
+		std::atomic<uint32_t> nextFree{ InvalidIndex };
+	};
+
+	static uint32_t IndexOf(Handle const handle_) { return uint32_t(handle_ & 0xFFFFFFFF); }
+	static uint32_t GenerationOf(Handle const handle_) { return uint32_t(handle_ >> 32); }
+	static Handle MakeHandle(uint32_t const index_, uint32_t const generation_)
+	{
+		return (Handle(generation_) << 32) | Handle(index_);
+	}
+
+	static uint32_t NextGeneration(uint32_t const generation_)
+	{
+		uint32_t const next = generation_ + 1;
+		return (next == 0 || next == ~0u) ? 1 : next;
+	}
+
+	Slot* getSlot(Handle const handle_) const
+	{
+		uint32_t const index = IndexOf(handle_);
+		if(index >= highWater.load()) return nullptr;
+		Slot* page = pages[index / PageSize].load(std::memory_order_acquire);
+		if(page == nullptr) return nullptr;
+		return page + (index % PageSize);
+	}
+
+	Slot& getOrAddSlot(uint32_t const index_)
+	{
+		std::atomic<Slot*>& page = pages[index_ / PageSize];
+		Slot* current = page.load(std::memory_order_acquire);
+		if(current == nullptr)
+		{
+			// whoever loses the race to add the page throws theirs away
+			Slot* fresh = new Slot[PageSize];
+			if(page.compare_exchange_strong(current, fresh, std::memory_order_acq_rel))
+			{
+				current = fresh;
+			} else
+			{
+				delete[] fresh;
+			}
+		}
+		return current[index_ % PageSize];
+	}
+
+	// the free slots are a stack threaded through the slots, the head has a count in its top 32 bits
+	// so a pop that was beaten by a pop and push of the same slot fails its exchange
+	void pushFree(uint32_t const index_)
+	{
+		Slot& slot = *getSlot(index_);
+		uint64_t head = freeHead.load();
+		uint64_t next;
+		do
+		{
+			slot.nextFree.store(uint32_t(head & 0xFFFFFFFF), std::memory_order_relaxed);
+			next = ((head >> 32) + 1) << 32 | index_;
+		} while(!freeHead.compare_exchange_weak(head, next));
+	}
+
+	uint32_t popFree()
+	{
+		uint64_t head = freeHead.load();
+		uint64_t next;
+		do
+		{
+			uint32_t const index = uint32_t(head & 0xFFFFFFFF);
+			if(index == InvalidIndex) return InvalidIndex;
+			uint32_t const nextFree = getSlot(index)->nextFree.load(std::memory_order_relaxed);
+			next = ((head >> 32) + 1) << 32 | nextFree;
+		} while(!freeHead.compare_exchange_weak(head, next));
+		return uint32_t(head & 0xFFFFFFFF);
+	}
+
+	std::array<std::atomic<Slot*>, MaxPages> pages;
+	std::atomic<uint32_t> highWater{ 0 };
+	std::atomic<uint64_t> freeHead{ InvalidIndex };
+	std::atomic<size_t> liveCount{ 0 };
+};
+
+} // end Core namespace
+
+#endif
@@ -0,0 +1,60 @@
+#pragma once
+#ifndef CORE_SHAREDTASKS_H_
+#define CORE_SHAREDTASKS_H_ 1
+
+#include "core/core.h"
+#include "enkiTS/src/TaskScheduler.h"
+#include <mutex>
+
+// the one task scheduler for an app or dll, defined by whoever owns main or the dll entry points
+extern enki::TaskScheduler g_EnkiTS;
+
+namespace Core {
+
+// enkiTS only takes tasks from one non task thread at a time. libraries get called from any thread
+// (unity jobs, tools threads etc.) so fan outs go through this lock, whoever holds it submits and
+// anyone else does the work on their own thread. recursive so the owner can fan out again from a task
+inline std::recursive_mutex SharedTasksMutex;
+
+// starts g_EnkiTS the first time, later calls (from anywhere) leave the running threads alone
+inline auto InitSharedTasks() -> void
+{
+	static std::once_flag once;
+	std::call_once(once, []()
+	{
+		if(g_EnkiTS.GetNumTaskThreads() == 0) g_EnkiTS.Initialize();
+	});
+}
+
+// runs func_(begin, end, threadnum) over [0, count_) in parts of at least minRange_ on g_EnkiTS.
+// runs as a single call on this thread (threadnum 0) if the scheduler isn't running, the range is
+// too small to split or another thread is submitting
+template<typename Func>
+auto ParallelFor(uint32_t const count_, uint32_t const minRange_, Func&& func_) -> void
+{
+	if(count_ == 0) return;
+	if(count_ < 2 * minRange_ || g_EnkiTS.GetNumTaskThreads() < 2)
+	{
+		func_(0u, count_, 0u);
+		return;
+	}
+
+	std::unique_lock<std::recursive_mutex> lock(SharedTasksMutex, std::try_to_lock);
+	if(!lock.owns_lock())
+	{
+		func_(0u, count_, 0u);
+		return;
+	}
+
+	enki::TaskSet task(count_, [&func_](enki::TaskSetPartition range_, uint32_t threadnum_)
+	{
+		func_(range_.start, range_.end, threadnum_);
+	});
+	task.m_MinRange = minRange_;
+	g_EnkiTS.AddTaskSetToPipe(&task);
+	g_EnkiTS.WaitforTask(&task);
+}
+
+}
+
+#endif //CORE_SHAREDTASKS_H_
@@ -1,6 +1,4 @@
 #include "core/core.h"
-#include <unordered_map>
-#include <array>
 #include "bundle.h"
 #include "crc32c/crc32c.h"
 #include "lz4/lz4.h"
@@ -80,16 +78,12 @@ auto Bundle::read(
 	uint8_t* loadBuffer = (uint8_t*) tmpAlloc(maxBufferSize);
 	uint8_t* decompBuffer = (uint8_t*) tmpAlloc(maxBufferSize);
 
-	size_t totalExtraMem = 0;
-
 	// TODO temp memory allocator for this map
-	std::unordered_map<uint32_t, std::array<int, MaxHandlerStages>> handlerMap(handlers_.size());
-	for(auto j = 0u; j < handlers_.size(); ++j)
-	{
-		ChunkHandler const& handler = handlers_.at(j);
-		handlerMap[handler.id].at(handler.stage) = j + 1; // 1 indexed so 0 can indicate no handler
-		totalExtraMem += handler.extraMem;
-	}
+	HandlerMap handlerMap(handlers_.size());
+	size_t const totalExtraMem = BuildHandlerMap(handlers_, handlerMap);
+
+	// TODO 32 bit file on 64 bit fixup magic (need to do major runtime surgery)
+	assert(!(header.flags & HeaderFlag_32Bit && sizeOfPtr == 8));
 
 	uintptr_t lastStoredSize = 0;
 
@@ -121,56 +115,141 @@ auto Bundle::read(
 		{
 			return {ErrorCode::ReadError, 0ul};
 		}
-		uint32_t crc32c = crc32c_append(0, loadBuffer, dir.storedSize);
-		if(crc32c != dir.storedCrc32c) return {ErrorCode::CorruptError, 0ul};;
 
-		uint8_t* fixupBuffer = loadBuffer;
-		if(dir.uncompressedSize != dir.storedSize)
+		uint8_t* unpacked = nullptr;
+		if(auto const error = UnpackChunk(dir, loadBuffer, decompBuffer, unpacked); error != ErrorCode::Okay)
 		{
-			int okay = LZ4_decompress_safe((char*) loadBuffer,
-										   (char*) decompBuffer,
-										   (int) dir.storedSize,
-										   (int) dir.uncompressedSize);
+			return {error, 0ul};
+		}
 
-			if(okay < 0) return {ErrorCode::CompressionError, 0ul};
-			if((okay) != dir.uncompressedSize) return {ErrorCode::CompressionError, 0ul};
+		// callee owns this memory!
+		AllocFunc const& chunkAlloc = (dir.flags & ChunkFlag_TempAlloc) ? tmpAlloc : permAlloc;
+		FreeFunc const& chunkFree = (dir.flags & ChunkFlag_TempAlloc) ? tmpFree : permFree;
+		bool inPlace = false;
+		auto const error = LoadChunk(dir, unpacked, handlers_, handlerMap, totalExtraMem, chunkAlloc, chunkFree, {}, inPlace);
+		if(error != ErrorCode::Okay) return {error, 0ul};
+	}
 
-			uint32_t ucrc32c = crc32c_append(0, decompBuffer, dir.uncompressedSize);
-			if(ucrc32c != dir.uncompressedCrc32c) return {ErrorCode::CorruptError, 0ul};
-			fixupBuffer = decompBuffer;
-		}
+	tmpFree(decompBuffer);
+	tmpFree(loadBuffer);
+	if(found == false) return {ErrorCode::NotFound, header.userData};
+	else return {ErrorCode::Okay, header.userData};
+}
+
+size_t Bundle::BuildHandlerMap(std::vector<ChunkHandler> const& handlers_, HandlerMap& handlerMap_)
+{
+	size_t totalExtraMem = 0;
+	for(auto j = 0u; j < handlers_.size(); ++j)
+	{
+		ChunkHandler const& handler = handlers_.at(j);
+		handlerMap_[handler.id].at(handler.stage) = j + 1; // 1 indexed so 0 can indicate no handler
+		totalExtraMem += handler.extraMem;
+	}
+	return totalExtraMem;
+}
+
+auto Bundle::UnpackChunk(DirEntry const& dir_, uint8_t* stored_, uint8_t* decompBuffer_, uint8_t*& unpacked_) -> ErrorCode
+{
+	uint32_t crc32c = crc32c_append(0, stored_, dir_.storedSize);
+	if(crc32c != dir_.storedCrc32c) return ErrorCode::CorruptError;
+
+	unpacked_ = stored_;
+	if(dir_.uncompressedSize != dir_.storedSize)
+	{
+		int okay = LZ4_decompress_safe((char const*) stored_,
+									   (char*) decompBuffer_,
+									   (int) dir_.storedSize,
+									   (int) dir_.uncompressedSize);
+
+		if(okay < 0) return ErrorCode::CompressionError;
+		if(uintptr_t(okay) != dir_.uncompressedSize) return ErrorCode::CompressionError;
+
+		uint32_t ucrc32c = crc32c_append(0, decompBuffer_, dir_.uncompressedSize);
+		if(ucrc32c != dir_.uncompressedCrc32c) return ErrorCode::CorruptError;
+		unpacked_ = decompBuffer_;
+	}
 
-		Bundle::ChunkHeader const* cheader = (Bundle::ChunkHeader const*) fixupBuffer;
+	if(dir_.uncompressedSize < sizeof(ChunkHeader)) return ErrorCode::CorruptError;
+	ChunkHeader const* cheader = (ChunkHeader const*) unpacked_;
+	if(cheader->dataOffset + cheader->dataSize > dir_.uncompressedSize) return ErrorCode::CorruptError;
+	if(cheader->fixupOffset + cheader->fixupSize > dir_.uncompressedSize) return ErrorCode::CorruptError;
+	return ErrorCode::Okay;
+}
 
-		bool allocatePrefix = false;
-		bool writePrefix = false;
-		auto const handlerIndex = handlerMap[dir.id].at(0);
+auto Bundle::LoadChunk(DirEntry const& dir_,
+					   uint8_t* unpacked_,
+					   std::vector<ChunkHandler> const& handlers_,
+					   HandlerMap& handlerMap_,
+					   size_t const totalExtraMem_,
+					   AllocFunc const& alloc_,
+					   FreeFunc const& free_,
+					   std::shared_ptr<void> const& inPlaceOwner_,
+					   bool& inPlace_) -> ErrorCode
+{
+	ChunkHeader const* cheader = (ChunkHeader const*) unpacked_;
+
+	bool allocatePrefix = false;
+	bool writePrefix = false;
+	auto const handlerIndex = handlerMap_[dir_.id].at(0);
+	if(handlerIndex > 0)
+	{
+		ChunkHandler const& handler = handlers_.at(handlerIndex - 1);
+		assert(handler.stage == 0);
+		allocatePrefix = handler.allocatePrefix;
+		writePrefix = handler.writePrefix;
+	}
+
+	// TODO this should go through temp alloc and its lambda copy through
+	// permenant alloc/free
+	std::vector<std::pair<int, ChunkDestroyFunc>> destroyers;
+	destroyers.reserve(MaxHandlerStages);
+
+	// reverse order for destruction
+	for(int j = MaxHandlerStages - 1; j >= 0; --j)
+	{
+		auto const handlerIndex = handlerMap_[dir_.id].at(j);
 		if(handlerIndex > 0)
 		{
 			ChunkHandler const& handler = handlers_.at(handlerIndex - 1);
-			assert(handler.stage == 0);
-			allocatePrefix = handler.allocatePrefix;
-			writePrefix = handler.writePrefix;
+			destroyers.push_back({j, handler.destroyFunc});
 		}
+	}
+
+	// anything that needs more memory than the chunk itself has to be copied out
+	inPlace_ = inPlaceOwner_ && !allocatePrefix && !writePrefix && totalExtraMem_ == 0 &&
+			   ((uintptr_t) (unpacked_ + cheader->dataOffset) % 8) == 0;
 
-		size_t memorySize = cheader->dataSize;
+	uint8_t* basePtr = nullptr;
+	uint8_t* dataPtr = nullptr;
+	size_t memorySize = cheader->dataSize;
+	std::shared_ptr<void> ptr;
+	if(inPlace_)
+	{
+		basePtr = dataPtr = unpacked_ + cheader->dataOffset;
+
+		auto localOwner = inPlaceOwner_; // keeps the callers memory alive as long as the chunk
+		ptr = std::shared_ptr<void>((void*) basePtr,
+									[localOwner, destroyers](void* ptr)
+									{
+										for(auto const& [stage, destroyer] : destroyers)
+										{
+											if (destroyer) { destroyer(stage, ptr); }
+										}
+									});
+	}
+	else
+	{
 		if(allocatePrefix)
 		{
 			memorySize += sizeof(uintptr_t) * MaxHandlerStages;
 		}
-		memorySize += totalExtraMem;
+		memorySize += totalExtraMem_;
 		memorySize = Core::alignTo(memorySize, 8);
 
 		// callee owns this memory!
-		uint8_t* basePtr = nullptr;
-		if(dir.flags & ChunkFlag_TempAlloc)
-		{
-			basePtr = (uint8_t*) tmpAlloc(memorySize);
-		} else
-		{
-			basePtr = (uint8_t*) permAlloc(memorySize);
-		}
-		uint8_t* dataPtr = basePtr;
+		basePtr = (uint8_t*) alloc_(memorySize);
+		if(basePtr == nullptr) return ErrorCode::MemoryError;
+		dataPtr = basePtr;
 		if(writePrefix)
 		{
 			std::memset(dataPtr, 0xDE, sizeof(uintptr_t) * MaxHandlerStages);
@@ -181,95 +260,71 @@ auto Bundle::read(
 		}
 
 		// copy all the data over
-		std::memcpy(dataPtr, fixupBuffer + cheader->dataOffset, cheader->dataSize);
-
-		// do the fixups
-
-		// TODO 32 bit file on 64 bit fixup magic (need to do major runtime surgery)
-		assert(!(header.flags & HeaderFlag_32Bit && sizeOfPtr == 8));
-
-		// begining of the fixup table
-		uintptr_t* fixupTable = (uintptr_t*) (fixupBuffer + cheader->fixupOffset);
-
-		size_t numFixups = cheader->fixupSize / sizeOfPtr;
-		for(size_t i = 0; i < numFixups; ++i)
-		{
-			uintptr_t* varAddress = (uintptr_t*) (dataPtr + fixupTable[i]);
-			if((uintptr_t) (varAddress) >= (uintptr_t) (dataPtr + cheader->dataSize))
-				return {ErrorCode::CorruptError, 0ul};
-			if(*varAddress >= cheader->dataSize) return {ErrorCode::CorruptError, 0ul};
-			*varAddress = (uintptr_t) (dataPtr + *varAddress);
-			if((uintptr_t) (*varAddress) >= (uintptr_t) (dataPtr + cheader->dataSize))
-				return {ErrorCode::CorruptError, 0ul};
-		}
-
-		// for debuggin mostly
-		dir.storedOffset = (uintptr_t) basePtr;
+		std::memcpy(dataPtr, unpacked_ + cheader->dataOffset, cheader->dataSize);
 
 		// setup the smart pointer to clean up llocated memory from the right pool
-		auto localFree = permFree; // this ensure the function pointer outlives the bundle
-		if(dir.flags & ChunkFlag_TempAlloc)
-		{
-			localFree = tmpFree;
-		}
+		auto localFree = free_; // this ensure the function pointer outlives the bundle
+		ptr = std::shared_ptr<void>((void*) basePtr,
+									[localFree, destroyers](void* ptr)
+									{
+										for(auto const& [stage, destroyer] : destroyers)
+										{
+											if (destroyer) { destroyer(stage, ptr); }
+										}
+										localFree(ptr);
+									});
+	}
 
-		// TODO this should go through temp alloc and its lambda copy through
-		// permenant alloc/free
-		std::vector<std::pair<int, ChunkDestroyFunc>> destroyers;
-		destroyers.reserve(MaxHandlerStages);
+	if(auto const error = FixupChunk(dataPtr, cheader, unpacked_); error != ErrorCode::Okay)
+	{
+		return error;
+	}
 
-		// reverse order for destruction
-		for(int j = MaxHandlerStages - 1; j >= 0; --j)
+	uint8_t* extraMemPtr = dataPtr + cheader->dataSize;
+	for(auto j = 0u; j < MaxHandlerStages; ++j)
+	{
+		auto const handlerIndex = handlerMap_[dir_.id].at(j);
+		if(handlerIndex > 0)
 		{
-			auto const handlerIndex = handlerMap[dir.id].at(j);
-			if(handlerIndex > 0)
+			ChunkHandler const& handler = handlers_.at(handlerIndex - 1);
+			extraMemPtr += handler.extraMem;
+			if(writePrefix)
 			{
-				ChunkHandler const& handler = handlers_.at(handlerIndex - 1);
-				destroyers.push_back({j, handler.destroyFunc});
+				((uintptr_t*) basePtr)[j] = (uintptr_t) extraMemPtr;
 			}
-		}
-		auto ptr = std::shared_ptr<void>((void*) basePtr,
-										 [localFree, destroyers](void* ptr)
-										 {
-											 for(auto const[stage, destroyer] : destroyers)
-											 {
-												 if (destroyer) { destroyer(stage, ptr); }
-											 }
-											 localFree(ptr);
-										 });
-		uint8_t* extraMemPtr = dataPtr + cheader->dataSize;
-
-		for(int j = 0; j < MaxHandlerStages; ++j)
-		{
-			auto const handlerIndex = handlerMap[dir.id].at(j);
-			if(handlerIndex > 0)
+
+			if(handler.createFunc != nullptr)
 			{
-				ChunkHandler const& handler = handlers_.at(handlerIndex - 1);
-				extraMemPtr += handler.extraMem;
-				if(writePrefix)
-				{
-					((uintptr_t*) basePtr)[j] = (uintptr_t) extraMemPtr;
-				}
-
-				if(handler.createFunc != nullptr)
-				{
-					// call the callee back with memory, version etc for this chunk
-					// we've already skipped any ids we don't handle
-					handler.createFunc(dir.getName(),
-									   handler.stage,
-									   cheader->majorVersion,
-									   cheader->minorVersion,
-									   memorySize,
-									   ptr);
-				}
+				// call the callee back with memory, version etc for this chunk
+				// we've already skipped any ids we don't handle
+				handler.createFunc(dir_.getName(),
+								   handler.stage,
+								   cheader->majorVersion,
+								   cheader->minorVersion,
+								   memorySize,
+								   ptr);
 			}
 		}
 	}
+	return ErrorCode::Okay;
+}
 
-	tmpFree(decompBuffer);
-	tmpFree(loadBuffer);
-	if(found == false) return {ErrorCode::NotFound, header.userData};
-	else return {ErrorCode::Okay, header.userData};
+auto Bundle::FixupChunk(uint8_t* dataPtr_, ChunkHeader const* cheader_, uint8_t const* unpacked_) -> ErrorCode
+{
+	static const int sizeOfPtr = sizeof(uintptr_t);
+
+	// begining of the fixup table
+	uintptr_t const* fixupTable = (uintptr_t const*) (unpacked_ + cheader_->fixupOffset);
+
+	size_t numFixups = cheader_->fixupSize / sizeOfPtr;
+	for(size_t i = 0; i < numFixups; ++i)
+	{
+		if(fixupTable[i] + sizeOfPtr > cheader_->dataSize) return ErrorCode::CorruptError;
+		uintptr_t* varAddress = (uintptr_t*) (dataPtr_ + fixupTable[i]);
+		if(*varAddress > cheader_->dataSize) return ErrorCode::CorruptError;
+		*varAddress = (uintptr_t) (dataPtr_ + *varAddress);
+	}
+	return ErrorCode::Okay;
 }
 
 std::pair<Bundle::ErrorCode, uint64_t> Bundle::peekAtHeader()
@@ -281,6 +336,27 @@ std::pair<Bundle::ErrorCode, uint64_t> Bundle::peekAtHeader()
 	return ret;
 }
 
+std::pair<Bundle::ErrorCode, uint64_t> Bundle::PeekAtHeader(uint8_t const* memory_, size_t size_)
+{
+	Header header;
+	if(memory_ == nullptr || size_ < sizeof(header))
+	{
+		return {ErrorCode::ReadError, 0ul};
+	}
+	std::memcpy(&header, memory_, sizeof(header));
+	if(header.magic != "BUND"_bundle_id ||
+	   header.majorVersion != majorVersion ||
+	   header.minorVersion > minorVersion)
+	{
+		return {ErrorCode::CorruptError, 0ul};
+	}
+	if(sizeof(uintptr_t) < 8 && header.flags & HeaderFlag_64Bit)
+	{
+		return {ErrorCode::AddressLength, 0ul};
+	}
+	return {ErrorCode::Okay, header.userData};
+}
+
 std::pair<Bundle::ErrorCode, uint64_t> Bundle::readHeader(Header& header)
 {
 	// read header
@@ -7,6 +7,8 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <unordered_map>
+#include <array>
 #include "binny/ibundle.h"
 
 namespace Binny {
@@ -24,6 +26,7 @@ class Bundle : public IBundle
 public:
 	friend class BundleWriter;
 	friend class WriteHelper;
+	friend class InPlaceBundle;
 
 	// if this flag is set, the memory will come out of the temp pool
 	// and will be freed
@@ -49,6 +52,10 @@ public:
 	std::string_view getDirectoryEntry(uint32_t const index_) final;
 
 	std::pair<ErrorCode, uint64_t> peekAtHeader();
+
+	// checks the header of a bundle already in memory and returns its user data, unlike
+	// peekAtHeader bad headers are just errors as memory might be anything (a stale cache file etc.)
+	static std::pair<ErrorCode, uint64_t> PeekAtHeader(uint8_t const* memory_, size_t size_);
 protected:
 	static const uint16_t majorVersion = 1;
 	static const uint16_t minorVersion = 0;
@@ -143,6 +150,33 @@ protected:
 
 	std::pair<ErrorCode, uint64_t> readHeader(Header & header);
 
+	// the rest is shared with InPlaceBundle, the two only differ in where chunks come from
+
+	// 1 indexed handler per chunk id and stage so 0 can indicate no handler
+	using HandlerMap = std::unordered_map<uint32_t, std::array<int, MaxHandlerStages>>;
+	// returns the extra memory all the handlers want
+	static size_t BuildHandlerMap(std::vector<ChunkHandler> const& handlers_, HandlerMap& handlerMap_);
+
+	// checks a stored chunks crcs, decompressing it into decompBuffer_ if it was compressed.
+	// unpacked_ is set to the chunks uncompressed bytes
+	static ErrorCode UnpackChunk(DirEntry const& dir_, uint8_t* stored_, uint8_t* decompBuffer_, uint8_t*& unpacked_);
+
+	// fixes up the chunk unpacked_ holds and hands it to its handlers. If inPlaceOwner_ is set and nothing
+	// needs extra memory the data is used where it lies in unpacked_ and holds a reference to inPlaceOwner_,
+	// otherwise its copied into alloc_ memory that free_ releases. inPlace_ says which happened
+	static ErrorCode LoadChunk(DirEntry const& dir_,
+							   uint8_t* unpacked_,
+							   std::vector<ChunkHandler> const& handlers_,
+							   HandlerMap& handlerMap_,
+							   size_t totalExtraMem_,
+							   AllocFunc const& alloc_,
+							   FreeFunc const& free_,
+							   std::shared_ptr<void> const& inPlaceOwner_,
+							   bool& inPlace_);
+
+	// pointers are stored as offsets from the start of the data, an offset equal to the data size
+	// is the end of the data so is valid too
+	static ErrorCode FixupChunk(uint8_t* dataPtr_, ChunkHeader const* cheader_, uint8_t const* unpacked_);
 };
 
 } // end namespace
@@ -88,6 +88,7 @@ bool BundleWriter::addChunkInternal(
 	int const maxSize = LZ4_compressBound((int)bin_.size());
 
 	std::vector<uint8_t>*  compressedData = new std::vector<uint8_t>(maxSize);
+	if(!storeUncompressed)
 	{
 		int okay = LZ4_compress_default((char const*)bin_.data(),
 										(char *)compressedData->data(),
@@ -99,7 +100,7 @@ bool BundleWriter::addChunkInternal(
 
 	// if compression made this block bigger, use the uncompressed data and mark it by
 	// having uncompressed size == 0 in the file
-	if (compressedData->size() >= bin_.size())
+	if (storeUncompressed || compressedData->size() >= bin_.size())
 	{
 		*compressedData = bin_;
 	}
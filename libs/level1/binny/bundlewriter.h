@@ -54,6 +54,10 @@ public:
 	void setLogBinifyText()
 	{ logBinifyText = true; }
 
+	/// chunks added after this are stored uncompressed, so an InPlaceBundle can use them where they lie
+	void setStoreUncompressed()
+	{ storeUncompressed = true; }
+
 private:
 	bool addChunkInternal( std::string const& name_,
 						   uint32_t id_,
@@ -80,6 +84,7 @@ private:
 
 	std::vector<DirEntryWriter> dirEntries;
 	bool logBinifyText = false;
+	bool storeUncompressed = false;
 };
 
 } // end namespace
@@ -0,0 +1,123 @@
+#include "core/core.h"
+#include "inplacebundle.h"
+
+namespace Binny {
+
+auto InPlaceBundle::readDirectory(Header& header_) -> ErrorCode
+{
+	if(memory == nullptr || memorySize < sizeof(Header)) return ErrorCode::ReadError;
+	std::memcpy(&header_, memory, sizeof(Header));
+
+	if(header_.magic != "BUND"_bundle_id) return ErrorCode::CorruptError;
+	if(header_.majorVersion != Bundle::majorVersion) return ErrorCode::OtherError;
+	if(header_.minorVersion > Bundle::minorVersion) return ErrorCode::OtherError;
+
+	// fixups are done in place so the bundle must have been written for this pointer size
+	static const int sizeOfPtr = sizeof(uintptr_t);
+	if(sizeOfPtr < 8 && header_.flags & Bundle::HeaderFlag_64Bit) return ErrorCode::AddressLength;
+	if(sizeOfPtr == 8 && header_.flags & Bundle::HeaderFlag_32Bit) return ErrorCode::AddressLength;
+
+	size_t offset = sizeof(Header);
+	size_t const dirMemorySize = header_.chunkCount * sizeof(DirEntry);
+	if(offset + dirMemorySize > memorySize) return ErrorCode::ReadError;
+	directory.resize(header_.chunkCount);
+	std::memcpy(directory.data(), memory + offset, dirMemorySize);
+	offset += dirMemorySize + header_.stringsMicroOffset;
+
+	char const* stringMemory = (char const*) memory + offset;
+	offset += header_.stringTableSize + header_.chunksMicroOffset;
+	if(offset > memorySize) return ErrorCode::ReadError;
+	chunksBase = memory + offset;
+
+	// names are left in the callers memory
+	for(auto& dir : directory)
+	{
+		if(dir.nameOffset >= header_.stringTableSize) return ErrorCode::CorruptError;
+		dir.nameOffset = (uintptr_t) stringMemory + dir.nameOffset;
+	}
+
+	return ErrorCode::Okay;
+}
+
+auto InPlaceBundle::read(
+		std::string_view name_,
+		std::vector<ChunkHandler> const& handlers_) -> ReadReturn
+{
+	inPlaceChunkCount = 0;
+
+	Header header;
+	if(auto const error = readDirectory(header); error != ErrorCode::Okay)
+	{
+		return {error, 0ul};
+	}
+
+	Bundle::HandlerMap handlerMap(handlers_.size());
+	size_t const totalExtraMem = Bundle::BuildHandlerMap(handlers_, handlerMap);
+
+	bool found = false;
+	std::vector<uint8_t> decompBuffer;
+	uint8_t* chunk = chunksBase;
+	for(auto& dir : directory)
+	{
+		// stored offsets are from the previous chunk
+		chunk += dir.storedOffset;
+
+		// skip any unhandled chunks
+		if(handlerMap.find(dir.id) == handlerMap.end())
+		{
+			continue;
+		}
+		if(!name_.empty())
+		{
+			if(name_ != std::string_view(dir.getName()))
+			{
+				continue;
+			}
+		}
+		found = true;
+
+		if(chunk + dir.storedSize > memory + memorySize) return {ErrorCode::ReadError, 0ul};
+		bool const compressed = dir.uncompressedSize != dir.storedSize;
+		if(compressed) decompBuffer.resize(dir.uncompressedSize);
+
+		uint8_t* unpacked = nullptr;
+		if(auto const error = Bundle::UnpackChunk(dir, chunk, decompBuffer.data(), unpacked); error != ErrorCode::Okay)
+		{
+			return {error, 0ul};
+		}
+
+		// compressed chunks have nowhere to live in place
+		bool inPlace = false;
+		auto const error = Bundle::LoadChunk(dir, unpacked, handlers_, handlerMap, totalExtraMem,
+											 permAlloc, permFree, compressed ? nullptr : owner, inPlace);
+		if(error != ErrorCode::Okay) return {error, 0ul};
+		if(inPlace) inPlaceChunkCount++;
+	}
+
+	if(found == false) return {ErrorCode::NotFound, header.userData};
+	else return {ErrorCode::Okay, header.userData};
+}
+
+uint32_t InPlaceBundle::getDirectoryCount()
+{
+	if(directory.empty())
+	{
+		Header header;
+		readDirectory(header);
+	}
+	return (uint32_t) directory.size();
+}
+
+std::string_view InPlaceBundle::getDirectoryEntry(uint32_t const index_)
+{
+	if(directory.empty())
+	{
+		Header header;
+		readDirectory(header);
+	}
+	assert(index_ < directory.size());
+
+	return directory[index_].getName();
+}
+
+} // end namespace
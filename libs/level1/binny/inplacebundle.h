@@ -0,0 +1,60 @@
+#pragma once
+#ifndef BINNY_INPLACEBUNDLE_H
+#define BINNY_INPLACEBUNDLE_H
+
+#include "core/core.h"
+#include "core/utils.h"
+#include <string>
+#include <vector>
+#include <functional>
+#include "binny/ibundle.h"
+#include "binny/bundle.h"
+
+namespace Binny {
+
+/// An in place bundle reads a whole bundle thats already in memory (a blob or mapped file).
+/// Uncompressed chunks are validated and fixed up where they lie, handlers get pointers into
+/// the callers memory and nothing is copied. Compressed chunks and chunks whose handlers want
+/// a prefix or extra memory are copied out into alloc_ memory as a Bundle does.
+/// The fixups modify the memory so a bundle can only be read in place once. Chunk pointers
+/// passed to handlers hold a reference to owner_, so the memory lives as long as they do
+class InPlaceBundle : public IBundle
+{
+public:
+	InPlaceBundle(AllocFunc alloc_,
+				  FreeFunc free_,
+				  std::shared_ptr<void> owner_,
+				  uint8_t* memory_,
+				  size_t size_) :
+			permAlloc(alloc_), permFree(free_),
+			owner(std::move(owner_)),
+			memory(memory_), memorySize(size_) {}
+
+	auto read(std::string_view name_, std::vector<ChunkHandler> const& handlers_) -> ReadReturn final;
+	uint32_t getDirectoryCount() final;
+	std::string_view getDirectoryEntry(uint32_t const index_) final;
+
+	// chunks the last read fixed up in place, the others were copied
+	uint32_t getInPlaceChunkCount() const { return inPlaceChunkCount; }
+
+protected:
+	using Header = Bundle::Header;
+	using DirEntry = Bundle::DirEntry;
+	using ChunkHeader = Bundle::ChunkHeader;
+
+	ErrorCode readDirectory(Header& header_);
+
+	AllocFunc permAlloc;
+	FreeFunc permFree;
+	std::shared_ptr<void> owner;
+	uint8_t* memory;
+	size_t memorySize;
+
+	std::vector<DirEntry> directory;
+	uint8_t* chunksBase = nullptr;
+	uint32_t inPlaceChunkCount = 0;
+};
+
+} // end namespace
+
+#endif //BINNY_INPLACEBUNDLE_H
@@ -143,6 +143,30 @@ constexpr unsigned int log2(unsigned int v)
 	return r;
 }
 
+/// \brief	return the number of set bits in v.
+inline unsigned int popCount(uint64_t v)
+{
+#if COMPILER == MS_COMPILER
+	return (unsigned int) __popcnt64(v);
+#else
+	return (unsigned int) __builtin_popcountll(v);
+#endif
+}
+
+/// \brief	return the index of the lowest set bit of v.
+/// v must not be 0
+inline unsigned int countTrailingZeros(uint64_t v)
+{
+	assert(v != 0);
+#if COMPILER == MS_COMPILER
+	unsigned long index;
+	_BitScanForward64(&index, v);
+	return (unsigned int) index;
+#else
+	return (unsigned int) __builtin_ctzll(v);
+#endif
+}
+
 // From Chunk Walbourns code from DirectXTexConvert.cpp
 // e5b9g9r9 are positive only shared exponent float formats
 inline uint32_t floats2e5b9g9r9(float const in_[3])
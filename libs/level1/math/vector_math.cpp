@@ -7,6 +7,7 @@
 
 #include "core/core.h"
 #include "vector_math.h"
+#include <cmath>
 
 namespace Math {
 
@@ -149,4 +150,42 @@ Plane CreatePlaneFromPoints(size_t pointCount, vec3 const* points)
 	return Plane(weightedDir, dot(weightedDir, centroid));
  }
 
+static int16_t QuantiseSnorm16(float const v_)
+{
+	return (int16_t) std::lround(clamp(v_, -1.0f, 1.0f) * 32767.0f);
+}
+
+std::array<int16_t, 2> EncodeOctahedral(vec3 const& normal_)
+{
+	float const l1 = std::abs(normal_.x) + std::abs(normal_.y) + std::abs(normal_.z);
+	if(!(l1 > 0.0f)) return { 0, 0 };
+
+	float x = normal_.x / l1;
+	float y = normal_.y / l1;
+	if(normal_.z < 0.0f)
+	{
+		// fold the lower hemisphere over the diagonals
+		float const ox = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float const oy = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = ox;
+		y = oy;
+	}
+	return { QuantiseSnorm16(x), QuantiseSnorm16(y) };
+}
+
+vec3 DecodeOctahedral(int16_t const x_, int16_t const y_)
+{
+	float x = float(x_) / 32767.0f;
+	float y = float(y_) / 32767.0f;
+	float const z = 1.0f - std::abs(x) - std::abs(y);
+	if(z < 0.0f)
+	{
+		float const ox = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float const oy = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = ox;
+		y = oy;
+	}
+	return Normalise(vec3(x, y, z));
+}
+
 };
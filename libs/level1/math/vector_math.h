@@ -21,6 +21,7 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include "glm/gtx/quaternion.hpp"
 #include "glm/gtx/euler_angles.hpp"
+#include <array>
 
 namespace Math
 {
@@ -412,6 +413,11 @@ inline bool IsFinite(const vec4& a)
 
 Plane CreatePlaneFromPoints(size_t pointCount, vec3 const *points);
 
+//! octahedral encodes a unit vector into 2 snorm16s, zero length vectors encode as 0, 0
+std::array<int16_t, 2> EncodeOctahedral(vec3 const& normal_);
+//! returns the unit vector an EncodeOctahedral pair decodes to
+vec3 DecodeOctahedral(int16_t x_, int16_t y_);
+
 inline bool ptInPoly(int nvert, const Math::vec2 *vert, const Math::vec2& test)
 {
 	bool c = false;
@@ -0,0 +1,230 @@
+#include "core/core.h"
+#include "core/filesystem.h"
+#include "binny/bundle.h"
+#include "cityhash/city.h"
+#include "resourcemanager/derivedcache.h"
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <thread>
+
+namespace ResourceManager {
+
+namespace {
+char const* const EntryExtension = ".ddc";
+
+// entries get trimmed down to this fraction of the limit, so a full cache doesn't rescan on every put
+constexpr uint64_t TrimPercentage = 90;
+}
+
+DerivedDataCache::DerivedDataCache(std::string_view directory_, uint64_t maxSizeInBytes_) :
+		directory(directory_),
+		maxSize(maxSizeInBytes_)
+{
+	namespace fs = std::filesystem;
+	std::error_code ec;
+	fs::create_directories(directory, ec);
+	if(!fs::is_directory(directory, ec))
+	{
+		LOG_F(WARNING, "Derived data cache directory %s can't be made", directory.c_str());
+	}
+
+	// processes sharing the directory each need their own temp names
+	std::random_device random;
+	tempCounter.store(random());
+
+	rescan();
+	if(maxSize != 0 && currentSize.load() > maxSize)
+	{
+		trim(maxSize);
+	}
+}
+
+auto DerivedDataCache::getKeyId(Key const& key_) -> uint64_t
+{
+	return CityHash::Hash64((char const*) &key_, sizeof(Key));
+}
+
+auto DerivedDataCache::pathOf(Key const& key_) const -> std::string
+{
+	// the name is the whole key so different keys never share a file
+	char name[80];
+	snprintf(name, sizeof(name), "%08x%08x-%016llx%016llx%s",
+			 key_.opId, key_.opVersion,
+			 (unsigned long long) key_.inputHash, (unsigned long long) key_.parameterHash,
+			 EntryExtension);
+	return (std::filesystem::path(directory) / name).string();
+}
+
+auto DerivedDataCache::get(Key const& key_, std::vector<uint8_t>& out_) -> bool
+{
+	namespace fs = std::filesystem;
+	std::string const path = pathOf(key_);
+	std::ifstream in(path, std::ifstream::in | std::ifstream::binary);
+	if(!in.is_open()) return false;
+
+	in.seekg(0, std::ifstream::end);
+	auto const size = in.tellg();
+	in.seekg(0, std::ifstream::beg);
+	if(size <= 0) return false;
+	out_.resize(size_t(size));
+	in.read((char*) out_.data(), size);
+	bool const readOkay = !in.fail();
+	in.close();
+
+	auto const header = Binny::Bundle::PeekAtHeader(out_.data(), out_.size());
+	if(!readOkay ||
+	   header.first != Binny::Bundle::ErrorCode::Okay ||
+	   header.second != getKeyId(key_))
+	{
+		LOG_F(WARNING, "Derived data cache entry %s is bad, removing it", path.c_str());
+		out_.clear();
+		remove(key_);
+		return false;
+	}
+
+	// the write time is the lru age, someone else trimming it away now is harmless
+	std::error_code ec;
+	fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+	return true;
+}
+
+auto DerivedDataCache::contains(Key const& key_) const -> bool
+{
+	std::error_code ec;
+	return std::filesystem::exists(pathOf(key_), ec);
+}
+
+auto DerivedDataCache::put(Key const& key_, std::vector<uint8_t> const& bundle_) -> bool
+{
+	namespace fs = std::filesystem;
+	auto const header = Binny::Bundle::PeekAtHeader(bundle_.data(), bundle_.size());
+	if(header.first != Binny::Bundle::ErrorCode::Okay || header.second != getKeyId(key_))
+	{
+		LOG_F(WARNING, "Derived data cache put of a bundle without the keys id as user data");
+		return false;
+	}
+
+	std::string const path = pathOf(key_);
+	std::string const tempPath = path + ".tmp" + std::to_string(tempCounter.fetch_add(1));
+	{
+		std::ofstream out(tempPath, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+		if(!out.is_open()) return false;
+		out.write((char const*) bundle_.data(), bundle_.size());
+		if(out.fail())
+		{
+			out.close();
+			std::error_code ec;
+			fs::remove(tempPath, ec);
+			return false;
+		}
+	}
+
+	// rename is atomic so readers see the old entry, the new one or none, never part of one
+	std::error_code ec;
+	fs::rename(tempPath, path, ec);
+	if(ec)
+	{
+		fs::remove(tempPath, ec);
+		return false;
+	}
+
+	uint64_t const size = currentSize.fetch_add(bundle_.size()) + bundle_.size();
+	if(maxSize != 0 && size > maxSize)
+	{
+		trim((maxSize * TrimPercentage) / 100);
+	}
+	return true;
+}
+
+auto DerivedDataCache::put(Key const& key_, std::function<bool(Binny::BundleWriter&)> const& writer_) -> bool
+{
+	Binny::BundleWriter writer;
+	if(!writer_(writer)) return false;
+
+	std::vector<uint8_t> bundle;
+	if(!writer.build(getKeyId(key_), bundle)) return false;
+	return put(key_, bundle);
+}
+
+auto DerivedDataCache::remove(Key const& key_) -> void
+{
+	namespace fs = std::filesystem;
+	std::string const path = pathOf(key_);
+	std::error_code ec;
+	auto const size = fs::file_size(path, ec);
+	if(ec) return;
+	if(fs::remove(path, ec))
+	{
+		uint64_t current = currentSize.load();
+		while(!currentSize.compare_exchange_weak(current, current - std::min(current, uint64_t(size))));
+	}
+}
+
+auto DerivedDataCache::trim(uint64_t maxSizeInBytes_) -> void
+{
+	namespace fs = std::filesystem;
+	std::lock_guard<std::mutex> lock(trimMutex);
+
+	// the disk is the truth as other processes share the directory
+	struct Entry
+	{
+		fs::path path;
+		uint64_t size;
+		fs::file_time_type lastUsed;
+	};
+	std::vector<Entry> entries;
+	uint64_t total = 0;
+	std::error_code ec;
+	for(auto const& file : fs::directory_iterator(directory, ec))
+	{
+		if(file.path().extension() != EntryExtension) continue;
+		std::error_code fileEc;
+		Entry entry{ file.path(), fs::file_size(file.path(), fileEc), fs::last_write_time(file.path(), fileEc) };
+		if(fileEc) continue;
+		total += entry.size;
+		entries.push_back(std::move(entry));
+	}
+
+	std::sort(entries.begin(), entries.end(), [](Entry const& a_, Entry const& b_) { return a_.lastUsed < b_.lastUsed; });
+	for(auto const& entry : entries)
+	{
+		if(total <= maxSizeInBytes_) break;
+		// readers that already have it open keep their copy (on windows the remove just fails)
+		if(fs::remove(entry.path, ec))
+		{
+			total -= entry.size;
+		}
+	}
+	currentSize.store(total);
+}
+
+auto DerivedDataCache::rescan() -> void
+{
+	namespace fs = std::filesystem;
+	auto const staleTempTime = fs::file_time_type::clock::now() - std::chrono::hours(1);
+	uint64_t total = 0;
+	std::error_code ec;
+	for(auto const& file : fs::directory_iterator(directory, ec))
+	{
+		std::string const name = file.path().filename().string();
+		if(file.path().extension() == EntryExtension)
+		{
+			std::error_code fileEc;
+			auto const size = fs::file_size(file.path(), fileEc);
+			if(!fileEc) total += size;
+		} else if(name.find(".tmp") != std::string::npos)
+		{
+			// left by a process that died mid write, anything newer might be a live writer
+			std::error_code fileEc;
+			auto const written = fs::last_write_time(file.path(), fileEc);
+			if(!fileEc && written < staleTempTime)
+			{
+				fs::remove(file.path(), fileEc);
+			}
+		}
+	}
+	currentSize.store(total);
+}
+
+}
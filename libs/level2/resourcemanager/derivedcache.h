@@ -0,0 +1,68 @@
+#pragma once
+#ifndef WYRD_RESOURCEMANANAGER_DERIVEDCACHE_H
+#define WYRD_RESOURCEMANANAGER_DERIVEDCACHE_H
+
+#include "core/core.h"
+#include "binny/bundlewriter.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <atomic>
+
+namespace ResourceManager {
+
+// local disk cache for the results of expensive ops (convex hulls, tactical map builds, mesh cooking etc.)
+// entries are content addressed by what made them, so any number of processes can share a directory.
+// each entry is a binny bundle whose header user data is its key id, written to a temp file and renamed
+// into place so readers never see half an entry. the least recently used entries are deleted when the
+// directory grows past its size limit
+class DerivedDataCache
+{
+public:
+	struct Key
+	{
+		uint32_t opId;			// which op, usually a _bundle_id style fourcc
+		uint32_t opVersion;		// bump when the op changes so old results are ignored
+		uint64_t inputHash;		// e.g. a 64 bit hash of the input mesh
+		uint64_t parameterHash;	// everything else that changes the result
+	};
+
+	// the directory is made if it doesn't exist, 0 size limit never trims
+	DerivedDataCache(std::string_view directory_, uint64_t maxSizeInBytes_);
+
+	// MT safe, false if its not cached (or the file was bad, which is then deleted)
+	auto get(Key const& key_, std::vector<uint8_t>& out_) -> bool;
+	auto contains(Key const& key_) const -> bool;
+
+	// MT safe, bundle_ should have been built with getKeyId(key_) as its user data
+	auto put(Key const& key_, std::vector<uint8_t> const& bundle_) -> bool;
+	// builds the bundle with the right user data, writer_ adds the chunks
+	auto put(Key const& key_, std::function<bool(Binny::BundleWriter&)> const& writer_) -> bool;
+
+	auto remove(Key const& key_) -> void;
+
+	// deletes the least recently used entries until under the size limit (or a 0 limit empties it)
+	auto trim(uint64_t maxSizeInBytes_) -> void;
+	auto getSize() const -> uint64_t { return currentSize.load(); }
+	auto getDirectory() const -> std::string const& { return directory; }
+
+	// hash of the whole key, stored as the bundles user data to catch misnamed files
+	static auto getKeyId(Key const& key_) -> uint64_t;
+
+private:
+	auto pathOf(Key const& key_) const -> std::string;
+	auto rescan() -> void;
+
+	std::string directory;
+	uint64_t maxSize;
+	std::atomic<uint64_t> currentSize{ 0 };
+	std::atomic<uint32_t> tempCounter{ 0 };
+	// only one thread trims at a time, gets and puts don't wait on it
+	std::mutex trimMutex;
+};
+
+}
+
+#endif //WYRD_RESOURCEMANANAGER_DERIVEDCACHE_H
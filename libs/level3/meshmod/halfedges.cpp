@@ -7,6 +7,8 @@
 #include <algorithm>
 #include <string>
 #include <unordered_set>
+#include "core/sharedtasks.h"
+#include <atomic>
 
 namespace MeshMod {
 
@@ -94,12 +96,14 @@ void HalfEdges::remove(HalfEdgeIndex const index)
 		HalfEdgeData::HalfEdge& prevHE = halfEdge(hedge.prev);
 		prevHE.endVertexIndex = hedge.startVertexIndex;
 		prevHE.next = hedge.next;
+		markPairDirty(hedge.prev);
 	}
 	if(hedge.next != InvalidHalfEdgeIndex)
 	{
 		HalfEdgeData::HalfEdge& nextHE = halfEdge(hedge.next);
 		nextHE.startVertexIndex = hedge.endVertexIndex;
 		nextHE.prev = hedge.prev;
+		markPairDirty(hedge.next);
 	}
 
 	// remove from pair's pair 
@@ -107,6 +111,7 @@ void HalfEdges::remove(HalfEdgeIndex const index)
 	{
 		auto& pedge = halfEdge(hedge.pair);
 		pedge.pair = InvalidHalfEdgeIndex;
+		markPairDirty(hedge.pair);
 	}
 
 	// from this half edge from start and end vertex half edge lists
@@ -234,6 +239,7 @@ void HalfEdges::repack()
 
 	// half edge now remapped
 	newHalfEdgeCon.cloneTo(halfEdgesContainer);
+	resetPairTracking();
 
 	auto& vertexHalfEdges = vertices.getAttribute<VertexData::HalfEdges>();
 	for (auto newIndex = 0u; newIndex < getCount(); ++newIndex)
@@ -291,69 +297,271 @@ void HalfEdges::breakPairs()
 	}
 }
 
+namespace {
+// half edges and vertex buckets per task
+constexpr uint32_t PairsPerTask = 8 * 1024;
+constexpr uint32_t BucketsPerTask = 4 * 1024;
+
+//! the other end of an undirected edge, bucketed by the lower vertex index
+struct EdgeEnd
+{
+	VertexIndex maxVertex;
+	HalfEdgeIndex index;
+
+	bool operator<(EdgeEnd const& rhs) const
+	{
+		return (maxVertex < rhs.maxVertex) || (maxVertex == rhs.maxVertex && index < rhs.index);
+	}
+};
+}
+
 /**
 Connects Half edge to the other half edges for the entire mesh.
-Builds the half edge to half edge data structures
+Builds the half edge to half edge data structures.
+Each half edge has an undirected key (min vertex, max vertex), the keys are counting
+sorted into a bucket per min vertex across the shared task threads, then each bucket is sorted by max
+vertex and runs of the same key are paired up. Runs are paired in half edge index order
+so the result doesn't depend on the thread count.
 */
 void HalfEdges::connectPairs()
 {
 	auto const& vertices = owner.getVertices();
 	auto const& polygons = owner.getPolygons();
+	auto& hes = halfEdges();
+	size_t const count = getCount();
+	size_t const vertexCount = vertices.getCount();
 
-	for(auto& poly : polygons.polygons())
+	auto isPairable = [this, &vertices, &polygons, &hes](HalfEdgeIndex const halfEdgeIndex) -> bool
+	{
+		if(!isValid(halfEdgeIndex)) return false;
+		auto const& he = hes[halfEdgeIndex];
+		return polygons.isValid(he.polygonIndex) &&
+			   vertices.isValid(he.startVertexIndex) &&
+			   vertices.isValid(he.endVertexIndex);
+	};
+
+	// count half edges per min vertex
+	std::vector<std::atomic<uint32_t>> bucketStarts(vertexCount + 1);
+	Core::ParallelFor(uint32_t(count), PairsPerTask, [&](uint32_t begin_, uint32_t end_, uint32_t)
 	{
-		if(!polygons.isValid(poly)) continue;
+		for(size_t i = begin_; i != end_; ++i)
+		{
+			HalfEdgeIndex const halfEdgeIndex = HalfEdgeIndex(i);
+			if(!isPairable(halfEdgeIndex)) continue;
+			auto const& he = hes[halfEdgeIndex];
+			size_t const minVertex = size_t(std::min(he.startVertexIndex, he.endVertexIndex));
+			bucketStarts[minVertex].fetch_add(1, std::memory_order_relaxed);
+		}
+	});
 
-		const HalfEdgeIndex firstEdge = poly.anyHalfEdge;
-		HalfEdgeIndex halfEdgeIndex = firstEdge;
+	// turn counts into bucket starts
+	uint32_t total = 0;
+	for(auto& bucket : bucketStarts)
+	{
+		uint32_t const bucketCount = bucket.load(std::memory_order_relaxed);
+		bucket.store(total, std::memory_order_relaxed);
+		total += bucketCount;
+	}
 
-		do
+	// scatter, order in a bucket depends on threads so is fixed by the sort below
+	std::vector<EdgeEnd> edgeEnds(total);
+	std::vector<uint32_t> bucketEnds(vertexCount);
+	for(size_t i = 0; i < vertexCount; ++i)
+	{
+		bucketEnds[i] = bucketStarts[i].load(std::memory_order_relaxed);
+	}
+	Core::ParallelFor(uint32_t(count), PairsPerTask, [&](uint32_t begin_, uint32_t end_, uint32_t)
+	{
+		for(size_t i = begin_; i != end_; ++i)
 		{
-			if (!isValid(halfEdgeIndex)) break;
-
-			// scan around edges attached to the start vertex of this edge
-			// pair up any edge with the same start and end
-			HalfEdgeData::HalfEdge& he = halfEdge(halfEdgeIndex);
-			VertexIndex startVert = he.startVertexIndex;
-			VertexIndex endVert = he.endVertexIndex;
-			if (startVert == InvalidVertexIndex || 
-				endVert == InvalidVertexIndex)
-				break;
-
-			// swap indices for consistent ordering
-			if(startVert > endVert)
-			{
-				std::swap(startVert, endVert);
-			}
-			auto const& vertexHalfEdges = vertices.getAttribute<VertexData::HalfEdges>();
+			HalfEdgeIndex const halfEdgeIndex = HalfEdgeIndex(i);
+			if(!isPairable(halfEdgeIndex)) continue;
+			auto const& he = hes[halfEdgeIndex];
+			size_t const minVertex = size_t(std::min(he.startVertexIndex, he.endVertexIndex));
+			uint32_t const slot = bucketStarts[minVertex].fetch_add(1, std::memory_order_relaxed);
+			edgeEnds[slot] = { std::max(he.startVertexIndex, he.endVertexIndex), halfEdgeIndex };
+		}
+	});
+
+	Core::ParallelFor(uint32_t(vertexCount), BucketsPerTask, [&](uint32_t begin_, uint32_t end_, uint32_t)
+	{
+		for(size_t v = begin_; v != end_; ++v)
+		{
+			// after the scatter bucketStarts[v] is the end of bucket v
+			auto const bucketBegin = edgeEnds.begin() + bucketEnds[v];
+			auto const bucketEnd = edgeEnds.begin() + bucketStarts[v].load(std::memory_order_relaxed);
+			std::sort(bucketBegin, bucketEnd);
 
-			//iterate through the edges connect to the start vertex
-			for(auto vheIndex : vertexHalfEdges.at(startVert).halfEdgeIndexContainer)
+			auto runStart = bucketBegin;
+			while(runStart != bucketEnd)
 			{
-				// check that we are not working on our own edge
-				if(vheIndex != halfEdgeIndex)
+				auto runEnd = runStart + 1;
+				while(runEnd != bucketEnd && runEnd->maxVertex == runStart->maxVertex)
 				{
-					// does this edge have the same start and end vertex indices, if so its a pair
-					HalfEdgeData::HalfEdge& e0 = halfEdge(vheIndex);
-					HalfEdgeData::HalfEdge& e1 = halfEdge(halfEdgeIndex);
-					if (e0.pair == InvalidHalfEdgeIndex && e1.pair == InvalidHalfEdgeIndex)
+					++runEnd;
+				}
+
+				// 2 manifold edges have a run of 2, more is supported badly, prefer
+				// opposite direction half edges but fallback to any unpaired one
+				for(auto i = runStart; i != runEnd; ++i)
+				{
+					auto& e0 = hes[i->index];
+					if(e0.pair != InvalidHalfEdgeIndex) continue;
+
+					auto match = runEnd;
+					for(auto j = i + 1; j != runEnd; ++j)
 					{
-						if (((e0.startVertexIndex == startVert) &&
-							(e0.endVertexIndex == endVert)) ||
-							((e0.startVertexIndex == endVert) &&
-							(e0.endVertexIndex == startVert)))
+						auto const& e1 = hes[j->index];
+						if(e1.pair != InvalidHalfEdgeIndex) continue;
+						if(match == runEnd) match = j;
+						if(e1.startVertexIndex == e0.endVertexIndex)
 						{
-							e0.pair = halfEdgeIndex;
-							e1.pair = vheIndex;
+							match = j;
+							break;
 						}
 					}
+
+					if(match != runEnd)
+					{
+						e0.pair = match->index;
+						hes[match->index].pair = i->index;
+					}
 				}
+
+				runStart = runEnd;
 			}
-			halfEdgeIndex = he.next;
-		} while(halfEdgeIndex != firstEdge);
+		}
+	});
+
+	pairedCount = count;
+	pairDirtyList.clear();
+}
+
+/**
+Pairs a single half edge if a unpaired match can be found.
+Scans the edges attached to the start vertex of this edge, to find one with the same
+start and end
+*/
+void HalfEdges::connectPair(HalfEdgeIndex const halfEdgeIndex)
+{
+	auto const& vertices = owner.getVertices();
+	auto const& polygons = owner.getPolygons();
+
+	if(!isValid(halfEdgeIndex)) return;
+
+	HalfEdgeData::HalfEdge& e1 = halfEdge(halfEdgeIndex);
+	if(e1.pair != InvalidHalfEdgeIndex) return;
+	if(!polygons.isValid(e1.polygonIndex)) return;
+
+	VertexIndex startVert = e1.startVertexIndex;
+	VertexIndex endVert = e1.endVertexIndex;
+	if(!vertices.isValid(startVert) || !vertices.isValid(endVert)) return;
+
+	// swap indices for consistent ordering
+	if(startVert > endVert)
+	{
+		std::swap(startVert, endVert);
+	}
+	auto const& vertexHalfEdges = vertices.getAttribute<VertexData::HalfEdges>();
+
+	HalfEdgeIndex match = InvalidHalfEdgeIndex;
+	for(auto vheIndex : vertexHalfEdges[startVert].halfEdgeIndexContainer)
+	{
+		// check that we are not working on our own edge
+		if(vheIndex == halfEdgeIndex || !isValid(vheIndex)) continue;
+
+		// does this edge have the same start and end vertex indices, if so its a pair
+		HalfEdgeData::HalfEdge const& e0 = halfEdge(vheIndex);
+		if(e0.pair != InvalidHalfEdgeIndex) continue;
+		if(!polygons.isValid(e0.polygonIndex)) continue;
+
+		if(e0.startVertexIndex == e1.endVertexIndex && e0.endVertexIndex == e1.startVertexIndex)
+		{
+			match = vheIndex;
+			break;
+		}
+		if(match == InvalidHalfEdgeIndex &&
+			e0.startVertexIndex == e1.startVertexIndex && e0.endVertexIndex == e1.endVertexIndex)
+		{
+			match = vheIndex;
+		}
+	}
+
+	if(match != InvalidHalfEdgeIndex)
+	{
+		halfEdge(match).pair = halfEdgeIndex;
+		e1.pair = match;
 	}
 }
 
+void HalfEdges::updatePairs()
+{
+	size_t const count = getCount();
+	if(pairedCount > count) pairedCount = 0;
+
+	// if lots has changed, its quicker to do it all again
+	size_t const changedCount = (count - pairedCount) + pairDirtyList.size();
+	if(pairedCount == 0 || changedCount * 4 > count)
+	{
+		breakPairs();
+		connectPairs();
+		return;
+	}
+
+	// first unpair every changed half edge, which may free up its old pair
+	HalfEdgeIndexContainer toConnect;
+	toConnect.reserve(changedCount * 2);
+	auto& hes = halfEdges();
+
+	auto unpair = [this, &hes, &toConnect](HalfEdgeIndex const index)
+	{
+		auto& he = hes[index];
+		if(he.pair != InvalidHalfEdgeIndex)
+		{
+			auto& pairHe = hes[he.pair];
+			if(pairHe.pair == index)
+			{
+				pairHe.pair = InvalidHalfEdgeIndex;
+				toConnect.push_back(he.pair);
+			}
+			he.pair = InvalidHalfEdgeIndex;
+		}
+		toConnect.push_back(index);
+	};
+
+	for(auto index : pairDirtyList)
+	{
+		if(size_t(index) < count) unpair(index);
+	}
+	for(size_t i = pairedCount; i < count; ++i)
+	{
+		unpair(HalfEdgeIndex(i));
+	}
+
+	std::sort(toConnect.begin(), toConnect.end());
+	toConnect.erase(std::unique(toConnect.begin(), toConnect.end()), toConnect.end());
+	for(auto index : toConnect)
+	{
+		connectPair(index);
+	}
+
+	pairedCount = count;
+	pairDirtyList.clear();
+}
+
+void HalfEdges::markPairDirty(HalfEdgeIndex const index)
+{
+	// new half edges are always rechecked
+	if(size_t(index) >= pairedCount) return;
+	pairDirtyList.push_back(index);
+}
+
+void HalfEdges::resetPairTracking()
+{
+	pairedCount = 0;
+	pairDirtyList.clear();
+}
+
 void HalfEdges::visitAll(std::function<void(HalfEdgeIndex const)> const& func)
 {
 	for (auto i = 0u; i < halfEdgesContainer.size(); ++i)
@@ -364,14 +572,7 @@ void HalfEdges::visitAll(std::function<void(HalfEdgeIndex const)> const& func)
 
 void HalfEdges::visitValid(std::function<void(HalfEdgeIndex const)> const& func)
 {
-	for (auto i = 0u; i < halfEdgesContainer.size(); ++i)
-	{
-		HalfEdgeIndex hei{ i };
-		if (isValid(hei))
-		{
-			func(hei);
-		}
-	}
+	forEachValid(func);
 }
 
 void HalfEdges::visitLoop(HalfEdgeIndex const firstHalfEdgeIndex, std::function<void(HalfEdgeIndex const)> const& func)
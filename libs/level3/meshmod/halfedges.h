@@ -41,6 +41,12 @@ public:
 	//! has the half edges been deleted, return false if deleted.
 	bool isValid(HalfEdgeIndex const index) const { return halfEdgesContainer.isValid(index); }
 
+	//! template version of visitValid, func is inlined rather than called via std::function
+	template<typename Func> void forEachValid(Func&& func) const
+	{
+		halfEdgesContainer.forEachValid(std::forward<Func>(func));
+	}
+
 	void visitAll(std::function<void(HalfEdgeIndex const)> const& func);
 	void visitValid(std::function<void(HalfEdgeIndex const)> const& func);
 
@@ -55,14 +61,33 @@ public:
 	void breakPairs();
 
 	//! finds and hooks up any unpaired edges that should be paired.
+	//! matches by sorting undirected edge keys across threads.
 	void connectPairs();
 
+	//! only re-pairs half edges added or marked dirty since the pairs were last built.
+	//! falls back to breakPairs/connectPairs if a large part of the mesh changed
+	void updatePairs();
+
+	//! the half edge vertices or validity have changed, so its pair needs rechecking
+	void markPairDirty(HalfEdgeIndex const index);
+
+	//! forget what is paired, the next updatePairs will be a full rebuild
+	void resetPairTracking();
+
 protected:
 	void repack();
 
+	//! pairs a single half edge by searching its start vertex half edges
+	void connectPair(HalfEdgeIndex const index);
+
 	Mesh& owner;
 	//! half edge elements container.
 	HalfEdgeElementsContainer halfEdgesContainer;
+
+	//! half edges below this index had correct pairs when pairs were last built
+	size_t pairedCount = 0;
+	//! half edges below pairedCount that have changed since
+	HalfEdgeIndexContainer pairDirtyList;
 };
 
 inline HalfEdgeData::HalfEdge const& HalfEdges::halfEdge(HalfEdgeIndex const index) const
@@ -78,23 +103,23 @@ inline HalfEdgeData::HalfEdge& HalfEdges::halfEdge(HalfEdgeIndex const index)
 
 inline HalfEdgeData::HalfEdges const& HalfEdges::halfEdges() const
 {
-	return *halfEdgesContainer.getElement<HalfEdgeData::HalfEdges>();
+	return *halfEdgesContainer.getElementPtr<HalfEdgeData::HalfEdges>();
 }
 
 inline HalfEdgeData::HalfEdges& HalfEdges::halfEdges()
 {
-	return *halfEdgesContainer.getElement<HalfEdgeData::HalfEdges>();
+	return *halfEdgesContainer.getElementPtr<HalfEdgeData::HalfEdges>();
 }
 
 template<typename attribute>
 inline attribute const& HalfEdges::getAttributes() const
 {
-	return *halfEdgesContainer.getElement<attribute>();
+	return *halfEdgesContainer.getElementPtr<attribute>();
 }
 template<typename attribute>
 inline attribute& HalfEdges::getAttributes()
 {
-	return *halfEdgesContainer.getElement<attribute>();
+	return *halfEdgesContainer.getElementPtr<attribute>();
 }
 template<typename attribute>
 inline attribute& HalfEdges::getOrAddAttributes()
@@ -19,7 +19,9 @@
 #include "meshmod/vertexdata/vertexcontainers.h"
 #include "meshmod/vertexdata/positionvertex.h"
 #include "meshmod/vertexdata/pointrepvertex.h"
+#include "meshmod/vertexdata/normalvertex.h"
 #include "meshmod/halfedgedata/halfedgecontainers.h"
+#include "meshmod/polygonsdata/polygoncontainers.h"
 
 namespace
 {
@@ -69,6 +71,7 @@ Mesh::Mesh(const Mesh& rhs) :
 {
 	edits = rhs.edits;
 	maintain = rhs.maintain;
+	editedPositions = rhs.editedPositions;
 
 	rhs.vertices.getVerticesContainer().cloneTo(vertices.getVerticesContainer());
 
@@ -83,10 +86,12 @@ Mesh& Mesh::operator=(Mesh const& rhs)
 
 	vertices.getVerticesContainer().clear();
 	halfEdges.getHalfEdgesContainer().clear();
+	halfEdges.resetPairTracking();
 	polygons.getPolygonsContainer().clear();
 
 	edits = rhs.edits;
 	maintain = rhs.maintain;
+	editedPositions = rhs.editedPositions;
 	rhs.vertices.getVerticesContainer().cloneTo(vertices.getVerticesContainer());
 	rhs.halfEdges.getHalfEdgesContainer().cloneTo(halfEdges.getHalfEdgesContainer());
 	rhs.polygons.getPolygonsContainer().cloneTo(polygons.getPolygonsContainer());
@@ -108,35 +113,39 @@ void Mesh::updateEditState( MeshMod::Mesh::EditState editState_ )
 	edits |= editState_;
 }
 
+void Mesh::markPositionEdited( VertexIndex const vertexIndex_ )
+{
+	editedPositions.push_back(vertexIndex_);
+	edits |= PartialPositionEdits;
+}
+
+void Mesh::removeDerived( DerivedType change )
+{
+	vertices.getVerticesContainer().removeDerived( change );
+	halfEdges.getHalfEdgesContainer().removeDerived( change );
+	polygons.getPolygonsContainer().removeDerived( change );
+	materialContainer.removeDerived( change );
+}
+
 void Mesh::updateFromEdits()
 {
+	// derived types are ordered, removing one removes everything after it as well
 	if( edits & TopologyEdits)
 	{
-		vertices.getVerticesContainer().removeDerived( DerivedFromTopology );
-		halfEdges.getHalfEdgesContainer().removeDerived( DerivedFromTopology );
-		polygons.getPolygonsContainer().removeDerived( DerivedFromTopology );
-		materialContainer.removeDerived( DerivedFromTopology );
+		removeDerived( DerivedFromTopology );
 		edits |= MaintenanceEdits;
-	} else if(edits & TopologyAttributesEdits)
-	{
-		vertices.getVerticesContainer().removeDerived( DerivedFromAttributes );
-		halfEdges.getHalfEdgesContainer().removeDerived( DerivedFromAttributes );
-		polygons.getPolygonsContainer().removeDerived( DerivedFromAttributes );
-		materialContainer.removeDerived( DerivedFromAttributes );
 	} else if(edits & PositionEdits)
 	{
-		vertices.getVerticesContainer().removeDerived( DerivedFromPositions );
-		halfEdges.getHalfEdgesContainer().removeDerived( DerivedFromPositions );
-		polygons.getPolygonsContainer().removeDerived( DerivedFromPositions );
-		materialContainer.removeDerived( DerivedFromPositions );
+		removeDerived( DerivedFromPositions );
 		edits |= MaintenanceEdits;
-	} else if(edits & VertexAttributeEdits)
+	} else if(edits & PartialPositionEdits)
+	{
+		updateEditedPositions();
+	} else if(edits & (TopologyAttributesEdits | VertexAttributeEdits))
 	{
-		vertices.getVerticesContainer().removeDerived( DerivedFromAttributes );
-		halfEdges.getHalfEdgesContainer().removeDerived( DerivedFromAttributes );
-		polygons.getPolygonsContainer().removeDerived( DerivedFromAttributes );
-		materialContainer.removeDerived( DerivedFromAttributes );
+		removeDerived( DerivedFromAttributes );
 	}
+	editedPositions.clear();
 
 	if (edits & MaintenanceEdits)
 	{
@@ -148,16 +157,112 @@ void Mesh::updateFromEdits()
 
 		if (maintain & Maintenance::EdgeConnections)
 		{
-			halfEdges.breakPairs();
-			halfEdges.connectPairs();
+			halfEdges.updatePairs();
 		}
 	}
 
+	// pairs aren't being kept up to date, so can't be incrementally updated later
+	if (!(maintain & Maintenance::EdgeConnections))
+	{
+		halfEdges.resetPairTracking();
+	}
+
 	validate();
 
 	edits = NoEdits;
 }
 
+void Mesh::updateEditedPositions()
+{
+	auto& vertCon = vertices.getVerticesContainer();
+	auto& polyCon = polygons.getPolygonsContainer();
+
+	std::sort(editedPositions.begin(), editedPositions.end());
+	editedPositions.erase(std::unique(editedPositions.begin(), editedPositions.end()), editedPositions.end());
+	editedPositions.erase(std::remove_if(editedPositions.begin(), editedPositions.end(),
+			[this](VertexIndex const vertexIndex) { return !vertices.isValid(vertexIndex); }),
+			editedPositions.end());
+
+	// point reps, plane equations and normals are patched, anything else derived from positions goes
+	vertCon.removeDerivedExcept( DerivedFromPositions, {
+			VerticesElementsContainer::slotOf<VertexData::PointReps>(),
+			VerticesElementsContainer::slotOf<VertexData::Normals>() } );
+	polyCon.removeDerivedExcept( DerivedFromPositions, {
+			PolygonElementsContainer::slotOf<PolygonData::PlaneEquations>() } );
+	halfEdges.getHalfEdgesContainer().removeDerived( DerivedFromPositions );
+	materialContainer.removeDerived( DerivedFromPositions );
+
+	auto* pointReps = vertCon.getElementPtr<VertexData::PointReps>();
+	auto* normals = vertCon.getElementPtr<VertexData::Normals>();
+	auto* planeEquations = polyCon.getElementPtr<PolygonData::PlaneEquations>();
+
+	// normals sum over similar vertices, so ones that were similar before the move change too
+	VertexIndexContainer touched;
+	auto addSimilar = [&touched, &pointReps](VertexIndex const vertexIndex)
+	{
+		touched.push_back(vertexIndex);
+		if(pointReps == nullptr || (*pointReps)[vertexIndex].next == InvalidVertexIndex) return;
+		for(VertexIndex i = (*pointReps)[vertexIndex].next; i != vertexIndex; i = (*pointReps)[i].next)
+		{
+			touched.push_back(i);
+		}
+	};
+	if(normals)
+	{
+		for(auto const vertexIndex : editedPositions) addSimilar(vertexIndex);
+	}
+
+	if(maintain & Maintenance::PointReps)
+	{
+		vertices.updatePointReps(editedPositions);
+		pointReps = vertCon.getElementPtr<VertexData::PointReps>();
+	} else if(pointReps)
+	{
+		vertCon.removeElements<VertexData::PointReps>();
+		pointReps = nullptr;
+	}
+
+	if(planeEquations == nullptr && normals == nullptr) return;
+
+	// every polygon using a moved vertex has a new plane
+	PolygonIndexContainer movedPolygons;
+	auto const& vertexHalfEdges = vertices.getAttribute<VertexData::HalfEdges>();
+	for(auto const vertexIndex : editedPositions)
+	{
+		for(auto const halfEdgeIndex : vertexHalfEdges[vertexIndex].halfEdgeIndexContainer)
+		{
+			if(!halfEdges.isValid(halfEdgeIndex)) continue;
+			PolygonIndex const polygonIndex = halfEdges.halfEdge(halfEdgeIndex).polygonIndex;
+			if(polygons.isValid(polygonIndex)) movedPolygons.push_back(polygonIndex);
+		}
+	}
+	std::sort(movedPolygons.begin(), movedPolygons.end());
+	movedPolygons.erase(std::unique(movedPolygons.begin(), movedPolygons.end()), movedPolygons.end());
+
+	if(planeEquations)
+	{
+		for(auto const polygonIndex : movedPolygons) planeEquations->markStale(polygonIndex);
+	}
+
+	// and every vertex of those polygons (and anything similar to them) has a new normal
+	if(normals)
+	{
+		VertexIndexContainer polygonVertices;
+		for(auto const polygonIndex : movedPolygons)
+		{
+			polygonVertices.clear();
+			polygons.getVertexIndices(polygonIndex, polygonVertices);
+			for(auto const vertexIndex : polygonVertices)
+			{
+				if(vertices.isValid(vertexIndex)) addSimilar(vertexIndex);
+			}
+		}
+		std::sort(touched.begin(), touched.end());
+		touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+		for(auto const vertexIndex : touched) normals->markStale(vertexIndex);
+	}
+}
+
 namespace {
 
 //! links a float (X) to the vertex index
@@ -306,6 +411,7 @@ void Mesh::cleanAndRepack()
 	}
 
 	halfEdges.getHalfEdgesContainer().clear();
+	halfEdges.resetPairTracking();
 	polygons.getPolygonsContainer().clear();
 	polygons.getPolygonsContainer().addElements<PolygonData::Polygons>();
 	halfEdges.getHalfEdgesContainer().addElements<HalfEdgeData::HalfEdges>();
@@ -84,7 +84,8 @@ public:
 		PositionEdits = 0x2,			// vertex positions have changed
 		TopologyAttributesEdits = 0x4,	// topology based attributes (not actual topology changed)
 		TopologyEdits = 0x8,			// topology (polygons/half edges) changed
-		MaintenanceEdits = 0x16,			// change to the Maintenance settings
+		MaintenanceEdits = 0x10,		// change to the Maintenance settings
+		PartialPositionEdits = 0x20,	// only the positions passed to markPositionEdited have changed
 	};
 
 	//! ctor.
@@ -108,10 +109,17 @@ public:
 	uint32_t getEdited() const { return edits; }
 	void updateFromEdits();
 
+	//! record that just this vertex has moved. on the next updateFromEdits point reps
+	//! are patched and only the plane equations and normals around it are marked stale
+	//! (see Elements::staleItems), a PositionEdits in the meantime overrides this
+	void markPositionEdited(VertexIndex const vertexIndex_);
+	//! positions have changed since the last updateFromEdits
+	auto hasPendingPositionEdits() const -> bool { return edits & (PositionEdits | PartialPositionEdits); }
+
 	auto isMaintainPointReps() -> bool { return maintain & Maintenance::PointReps; }
 	auto isMaintainEdgeConnections() -> bool { return maintain & Maintenance::EdgeConnections; }
-	void maintainPointReps(bool enable) { maintain &= ~Maintenance::PointReps; maintain |= enable ? Maintenance::PointReps : 0; edits |= MaintenanceEdits; }
-	void maintainEdgeConnections(bool enable) { maintain &= ~Maintenance::EdgeConnections; maintain |= enable ? Maintenance::EdgeConnections : 0; edits |= MaintenanceEdits; };
+	void maintainPointReps(bool enable) { uint32_t const old = maintain; maintain &= ~Maintenance::PointReps; maintain |= enable ? Maintenance::PointReps : 0; if(maintain != old) edits |= MaintenanceEdits; }
+	void maintainEdgeConnections(bool enable) { uint32_t const old = maintain; maintain &= ~Maintenance::EdgeConnections; maintain |= enable ? Maintenance::EdgeConnections : 0; if(maintain != old) edits |= MaintenanceEdits; };
 
 	Vertices& getVertices() { return vertices; }
 	Vertices const& getVertices() const { return vertices; }
@@ -145,7 +153,15 @@ protected:
 	// 
 	void cleanAndRepackWIP();
 
+	// removes derived data from all the containers
+	void removeDerived(DerivedType change);
+
+	// patches derived data around editedPositions
+	void updateEditedPositions();
+
 	uint32_t edits;
+	//! vertices passed to markPositionEdited since the last updateFromEdits
+	VertexIndexContainer editedPositions;
 	enum Maintenance
 	{
 		PointReps 		= 0x1,
@@ -368,14 +368,7 @@ void Polygons::visitAll(std::function<void(PolygonIndex const)> const& func) con
 
 void Polygons::visitValid(std::function<void(PolygonIndex const)> const& func) const
 {
-	for (auto i = 0u; i < polygonsContainer.size(); ++i)
-	{
-		PolygonIndex pi{ i };
-		if (isValid(pi))
-		{
-			func(pi);
-		}
-	}
+	forEachValid(func);
 }
 
 }
\ No newline at end of file
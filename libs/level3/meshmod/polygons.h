@@ -45,6 +45,12 @@ public:
 	bool isValid(PolygonData::Polygons::const_iterator polyIt) const;
 	bool isValid(PolygonData::Polygon const& poly) const;
 
+	//! template version of visitValid, func is inlined rather than called via std::function
+	template<typename Func> void forEachValid(Func&& func) const
+	{
+		polygonsContainer.forEachValid(std::forward<Func>(func));
+	}
+
 	void visitAll(std::function<void(PolygonIndex const)> const& func) const;
 	void visitValid(std::function<void(PolygonIndex const)> const& func) const;
 	void visitValidVertices(std::function<void(PolygonIndex const, VertexIndex const)> const& func) const;
@@ -88,29 +94,29 @@ inline PolygonData::Polygon& Polygons::polygon(MeshMod::PolygonIndex const index
 
 inline PolygonData::Polygons const& Polygons::polygons() const
 {
-	return *polygonsContainer.getElement<PolygonData::Polygons>();
+	return *polygonsContainer.getElementPtr<PolygonData::Polygons>();
 }
 
 inline PolygonData::Polygons& Polygons::polygons()
 {
-	return *polygonsContainer.getElement<PolygonData::Polygons>();
+	return *polygonsContainer.getElementPtr<PolygonData::Polygons>();
 }
 
 template<typename attribute>
 inline bool Polygons::hasAttribute() const
 {
-	return polygonsContainer.getElement<attribute>() != nullptr;
+	return polygonsContainer.getElementPtr<attribute>() != nullptr;
 }
 template<typename attribute>
 inline attribute const& Polygons::getAttribute() const
 {
-	assert(polygonsContainer.getElement<attribute>() != nullptr);
-	return *polygonsContainer.getElement<attribute>();
+	assert(polygonsContainer.getElementPtr<attribute>() != nullptr);
+	return *polygonsContainer.getElementPtr<attribute>();
 }
 template<typename attribute>
 inline attribute& Polygons::getAttribute()
 {
-	return *polygonsContainer.getElement<attribute>();
+	return *polygonsContainer.getElementPtr<attribute>();
 }
 template<typename attribute>
 inline attribute& Polygons::getOrAddAttribute()
@@ -32,7 +32,7 @@ template<DerivedType derived> using Float1Tuples = MeshMod::Float1Tuples<Polygon
 template<DerivedType derived> using UnsignedInt1Tuples = MeshMod::UnsignedInt1Tuples<Polygon_, derived>;
 
 typedef BaseElements<PolygonData::Polygon, Polygon_, false, DerivedType::NotDerived> Polygons;
-typedef BaseElements<PolygonData::PlaneEquation, Polygon_, false, DerivedType::DerivedFromTopology> PlaneEquations;
+typedef BaseElements<PolygonData::PlaneEquation, Polygon_, false, DerivedType::DerivedFromPositions> PlaneEquations;
 typedef BaseElements<PolygonData::SortIndex, Polygon_, false, DerivedType::NotDerived> SortIndices;
 typedef BaseElements<PolygonData::Material, Polygon_, false, DerivedType::NotDerived> Materials;
 
@@ -8,9 +8,13 @@
 #define MESH_MOD_VARICONTAINER_H_
 
 #include "core/core.h"
+#include "math/scalar_math.h"
 #include <string>
 #include <vector>
 #include <string_view>
+#include <initializer_list>
+#include <algorithm>
+#include <stdexcept>
 #include "varielements.h"
 
 namespace MeshMod {
@@ -28,21 +32,66 @@ public:
 	auto isValid(IndexType elementIndex) const -> bool
 	{
 		if(elementIndex == IndexType(~0u)) return false;
-		return !notValids.at(size_t(elementIndex));
+		size_t const index = checkedIndex(elementIndex);
+		return (validBits[index >> 6] >> (index & 63)) & 1;
 	}
 
 	void setValid(IndexType elementIndex_, bool valid_)
 	{
-		notValids.at(size_t(elementIndex_)) = !valid_;
+		size_t const index = checkedIndex(elementIndex_);
+		uint64_t const bit = uint64_t(1) << (index & 63);
+		if(valid_) validBits[index >> 6] |= bit;
+		else validBits[index >> 6] &= ~bit;
 	}
 
-	void resetValidFlags() 
+	void resetValidFlags()
 	{
-		for(auto& nv : notValids)
+		std::fill(validBits.begin(), validBits.end(), ~uint64_t(0));
+		maskTailBits();
+	}
+
+	//! how many of the element items are valid
+	auto getValidCount() const -> size_t
+	{
+		size_t count = 0;
+		for(auto const word : validBits)
+		{
+			count += Math::popCount(word);
+		}
+		return count;
+	}
+
+	//! calls func_(IndexType) for every valid element item, in index order.
+	//! skips 64 invalid items at a time and inlines func_ unlike visitValid
+	template<typename Func>
+	void forEachValid(Func&& func_) const
+	{
+		forEachValidInRange(0, validCount, std::forward<Func>(func_));
+	}
+
+	//! as forEachValid but only for items in [begin_, end_)
+	template<typename Func>
+	void forEachValidInRange(size_t begin_, size_t end_, Func&& func_) const
+	{
+		assert(end_ <= validCount);
+		if(begin_ >= end_) return;
+
+		size_t const lastWord = (end_ - 1) >> 6;
+		for(size_t w = begin_ >> 6; w <= lastWord; ++w)
 		{
-			nv = false;
+			uint64_t word = validBits[w];
+			if(w == (begin_ >> 6)) word &= ~uint64_t(0) << (begin_ & 63);
+			if(w == lastWord && (end_ & 63) != 0) word &= ~(~uint64_t(0) << (end_ & 63));
+
+			while(word != 0)
+			{
+				size_t const bit = Math::countTrailingZeros(word);
+				func_(IndexType((w << 6) + bit));
+				word &= word - 1;
+			}
 		}
 	}
+
 	auto resizeForNewElement() -> IndexType;
 
 	void resize(size_t const size_);
@@ -97,6 +146,7 @@ public:
 				elements.erase(it);
 			}
 		}
+		rebuildSlots();
 	}
 
 
@@ -139,7 +189,7 @@ public:
 			if(pType->size() == 0)
 			{
 				pType->push_back(data);
-				notValids.push_back(false);
+				pushValid(true);
 			} else
 			{
 				pType->getElement(0) = data;
@@ -148,20 +198,42 @@ public:
 		{
 			Type *pType = getElement<Type>(subName);
 			pType->push_back(data);
-			notValids.push_back(false);
+			pushValid(true);
 		}
 	}
 
 	template<typename Type>
 	auto getElement() -> std::shared_ptr<Type>
 	{
-		return std::static_pointer_cast<Type>(getElement(Type::DataType::getName()));
+		auto const* slot = findSlot(ElementSlots<CT>::template get<typename Type::DataType>(), Type::DataType::getName());
+		if(slot == nullptr) return {};
+		return std::static_pointer_cast<Type>(*slot);
 	}
 
 	template<typename Type>
 	auto getElement() const -> std::shared_ptr<Type const>
 	{
-		return std::static_pointer_cast<Type const>(getElement(Type::DataType::getName()));
+		auto const* slot = findSlot(ElementSlots<CT>::template get<typename Type::DataType>(), Type::DataType::getName());
+		if(slot == nullptr) return {};
+		return std::static_pointer_cast<Type const>(*slot);
+	}
+
+	//! O(1) raw access to the first element of Type, nullptr if not present.
+	//! the pointer stays valid until elements are added or removed
+	template<typename Type>
+	auto getElementPtr() -> Type*
+	{
+		auto const* slot = findSlot(ElementSlots<CT>::template get<typename Type::DataType>(), Type::DataType::getName());
+		if(slot == nullptr) return nullptr;
+		return static_cast<Type*>(slot->get());
+	}
+
+	template<typename Type>
+	auto getElementPtr() const -> Type const*
+	{
+		auto const* slot = findSlot(ElementSlots<CT>::template get<typename Type::DataType>(), Type::DataType::getName());
+		if(slot == nullptr) return nullptr;
+		return static_cast<Type const*>(slot->get());
 	}
 
 	template<typename Type>
@@ -206,32 +278,113 @@ public:
 
 	void removeDerived(DerivedType change);
 
+	//! as removeDerived but the element types whose slots are in keep_ are left alone, for
+	//! derived data that is patched up incrementally (see Elements::staleItems)
+	void removeDerivedExcept(DerivedType change, std::initializer_list<uint32_t> keep_);
+
+	//! the slot key used for Type by this container (see ElementSlots)
+	template<typename Type>
+	static auto slotOf() -> uint32_t { return ElementSlots<CT>::template get<typename Type::DataType>(); }
+
 private:
-	// we have a flag per element item saying if that element item is not valid
 	using elementContainer = std::vector<std::shared_ptr<ContainerType>>;
-	using notValidContainer = std::vector<uint8_t>;
+
+	// keep the bits past the last element clear so whole words can be counted
+	void maskTailBits()
+	{
+		if((validCount & 63) != 0)
+		{
+			validBits.back() &= ~(~uint64_t(0) << (validCount & 63));
+		}
+	}
+
+	// out of range throws like the vector::at this replaced
+	auto checkedIndex(IndexType elementIndex_) const -> size_t
+	{
+		size_t const index = size_t(elementIndex_);
+		if(index >= validCount) throw std::out_of_range("VariContainer element index out of range");
+		return index;
+	}
+
+	// linear probe for key_, the table always has an empty slot to stop on. names are only
+	// compared when the keys match, a different name with the same key is a hash clash so keep going
+	auto findSlot(uint32_t key_, std::string_view name_) const -> std::shared_ptr<ContainerType> const*
+	{
+		if(slots.empty()) return nullptr;
+		size_t const mask = slots.size() - 1;
+		for(size_t i = key_ & mask;; i = (i + 1) & mask)
+		{
+			auto const& slot = slots[i];
+			if(!slot) return nullptr;
+			if(slot->slot == key_ && slot->name == name_) return &slot;
+		}
+	}
+
+	void pushValid(bool valid_)
+	{
+		size_t const index = validCount++;
+		if((index >> 6) >= validBits.size()) validBits.push_back(0);
+		setValid(IndexType(index), valid_);
+	}
+
+	// called whenever the set of elements changes
+	void rebuildSlots();
 
 	elementContainer elements;
-	notValidContainer notValids;
+
+	// the first element of each data type, open addressed by ElementSlots key
+	elementContainer slots;
+
+	// we have a bit per element item saying if that element item is valid
+	std::vector<uint64_t> validBits;
+	size_t validCount = 0;
 };
 
 template<typename CT>
 inline void VariContainer<CT>::clear()
 {
 	elements.clear();
-	notValids.clear();
+	slots.clear();
+	validBits.clear();
+	validCount = 0;
+}
+
+template<typename CT>
+inline void VariContainer<CT>::rebuildSlots()
+{
+	slots.clear();
+	if(elements.empty()) return;
+
+	// at most half full so probes are short and always end
+	size_t size = 4;
+	while(size < elements.size() * 2) size <<= 1;
+	slots.resize(size);
+	for(auto const& ptr : elements)
+	{
+		for(size_t i = ptr->slot & (size - 1);; i = (i + 1) & (size - 1))
+		{
+			auto& slot = slots[i];
+			if(!slot)
+			{
+				slot = ptr;
+				break;
+			}
+			// first of each type wins, different names with the same key are a hash clash and get their own slot
+			if(slot->slot == ptr->slot && slot->name == ptr->name) break;
+		}
+	}
 }
 
 template<typename CT>
 inline auto VariContainer<CT>::size() const -> size_t
 {
-	return notValids.size();
+	return validCount;
 }
 
 template<typename CT>
 inline auto VariContainer<CT>::resizeForNewElement() -> IndexType
 {
-	size_t initialSize = notValids.size();
+	size_t initialSize = validCount;
 	resize(initialSize + 1);
 	return IndexType(initialSize);
 }
@@ -243,15 +396,25 @@ inline void VariContainer<CT>::resize(size_t const size)
 	{
 		con->resize(size);
 	}
-	notValids.resize(size);
+
+	// new element items are valid
+	size_t const oldCount = validCount;
+	validBits.resize((size + 63) >> 6, 0);
+	validCount = size;
+	for(size_t i = oldCount; i < size; ++i)
+	{
+		validBits[i >> 6] |= uint64_t(1) << (i & 63);
+	}
+	maskTailBits();
 }
 
 template<typename CT>
 inline auto VariContainer<CT>::addElement(std::shared_ptr<ContainerType> ele_, std::string_view subName_) -> void
 {
 	elements.push_back(ele_);
-	ele_->resize(notValids.size());
+	ele_->resize(validCount);
 	ele_->subName = subName_;
+	rebuildSlots();
 }
 
 template<typename CT>
@@ -262,6 +425,7 @@ inline void VariContainer<CT>::removeElements(std::shared_ptr<ContainerType> ele
 	{
 		elements.erase(it);
 	}
+	rebuildSlots();
 }
 
 
@@ -340,8 +504,8 @@ inline auto VariContainer<CT>::cloneElement(IndexType elementToCopy_) -> IndexTy
 	{
 		ptr->cloneElement(elementToCopy_);
 	}
-	notValids.push_back(notValids[(size_t)elementToCopy_]);
-	return IndexType(size() - 1);
+	pushValid(isValid(elementToCopy_));
+	return IndexType(validCount - 1);
 }
 
 template<typename CT>
@@ -351,11 +515,19 @@ inline void VariContainer<CT>::cloneTo(VariContainer<CT> &nvc) const
 	{
 		nvc.elements.push_back(ptr->clone());
 	}
-	nvc.notValids = notValids;
+	nvc.validBits = validBits;
+	nvc.validCount = validCount;
+	nvc.rebuildSlots();
 }
 
 template<typename CT>
 inline void VariContainer<CT>::removeDerived(DerivedType change)
+{
+	removeDerivedExcept(change, {});
+}
+
+template<typename CT>
+inline void VariContainer<CT>::removeDerivedExcept(DerivedType change, std::initializer_list<uint32_t> keep)
 {
 	assert(change != DerivedType::NotDerived);
 
@@ -364,7 +536,8 @@ inline void VariContainer<CT>::removeDerived(DerivedType change)
 	for (size_t i = 0; i < getSizeOfElementContainer(); ++i)
 	{
 		auto elementContainer = getElementContainer(i);
-		if (elementContainer->derived() >= change)
+		if (elementContainer->derived() >= change &&
+			std::find(keep.begin(), keep.end(), elementContainer->slot) == keep.end())
 		{
 			derivedElements.push_back(elementContainer);
 		}
@@ -378,6 +551,7 @@ inline void VariContainer<CT>::removeDerived(DerivedType change)
 			elements.erase(it);
 		}
 	}
+	rebuildSlots();
 }
 
 } // end namespace
@@ -7,6 +7,7 @@
 #define MESHMOD_VARIELEMENTS_H
 
 #include "core/core.h"
+#include "core/quick_hash.h"
 #include <string>
 #include <vector>
 
@@ -20,6 +21,20 @@ enum DerivedType
 	DerivedFromAttributes,
 };
 
+//! each data type stored in an Elements<CT> container has a slot key hashed from its name, lets
+//! containers find a typed element without comparing names. meshes are passed between dlls that
+//! each link meshmod so the key must be the same in every binary, hence the name hash
+template<typename CT>
+struct ElementSlots
+{
+	template<typename DT>
+	static auto get() -> uint32_t
+	{
+		static uint32_t const key = Core::QuickHash(DT::getName());
+		return key;
+	}
+};
+
 /**
 Short description.
 Detailed description
@@ -36,6 +51,14 @@ public:
 	std::string_view const name;
 	// subname. changeable for multiple sets of m_name's ("worldspace", "Tex0",etc)
 	std::string subName;
+	// slot key of the data type this element holds (see ElementSlots)
+	uint32_t const slot;
+	// items of a derived element that are out of date. rather than recomputing every item
+	// the op that made the element brings just these up to date the next time its called
+	std::vector<IndexType> staleItems;
+
+	void markStale(IndexType const index_) { staleItems.push_back(index_); }
+	bool isStale() const { return !staleItems.empty(); }
 
 	// this only works if the dest is the same as the source else does nothing!
 	virtual void unsafeCopyElementTo(Elements<CT>& dest_, IndexType srcIndex_, IndexType destIndex_) = 0;
@@ -51,8 +74,8 @@ public:
 	virtual DerivedType derived() const = 0;
 
 protected:
-	Elements(std::string_view name_)
-			: name(name_)
+	Elements(std::string_view name_, uint32_t slot_)
+			: name(name_), slot(slot_)
 	{};
 
 	Elements &operator=(Elements const&);
@@ -73,7 +96,7 @@ public:
 
 	std::vector<DataType> elements;
 
-	BaseElements() : Elements<ContainerType>(DataType::getName())
+	BaseElements() : Elements<ContainerType>(DataType::getName(), ElementSlots<Elements<CT>>::template get<DataType>())
 	{
 		elements.reserve(reserveAmnt);
 	}
@@ -88,6 +111,9 @@ public:
 	DataType const &operator[](IndexType const i) const { return elements[size_t(i)]; };
 	DataType &operator[](IndexType const i) { return elements[size_t(i)]; };
 
+	DataType const *data() const { return elements.data(); }
+	DataType *data() { return elements.data(); }
+
 	iterator begin() { return elements.begin(); }
 	iterator end() { return elements.end(); }
 	const_iterator begin() const { return elements.begin(); }
@@ -85,7 +85,7 @@ struct Normal
 		return "Normal"sv; };
 };
 //! normal vertex element (x,y,z)
-typedef BaseElements<VertexData::Normal, Vertex_, true, DerivedType::DerivedFromTopology> Normals;
+typedef BaseElements<VertexData::Normal, Vertex_, true, DerivedType::DerivedFromPositions> Normals;
 
 } } // end namespace
 
@@ -99,11 +99,9 @@ void Vertices::createPointReps(VertexData::Axis axis, float fEpsilon)
 	{
 		auto const prIndex = (VertexIndex) std::distance(pointReps.begin(), prIt);
 
-		// a point rep set to InvalidVertexIndex is 'deleted' if its deleted leave it deleted
-		if (isValid(prIndex) && (*prIt).next != InvalidVertexIndex)
-		{
-			(*prIt).next = prIndex;
-		}
+		// deleted vertices get an InvalidVertexIndex point rep. the element may have
+		// just been added so can't trust what is already there
+		(*prIt).next = isValid(prIndex) ? prIndex : InvalidVertexIndex;
 
 		++prIt;
 	}
@@ -149,6 +147,73 @@ void Vertices::createPointReps(VertexData::Axis axis, float fEpsilon)
 		}
 	}
 }
+/**
+Patch the point reps after a few vertices have moved.
+Each moved vertex leaves its old similar ring and joins the ring of any vertex it
+now shares a position with. Finding that vertex is a linear scan per moved vertex,
+so past a handful of moved vertices the sort in createPointReps is cheaper.
+@param movedVertices the vertices that have moved (no duplicates)
+@param fEpsilon how similar is similar?
+*/
+void Vertices::updatePointReps(VertexIndexContainer const& movedVertices, float fEpsilon)
+{
+	static size_t const MaxIncrementalMoves = 32;
+
+	if(!hasAttribute<VertexData::PointReps>() || movedVertices.size() > MaxIncrementalMoves)
+	{
+		createPointReps(VertexData::Axis::X, fEpsilon);
+		return;
+	}
+
+	auto& pointReps = getAttribute<VertexData::PointReps>();
+
+	// moved vertices that haven't been relinked yet can't be joined to
+	std::vector<VertexIndex> pending;
+	pending.reserve(movedVertices.size());
+
+	// unlink from the old rings
+	for(auto const movedIndex : movedVertices)
+	{
+		if(!isValid(movedIndex) || pointReps[movedIndex].next == InvalidVertexIndex) continue;
+
+		VertexIndex prev = movedIndex;
+		while(pointReps[prev].next != movedIndex)
+		{
+			prev = pointReps[prev].next;
+		}
+		pointReps[prev].next = pointReps[movedIndex].next;
+		pointReps[movedIndex].next = movedIndex;
+		pending.push_back(movedIndex);
+	}
+	std::sort(pending.begin(), pending.end());
+
+	auto const& poss = positions();
+	for(auto const movedIndex : movedVertices)
+	{
+		auto const it = std::lower_bound(pending.begin(), pending.end(), movedIndex);
+		if(it == pending.end() || *it != movedIndex) continue;
+		pending.erase(it);
+
+		VertexData::Position const& pos = poss[movedIndex];
+		VertexIndex found = InvalidVertexIndex;
+		for(size_t i = 0; i < getCount() && found == InvalidVertexIndex; ++i)
+		{
+			VertexIndex const other = VertexIndex(i);
+			if(other == movedIndex || !isValid(other)) continue;
+			if(pointReps[other].next == InvalidVertexIndex) continue;
+			if(!poss[other].equal(pos, fEpsilon)) continue;
+			if(std::binary_search(pending.begin(), pending.end(), other)) continue;
+			found = other;
+		}
+
+		if(found != InvalidVertexIndex)
+		{
+			pointReps[movedIndex].next = pointReps[found].next;
+			pointReps[found].next = movedIndex;
+		}
+	}
+}
+
 /**
 Clones the input vertex.
 An exact copy of the input vertex is created and its index returned, point reps are kept upto date
@@ -199,6 +264,7 @@ void Vertices::remove(VertexIndex const vertexIndex_)
 		halfEdge.startVertexIndex = InvalidVertexIndex;
 		halfEdge.endVertexIndex = InvalidVertexIndex;
 		halfEdges.getHalfEdgesContainer().setValid(halfEdgeIndex, false);
+		halfEdges.markPairDirty(halfEdgeIndex);
 	}
 
 	verticesContainer.setValid(vertexIndex_, false);
@@ -227,6 +293,7 @@ void Vertices::weldSimilar(VertexIndex vertexIndex_)
 				halfEdge.startVertexIndex = vertexIndex_;
 			if (halfEdge.endVertexIndex == del)
 				halfEdge.endVertexIndex = vertexIndex_;
+			halfEdges.markPairDirty(heIndex);
 		}
 		pointReps[del] = InvalidVertexIndex;
 		verticesContainer.setValid(del, false);
@@ -279,6 +346,7 @@ void Vertices::removeAllSimilarPositions(VertexData::Axis axis, float fEpsilon)
 					halfEdge.startVertexIndex = vertexIndex;
 				if (halfEdge.endVertexIndex == del)
 					halfEdge.endVertexIndex = vertexIndex;
+				halfEdges.markPairDirty(heIndex);
 			}
 			pointReps[del] = InvalidVertexIndex;
 			verticesContainer.setValid(del, false);
@@ -432,24 +500,12 @@ void Vertices::visitAll(std::function<void(VertexIndex const)> const& func)
 
 void Vertices::visitValid(std::function<void(VertexIndex const)> const& func)
 {
-	for (auto i = 0u; i < verticesContainer.size(); ++i)
-	{
-		if (isValid(VertexIndex(i)))
-		{
-			func(VertexIndex(i));
-		}
-	}
+	forEachValid(func);
 }
 
 void Vertices::visitValid(std::function<void(VertexIndex const)> const& func) const
 {
-	for (size_t i = 0u; i < verticesContainer.size(); ++i)
-	{
-		if (isValid(VertexIndex(i)))
-		{
-			func(VertexIndex(i));
-		}
-	}
+	forEachValid(func);
 }
 
 void Vertices::visitAll(std::function<void(VertexIndex const)> const& func) const
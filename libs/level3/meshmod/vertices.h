@@ -63,6 +63,12 @@ public:
 	//! scan the vertex index list to see if have a samePosition return the index if we have else MM_INVALID_INDEX
 	VertexIndex hasPosition(VertexIndex const i0, VertexIndexContainer const& vertexList) const;
 
+	//! template version of visitValid, func is inlined rather than called via std::function
+	template<typename Func> void forEachValid(Func&& func) const
+	{
+		verticesContainer.forEachValid(std::forward<Func>(func));
+	}
+
 	void visitAll(std::function<void(VertexIndex const)> const& func);
 	void visitAll(std::function<void(VertexIndex const)> const& func) const;
 	void visitValid(std::function<void(VertexIndex const)> const& func);
@@ -86,6 +92,10 @@ public:
 
 	void createPointReps(VertexData::Axis axis = VertexData::Axis::X, float fEpsilon = 1e-5f);
 
+	//! updates the point reps after only the listed vertices have moved, falls back to
+	//! createPointReps if lots have moved
+	void updatePointReps(VertexIndexContainer const& movedVertices, float fEpsilon = 1e-5f);
+
 	void removeAllSimilarPositions(VertexData::Axis axis = VertexData::Axis::X, float fEpsilon = 1e-5f);
 
 protected:
@@ -111,29 +121,29 @@ inline VertexData::Position& Vertices::position(VertexIndex const index)
 
 inline VertexData::Positions const& Vertices::positions() const
 {
-	return *verticesContainer.getElement<VertexData::Positions>();
+	return *verticesContainer.getElementPtr<VertexData::Positions>();
 }
 
 inline VertexData::Positions& Vertices::positions()
 {
-	return *verticesContainer.getElement<VertexData::Positions>();
+	return *verticesContainer.getElementPtr<VertexData::Positions>();
 }
 
 template<typename attribute>
 inline bool Vertices::hasAttribute() const
 {
-	return verticesContainer.getElement<attribute>() != nullptr;
+	return verticesContainer.getElementPtr<attribute>() != nullptr;
 }
 
 template<typename attribute>
 inline attribute const& Vertices::getAttribute() const
 {
-	return *verticesContainer.getElement<attribute>();
+	return *verticesContainer.getElementPtr<attribute>();
 }
 template<typename attribute>
 inline attribute& Vertices::getAttribute()
 {
-	return *verticesContainer.getElement<attribute>();
+	return *verticesContainer.getElementPtr<attribute>();
 }
 
 template<typename attribute>
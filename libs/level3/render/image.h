@@ -99,6 +99,13 @@ public:
 	auto setChannelAt(double value_, Channel channel_, unsigned int x_, unsigned int y_ = 0, unsigned int z_ = 0,
 					  unsigned int slice_ = 0) -> void;
 
+	// the per pixel decode/encode of a single uncompressed pixel at ptr_, the reference
+	// for the bulk PixelConverter. missing channels decode as 0 and aren't encoded
+	static auto fetchPixel(GenericTextureFormat fmt_, uint8_t const *ptr_) -> Pixel;
+	static auto putPixel(GenericTextureFormat fmt_, Pixel const& pixel_, uint8_t *ptr_) -> void;
+	static auto fetchChannel(Channel channel_, GenericTextureFormat fmt_, uint8_t const *ptr_) -> double;
+	static auto putChannel(Channel channel_, GenericTextureFormat fmt_, uint8_t *ptr_, double const value_) -> void;
+
 
 protected:
 	~Image() = default;
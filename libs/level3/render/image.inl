@@ -33,29 +33,34 @@ auto Image<id_>::channelAt(Channel channel_, unsigned int x_, unsigned int y_, u
 	// split into bit width grouped formats
 	assert(GtfCracker::bitWidth(format) >= 8);
 	uint8_t *pixelPtr = data() + index * (GtfCracker::bitWidth(format) / 8);
+	return fetchChannel(channel_, format, pixelPtr);
+}
 
-	switch(GtfCracker::bitWidth(format))
+template<ResourceManager::ResourceId id_>
+auto Image<id_>::fetchChannel(Channel channel_, GenericTextureFormat fmt_, uint8_t const *ptr_) -> double
+{
+	switch(GtfCracker::bitWidth(fmt_))
 	{
 		case 256:
-			return bitWidth256ChannelAt(channel_, format, pixelPtr);
+			return bitWidth256ChannelAt(channel_, fmt_, ptr_);
 		case 192:
-			return bitWidth192ChannelAt(channel_, format, pixelPtr);
+			return bitWidth192ChannelAt(channel_, fmt_, ptr_);
 		case 128:
-			return bitWidth128ChannelAt(channel_, format, pixelPtr);
+			return bitWidth128ChannelAt(channel_, fmt_, ptr_);
 		case 96:
-			return bitWidth96ChannelAt(channel_, format, pixelPtr);
+			return bitWidth96ChannelAt(channel_, fmt_, ptr_);
 		case 64:
-			return bitWidth64ChannelAt(channel_, format, pixelPtr);
+			return bitWidth64ChannelAt(channel_, fmt_, ptr_);
 		case 48:
-			return bitWidth48ChannelAt(channel_, format, pixelPtr);
+			return bitWidth48ChannelAt(channel_, fmt_, ptr_);
 		case 32:
-			return bitWidth32ChannelAt(channel_, format, pixelPtr);
+			return bitWidth32ChannelAt(channel_, fmt_, ptr_);
 		case 24:
-			return bitWidth24ChannelAt(channel_, format, pixelPtr);
+			return bitWidth24ChannelAt(channel_, fmt_, ptr_);
 		case 16:
-			return bitWidth16ChannelAt(channel_, format, pixelPtr);
+			return bitWidth16ChannelAt(channel_, fmt_, ptr_);
 		case 8:
-			return bitWidth8ChannelAt(channel_, format, pixelPtr);
+			return bitWidth8ChannelAt(channel_, fmt_, ptr_);
 		default:
 			LOG_F(ERROR, "Bitwidth of format not supported");
 			return 0.0;
@@ -127,41 +132,96 @@ auto Image<id_>::setChannelAt(double value_, Channel channel_, unsigned int x_,
 	// split into bit width grouped formats
 	assert(GtfCracker::bitWidth(format) >= 8);
 	uint8_t *pixelPtr = data() + index * (GtfCracker::bitWidth(format) / 8);
+	putChannel(channel_, format, pixelPtr, value_);
+}
 
-	switch(GtfCracker::bitWidth(format))
+template<ResourceManager::ResourceId id_>
+auto Image<id_>::putChannel(Channel channel_, GenericTextureFormat fmt_, uint8_t *ptr_, double const value_) -> void
+{
+	switch(GtfCracker::bitWidth(fmt_))
 	{
 		case 256:
-			bitWidth256SetChannelAt(channel_, format, pixelPtr, value_);
+			bitWidth256SetChannelAt(channel_, fmt_, ptr_, value_);
 			break;
 		case 192:
-			bitWidth192SetChannelAt(channel_, format, pixelPtr, value_);
+			bitWidth192SetChannelAt(channel_, fmt_, ptr_, value_);
 			break;
 		case 128:
-			bitWidth128SetChannelAt(channel_, format, pixelPtr, value_);
+			bitWidth128SetChannelAt(channel_, fmt_, ptr_, value_);
 			break;
 		case 96:
-			bitWidth96SetChannelAt(channel_, format, pixelPtr, value_);
+			bitWidth96SetChannelAt(channel_, fmt_, ptr_, value_);
 			break;
 		case 64:
-			bitWidth64SetChannelAt(channel_, format, pixelPtr, value_);
+			bitWidth64SetChannelAt(channel_, fmt_, ptr_, value_);
 			break;
 		case 48:
-			bitWidth48SetChannelAt(channel_, format, pixelPtr, value_);
+			bitWidth48SetChannelAt(channel_, fmt_, ptr_, value_);
 			break;
 		case 32:
-			bitWidth32SetChannelAt(channel_, format, pixelPtr, value_);
+			bitWidth32SetChannelAt(channel_, fmt_, ptr_, value_);
 			break;
 		case 24:
-			bitWidth24SetChannelAt(channel_, format, pixelPtr, value_);
+			bitWidth24SetChannelAt(channel_, fmt_, ptr_, value_);
 			break;
 		case 16:
-			bitWidth16SetChannelAt(channel_, format, pixelPtr, value_);
+			bitWidth16SetChannelAt(channel_, fmt_, ptr_, value_);
 			break;
 		case 8:
-			bitWidth8SetChannelAt(channel_, format, pixelPtr, value_);
+			bitWidth8SetChannelAt(channel_, fmt_, ptr_, value_);
 			break;
 		default:
-			LOG_S(ERROR) << "Bitwidth " << GtfCracker::bitWidth(format) << " of format " << GtfCracker::name(format)
+			LOG_S(ERROR) << "Bitwidth " << GtfCracker::bitWidth(fmt_) << " of format " << GtfCracker::name(fmt_)
 						 << " not supported";
 	}
 }
+
+template<ResourceManager::ResourceId id_>
+auto Image<id_>::fetchPixel(GenericTextureFormat fmt_, uint8_t const *ptr_) -> Pixel
+{
+	assert(!GtfCracker::isCompressed(fmt_));
+	Pixel pixel{0, 0, 0, 0};
+
+	// intentional fallthrough on this switch statement
+	switch(GtfCracker::channelCount(fmt_))
+	{
+		case 4:
+			pixel.a = fetchChannel(Channel::A, fmt_, ptr_);
+		case 3:
+			pixel.b = fetchChannel(Channel::B, fmt_, ptr_);
+		case 2:
+			pixel.g = fetchChannel(Channel::G, fmt_, ptr_);
+		case 1:
+			pixel.r = fetchChannel(Channel::R, fmt_, ptr_);
+			break;
+		default:
+			assert(GtfCracker::channelCount(fmt_) <= 4);
+			assert(GtfCracker::channelCount(fmt_) > 0);
+			break;
+	}
+	return pixel;
+}
+
+template<ResourceManager::ResourceId id_>
+auto Image<id_>::putPixel(GenericTextureFormat fmt_, Pixel const& pixel_, uint8_t *ptr_) -> void
+{
+	assert(!GtfCracker::isCompressed(fmt_));
+
+	// intentional fallthrough on this switch statement
+	switch(GtfCracker::channelCount(fmt_))
+	{
+		case 4:
+			putChannel(Channel::A, fmt_, ptr_, pixel_.a);
+		case 3:
+			putChannel(Channel::B, fmt_, ptr_, pixel_.b);
+		case 2:
+			putChannel(Channel::G, fmt_, ptr_, pixel_.g);
+		case 1:
+			putChannel(Channel::R, fmt_, ptr_, pixel_.r);
+			break;
+		default:
+			assert(GtfCracker::channelCount(fmt_) <= 4);
+			assert(GtfCracker::channelCount(fmt_) > 0);
+			break;
+	}
+}
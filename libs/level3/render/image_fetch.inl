@@ -24,7 +24,9 @@ template<ResourceManager::ResourceId id_>
 template<typename type_>
 auto Image<id_>::fetchHomoChannel_sRGB(uint8_t channel_, uint8_t const *ptr_) -> double
 {
-	return Math::sRGB2LinearRGB_channel(fetchRaw<type_>(ptr_ + sizeof(type_) * channel_));
+	// the curve is over 0 to 1
+	double const x = fetchRaw<type_>(ptr_ + sizeof(type_) * channel_) / (double) std::numeric_limits<type_>::max();
+	return Math::sRGB2LinearRGB_channel((float) x);
 }
 
 template<ResourceManager::ResourceId id_>
@@ -162,9 +164,10 @@ auto Image<id_>::fetchChannel_X8D24_UNORM(uint8_t channel_, uint8_t const *ptr_)
 template<ResourceManager::ResourceId id_>
 auto Image<id_>::fetchChannel_D24X8_UNORM(uint8_t channel_, uint8_t const *ptr_) -> double
 {
+	// depth in the top 24 bits, stencil in the bottom 8 (matches putChannel_D24X8_UNORM)
 	uint32_t pixel = fetchRaw<uint32_t>(ptr_);
-	if(channel_ == 0) return ((double) (pixel & 0x000000FF) / 255.0);
-	else return ((double) ((pixel & 0xFFFFFF00) >> 8) / 16777215.0);
+	if(channel_ == 0) return ((double) ((pixel & 0xFFFFFF00) >> 8) / 16777215.0);
+	else return ((double) (pixel & 0x000000FF) / 255.0);
 }
 
 template<ResourceManager::ResourceId id_>
@@ -173,7 +176,7 @@ auto Image<id_>::fetchChannel_D16S8_UNORM_UINT(uint8_t channel_, uint8_t const *
 	if(channel_ == 0)
 		return fetchHomoChannel_NORM<uint16_t>(channel_, ptr_);
 	else
-		return fetchHomoChannel<uint8_t>(1, ptr_);
+		return fetchHomoChannel<uint8_t>(2, ptr_);
 }
 
 
@@ -358,7 +361,7 @@ auto Image<id_>::bitWidth32ChannelAt(Channel channel_, GenericTextureFormat fmt_
 			return fetchHomoChannel<int8_t>(swizzle(fmt_, channel_), ptr_);
 		case GenericTextureFormat::R8G8B8A8_SRGB:
 			if(channel_ == Channel::A)
-				return fetchHomoChannel<uint8_t>(swizzle(fmt_, channel_), ptr_);
+				return fetchHomoChannel_NORM<uint8_t>(swizzle(fmt_, channel_), ptr_);
 			else
 				return fetchHomoChannel_sRGB<uint8_t>(swizzle(fmt_, channel_), ptr_);
 		case GenericTextureFormat::B8G8R8A8_UNORM:
@@ -373,7 +376,7 @@ auto Image<id_>::bitWidth32ChannelAt(Channel channel_, GenericTextureFormat fmt_
 			return fetchHomoChannel<int8_t>(swizzle(fmt_, channel_), ptr_);
 		case GenericTextureFormat::B8G8R8A8_SRGB:
 			if(channel_ == Channel::A)
-				return fetchHomoChannel<uint8_t>(swizzle(fmt_, channel_), ptr_);
+				return fetchHomoChannel_NORM<uint8_t>(swizzle(fmt_, channel_), ptr_);
 			else
 				return fetchHomoChannel_sRGB<uint8_t>(swizzle(fmt_, channel_), ptr_);
 		case GenericTextureFormat::A8B8G8R8_UNORM_PACK32:
@@ -388,7 +391,7 @@ auto Image<id_>::bitWidth32ChannelAt(Channel channel_, GenericTextureFormat fmt_
 			return fetchHomoChannel<int8_t>(swizzle(fmt_, channel_), ptr_);
 		case GenericTextureFormat::A8B8G8R8_SRGB_PACK32:
 			if(channel_ == Channel::A)
-				return fetchHomoChannel<uint8_t>(swizzle(fmt_, channel_), ptr_);
+				return fetchHomoChannel_NORM<uint8_t>(swizzle(fmt_, channel_), ptr_);
 			else
 				return fetchHomoChannel_sRGB<uint8_t>(swizzle(fmt_, channel_), ptr_);
 		case GenericTextureFormat::A2R10G10B10_UNORM_PACK32:
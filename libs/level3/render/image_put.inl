@@ -25,7 +25,8 @@ template<ResourceManager::ResourceId id_>
 template<typename type_>
 auto Image<id_>::putHomoChannel_sRGB(uint8_t channel_, uint8_t *ptr_, double const value_) -> void
 {
-	putHomoChannel<type_>(channel_, ptr_, Math::LinearRGB2sRGB_channel((float) value_));
+	double const x = Math::Clamp(Math::LinearRGB2sRGB_channel((float) value_), 0.0f, 1.0f);
+	putHomoChannel<type_>(channel_, ptr_, x * (double) std::numeric_limits<type_>::max());
 }
 
 template<ResourceManager::ResourceId id_>
@@ -217,7 +218,7 @@ auto Image<id_>::putChannel_D16S8_UNORM_UINT(uint8_t channel_, uint8_t *ptr_, do
 	} else if(channel_ == 1)
 	{
 		double const v = Math::Clamp(value_, 0.0, 255.0);
-		putHomoChannel<uint16_t>(0, ptr_ + 2, (uint8_t) v);
+		putHomoChannel<uint8_t>(0, ptr_ + 2, (uint8_t) v);
 	} else
 	{
 		assert(channel_ < 2);
@@ -446,7 +447,7 @@ auto Image<id_>::bitWidth32SetChannelAt(Channel channel_, GenericTextureFormat f
 			break;
 		case GenericTextureFormat::R8G8B8A8_SRGB:
 			if(channel_ == Channel::A)
-				putHomoChannel<uint8_t>(swizzle(fmt_, channel_), ptr_, value_);
+				putHomoChannel_NORM<uint8_t>(swizzle(fmt_, channel_), ptr_, value_);
 			else
 				putHomoChannel_sRGB<uint8_t>(swizzle(fmt_, channel_), ptr_, value_);
 			break;
@@ -466,7 +467,7 @@ auto Image<id_>::bitWidth32SetChannelAt(Channel channel_, GenericTextureFormat f
 			break;
 		case GenericTextureFormat::B8G8R8A8_SRGB:
 			if(channel_ == Channel::A)
-				putHomoChannel<uint8_t>(swizzle(fmt_, channel_), ptr_, value_);
+				putHomoChannel_NORM<uint8_t>(swizzle(fmt_, channel_), ptr_, value_);
 			else
 				putHomoChannel_sRGB<uint8_t>(swizzle(fmt_, channel_), ptr_, value_);
 			break;
@@ -486,7 +487,7 @@ auto Image<id_>::bitWidth32SetChannelAt(Channel channel_, GenericTextureFormat f
 			break;
 		case GenericTextureFormat::A8B8G8R8_SRGB_PACK32:
 			if(channel_ == Channel::A)
-				putHomoChannel<uint8_t>(swizzle(fmt_, channel_), ptr_, value_);
+				putHomoChannel_NORM<uint8_t>(swizzle(fmt_, channel_), ptr_, value_);
 			else
 				putHomoChannel_sRGB<uint8_t>(swizzle(fmt_, channel_), ptr_, value_);
 			break;
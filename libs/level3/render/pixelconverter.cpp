@@ -0,0 +1,583 @@
+#include "core/core.h"
+#include "math/scalar_math.h"
+#include "math/colourspace.h"
+#include "render/image.h"
+#include "render/pixelconverter.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXELCONVERTER_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define PIXELCONVERTER_F16C 1
+#include <immintrin.h>
+#endif
+
+namespace Render {
+
+namespace {
+
+using Layout = PixelConverter::Layout;
+
+// how a homogeneous channel maps to a float
+enum class Kind
+{
+	Raw,	// ints, scaled and floats as is
+	Norm,	// divided by the types max
+	SRGB	// 8 bit curve on RGB, alpha is norm
+};
+
+// rows go through this many pixels of float RGBA at a time
+constexpr uint32_t SpanSize = 64;
+
+struct SRGBTable
+{
+	SRGBTable()
+	{
+		for(auto i = 0u; i < 256; ++i)
+		{
+			toLinear[i] = Math::sRGB2LinearRGB_channel(float(i) / 255.0f);
+		}
+	}
+
+	// encoding truncates like putPixel, so the byte is how many curve points are <= the value
+	auto encode(float value_) const -> uint8_t
+	{
+		return uint8_t(std::upper_bound(toLinear + 1, toLinear + 256, value_) - (toLinear + 1));
+	}
+
+	float toLinear[256];
+};
+
+auto SRGB() -> SRGBTable const&
+{
+	static SRGBTable const table;
+	return table;
+}
+
+template<typename type_>
+auto Load(uint8_t const* ptr_) -> type_
+{
+	type_ value;
+	std::memcpy(&value, ptr_, sizeof(type_));
+	return value;
+}
+
+template<typename type_>
+auto Store(uint8_t* ptr_, type_ const value_) -> void
+{
+	std::memcpy(ptr_, &value_, sizeof(type_));
+}
+
+// generic kernels, any homogeneous 1 to 4 channel format
+template<typename type_, Kind kind_>
+auto DecodeHomo(Layout const& layout_, uint8_t const* src_, float* rgba_, uint32_t count_) -> void
+{
+	constexpr float max = float(std::numeric_limits<type_>::max());
+	SRGBTable const& srgb = SRGB();
+	for(auto i = 0u; i < count_; ++i)
+	{
+		uint8_t const* pixel = src_ + i * layout_.bytesPerPixel;
+		for(auto c = 0u; c < 4; ++c)
+		{
+			if(c >= layout_.channelCount)
+			{
+				rgba_[c] = 0.0f;
+				continue;
+			}
+			type_ const value = Load<type_>(pixel + layout_.swizzle[c] * sizeof(type_));
+			if constexpr(kind_ == Kind::SRGB)
+			{
+				rgba_[c] = (c == 3) ? float(value) / max : srgb.toLinear[value];
+			} else if constexpr(kind_ == Kind::Norm)
+			{
+				rgba_[c] = float(value) / max;
+			} else
+			{
+				rgba_[c] = float(value);
+			}
+		}
+		rgba_ += 4;
+	}
+}
+
+template<typename type_, Kind kind_>
+auto EncodeHomo(Layout const& layout_, float const* rgba_, uint8_t* dst_, uint32_t count_) -> void
+{
+	constexpr float max = float(std::numeric_limits<type_>::max());
+	constexpr float lowest = float(std::numeric_limits<type_>::lowest());
+	SRGBTable const& srgb = SRGB();
+	for(auto i = 0u; i < count_; ++i)
+	{
+		uint8_t* pixel = dst_ + i * layout_.bytesPerPixel;
+		for(auto c = 0u; c < layout_.channelCount; ++c)
+		{
+			type_ value;
+			if constexpr(std::is_floating_point_v<type_>)
+			{
+				value = type_(rgba_[c]);
+			} else if constexpr(kind_ == Kind::SRGB)
+			{
+				value = (c == 3) ? type_(Math::Clamp(rgba_[c] * max, 0.0f, max)) : srgb.encode(rgba_[c]);
+			} else if constexpr(kind_ == Kind::Norm)
+			{
+				value = type_(Math::Clamp(rgba_[c] * max, lowest, max));
+			} else
+			{
+				// doubles as floats can't hold every 32 bit int
+				value = type_(Math::Clamp(double(rgba_[c]), double(lowest), double(max)));
+			}
+			Store<type_>(pixel + layout_.swizzle[c] * sizeof(type_), value);
+		}
+		rgba_ += 4;
+	}
+}
+
+auto DecodeHalf(Layout const& layout_, uint8_t const* src_, float* rgba_, uint32_t count_) -> void
+{
+	uint32_t i = 0;
+#if PIXELCONVERTER_F16C
+	if(layout_.channelCount == 4)
+	{
+		for(; i < count_; ++i)
+		{
+			__m128i const halfs = _mm_loadl_epi64((__m128i const*) (src_ + i * 8));
+			_mm_storeu_ps(rgba_ + i * 4, _mm_cvtph_ps(halfs));
+		}
+	}
+#endif
+	for(; i < count_; ++i)
+	{
+		uint8_t const* pixel = src_ + i * layout_.bytesPerPixel;
+		for(auto c = 0u; c < 4; ++c)
+		{
+			rgba_[i * 4 + c] = (c < layout_.channelCount) ?
+							   Math::half2float(Load<uint16_t>(pixel + c * sizeof(uint16_t))) : 0.0f;
+		}
+	}
+}
+
+auto EncodeHalf(Layout const& layout_, float const* rgba_, uint8_t* dst_, uint32_t count_) -> void
+{
+	uint32_t i = 0;
+#if PIXELCONVERTER_F16C
+	if(layout_.channelCount == 4)
+	{
+		for(; i < count_; ++i)
+		{
+			// round to nearest even like float2half
+			__m128i const halfs = _mm_cvtps_ph(_mm_loadu_ps(rgba_ + i * 4), 0);
+			_mm_storel_epi64((__m128i*) (dst_ + i * 8), halfs);
+		}
+	}
+#endif
+	for(; i < count_; ++i)
+	{
+		uint8_t* pixel = dst_ + i * layout_.bytesPerPixel;
+		for(auto c = 0u; c < layout_.channelCount; ++c)
+		{
+			Store<uint16_t>(pixel + c * sizeof(uint16_t), Math::float2half(rgba_[i * 4 + c]));
+		}
+	}
+}
+
+// RGBA32F is the span format so its just a copy
+auto DecodeFloat4(Layout const&, uint8_t const* src_, float* rgba_, uint32_t count_) -> void
+{
+	std::memcpy(rgba_, src_, count_ * 4 * sizeof(float));
+}
+
+auto EncodeFloat4(Layout const&, float const* rgba_, uint8_t* dst_, uint32_t count_) -> void
+{
+	std::memcpy(dst_, rgba_, count_ * 4 * sizeof(float));
+}
+
+// 4 byte unorm with the swizzle as template parameters so the SIMD shuffles are immediates
+template<uint8_t R_, uint8_t G_, uint8_t B_, uint8_t A_>
+auto DecodeUnorm8x4(Layout const& layout_, uint8_t const* src_, float* rgba_, uint32_t count_) -> void
+{
+	uint32_t i = 0;
+#if PIXELCONVERTER_SSE2
+	__m128i const zero = _mm_setzero_si128();
+	__m128 const max = _mm_set1_ps(255.0f);
+	for(; i + 4 <= count_; i += 4)
+	{
+		__m128i const bytes = _mm_loadu_si128((__m128i const*) (src_ + i * 4));
+		__m128i const lo = _mm_unpacklo_epi8(bytes, zero);
+		__m128i const hi = _mm_unpackhi_epi8(bytes, zero);
+		__m128i const pixels[4] = {
+				_mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+				_mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero)
+		};
+		for(auto j = 0u; j < 4; ++j)
+		{
+			__m128 const v = _mm_div_ps(_mm_cvtepi32_ps(pixels[j]), max);
+			_mm_storeu_ps(rgba_ + (i + j) * 4, _mm_shuffle_ps(v, v, _MM_SHUFFLE(A_, B_, G_, R_)));
+		}
+	}
+#endif
+	DecodeHomo<uint8_t, Kind::Norm>(layout_, src_ + i * 4, rgba_ + i * 4, count_ - i);
+}
+
+template<uint8_t R_, uint8_t G_, uint8_t B_, uint8_t A_>
+auto EncodeUnorm8x4(Layout const& layout_, float const* rgba_, uint8_t* dst_, uint32_t count_) -> void
+{
+	uint32_t i = 0;
+#if PIXELCONVERTER_SSE2
+	// which channel goes to each byte
+	constexpr auto from = [](uint8_t byte_) -> int { return R_ == byte_ ? 0 : G_ == byte_ ? 1 : B_ == byte_ ? 2 : 3; };
+	__m128 const zero = _mm_setzero_ps();
+	__m128 const max = _mm_set1_ps(255.0f);
+	for(; i + 4 <= count_; i += 4)
+	{
+		__m128i ints[4];
+		for(auto j = 0u; j < 4; ++j)
+		{
+			__m128 const v = _mm_loadu_ps(rgba_ + (i + j) * 4);
+			__m128 const bytes = _mm_shuffle_ps(v, v, _MM_SHUFFLE(from(3), from(2), from(1), from(0)));
+			ints[j] = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(bytes, max), zero), max));
+		}
+		__m128i const words = _mm_packs_epi32(ints[0], ints[1]);
+		__m128i const words2 = _mm_packs_epi32(ints[2], ints[3]);
+		_mm_storeu_si128((__m128i*) (dst_ + i * 4), _mm_packus_epi16(words, words2));
+	}
+#endif
+	EncodeHomo<uint8_t, Kind::Norm>(layout_, rgba_ + i * 4, dst_ + i * 4, count_ - i);
+}
+
+// 10:10:10:2, the fields come from the layout so both orders and unorm/uint share these
+auto DecodePacked(Layout const& layout_, uint8_t const* src_, float* rgba_, uint32_t count_) -> void
+{
+	uint32_t i = 0;
+#if PIXELCONVERTER_SSE2
+	__m128i shift[4];
+	__m128i mask[4];
+	__m128 divisor[4];
+	for(auto c = 0u; c < 4; ++c)
+	{
+		shift[c] = _mm_cvtsi32_si128(int(layout_.shift[c]));
+		mask[c] = _mm_set1_epi32(int(layout_.mask[c]));
+		divisor[c] = _mm_set1_ps(layout_.divisor[c]);
+	}
+	for(; i + 4 <= count_; i += 4)
+	{
+		__m128i const packed = _mm_loadu_si128((__m128i const*) (src_ + i * 4));
+		__m128 channels[4];
+		for(auto c = 0u; c < 4; ++c)
+		{
+			__m128i const field = _mm_and_si128(_mm_srl_epi32(packed, shift[c]), mask[c]);
+			channels[c] = _mm_div_ps(_mm_cvtepi32_ps(field), divisor[c]);
+		}
+		_MM_TRANSPOSE4_PS(channels[0], channels[1], channels[2], channels[3]);
+		for(auto j = 0u; j < 4; ++j)
+		{
+			_mm_storeu_ps(rgba_ + (i + j) * 4, channels[j]);
+		}
+	}
+#endif
+	for(; i < count_; ++i)
+	{
+		uint32_t const packed = Load<uint32_t>(src_ + i * 4);
+		for(auto c = 0u; c < 4; ++c)
+		{
+			rgba_[i * 4 + c] = float((packed >> layout_.shift[c]) & layout_.mask[c]) / layout_.divisor[c];
+		}
+	}
+}
+
+auto EncodePacked(Layout const& layout_, float const* rgba_, uint8_t* dst_, uint32_t count_) -> void
+{
+	uint32_t i = 0;
+#if PIXELCONVERTER_SSE2
+	__m128i shift[4];
+	__m128 max[4];
+	__m128 divisor[4];
+	for(auto c = 0u; c < 4; ++c)
+	{
+		shift[c] = _mm_cvtsi32_si128(int(layout_.shift[c]));
+		max[c] = _mm_set1_ps(float(layout_.mask[c]));
+		divisor[c] = _mm_set1_ps(layout_.divisor[c]);
+	}
+	__m128 const zero = _mm_setzero_ps();
+	for(; i + 4 <= count_; i += 4)
+	{
+		__m128 channels[4];
+		for(auto j = 0u; j < 4; ++j)
+		{
+			channels[j] = _mm_loadu_ps(rgba_ + (i + j) * 4);
+		}
+		_MM_TRANSPOSE4_PS(channels[0], channels[1], channels[2], channels[3]);
+		__m128i packed = _mm_setzero_si128();
+		for(auto c = 0u; c < 4; ++c)
+		{
+			__m128 const v = _mm_min_ps(_mm_max_ps(_mm_mul_ps(channels[c], divisor[c]), zero), max[c]);
+			packed = _mm_or_si128(packed, _mm_sll_epi32(_mm_cvttps_epi32(v), shift[c]));
+		}
+		_mm_storeu_si128((__m128i*) (dst_ + i * 4), packed);
+	}
+#endif
+	for(; i < count_; ++i)
+	{
+		uint32_t packed = 0;
+		for(auto c = 0u; c < 4; ++c)
+		{
+			float const v = Math::Clamp(rgba_[i * 4 + c] * layout_.divisor[c], 0.0f, float(layout_.mask[c]));
+			packed |= uint32_t(v) << layout_.shift[c];
+		}
+		Store<uint32_t>(dst_ + i * 4, packed);
+	}
+}
+
+// everything else goes through the per pixel path
+auto DecodeReference(Layout const& layout_, uint8_t const* src_, float* rgba_, uint32_t count_) -> void
+{
+	for(auto i = 0u; i < count_; ++i)
+	{
+		auto const pixel = GenericImage::fetchPixel(layout_.format, src_ + i * layout_.bytesPerPixel);
+		rgba_[i * 4 + 0] = float(pixel.r);
+		rgba_[i * 4 + 1] = float(pixel.g);
+		rgba_[i * 4 + 2] = float(pixel.b);
+		rgba_[i * 4 + 3] = float(pixel.a);
+	}
+}
+
+auto EncodeReference(Layout const& layout_, float const* rgba_, uint8_t* dst_, uint32_t count_) -> void
+{
+	for(auto i = 0u; i < count_; ++i)
+	{
+		uint8_t* pixel = dst_ + i * layout_.bytesPerPixel;
+		// packed formats merge into whats there
+		std::memset(pixel, 0, layout_.bytesPerPixel);
+		GenericImage::putPixel(layout_.format,
+							   {rgba_[i * 4 + 0], rgba_[i * 4 + 1], rgba_[i * 4 + 2], rgba_[i * 4 + 3]},
+							   pixel);
+	}
+}
+
+auto CopyPixels(Layout const& srcLayout_, Layout const&, uint8_t const* src_, uint8_t* dst_, uint32_t count_) -> void
+{
+	std::memcpy(dst_, src_, count_ * srcLayout_.bytesPerPixel);
+}
+
+// 4 byte formats of the same kind that only differ in order (RGBA <-> BGRA etc.)
+auto Swizzle8x4(Layout const& srcLayout_, Layout const& dstLayout_, uint8_t const* src_, uint8_t* dst_,
+				uint32_t count_) -> void
+{
+	uint8_t order[4];
+	for(auto c = 0u; c < 4; ++c)
+	{
+		order[dstLayout_.swizzle[c]] = srcLayout_.swizzle[c];
+	}
+	for(auto i = 0u; i < count_; ++i)
+	{
+		uint8_t const* s = src_ + i * 4;
+		uint8_t* d = dst_ + i * 4;
+		d[0] = s[order[0]];
+		d[1] = s[order[1]];
+		d[2] = s[order[2]];
+		d[3] = s[order[3]];
+	}
+}
+
+auto IsPacked1010102(GenericTextureFormat fmt_) -> bool
+{
+	switch(fmt_)
+	{
+		case GenericTextureFormat::A2R10G10B10_UNORM_PACK32:
+		case GenericTextureFormat::A2R10G10B10_USCALED_PACK32:
+		case GenericTextureFormat::A2R10G10B10_UINT_PACK32:
+		case GenericTextureFormat::A2B10G10R10_UNORM_PACK32:
+		case GenericTextureFormat::A2B10G10R10_USCALED_PACK32:
+		case GenericTextureFormat::A2B10G10R10_UINT_PACK32:
+			return true;
+		default:
+			return false;
+	}
+}
+
+// every channel the same power of 2 size, i.e. an array of one type
+auto HomogeneousBits(GenericTextureFormat fmt_) -> uint32_t
+{
+	if(GtfCracker::isCompressed(fmt_) || GtfCracker::isDepth(fmt_) || GtfCracker::isStencil(fmt_)) return 0;
+	if(IsPacked1010102(fmt_)) return 0;
+
+	uint32_t const count = GtfCracker::channelCount(fmt_);
+	if(count == 0 || count > 4) return 0;
+	uint32_t const bits = GtfCracker::channelBitWidth(fmt_, 0);
+	if(bits != 8 && bits != 16 && bits != 32 && bits != 64) return 0;
+	if(GtfCracker::bitWidth(fmt_) != bits * count) return 0;
+	for(auto c = 1u; c < count; ++c)
+	{
+		if(GtfCracker::channelBitWidth(fmt_, int(c)) != bits) return 0;
+	}
+	return bits;
+}
+
+auto MakeLayout(GenericTextureFormat fmt_) -> Layout
+{
+	Layout layout{};
+	layout.format = fmt_;
+	layout.bytesPerPixel = GtfCracker::bitWidth(fmt_) / 8;
+	layout.channelCount = GtfCracker::channelCount(fmt_);
+	layout.swizzle = GtfCracker::swizzleFormat(fmt_);
+	if(IsPacked1010102(fmt_))
+	{
+		bool const norm = GtfCracker::isNormalised(fmt_);
+		for(auto c = 0u; c < 4; ++c)
+		{
+			// field 0 is the 2 bit alpha at the top, then 10 bits each down to 0
+			uint8_t const field = layout.swizzle[c];
+			layout.shift[c] = (field == 0) ? 30 : (3 - field) * 10;
+			layout.mask[c] = (field == 0) ? 0x3 : 0x3FF;
+			layout.divisor[c] = norm ? float(layout.mask[c]) : 1.0f;
+		}
+	}
+	return layout;
+}
+
+auto SelectDecode(Layout const& layout_) -> PixelConverter::DecodeFunc
+{
+	GenericTextureFormat const fmt = layout_.format;
+	if(fmt == GenericTextureFormat::UNDEFINED || GtfCracker::isCompressed(fmt)) return nullptr;
+	if(IsPacked1010102(fmt)) return &DecodePacked;
+
+	bool const isSigned = GtfCracker::isSigned(fmt);
+	bool const isNorm = GtfCracker::isNormalised(fmt);
+	bool const isFour = layout_.channelCount == 4;
+	using S = GtfCracker;
+	switch(HomogeneousBits(fmt))
+	{
+		case 8:
+			if(GtfCracker::isSRGB(fmt)) return &DecodeHomo<uint8_t, Kind::SRGB>;
+			if(isNorm && !isSigned && isFour)
+			{
+				if(layout_.swizzle == S::RGBA) return &DecodeUnorm8x4<0, 1, 2, 3>;
+				if(layout_.swizzle == S::BGRA) return &DecodeUnorm8x4<2, 1, 0, 3>;
+				if(layout_.swizzle == S::ABGR) return &DecodeUnorm8x4<3, 2, 1, 0>;
+			}
+			if(isNorm) return isSigned ? &DecodeHomo<int8_t, Kind::Norm> : &DecodeHomo<uint8_t, Kind::Norm>;
+			return isSigned ? &DecodeHomo<int8_t, Kind::Raw> : &DecodeHomo<uint8_t, Kind::Raw>;
+		case 16:
+			if(GtfCracker::isFloat(fmt)) return &DecodeHalf;
+			if(isNorm) return isSigned ? &DecodeHomo<int16_t, Kind::Norm> : &DecodeHomo<uint16_t, Kind::Norm>;
+			return isSigned ? &DecodeHomo<int16_t, Kind::Raw> : &DecodeHomo<uint16_t, Kind::Raw>;
+		case 32:
+			if(GtfCracker::isFloat(fmt)) return isFour ? &DecodeFloat4 : &DecodeHomo<float, Kind::Raw>;
+			return isSigned ? &DecodeHomo<int32_t, Kind::Raw> : &DecodeHomo<uint32_t, Kind::Raw>;
+		case 64:
+			if(GtfCracker::isFloat(fmt)) return &DecodeHomo<double, Kind::Raw>;
+			return &DecodeReference;
+		default:
+			return &DecodeReference;
+	}
+}
+
+auto SelectEncode(Layout const& layout_) -> PixelConverter::EncodeFunc
+{
+	GenericTextureFormat const fmt = layout_.format;
+	if(fmt == GenericTextureFormat::UNDEFINED || GtfCracker::isCompressed(fmt)) return nullptr;
+	if(IsPacked1010102(fmt)) return &EncodePacked;
+
+	bool const isSigned = GtfCracker::isSigned(fmt);
+	bool const isNorm = GtfCracker::isNormalised(fmt);
+	bool const isFour = layout_.channelCount == 4;
+	using S = GtfCracker;
+	switch(HomogeneousBits(fmt))
+	{
+		case 8:
+			if(GtfCracker::isSRGB(fmt)) return &EncodeHomo<uint8_t, Kind::SRGB>;
+			if(isNorm && !isSigned && isFour)
+			{
+				if(layout_.swizzle == S::RGBA) return &EncodeUnorm8x4<0, 1, 2, 3>;
+				if(layout_.swizzle == S::BGRA) return &EncodeUnorm8x4<2, 1, 0, 3>;
+				if(layout_.swizzle == S::ABGR) return &EncodeUnorm8x4<3, 2, 1, 0>;
+			}
+			if(isNorm) return isSigned ? &EncodeHomo<int8_t, Kind::Norm> : &EncodeHomo<uint8_t, Kind::Norm>;
+			return isSigned ? &EncodeHomo<int8_t, Kind::Raw> : &EncodeHomo<uint8_t, Kind::Raw>;
+		case 16:
+			if(GtfCracker::isFloat(fmt)) return &EncodeHalf;
+			if(isNorm) return isSigned ? &EncodeHomo<int16_t, Kind::Norm> : &EncodeHomo<uint16_t, Kind::Norm>;
+			return isSigned ? &EncodeHomo<int16_t, Kind::Raw> : &EncodeHomo<uint16_t, Kind::Raw>;
+		case 32:
+			if(GtfCracker::isFloat(fmt)) return isFour ? &EncodeFloat4 : &EncodeHomo<float, Kind::Raw>;
+			return isSigned ? &EncodeHomo<int32_t, Kind::Raw> : &EncodeHomo<uint32_t, Kind::Raw>;
+		case 64:
+			if(GtfCracker::isFloat(fmt)) return &EncodeHomo<double, Kind::Raw>;
+			return &EncodeReference;
+		default:
+			return &EncodeReference;
+	}
+}
+
+} // anon namespace
+
+PixelConverter::PixelConverter(GenericTextureFormat srcFormat_, GenericTextureFormat dstFormat_) :
+		srcLayout(MakeLayout(srcFormat_)),
+		dstLayout(MakeLayout(dstFormat_))
+{
+	decode = SelectDecode(srcLayout);
+	encode = SelectEncode(dstLayout);
+	if(decode == nullptr || encode == nullptr) return;
+
+	if(srcFormat_ == dstFormat_)
+	{
+		direct = &CopyPixels;
+	} else if(HomogeneousBits(srcFormat_) == 8 && HomogeneousBits(dstFormat_) == 8 &&
+			  srcLayout.channelCount == 4 && dstLayout.channelCount == 4 &&
+			  GtfCracker::isSRGB(srcFormat_) == GtfCracker::isSRGB(dstFormat_) &&
+			  GtfCracker::isNormalised(srcFormat_) == GtfCracker::isNormalised(dstFormat_) &&
+			  GtfCracker::isSigned(srcFormat_) == GtfCracker::isSigned(dstFormat_))
+	{
+		direct = &Swizzle8x4;
+	}
+}
+
+auto PixelConverter::convertRow(uint8_t const* src_, uint8_t* dst_, uint32_t width_) const -> void
+{
+	assert(isValid());
+	if(direct != nullptr)
+	{
+		direct(srcLayout, dstLayout, src_, dst_, width_);
+		return;
+	}
+
+	alignas(16) float rgba[SpanSize * 4];
+	for(uint32_t x = 0; x < width_; x += SpanSize)
+	{
+		uint32_t const count = std::min(SpanSize, width_ - x);
+		decode(srcLayout, src_ + x * srcLayout.bytesPerPixel, rgba, count);
+		encode(dstLayout, rgba, dst_ + x * dstLayout.bytesPerPixel, count);
+	}
+}
+
+auto PixelConverter::convert(uint8_t const* src_, size_t srcStride_, uint8_t* dst_, size_t dstStride_,
+							 uint32_t width_, uint32_t rowCount_) const -> bool
+{
+	if(!isValid())
+	{
+		LOG_S(WARNING) << "PixelConverter can't convert " << GtfCracker::name(srcLayout.format)
+					   << " to " << GtfCracker::name(dstLayout.format);
+		return false;
+	}
+	assert(srcStride_ >= size_t(width_) * srcLayout.bytesPerPixel);
+	assert(dstStride_ >= size_t(width_) * dstLayout.bytesPerPixel);
+
+	for(auto y = 0u; y < rowCount_; ++y)
+	{
+		convertRow(src_ + y * srcStride_, dst_ + y * dstStride_, width_);
+	}
+	return true;
+}
+
+auto PixelConverter::Convert(GenericTextureFormat srcFormat_, uint8_t const* src_, size_t srcStride_,
+							 GenericTextureFormat dstFormat_, uint8_t* dst_, size_t dstStride_,
+							 uint32_t width_, uint32_t rowCount_) -> bool
+{
+	PixelConverter converter(srcFormat_, dstFormat_);
+	return converter.convert(src_, srcStride_, dst_, dstStride_, width_, rowCount_);
+}
+
+}
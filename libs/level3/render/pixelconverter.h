@@ -0,0 +1,63 @@
+#pragma once
+#ifndef WYRD_RENDER_PIXELCONVERTER_H
+#define WYRD_RENDER_PIXELCONVERTER_H
+
+#include "core/core.h"
+#include "render/generictextureformat.h"
+#include "render/gtfcracker.h"
+#include <array>
+
+namespace Render {
+
+// bulk conversion between uncompressed generic texture formats
+// the kernels for a format pair are picked once when the converter is made, rows are then
+// converted a span at a time via a float RGBA buffer (or directly for copies and 8 bit swizzles).
+// the common formats (8 bit unorm/srgb, fp16, fp32 and 10:10:10:2) have SIMD kernels, everything
+// else uses the per pixel Image::fetchPixel/putPixel, which are also the reference for the results.
+// like them missing channels read as 0 and encoding truncates
+class PixelConverter
+{
+public:
+	PixelConverter(GenericTextureFormat srcFormat_, GenericTextureFormat dstFormat_);
+
+	// false if either format isn't supported (block compressed etc.)
+	auto isValid() const -> bool { return direct != nullptr || (decode != nullptr && encode != nullptr); }
+
+	auto convertRow(uint8_t const* src_, uint8_t* dst_, uint32_t width_) const -> void;
+	// strides are in bytes, so rows can be sub rectangles or have padding
+	auto convert(uint8_t const* src_, size_t srcStride_, uint8_t* dst_, size_t dstStride_,
+				 uint32_t width_, uint32_t rowCount_) const -> bool;
+
+	// one off convert, makes a converter for the pair
+	static auto Convert(GenericTextureFormat srcFormat_, uint8_t const* src_, size_t srcStride_,
+						GenericTextureFormat dstFormat_, uint8_t* dst_, size_t dstStride_,
+						uint32_t width_, uint32_t rowCount_) -> bool;
+
+	struct Layout
+	{
+		GenericTextureFormat format;
+		uint32_t bytesPerPixel;
+		uint32_t channelCount;
+		GtfCracker::SwizzleFormat swizzle;
+		// packed 10:10:10:2 fields per RGBA channel
+		std::array<uint32_t, 4> shift;
+		std::array<uint32_t, 4> mask;
+		std::array<float, 4> divisor;
+	};
+
+	using DecodeFunc = void (*)(Layout const& layout_, uint8_t const* src_, float* rgba_, uint32_t count_);
+	using EncodeFunc = void (*)(Layout const& layout_, float const* rgba_, uint8_t* dst_, uint32_t count_);
+	using DirectFunc = void (*)(Layout const& srcLayout_, Layout const& dstLayout_,
+								uint8_t const* src_, uint8_t* dst_, uint32_t count_);
+
+private:
+	Layout srcLayout;
+	Layout dstLayout;
+	DecodeFunc decode = nullptr;
+	EncodeFunc encode = nullptr;
+	DirectFunc direct = nullptr;
+};
+
+}
+
+#endif //WYRD_RENDER_PIXELCONVERTER_H
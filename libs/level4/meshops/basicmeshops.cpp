@@ -31,15 +31,51 @@
 #include "meshops/meshsorter.h"
 
 #include "fmt/format.h"
+#include "core/sharedtasks.h"
 
 #include <cassert>
 #include <algorithm>
+#include <atomic>
 #include <set>
 
 namespace MeshOps {
 
 DECLARE_EXCEPTION(BasicMeshOp, "Cannot process mesh with this op");
 
+namespace {
+// smaller meshes aren't worth splitting
+uint32_t const ParallelGrainSize = 4096;
+std::atomic<bool> s_parallel{ true };
+
+// calls func_(begin, end, threadnum) over chunks of [0, count_), on the shared task threads if enabled
+template<typename Func>
+void forChunks(size_t const count_, Func&& func_)
+{
+	if(s_parallel)
+	{
+		Core::InitSharedTasks();
+		Core::ParallelFor(uint32_t(count_), ParallelGrainSize,
+						  [&func_](uint32_t const begin_, uint32_t const end_, uint32_t const threadnum_)
+						  {
+							  func_(size_t(begin_), size_t(end_), threadnum_);
+						  });
+	} else
+	{
+		func_(size_t(0), count_, 0u);
+	}
+}
+}
+
+auto BasicMeshOps::setParallel(bool enable_) -> void
+{
+	s_parallel = enable_;
+}
+
+auto BasicMeshOps::isParallel() -> bool
+{
+	return s_parallel;
+}
+
 /**
 Compute and stores triangle plane equations.
 Add a face element with each faces plane equation, will work for polygons but non-planar 
@@ -63,22 +99,24 @@ auto BasicMeshOps::computeFacePlaneEquations(std::shared_ptr<MeshMod::Mesh> cons
 	auto& polyCon = polygons.getPolygonsContainer();
 
 	// create plane equation face data if nessecary
-	if(polyCon.getElement<PolygonData::PlaneEquations>() &&
+	auto const* existing = polyCon.getElementPtr<PolygonData::PlaneEquations>();
+	if(existing && existing->isStale() == false &&
 	   replaceExisting == false)
 	{
 		return; // we already have normal and don't want to overwrite existing so just return
 	}
+	// existing but out of date in places, just redo them
+	bool const onlyStale = (existing != nullptr) && (replaceExisting == false);
 
 	auto& planeEquations = polygons.getOrAddAttribute<PolygonData::PlaneEquations>();
 	auto const& positions = mesh->getVertices().positions();
 
-	auto peIt = planeEquations.begin();
-	while(peIt != planeEquations.end())
+	auto computePlaneEquation = [&](PolygonIndex const polygonIndex, VertexIndexContainer& faceVert)
 	{
-		auto const polyonIndex = planeEquations.distance(peIt);
+		auto& planeEq = planeEquations[polygonIndex].planeEq;
 
-		VertexIndexContainer faceVert;
-		polygons.getVertexIndices(polyonIndex, faceVert);
+		faceVert.clear();
+		polygons.getVertexIndices(polygonIndex, faceVert);
 
 		// only makes sense for triangles or polygons (TODO should use newell method for polygons)
 		if(faceVert.size() >= 3)
@@ -97,12 +135,12 @@ auto BasicMeshOps::computeFacePlaneEquations(std::shared_ptr<MeshMod::Mesh> cons
 			{
 				// d = distance along the plane normal to a vertex (all are on the plane if planar)
 				float d = dot(nc, b);
-				peIt->planeEq = Math::Plane(nc, -d);
+				planeEq = Math::Plane(nc, -d);
 			} else
 			{
 				if(zeroBad)
 				{
-					peIt->planeEq = Math::Plane(0, 0, 0, 0);
+					planeEq = Math::Plane(0, 0, 0, 0);
 				} else if(fixBad)
 				{
 					// polygon has degenerated to a line or point
@@ -110,7 +148,7 @@ auto BasicMeshOps::computeFacePlaneEquations(std::shared_ptr<MeshMod::Mesh> cons
 					// it will give a plane going throught the line or point (best we can do)
 					nc = vec3(1, 0, 0); // any normal would do, randome would be better tbh...
 					float d = dot(nc, b);
-					peIt->planeEq = Math::Plane(nc, -d);
+					planeEq = Math::Plane(nc, -d);
 				} else
 				{
 					CoreThrowException(BasicMeshOp, "Bad plane equation");
@@ -120,7 +158,7 @@ auto BasicMeshOps::computeFacePlaneEquations(std::shared_ptr<MeshMod::Mesh> cons
 		{
 			if(zeroBad)
 			{
-				peIt->planeEq = Math::Plane(0, 0, 0, 0);
+				planeEq = Math::Plane(0, 0, 0, 0);
 			} else if(fixBad && faceVert.size() >= 1)
 			{
 				vec3 a(positions[faceVert[0]].getVec3());
@@ -129,12 +167,31 @@ auto BasicMeshOps::computeFacePlaneEquations(std::shared_ptr<MeshMod::Mesh> cons
 				// it will give a plane going throught the line or point (best we can do)
 				vec3 nc(1, 0, 0); // any normal would do, randome would be better tbh...
 				float d = dot(nc, a);
-				peIt->planeEq = Math::Plane(nc, -d);
+				planeEq = Math::Plane(nc, -d);
 			}
 		}
+	};
 
-		++peIt;
+	if(onlyStale)
+	{
+		VertexIndexContainer faceVert;
+		for(auto const polygonIndex : planeEquations.staleItems)
+		{
+			if(polygons.isValid(polygonIndex)) computePlaneEquation(polygonIndex, faceVert);
+		}
+	} else
+	{
+		forChunks(polygons.getCount(), [&](size_t const begin_, size_t const end_, uint32_t)
+		{
+			VertexIndexContainer faceVert;
+			faceVert.reserve(16);
+			polyCon.forEachValidInRange(begin_, end_, [&](PolygonIndex const polygonIndex)
+			{
+				computePlaneEquation(polygonIndex, faceVert);
+			});
+		});
 	}
+	planeEquations.staleItems.clear();
 
 	mesh->updateEditState(Mesh::TopologyAttributesEdits);
 }
@@ -149,11 +206,19 @@ auto BasicMeshOps::computeAABB(std::shared_ptr<MeshMod::Mesh const> const& mesh,
 
 	auto const& positions = mesh->getVertices().positions();
 
+	// a box per chunk merged under a lock, min/max so the order chunks finish in doesn't change the result
 	aabb = Geometry::AABB(); // reset aabb
-	for(auto const& pos : positions)
+	std::mutex mergeMutex;
+	forChunks(positions.size(), [&](size_t const begin_, size_t const end_, uint32_t)
 	{
-		aabb.expandBy(pos.getVec3());
-	}
+		Geometry::AABB chunkAABB;
+		for(size_t i = begin_; i < end_; ++i)
+		{
+			chunkAABB.expandBy(positions.elements[i].getVec3());
+		}
+		std::lock_guard<std::mutex> lock(mergeMutex);
+		aabb.expandBy(chunkAABB);
+	});
 }
 
 template<size_t n>
@@ -168,10 +233,13 @@ auto BasicMeshOps::ngulate(std::shared_ptr<MeshMod::Mesh> const& mesh) -> void
 
 	auto const origFaceCount = polygons.getCount();
 
+	// n-gons that need splitting are reasonable rare, so reuse the half edge list
+	HalfEdgeIndexContainer faceHalfEdges;
+	faceHalfEdges.reserve(16);
+
 	for(auto polygonIndex = 0u; polygonIndex < origFaceCount; polygonIndex++)
 	{
-		HalfEdgeIndexContainer faceHalfEdges;
-
+		faceHalfEdges.clear();
 		polygons.getHalfEdgeIndices(PolygonIndex(polygonIndex), faceHalfEdges);
 		if(faceHalfEdges.size() > n)
 		{
@@ -289,66 +357,91 @@ auto BasicMeshOps::computeVertexNormals(std::shared_ptr<MeshMod::Mesh> const& me
 	auto const& polygons = mesh->getPolygons();
 	auto& vertices = mesh->getVertices();
 
-	if(vertices.hasAttribute<VertexData::Normals>() &&
+	auto const* existing = vertices.getVerticesContainer().getElementPtr<VertexData::Normals>();
+	if(existing && existing->isStale() == false &&
 	   replaceExisting == false)
 	{
 		return; // we already have normal and don't want to overwrite existing so just return
 	}
+	// existing but out of date in places, just redo them
+	bool const onlyStale = (existing != nullptr) && (replaceExisting == false);
 
 	bool backupMaintainPointReps = mesh->isMaintainPointReps();
 	mesh->maintainPointReps(true);
 
-	// clear normals
-	auto normals = vertices.getAttribute<VertexData::Normals>();
-	vertices.visitAll(
-			[&normals](VertexIndex const vertexIndex_)
-			{
-				normals[vertexIndex_] = {0, 0, 0};
-			});
-
 	computeFacePlaneEquations(mesh, replaceExisting);
 
+	auto& normals = vertices.getOrAddAttribute<VertexData::Normals>();
 	auto const& planeEqs = polygons.getAttribute<PolygonData::PlaneEquations>();
-	// add the poly equation to every vertex in every face
-	polygons.visitValid(
-			[&polygons, &vertices, &normals, &planeEqs](PolygonIndex const polygonIndex_)
-			{
-				VertexIndexContainer vertList;
-				polygons.getVertexIndices(polygonIndex_, vertList);
+	auto const* pointReps = vertices.getVerticesContainer().getElementPtr<VertexData::PointReps>();
+	auto const& hes = mesh->getHalfEdges().halfEdges();
+	auto const& vertexHalfEdges = vertices.getAttribute<VertexData::HalfEdges>();
 
-				for(auto const& vert : vertList)
-				{
-					VertexIndexContainer simVertList;
-					vertices.getSimilarVertexIndices(vert, simVertList);
-					for(auto const& simVert : simVertList)
-					{
+	// sum of the plane normals of every polygon using this vertex. gathered per vertex
+	// rather than scattered per polygon so each vertex is only written by one chunk
+	auto faceSum = [&](VertexIndex const vertexIndex_) -> Math::vec3
+	{
+		Math::vec3 sum(0, 0, 0);
+		for(auto const halfEdgeIndex : vertexHalfEdges[vertexIndex_].halfEdgeIndexContainer)
+		{
+			auto const& halfEdge = hes[halfEdgeIndex];
+			if(halfEdge.startVertexIndex != vertexIndex_ || !polygons.isValid(halfEdge.polygonIndex)) continue;
+			sum += planeEqs[halfEdge.polygonIndex].planeEq.normal();
+		}
+		return sum;
+	};
 
-						normals[simVert].x += planeEqs[polygonIndex_].planeEq.a;
-						normals[simVert].y += planeEqs[polygonIndex_].planeEq.b;
-						normals[simVert].z += planeEqs[polygonIndex_].planeEq.c;
-					}
-				}
-			});
+	// each vertex gets the sum of all faces touching any similar vertex, then normalise
+	auto computeNormal = [&](VertexIndex const vertexIndex_, auto const& getFaceSum)
+	{
+		if(!vertices.isValid(vertexIndex_))
+		{
+			// invalid vertex so set normal to NAN
+			normals[vertexIndex_] = {s_floatMarker, s_floatMarker, s_floatMarker};
+			return;
+		}
 
-	// now normalise all normals
-	vertices.visitAll(
-			[&vertices, &normals](VertexIndex const vertexIndex_)
-			{
-				if(!vertices.isValid(vertexIndex_))
-				{
-					// invalid vertex so set normal to NAN
-					normals[vertexIndex_] = {s_floatMarker, s_floatMarker, s_floatMarker};
-				} else
-				{
-					//valid vertex (not deleted)
-					float norm = Math::Length(normals[vertexIndex_].getVec3());
-					norm = sqrtf(norm);
+		//valid vertex (not deleted)
+		Math::vec3 sum = getFaceSum(vertexIndex_);
+		VertexIndex similar = pointReps ? (*pointReps)[vertexIndex_].next : vertexIndex_;
+		while(similar != vertexIndex_ && similar != InvalidVertexIndex)
+		{
+			sum += getFaceSum(similar);
+			similar = (*pointReps)[similar].next;
+		}
 
-					normals[vertexIndex_].x = normals[vertexIndex_].x / norm;
-					normals[vertexIndex_].y = normals[vertexIndex_].y / norm;
-					normals[vertexIndex_].z = normals[vertexIndex_].z / norm;
-				}
+		float const norm = Math::Length(sum);
+		normals[vertexIndex_] = {sum.x / norm, sum.y / norm, sum.z / norm};
+	};
+
+	if(onlyStale)
+	{
+		// same sums as below in the same order, so the same bits
+		for(auto const vertexIndex : normals.staleItems)
+		{
+			computeNormal(vertexIndex, faceSum);
+		}
+	} else
+	{
+		std::vector<Math::vec3> faceSums(vertices.getCount(), Math::vec3(0, 0, 0));
+		forChunks(vertices.getCount(), [&](size_t const begin_, size_t const end_, uint32_t)
+		{
+			vertices.getVerticesContainer().forEachValidInRange(begin_, end_, [&](VertexIndex const vertexIndex_)
+			{
+				faceSums[size_t(vertexIndex_)] = faceSum(vertexIndex_);
 			});
+		});
+
+		auto getFaceSum = [&faceSums](VertexIndex const vertexIndex_) { return faceSums[size_t(vertexIndex_)]; };
+		forChunks(vertices.getCount(), [&](size_t const begin_, size_t const end_, uint32_t)
+		{
+			for(size_t i = begin_; i < end_; ++i)
+			{
+				computeNormal(VertexIndex(i), getFaceSum);
+			}
+		});
+	}
+	normals.staleItems.clear();
 
 	mesh->maintainPointReps(backupMaintainPointReps);
 	mesh->updateEditState(Mesh::VertexAttributeEdits);
@@ -375,7 +468,11 @@ auto BasicMeshOps::computeVertexNormalsEx(std::shared_ptr<MeshMod::Mesh> const&
 	auto const& halfEdges = mesh->getHalfEdges();
 	auto const& polygons = mesh->getPolygons();
 
-	if(vertices.hasAttribute<VertexData::Normals>() && replaceExisting == false)
+	// moved positions make some or all of any existing normals out of date, which is only known
+	// after the update below
+	if(vertices.hasAttribute<VertexData::Normals>() && replaceExisting == false &&
+	   vertices.getAttribute<VertexData::Normals>().isStale() == false &&
+	   mesh->hasPendingPositionEdits() == false)
 	{
 		return; // we already have normal and don't want to overwrite existing so just return
 	}
@@ -384,99 +481,100 @@ auto BasicMeshOps::computeVertexNormalsEx(std::shared_ptr<MeshMod::Mesh> const&
 	mesh->maintainPointReps(true);
 	mesh->updateFromEdits();
 
-	// clear normals
-	auto& normals = vertices.getOrAddAttribute<VertexData::Normals>();
-	vertices.visitAll(
-			[&normals](VertexIndex const vertexIndex_)
-			{
-				normals[vertexIndex_] = {0, 0, 0};
-			});
-
 	computeFacePlaneEquations(mesh, replaceExisting, zeroBad, fixBad);
 	auto const& planeEqs = polygons.getAttribute<PolygonData::PlaneEquations>();
+	auto& normals = vertices.getOrAddAttribute<VertexData::Normals>();
 
 	auto const& hes = halfEdges.halfEdges();
 
-	HalfEdgeIndexContainer vertexHalfEdges;
-	vertexHalfEdges.reserve(10);
-
 	// each normal try to generate a fair normal (TODO smoothing group polygons)
 	// fix or zero bad normals, fix try using simplier plane equation generator
 	// TODO if this fix fails try mesh libs average of existing normals?
 
-	for(auto& normal : normals)
+	forChunks(normals.size(), [&](size_t const begin_, size_t const end_, uint32_t)
 	{
-		// get the vertex and edges connected to this vertex
-		auto const vertexIndex = normals.distance(normal);
-		if(vertices.isValid(vertexIndex) == false) continue;
+		HalfEdgeIndexContainer vertexHalfEdges;
+		vertexHalfEdges.reserve(10);
 
-		vertexHalfEdges.clear();
-		vertices.getVertexHalfEdges(vertexIndex, vertexHalfEdges);
+		for(size_t i = begin_; i < end_; ++i)
+		{
+			// clear normal
+			auto& normal = normals.elements[i];
+			normal = {0, 0, 0};
 
-		Math::vec3 vertexNormal(0, 0, 0);
+			// get the vertex and edges connected to this vertex
+			auto const vertexIndex = VertexIndex(i);
+			if(vertices.isValid(vertexIndex) == false) continue;
 
-		// TODO smoothing groups
-		for(auto heIt = vertexHalfEdges.cbegin(); heIt != vertexHalfEdges.cend(); ++heIt)
-		{
-			const HalfEdgeData::HalfEdge& he = hes.at(*heIt);
-			const PolygonData::PlaneEquation& pe = planeEqs.at(he.polygonIndex);
-			Math::vec3 localNormal = pe.planeEq.normal();
-
-			// get opposing indices
-			const HalfEdgeIndex i1 = (HalfEdgeIndex) ((size_t(*heIt) + 1) % vertexHalfEdges.size());
-			const HalfEdgeIndex i2 = (HalfEdgeIndex) ((size_t(*heIt) + 2) % vertexHalfEdges.size());
-			const HalfEdgeData::HalfEdge& he1 = hes.at(i1);
-			const HalfEdgeData::HalfEdge& he2 = hes.at(i2);
-			const PolygonData::PlaneEquation& pe1 = planeEqs.at(he1.polygonIndex);
-			const PolygonData::PlaneEquation& pe2 = planeEqs.at(he2.polygonIndex);
-
-			Math::vec3 e1 = Normalise(pe1.planeEq.normal());
-			Math::vec3 e2 = Normalise(pe2.planeEq.normal());
-
-			// compute the angle and only accumulate at non-sliver angles
-			const float angle = std::acos(-dot(e1, e2) / (Math::Length(e1) * Math::Length(e2)));
-			if(std::isfinite(angle))
+			vertexHalfEdges.clear();
+			vertices.getVertexHalfEdges(vertexIndex, vertexHalfEdges);
+
+			Math::vec3 vertexNormal(0, 0, 0);
+
+			// TODO smoothing groups
+			for(auto heIt = vertexHalfEdges.cbegin(); heIt != vertexHalfEdges.cend(); ++heIt)
 			{
-				// accumulate the normal
-				vertexNormal += localNormal * angle;
+				const HalfEdgeData::HalfEdge& he = hes.at(*heIt);
+				const PolygonData::PlaneEquation& pe = planeEqs.at(he.polygonIndex);
+				Math::vec3 localNormal = pe.planeEq.normal();
+
+				// get opposing indices
+				const HalfEdgeIndex i1 = (HalfEdgeIndex) ((size_t(*heIt) + 1) % vertexHalfEdges.size());
+				const HalfEdgeIndex i2 = (HalfEdgeIndex) ((size_t(*heIt) + 2) % vertexHalfEdges.size());
+				const HalfEdgeData::HalfEdge& he1 = hes.at(i1);
+				const HalfEdgeData::HalfEdge& he2 = hes.at(i2);
+				const PolygonData::PlaneEquation& pe1 = planeEqs.at(he1.polygonIndex);
+				const PolygonData::PlaneEquation& pe2 = planeEqs.at(he2.polygonIndex);
+
+				Math::vec3 e1 = Normalise(pe1.planeEq.normal());
+				Math::vec3 e2 = Normalise(pe2.planeEq.normal());
+
+				// compute the angle and only accumulate at non-sliver angles
+				const float angle = std::acos(-dot(e1, e2) / (Math::Length(e1) * Math::Length(e2)));
+				if(std::isfinite(angle))
+				{
+					// accumulate the normal
+					vertexNormal += localNormal * angle;
+				}
 			}
-		}
 
-		// normalise it
-		vertexNormal = Math::Normalise(vertexNormal);
+			// normalise it
+			vertexNormal = Math::Normalise(vertexNormal);
 
-		// check it's finite
-		if(!IsFinite(vertexNormal))
-		{
-			// either fix it using simplier plane equation average, zero or ignore
-			if(zeroBad)
-			{
-				vertexNormal = Math::vec3(0, 0, 0);
-			} else if(fixBad)
+			// check it's finite
+			if(!IsFinite(vertexNormal))
 			{
-				HalfEdgeIndexContainer::const_iterator edgeIt = vertexHalfEdges.begin();
-				vertexNormal = Math::vec3(0, 0, 0);
-				while(edgeIt != vertexHalfEdges.end())
+				// either fix it using simplier plane equation average, zero or ignore
+				if(zeroBad)
+				{
+					vertexNormal = Math::vec3(0, 0, 0);
+				} else if(fixBad)
 				{
-					const HalfEdgeData::HalfEdge& he = hes.at(*edgeIt);
-					const PolygonData::PlaneEquation& pe = planeEqs.at(he.polygonIndex);
-					vertexNormal += pe.planeEq.normal();
-					++edgeIt;
+					HalfEdgeIndexContainer::const_iterator edgeIt = vertexHalfEdges.begin();
+					vertexNormal = Math::vec3(0, 0, 0);
+					while(edgeIt != vertexHalfEdges.end())
+					{
+						const HalfEdgeData::HalfEdge& he = hes.at(*edgeIt);
+						const PolygonData::PlaneEquation& pe = planeEqs.at(he.polygonIndex);
+						vertexNormal += pe.planeEq.normal();
+						++edgeIt;
+					}
+					// normalise it
+					vertexNormal = Math::Normalise(vertexNormal);
 				}
-				// normalise it
-				vertexNormal = Math::Normalise(vertexNormal);
 			}
-		}
 
-		// remove denormals here at source, to ensure none enter the pipe at source
-		if(!std::isnormal(normal.x)) normal.x = float(0);
-		if(!std::isnormal(normal.y)) normal.y = float(0);
-		if(!std::isnormal(normal.z)) normal.z = float(0);
+			// remove denormals here at source, to ensure none enter the pipe at source
+			if(!std::isnormal(normal.x)) normal.x = float(0);
+			if(!std::isnormal(normal.y)) normal.y = float(0);
+			if(!std::isnormal(normal.z)) normal.z = float(0);
 
-		normal.x += vertexNormal.x;
-		normal.y += vertexNormal.y;
-		normal.z += vertexNormal.z;
-	}
+			normal.x += vertexNormal.x;
+			normal.y += vertexNormal.y;
+			normal.z += vertexNormal.z;
+		}
+	});
+	normals.staleItems.clear();
 
 	mesh->maintainPointReps(backupMaintainPointReps);
 	mesh->updateEditState(Mesh::VertexAttributeEdits);
@@ -485,14 +583,41 @@ auto BasicMeshOps::computeVertexNormalsEx(std::shared_ptr<MeshMod::Mesh> const&
 
 auto BasicMeshOps::transform(std::shared_ptr<MeshMod::Mesh> const& mesh, Math::mat4x4 const& transform) -> void
 {
-	auto& vertices = mesh->getVertices();
-	for(auto& vertex : vertices.positions())
+	auto& positions = mesh->getVertices().positions();
+
+	// the matrix is pulled apart into scalars so the loops are simple enough for the
+	// compiler to vectorise across vertices, same maths as Math::TransformAndProject
+	float const m00 = transform[0][0], m01 = transform[0][1], m02 = transform[0][2], m03 = transform[0][3];
+	float const m10 = transform[1][0], m11 = transform[1][1], m12 = transform[1][2], m13 = transform[1][3];
+	float const m20 = transform[2][0], m21 = transform[2][1], m22 = transform[2][2], m23 = transform[2][3];
+	float const m30 = transform[3][0], m31 = transform[3][1], m32 = transform[3][2], m33 = transform[3][3];
+	// no projection then w is always 1 and the divide can go
+	bool const affine = (m03 == 0.0f && m13 == 0.0f && m23 == 0.0f && m33 == 1.0f);
+
+	MeshMod::VertexData::Position* const data = positions.data();
+	forChunks(positions.size(), [&](size_t const begin_, size_t const end_, uint32_t)
 	{
-		Math::vec3 pos = Math::TransformAndProject(transform, vertex.getVec3());
-		vertex.x = pos.x;
-		vertex.y = pos.y;
-		vertex.z = pos.z;
-	}
+		if(affine)
+		{
+			for(size_t i = begin_; i < end_; ++i)
+			{
+				float const x = data[i].x, y = data[i].y, z = data[i].z;
+				data[i].x = m00 * x + m10 * y + m20 * z + m30;
+				data[i].y = m01 * x + m11 * y + m21 * z + m31;
+				data[i].z = m02 * x + m12 * y + m22 * z + m32;
+			}
+		} else
+		{
+			for(size_t i = begin_; i < end_; ++i)
+			{
+				float const x = data[i].x, y = data[i].y, z = data[i].z;
+				float const w = m03 * x + m13 * y + m23 * z + m33;
+				data[i].x = (m00 * x + m10 * y + m20 * z + m30) / w;
+				data[i].y = (m01 * x + m11 * y + m21 * z + m31) / w;
+				data[i].z = (m02 * x + m12 * y + m22 * z + m32) / w;
+			}
+		}
+	});
 	mesh->updateEditState(MeshMod::Mesh::PositionEdits);
 }
 
@@ -625,6 +750,7 @@ auto BasicMeshOps::spherize(std::shared_ptr<MeshMod::Mesh> const& mesh_, float t
 				vertices.position(vertexIndex_).y = p.y;
 				vertices.position(vertexIndex_).z = p.z;
 			});
+	mesh_->updateEditState(MeshMod::Mesh::PositionEdits);
 
 }
 
@@ -20,10 +20,12 @@ class BasicMeshOps
 {
 public:
 
-	//! compute a per-polygon plane equation
+	//! compute a per-polygon plane equation. when not replacing any that are out of date
+	//! (see Mesh::markPositionEdited) are redone
 	static auto computeFacePlaneEquations(std::shared_ptr<MeshMod::Mesh> const& mesh, bool replaceExisting = true, bool zeroBad = false, bool fixBad = true ) -> void;
 
-	//! generates a basic vertex normal set. optionally replace any existing normals
+	//! generates a basic vertex normal set. optionally replace any existing normals, when not
+	//! replacing any that are out of date (see Mesh::markPositionEdited) are redone
 	static auto computeVertexNormals(std::shared_ptr<MeshMod::Mesh> const& mesh, bool replaceExisting = true ) -> void;
 
 	//! conpute vertex normals handling bad cases better
@@ -52,6 +54,13 @@ public:
 
 	static auto spherize(std::shared_ptr<MeshMod::Mesh> const& mesh_, float t_) -> void;
 
+	//! plane equations, normals, transform and aabb split their loops into chunks run
+	//! on the shared task threads (g_EnkiTS). every item is written by only one chunk and
+	//! the aabb reduction is min/max, so results are bitwise identical to serial.
+	//! disable to run serially
+	static auto setParallel(bool enable_) -> void;
+	static auto isParallel() -> bool;
+
 private:
 	template<size_t n>
 	static auto ngulate(std::shared_ptr<MeshMod::Mesh> const& mesh) -> void;
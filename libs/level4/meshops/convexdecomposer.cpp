@@ -0,0 +1,435 @@
+#include "core/core.h"
+#include "meshmod/mesh.h"
+#include "convexdecomposer.h"
+#include "meshops/VHACD_Lib/public/VHACD.h"
+#include "core/sharedtasks.h"
+#include "cityhash/city.h"
+#include "binny/inplacebundle.h"
+#include "resourcemanager/derivedcache.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace MeshOps {
+
+ConvexDecomposer::ConvexDecomposer(uint32_t workerCount_) :
+		workerCount(workerCount_)
+{
+	Core::InitSharedTasks();
+	if(workerCount == 0)
+	{
+		workerCount = std::max(g_EnkiTS.GetNumTaskThreads(), 2u) - 1;
+	}
+}
+
+ConvexDecomposer::~ConvexDecomposer()
+{
+	{
+		std::unique_lock<std::mutex> lock(jobMutex);
+		jobsDone.wait(lock, [this]() { return outstanding == 0 && running == 0; });
+	}
+	// a runner has left runJobs but enkiTS may still be finishing its task set
+	for(auto const& runner : runners)
+	{
+		while(!runner->GetIsComplete())
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+auto ConvexDecomposer::computeDiskKey(float const* points_, uint32_t pointCount_, uint32_t const* triangles_,
+									  uint32_t triangleCount_, ConvexHullParameters const& parameters_)
+-> ResourceManager::DerivedDataCache::Key
+{
+	uint64_t const meshHash = CityHash::Hash64WithSeeds((char const*) triangles_, size_t(triangleCount_) * 3 * sizeof(uint32_t),
+														CityHash::Hash64((char const*) points_, size_t(pointCount_) * 3 * sizeof(float)),
+														(uint64_t(pointCount_) << 32) | uint64_t(triangleCount_));
+
+	// field by field so padding and the progress callback don't change the key
+	float const floats[] = {
+			parameters_.concavity, parameters_.alpha, parameters_.beta, parameters_.minVolumePerCH
+	};
+	uint32_t const uints[] = {
+			parameters_.resolution, parameters_.maxNumVerticesPerCH, parameters_.planeDownsampling,
+			parameters_.convexhullDownsampling, parameters_.pca, parameters_.mode,
+			parameters_.convexhullApproximation, parameters_.maxConvexHulls, parameters_.projectHullVertices
+	};
+	uint64_t const parameterHash = CityHash::Hash64WithSeed((char const*) uints, sizeof(uints),
+															CityHash::Hash64((char const*) floats, sizeof(floats)));
+
+	return { DiskCacheOpId, DiskCacheOpVersion, meshHash, parameterHash };
+}
+
+auto ConvexDecomposer::computeKey(float const* points_, uint32_t pointCount_, uint32_t const* triangles_, uint32_t triangleCount_,
+								  ConvexHullParameters const& parameters_) -> uint64_t
+{
+	auto const diskKey = computeDiskKey(points_, pointCount_, triangles_, triangleCount_, parameters_);
+	return CityHash::Hash128to64({ diskKey.inputHash, diskKey.parameterHash });
+}
+
+auto ConvexDecomposer::submit(std::vector<Request> batch_) -> std::vector<uint64_t>
+{
+	std::vector<uint64_t> keys;
+	keys.reserve(batch_.size());
+	if(batch_.empty()) return keys;
+
+	// copying and hashing the inputs is done before taking any locks
+	std::vector<std::shared_ptr<Job>> newJobs;
+	newJobs.reserve(batch_.size());
+	for(auto& request : batch_)
+	{
+		auto job = std::make_shared<Job>();
+		if(request.points == nullptr && request.pointCount == 0)
+		{
+			job->points = std::move(request.ownedPoints);
+			job->triangles = std::move(request.ownedTriangles);
+		} else
+		{
+			assert(request.points != nullptr || request.pointCount == 0);
+			assert(request.triangles != nullptr || request.triangleCount == 0);
+			job->points.assign(request.points, request.points + (size_t(request.pointCount) * 3));
+			job->triangles.assign(request.triangles, request.triangles + (size_t(request.triangleCount) * 3));
+		}
+		job->diskKey = computeDiskKey(job->points.data(), uint32_t(job->points.size() / 3),
+									  job->triangles.data(), uint32_t(job->triangles.size() / 3), request.parameters);
+		job->key = CityHash::Hash128to64({ job->diskKey.inputHash, job->diskKey.parameterHash });
+		job->priority = request.priority;
+		job->parameters = request.parameters;
+		job->parameters.convexHullProgressCallback = nullptr;
+		job->onComplete = request.onComplete;
+		keys.push_back(job->key);
+		newJobs.push_back(std::move(job));
+	}
+
+	uint32_t newRunners;
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		for(auto& job : newJobs)
+		{
+			job->order = nextOrder++;
+			jobs.push_back(job);
+			std::push_heap(jobs.begin(), jobs.end(), JobCompare());
+		}
+		outstanding += newJobs.size();
+		newRunners = std::min(workerCount - running, uint32_t(newJobs.size()));
+		running += newRunners;
+	}
+	if(newRunners == 0) return keys;
+
+	// same rules as Core::ParallelFor, only one thread gives g_EnkiTS tasks at a time
+	std::unique_lock<std::recursive_mutex> lock(Core::SharedTasksMutex, std::try_to_lock);
+	if(!lock.owns_lock() || g_EnkiTS.GetNumTaskThreads() < 2)
+	{
+		// the first drains the heap, the rest just leave
+		for(auto i = 0u; i < newRunners; ++i)
+		{
+			runJobs();
+		}
+		return keys;
+	}
+
+	runners.erase(std::remove_if(runners.begin(), runners.end(),
+								 [](std::unique_ptr<enki::TaskSet> const& runner_) { return runner_->GetIsComplete(); }),
+				  runners.end());
+	for(auto i = 0u; i < newRunners; ++i)
+	{
+		runners.push_back(std::make_unique<enki::TaskSet>([this](enki::TaskSetPartition, uint32_t) { runJobs(); }));
+		g_EnkiTS.AddTaskSetToPipe(runners.back().get());
+	}
+	return keys;
+}
+
+auto ConvexDecomposer::submit(std::shared_ptr<MeshMod::Mesh> const& mesh_, ConvexHullParameters const& parameters_,
+							  int32_t priority_, Callback const& onComplete_) -> uint64_t
+{
+	assert(mesh_);
+	std::vector<Request> batch(1);
+	Request& request = batch[0];
+	ConvexHullComputer::gatherTriangles(*mesh_, request.ownedPoints, request.ownedTriangles);
+	request.parameters = parameters_;
+	request.priority = priority_;
+	request.onComplete = onComplete_;
+	return submit(std::move(batch))[0];
+}
+
+auto ConvexDecomposer::waitForAll() -> void
+{
+	std::unique_lock<std::mutex> lock(jobMutex);
+	jobsDone.wait(lock, [this]() { return outstanding == 0; });
+}
+
+auto ConvexDecomposer::runJobs() -> void
+{
+	for(;;)
+	{
+		std::shared_ptr<Job> job;
+		{
+			std::lock_guard<std::mutex> lock(jobMutex);
+			if(jobs.empty())
+			{
+				// checked and counted under the same lock submit starts runners with, so nothing is left waiting
+				if(--running == 0) jobsDone.notify_all();
+				return;
+			}
+			std::pop_heap(jobs.begin(), jobs.end(), JobCompare());
+			job = std::move(jobs.back());
+			jobs.pop_back();
+		}
+		runJob(*job);
+	}
+}
+
+auto ConvexDecomposer::runJob(Job& job_) -> void
+{
+	auto hulls = findCached(job_.key);
+	if(!hulls)
+	{
+		// last session may have done it already
+		hulls = loadFromDisk(job_.diskKey);
+		if(!hulls)
+		{
+			hulls = decompose(job_);
+			saveToDisk(job_.diskKey, *hulls);
+		}
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		hulls = addToCache(job_.key, hulls);
+	}
+
+	if(job_.onComplete)
+	{
+		job_.onComplete(job_.key, toMeshes(*hulls));
+	}
+
+	std::lock_guard<std::mutex> lock(jobMutex);
+	if(--outstanding == 0)
+	{
+		jobsDone.notify_all();
+	}
+}
+
+auto ConvexDecomposer::decompose(Job const& job_) -> std::shared_ptr<CachedHulls const>
+{
+	auto hulls = std::make_shared<CachedHulls>();
+
+	// plain blocking vhacd, the runner already has a thread to itself
+	auto computer = std::make_shared<ConvexHullComputer::ReturnType>(VHACD::CreateVHACD(), nullptr);
+	VHACD::IVHACD* vhacd = computer->first;
+	if(ConvexHullComputer::begin(computer, job_.points.data(), uint32_t(job_.points.size() / 3),
+								 job_.triangles.data(), uint32_t(job_.triangles.size() / 3), job_.parameters))
+	{
+		hulls->resize(vhacd->GetNConvexHulls());
+		for(auto i = 0u; i < hulls->size(); ++i)
+		{
+			VHACD::IVHACD::ConvexHull ch;
+			vhacd->GetConvexHull(i, ch);
+			HullData& hull = (*hulls)[i];
+			hull.points.assign(ch.m_points, ch.m_points + (size_t(ch.m_nPoints) * 3));
+			hull.triangles.assign(ch.m_triangles, ch.m_triangles + (size_t(ch.m_nTriangles) * 3));
+		}
+	} else
+	{
+		LOG_F(WARNING, "Convex decomposition of %u triangles failed", uint32_t(job_.triangles.size() / 3));
+	}
+	vhacd->Clean();
+	vhacd->Release();
+	return hulls;
+}
+
+auto ConvexDecomposer::findCached(uint64_t key_) const -> std::shared_ptr<CachedHulls const>
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	auto const it = cache.find(key_);
+	if(it == cache.end()) return nullptr;
+	cacheUse.splice(cacheUse.begin(), cacheUse, it->second.use);
+	return it->second.hulls;
+}
+
+auto ConvexDecomposer::addToCache(uint64_t key_, std::shared_ptr<CachedHulls const> const& hulls_)
+-> std::shared_ptr<CachedHulls const>
+{
+	// a duplicate may have finished first, either result is the same
+	auto const found = cache.find(key_);
+	if(found != cache.end()) return found->second.hulls;
+
+	cacheUse.push_front(key_);
+	size_t const bytes = sizeOf(*hulls_);
+	cache.emplace(key_, CacheEntry{ hulls_, bytes, cacheUse.begin() });
+	cacheBytes += bytes;
+
+	// the newest always stays
+	trimCache(1);
+	return hulls_;
+}
+
+auto ConvexDecomposer::trimCache(size_t keepCount_) -> void
+{
+	// anyone still using an evicted result keeps it alive
+	while(cacheBytes > maxCacheBytes && cacheUse.size() > keepCount_)
+	{
+		auto const it = cache.find(cacheUse.back());
+		cacheBytes -= it->second.bytes;
+		cache.erase(it);
+		cacheUse.pop_back();
+	}
+}
+
+auto ConvexDecomposer::sizeOf(CachedHulls const& hulls_) -> size_t
+{
+	size_t bytes = sizeof(CachedHulls) + hulls_.size() * sizeof(HullData);
+	for(auto const& hull : hulls_)
+	{
+		bytes += hull.points.size() * sizeof(float) + hull.triangles.size() * sizeof(uint32_t);
+	}
+	return bytes;
+}
+
+auto ConvexDecomposer::toMeshes(CachedHulls const& hulls_) -> Hulls
+{
+	Hulls meshes(hulls_.size());
+	for(auto i = 0u; i < hulls_.size(); ++i)
+	{
+		HullData const& hull = hulls_[i];
+		meshes[i] = ConvexHullComputer::createHullMesh("ConvexHull_" + std::to_string(i),
+													   hull.points.data(), uint32_t(hull.points.size() / 3),
+													   hull.triangles.data(), uint32_t(hull.triangles.size() / 3));
+	}
+	return meshes;
+}
+
+auto ConvexDecomposer::getCached(uint64_t key_) const -> Hulls
+{
+	auto hulls = findCached(key_);
+	if(!hulls) return {};
+	return toMeshes(*hulls);
+}
+
+auto ConvexDecomposer::clearCache() -> void
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	cache.clear();
+	cacheUse.clear();
+	cacheBytes = 0;
+}
+
+auto ConvexDecomposer::setMaxCacheBytes(size_t maxBytes_) -> void
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	maxCacheBytes = maxBytes_;
+	trimCache(0);
+}
+
+auto ConvexDecomposer::getCacheBytes() const -> size_t
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	return cacheBytes;
+}
+
+auto ConvexDecomposer::setDiskCache(std::shared_ptr<ResourceManager::DerivedDataCache> const& diskCache_) -> void
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	diskCache = diskCache_;
+}
+
+namespace {
+constexpr uint32_t HullsChunkId = 0x4C4C5548; // HULL
+}
+
+// a single chunk, hull count then per hull its point and triangle counts, its points and its triangles
+auto ConvexDecomposer::saveToDisk(ResourceManager::DerivedDataCache::Key const& key_, CachedHulls const& hulls_) -> void
+{
+	std::shared_ptr<ResourceManager::DerivedDataCache> disk;
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		disk = diskCache;
+	}
+	if(!disk) return;
+
+	std::vector<uint8_t> data;
+	auto const append = [&data](void const* src_, size_t size_)
+	{
+		size_t const offset = data.size();
+		data.resize(offset + size_);
+		if(size_ != 0) std::memcpy(data.data() + offset, src_, size_);
+	};
+	uint32_t const hullCount = uint32_t(hulls_.size());
+	append(&hullCount, sizeof(uint32_t));
+	for(auto const& hull : hulls_)
+	{
+		uint32_t const counts[] = { uint32_t(hull.points.size()), uint32_t(hull.triangles.size()) };
+		append(counts, sizeof(counts));
+		append(hull.points.data(), hull.points.size() * sizeof(float));
+		append(hull.triangles.data(), hull.triangles.size() * sizeof(uint32_t));
+	}
+
+	disk->put(key_, [&data](Binny::BundleWriter& writer_)
+	{
+		return writer_.addRawBinaryChunk("hulls", HullsChunkId, 0, 0, 0, {}, data);
+	});
+}
+
+auto ConvexDecomposer::loadFromDisk(ResourceManager::DerivedDataCache::Key const& key_) -> std::shared_ptr<CachedHulls const>
+{
+	std::shared_ptr<ResourceManager::DerivedDataCache> disk;
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		disk = diskCache;
+	}
+	if(!disk) return nullptr;
+
+	auto bytes = std::make_shared<std::vector<uint8_t>>();
+	if(!disk->get(key_, *bytes)) return nullptr;
+
+	using namespace Binny;
+	auto hulls = std::make_shared<CachedHulls>();
+	bool valid = false;
+	std::vector<IBundle::ChunkHandler> handlers = {
+			{HullsChunkId, 0, 0,
+					[&hulls, &valid](std::string_view, int, uint16_t majorVersion_, uint16_t, size_t size_,
+									 std::shared_ptr<void> ptr_) -> bool
+					{
+						if(majorVersion_ != 0) return false;
+						uint8_t const* data = (uint8_t const*) ptr_.get();
+						uint8_t const* end = data + size_;
+						auto const read = [&data, end](void* dst_, size_t size_) -> bool
+						{
+							if(size_t(end - data) < size_) return false;
+							if(size_ != 0) std::memcpy(dst_, data, size_);
+							data += size_;
+							return true;
+						};
+						uint32_t hullCount;
+						if(!read(&hullCount, sizeof(uint32_t))) return false;
+						hulls->resize(hullCount);
+						for(auto& hull : *hulls)
+						{
+							uint32_t counts[2];
+							if(!read(counts, sizeof(counts))) return false;
+							hull.points.resize(counts[0]);
+							hull.triangles.resize(counts[1]);
+							if(!read(hull.points.data(), counts[0] * sizeof(float))) return false;
+							if(!read(hull.triangles.data(), counts[1] * sizeof(uint32_t))) return false;
+						}
+						valid = true;
+						return true;
+					},
+					[](int, void*) {}
+			}
+	};
+	InPlaceBundle bundle(&malloc, &free, bytes, bytes->data(), bytes->size());
+	auto const ret = bundle.read({}, handlers);
+	if(ret.first != IBundle::ErrorCode::Okay || !valid)
+	{
+		disk->remove(key_);
+		return nullptr;
+	}
+	return hulls;
+}
+
+auto ConvexDecomposer::getCacheSize() const -> size_t
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	return cache.size();
+}
+
+}
@@ -0,0 +1,162 @@
+#pragma once
+#ifndef MESHOPS_CONVEXDECOMPOSER_H
+#define MESHOPS_CONVEXDECOMPOSER_H
+
+#include "core/core.h"
+#include "meshmod/mesh.h"
+#include "meshops/convexhullcomputer.h"
+#include "resourcemanager/derivedcache.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace enki { class TaskSet; }
+
+namespace MeshOps {
+
+// batch convex decomposition on a bounded number of the shared g_EnkiTS threads, for generating colliders
+// in bulk. each request runs the blocking VHACD on whichever runner picks it up, highest priority first, and
+// its callback is called on that thread when done. if the scheduler is busy with another submitter the batch
+// runs on the submitting thread instead. results are cached by a 64 bit hash of the inputs plus
+// parameters so repeated meshes (instanced props etc.) only get decomposed once
+class ConvexDecomposer
+{
+public:
+	using Hulls = std::vector<std::shared_ptr<MeshMod::Mesh>>;
+	using Callback = std::function<void(uint64_t key, Hulls const& hulls)>;
+
+	struct Request
+	{
+		// 3 floats per point and 3 indices per triangle, copied by submit
+		float const* points = nullptr;
+		uint32_t pointCount = 0;
+		uint32_t const* triangles = nullptr;
+		uint32_t triangleCount = 0;
+		// or arrays the job takes over without a copy, used instead of the pointers if points is empty
+		std::vector<float> ownedPoints;
+		std::vector<uint32_t> ownedTriangles;
+		ConvexHullParameters parameters;
+		// higher priorities start first, equal ones in submit order
+		int32_t priority = 0;
+		Callback onComplete;
+	};
+
+	// at most this many requests run at once, 0 uses all but one of the shared task threads
+	explicit ConvexDecomposer(uint32_t workerCount_ = 0);
+	// waits for anything still queued or running
+	~ConvexDecomposer();
+
+	ConvexDecomposer(ConvexDecomposer const&) = delete;
+	ConvexDecomposer& operator=(ConvexDecomposer const&) = delete;
+
+	// MT safe, returns the cache key of each request in order. progress callbacks in the parameters are ignored
+	auto submit(std::vector<Request> batch_) -> std::vector<uint64_t>;
+	auto submit(std::shared_ptr<MeshMod::Mesh> const& mesh_, ConvexHullParameters const& parameters_,
+				int32_t priority_, Callback const& onComplete_) -> uint64_t;
+
+	// blocks until every request submitted so far has had its callback called
+	auto waitForAll() -> void;
+
+	// new meshes of a cached result or empty if it isn't (yet) in the cache
+	auto getCached(uint64_t key_) const -> Hulls;
+	auto clearCache() -> void;
+	auto getCacheSize() const -> size_t;
+	// the in memory cache drops the least recently used results past this many bytes of hull data
+	auto setMaxCacheBytes(size_t maxBytes_) -> void;
+	auto getCacheBytes() const -> size_t;
+	static constexpr size_t DefaultMaxCacheBytes = 64 * 1024 * 1024;
+
+	// results missing from memory are looked for here before decomposing and new ones are stored in it,
+	// so they last across sessions. null turns it off
+	auto setDiskCache(std::shared_ptr<ResourceManager::DerivedDataCache> const& diskCache_) -> void;
+
+	// derived data cache op id and version, bump the version when the results would change
+	static constexpr uint32_t DiskCacheOpId = 0x4C4C5548; // HULL
+	static constexpr uint32_t DiskCacheOpVersion = 2;
+
+	auto getWorkerCount() const -> uint32_t { return workerCount; }
+
+	static auto computeKey(float const* points_, uint32_t pointCount_, uint32_t const* triangles_, uint32_t triangleCount_,
+						   ConvexHullParameters const& parameters_) -> uint64_t;
+	// the mesh and parameter hashes computeKey combines, the disk cache keeps both whole
+	static auto computeDiskKey(float const* points_, uint32_t pointCount_, uint32_t const* triangles_, uint32_t triangleCount_,
+							   ConvexHullParameters const& parameters_) -> ResourceManager::DerivedDataCache::Key;
+
+private:
+	// hull points and triangles as vhacd gives them, meshes are made fresh for each caller
+	struct HullData
+	{
+		std::vector<float> points;
+		std::vector<uint32_t> triangles;
+	};
+	using CachedHulls = std::vector<HullData>;
+
+	struct Job
+	{
+		uint64_t key;
+		ResourceManager::DerivedDataCache::Key diskKey;
+		int32_t priority;
+		uint64_t order;
+		std::vector<float> points;
+		std::vector<uint32_t> triangles;
+		ConvexHullParameters parameters;
+		Callback onComplete;
+	};
+	struct JobCompare
+	{
+		bool operator()(std::shared_ptr<Job> const& a_, std::shared_ptr<Job> const& b_) const
+		{
+			if(a_->priority != b_->priority) return a_->priority < b_->priority;
+			return a_->order > b_->order;
+		}
+	};
+
+	// pulls the best waiting job until there are none left
+	auto runJobs() -> void;
+	auto runJob(Job& job_) -> void;
+	auto decompose(Job const& job_) -> std::shared_ptr<CachedHulls const>;
+	auto findCached(uint64_t key_) const -> std::shared_ptr<CachedHulls const>;
+	auto loadFromDisk(ResourceManager::DerivedDataCache::Key const& key_) -> std::shared_ptr<CachedHulls const>;
+	auto saveToDisk(ResourceManager::DerivedDataCache::Key const& key_, CachedHulls const& hulls_) -> void;
+	// call with cacheMutex held, returns whichever result is cached for key_
+	auto addToCache(uint64_t key_, std::shared_ptr<CachedHulls const> const& hulls_) -> std::shared_ptr<CachedHulls const>;
+	// call with cacheMutex held, evicts least recently used past maxCacheBytes leaving at least keepCount_
+	auto trimCache(size_t keepCount_) -> void;
+	static auto toMeshes(CachedHulls const& hulls_) -> Hulls;
+	static auto sizeOf(CachedHulls const& hulls_) -> size_t;
+
+	uint32_t workerCount;
+
+	// jobs wait in a heap, up to workerCount runner tasks pull the best one until its empty
+	std::mutex jobMutex;
+	std::condition_variable jobsDone;
+	std::vector<std::shared_ptr<Job>> jobs;
+	uint64_t nextOrder = 0;
+	size_t outstanding = 0;
+	uint32_t running = 0;
+
+	// runner tasks given to g_EnkiTS, only touched with Core::SharedTasksMutex held
+	std::deque<std::unique_ptr<enki::TaskSet>> runners;
+
+	struct CacheEntry
+	{
+		std::shared_ptr<CachedHulls const> hulls;
+		size_t bytes;
+		std::list<uint64_t>::iterator use;
+	};
+	mutable std::mutex cacheMutex;
+	std::unordered_map<uint64_t, CacheEntry> cache;
+	// most recently used first, lookups move their key to the front
+	mutable std::list<uint64_t> cacheUse;
+	size_t cacheBytes = 0;
+	size_t maxCacheBytes = DefaultMaxCacheBytes;
+	std::shared_ptr<ResourceManager::DerivedDataCache> diskCache;
+};
+
+}
+
+#endif //MESHOPS_CONVEXDECOMPOSER_H
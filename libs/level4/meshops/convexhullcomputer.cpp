@@ -58,10 +58,19 @@ void ReturnDestroyer(MeshOps::ConvexHullComputer::ReturnType* b)
 namespace MeshOps {
 
 auto ConvexHullComputer::generate(std::shared_ptr<MeshMod::Mesh> const& in_, ConvexHullParameters const& parameters_) -> std::vector<std::shared_ptr<MeshMod::Mesh>>
+{
+	std::vector<float> points;
+	std::vector<uint32_t> triangles;
+	gatherTriangles(*in_, points, triangles);
+	return generate(points.data(), uint32_t(points.size() / 3), triangles.data(), uint32_t(triangles.size() / 3), parameters_);
+}
+
+auto ConvexHullComputer::generate(float const* points_, uint32_t pointCount_, uint32_t const* triangles_, uint32_t triangleCount_,
+								  ConvexHullParameters const& parameters_) -> std::vector<std::shared_ptr<MeshMod::Mesh>>
 {
 	auto ivhacd = std::shared_ptr<ReturnType>(new ReturnType(VHACD::CreateVHACD(), nullptr), ReturnDestroyer);
 
-	if (begin(ivhacd, in_, parameters_) == false)
+	if (begin(ivhacd, points_, pointCount_, triangles_, triangleCount_, parameters_) == false)
 	{
 		return {};
 	}
@@ -79,6 +88,15 @@ void ConvexHullComputer::generateInline( std::shared_ptr<MeshMod::Mesh>& in_ )
 auto ConvexHullComputer::createAsync(std::shared_ptr<MeshMod::Mesh> const& in_,
 										ConvexHullParameters const& parameters_
 										) -> std::shared_ptr<ReturnType>
+{
+	std::vector<float> points;
+	std::vector<uint32_t> triangles;
+	gatherTriangles(*in_, points, triangles);
+	return createAsync(points.data(), uint32_t(points.size() / 3), triangles.data(), uint32_t(triangles.size() / 3), parameters_);
+}
+
+auto ConvexHullComputer::createAsync(float const* points_, uint32_t pointCount_, uint32_t const* triangles_, uint32_t triangleCount_,
+									 ConvexHullParameters const& parameters_) -> std::shared_ptr<ReturnType>
 {
 	ConvexHullProgessCallback* callback = nullptr;
 	if (parameters_.convexHullProgressCallback)
@@ -87,7 +105,8 @@ auto ConvexHullComputer::createAsync(std::shared_ptr<MeshMod::Mesh> const& in_,
 	}
 	auto ivhacd = std::shared_ptr<ReturnType>(new ReturnType(VHACD::CreateVHACD_ASYNC(), callback), ReturnDestroyer);
 
-	if (begin(ivhacd, in_, parameters_) == false)
+	// the async compute takes its own copy of the input before returning
+	if (begin(ivhacd, points_, pointCount_, triangles_, triangleCount_, parameters_) == false)
 	{
 		return {};
 	}
@@ -120,54 +139,65 @@ auto ConvexHullComputer::getResults(std::shared_ptr<ReturnType> ptr_) -> std::ve
 
 		using namespace MeshMod;
 		std::vector<std::shared_ptr<Mesh>> outArray(nConvexHulls);
+		std::vector<float> points;
 		for (auto j = 0u; j < nConvexHulls; ++j)
 		{
 			VHACD::IVHACD::ConvexHull ch;
 			ptr_->first->GetConvexHull(j, ch);
 
-			auto out = std::make_shared<Mesh>("ConvexHull_" + std::to_string(j));
-			for (auto i = 0u; i < ch.m_nPoints * 3; i += 3)
-			{
-				float x = (float)ch.m_points[i + 0];
-				float y = (float)ch.m_points[i + 1];
-				float z = (float)ch.m_points[i + 2];
-				out->getVertices().add(x, y, z);
-			}
-
-			VertexIndexContainer triIndices(ch.m_nTriangles * 3);
-			for (auto i = 0u; i < ch.m_nTriangles * 3; i += 3)
-			{
-				triIndices[i + 0] = VertexIndex(ch.m_triangles[i + 0]);
-				triIndices[i + 1] = VertexIndex(ch.m_triangles[i + 1]);
-				triIndices[i + 2] = VertexIndex(ch.m_triangles[i + 2]);
-			}
-			out->getPolygons().addTriangles(triIndices);
-
-			out->updateFromEdits();
-			outArray[j] = out;
+			points.assign(ch.m_points, ch.m_points + (size_t(ch.m_nPoints) * 3));
+			outArray[j] = createHullMesh("ConvexHull_" + std::to_string(j),
+										 points.data(), ch.m_nPoints, ch.m_triangles, ch.m_nTriangles);
 		}
 		return outArray;
 	}
 	return {};
 }
 
-auto ConvexHullComputer::begin(std::shared_ptr<ReturnType> ptr_, std::shared_ptr<MeshMod::Mesh> const& in_, ConvexHullParameters const& parameters_) -> bool
+auto ConvexHullComputer::createHullMesh(std::string const& name_, float const* points_, uint32_t pointCount_,
+										uint32_t const* triangles_, uint32_t triangleCount_) -> std::shared_ptr<MeshMod::Mesh>
 {
 	using namespace MeshMod;
+	auto out = std::make_shared<Mesh>(name_);
+
+	// all the vertices at once rather than an add each
+	Vertices& vertices = out->getVertices();
+	auto& pointReps = vertices.getOrAddAttribute<VertexData::PointReps>();
+	vertices.getVerticesContainer().resize(pointCount_);
+	auto& positions = vertices.positions();
+	for (auto i = 0u; i < pointCount_; ++i)
+	{
+		positions[VertexIndex(i)] = VertexData::Position(points_[(i * 3) + 0], points_[(i * 3) + 1], points_[(i * 3) + 2]);
+		pointReps[VertexIndex(i)] = VertexData::PointRep(VertexIndex(i));
+	}
 
-	auto const& vertices = in_->getVertices();
-	auto const& polygons = in_->getPolygons();
+	VertexIndexContainer triIndices(size_t(triangleCount_) * 3);
+	for (auto i = 0u; i < triangleCount_ * 3; ++i)
+	{
+		triIndices[i] = VertexIndex(triangles_[i]);
+	}
+	out->getPolygons().addTriangles(triIndices);
+
+	out->updateFromEdits();
+	return out;
+}
+
+void ConvexHullComputer::gatherTriangles(MeshMod::Mesh const& in_, std::vector<float>& points_, std::vector<uint32_t>& triangles_)
+{
+	using namespace MeshMod;
+
+	auto const& vertices = in_.getVertices();
+	auto const& polygons = in_.getPolygons();
 
 	auto const& positions = vertices.positions();
-	std::vector<float> points;
-	points.resize(size_t(vertices.getCount()) * 3);
+	points_.resize(size_t(vertices.getCount()) * 3);
 
 	for (auto const& pos : positions)
 	{
 		size_t i = size_t(positions.distance(pos)) * 3;
-		points[i + 0] = pos.x;
-		points[i + 1] = pos.y;
-		points[i + 2] = pos.z;
+		points_[i + 0] = pos.x;
+		points_[i + 1] = pos.y;
+		points_[i + 2] = pos.z;
 	}
 
 	VertexIndexContainer vertexIndices;
@@ -175,7 +205,16 @@ auto ConvexHullComputer::begin(std::shared_ptr<ReturnType> ptr_, std::shared_ptr
 	{
 		polygons.getVertexIndices(PolygonIndex(i), vertexIndices);
 	}
+	triangles_.resize(vertexIndices.size());
+	for (auto i = 0u; i < vertexIndices.size(); ++i)
+	{
+		triangles_[i] = uint32_t(vertexIndices[i]);
+	}
+}
 
+auto ConvexHullComputer::begin(std::shared_ptr<ReturnType> ptr_, float const* points_, uint32_t pointCount_,
+							   uint32_t const* triangles_, uint32_t triangleCount_, ConvexHullParameters const& parameters_) -> bool
+{
 	VHACD::IVHACD::Parameters params;
 	params.m_concavity = parameters_.concavity;
 	params.m_alpha = parameters_.alpha;
@@ -191,10 +230,10 @@ auto ConvexHullComputer::begin(std::shared_ptr<ReturnType> ptr_, std::shared_ptr
 	params.m_maxConvexHulls = parameters_.maxConvexHulls;
 	params.m_projectHullVertices = parameters_.projectHullVertices;
 
-	bool res = ptr_->first->Compute(points.data(),
-		(unsigned int)points.size() / 3,
-		(unsigned int*)vertexIndices.data(),
-		(unsigned int)vertexIndices.size() / 3, params);
+	bool res = ptr_->first->Compute(points_,
+		pointCount_,
+		triangles_,
+		triangleCount_, params);
 
 	return res;
 }
@@ -16,6 +16,7 @@ namespace VHACD
 namespace MeshOps {
 
 struct ConvexHullProgessCallback;
+class ConvexDecomposer;
 
 class ConvexHullParameters {
 public:
@@ -67,9 +68,26 @@ public:
 	static auto isReady(std::shared_ptr<ReturnType> ptr_) -> bool;
 	static auto getResults(std::shared_ptr<ReturnType> ptr_) -> std::vector<std::shared_ptr<MeshMod::Mesh>>;
 
+	// straight from a triangle list (3 floats per point, 3 indices per triangle) without building a mesh,
+	// the arrays are only read during the call even for the async version
+	static auto generate(float const* points_, uint32_t pointCount_, uint32_t const* triangles_, uint32_t triangleCount_,
+						 ConvexHullParameters const& parameters_) -> std::vector<std::shared_ptr<MeshMod::Mesh>>;
+	static auto createAsync(float const* points_, uint32_t pointCount_, uint32_t const* triangles_, uint32_t triangleCount_,
+							ConvexHullParameters const& parameters_) -> std::shared_ptr<ReturnType>;
+
+	// builds a hull mesh in one go from a triangle list
+	static auto createHullMesh(std::string const& name_, float const* points_, uint32_t pointCount_,
+							   uint32_t const* triangles_, uint32_t triangleCount_) -> std::shared_ptr<MeshMod::Mesh>;
+
+	// flattens a mesh for the triangle list versions
+	static void gatherTriangles(MeshMod::Mesh const& in_, std::vector<float>& points_, std::vector<uint32_t>& triangles_);
+
 private:
+	friend class ConvexDecomposer;
+
 	// dependent on whether createAsync or generate were called begin will be blocking or async
-	static auto begin(std::shared_ptr<ReturnType> ptr_, std::shared_ptr<MeshMod::Mesh> const& in_, ConvexHullParameters const& parameters_) -> bool;
+	static auto begin(std::shared_ptr<ReturnType> ptr_, float const* points_, uint32_t pointCount_,
+					  uint32_t const* triangles_, uint32_t triangleCount_, ConvexHullParameters const& parameters_) -> bool;
 
 };
 
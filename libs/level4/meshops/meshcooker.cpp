@@ -0,0 +1,533 @@
+/** \file meshcooker.cpp
+   Turns MeshMod meshes into compact GPU ready data.
+ */
+
+#include "core/core.h"
+#include "core/quick_hash.h"
+#include "meshops/meshcooker.h"
+#include "meshops/basicmeshops.h"
+
+#include "meshmod/mesh.h"
+#include "meshmod/vertices.h"
+#include "meshmod/polygons.h"
+#include "meshmod/vertexdata/positionvertex.h"
+#include "meshmod/vertexdata/normalvertex.h"
+#include "binny/inplacebundle.h"
+#include "binny/bundlewriter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+#include <unordered_map>
+
+namespace MeshOps {
+namespace {
+using namespace Binny;
+static const uint32_t CookedMeshId = "CMSH"_bundle_id;
+
+// Tom Forsyth's scoring constants
+float const CacheDecayPower = 1.5f;
+float const LastTriScore = 0.75f;
+float const ValenceBoostScale = 2.0f;
+float const ValenceBoostPower = 0.5f;
+
+float vertexCacheScore(int32_t const cachePosition_, uint32_t const remainingTris_, uint32_t const cacheSize_)
+{
+	// no triangles left to use this vertex
+	if(remainingTris_ == 0) return -1.0f;
+
+	float score = 0.0f;
+	if(cachePosition_ >= 0)
+	{
+		// the last triangles vertices get a fixed score so the next isn't always a neighbour
+		if(cachePosition_ < 3)
+		{
+			score = LastTriScore;
+		} else
+		{
+			float const scaler = 1.0f / float(cacheSize_ - 3);
+			score = std::pow(1.0f - float(cachePosition_ - 3) * scaler, CacheDecayPower);
+		}
+	}
+
+	// boost vertices with few triangles left so they aren't left as lone stragglers
+	score += ValenceBoostScale * std::pow(float(remainingTris_), -ValenceBoostPower);
+	return score;
+}
+
+struct CookedVertexHash
+{
+	size_t operator()(CookedVertex const& v_) const
+	{
+		return Core::QuickHash((char const*) &v_, sizeof(CookedVertex));
+	}
+};
+
+struct CookedVertexEqual
+{
+	bool operator()(CookedVertex const& a_, CookedVertex const& b_) const
+	{
+		return std::memcmp(&a_, &b_, sizeof(CookedVertex)) == 0;
+	}
+};
+
+uint16_t quantiseUnorm16(float const v_, float const offset_, float const scale_)
+{
+	float const t = Math::clamp((v_ - offset_) / scale_, 0.0f, 1.0f);
+	return (uint16_t) std::lround(t * 65535.0f);
+}
+
+}
+
+auto CookedMesh::decodePosition(CookedVertex const& vertex_) const -> Math::vec3
+{
+	Math::vec3 const q(float(vertex_.x), float(vertex_.y), float(vertex_.z));
+	return positionOffset + (q / 65535.0f) * positionScale;
+}
+
+auto CookedMesh::decodeNormal(CookedVertex const& vertex_) -> Math::vec3
+{
+	return Math::DecodeOctahedral(vertex_.nx, vertex_.ny);
+}
+
+bool CookedMesh::createFromStream(std::istream& in_, std::vector<std::shared_ptr<CookedMesh>>& out_)
+{
+	// the stream is read once into memory the meshes then live in, no per chunk copies
+	auto bytes = std::make_shared<std::vector<uint8_t>>(std::istreambuf_iterator<char>(in_), std::istreambuf_iterator<char>());
+	if(bytes->empty()) return false;
+	return createFromMemory(bytes, bytes->data(), bytes->size(), out_);
+}
+
+bool CookedMesh::createFromMemory(std::shared_ptr<void> owner_, uint8_t* memory_, size_t size_,
+								  std::vector<std::shared_ptr<CookedMesh>>& out_)
+{
+	using namespace Binny;
+	std::vector<IBundle::ChunkHandler> handlers = {
+			{{CookedMeshId, 0, 0,
+					 [&out_](std::string_view, int, uint16_t majorVersion_, uint16_t minorVersion_, size_t,
+							 std::shared_ptr<void> ptr_) -> bool
+					 {
+						 auto cmesh = std::static_pointer_cast<CookedMesh>(ptr_);
+
+						 if(majorVersion_ != MajorVersion) return false;
+						 if(minorVersion_ > MinorVersion) return false;
+						 if(sizeof(CookedVertex) != cmesh->sizeOfCookedVertex) return false;
+
+						 out_.emplace_back(cmesh);
+						 return true;
+					 },
+					 [](int, void*) {}
+			 }}
+	};
+
+	InPlaceBundle bundle(&malloc, &free, std::move(owner_), memory_, size_);
+	auto const ret = bundle.read({}, handlers);
+	if(ret.first != IBundle::ErrorCode::Okay)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+/**
+Linear-Speed Vertex Cache Optimisation (Tom Forsyth).
+Greedily picks the next triangle with the best score, a vertex scores for being recently used
+and for having few triangles left to use it. Only triangles touching the simulated cache are
+rescored each step so its linear in the triangle count.
+*/
+auto MeshCooker::optimiseVertexCache(std::vector<uint32_t>& indices_, size_t const vertexCount_, uint32_t const cacheSize_) -> void
+{
+	assert(cacheSize_ > 3);
+	size_t const triCount = indices_.size() / 3;
+	if(triCount == 0) return;
+
+	// triangles using each vertex
+	std::vector<uint32_t> vertexTriStart(vertexCount_ + 1, 0);
+	for(auto const index : indices_)
+	{
+		vertexTriStart[index + 1]++;
+	}
+	std::partial_sum(vertexTriStart.begin(), vertexTriStart.end(), vertexTriStart.begin());
+
+	// the first remainingTris[v] entries of a vertex's triangles are the ones not yet added
+	std::vector<uint32_t> remainingTris(vertexCount_);
+	std::vector<uint32_t> vertexTris(indices_.size());
+	for(size_t v = 0; v < vertexCount_; ++v)
+	{
+		remainingTris[v] = vertexTriStart[v + 1] - vertexTriStart[v];
+	}
+	{
+		std::vector<uint32_t> cursor(vertexTriStart.begin(), vertexTriStart.end() - 1);
+		for(size_t i = 0; i < indices_.size(); ++i)
+		{
+			vertexTris[cursor[indices_[i]]++] = uint32_t(i / 3);
+		}
+	}
+
+	std::vector<int32_t> cachePosition(vertexCount_, -1);
+	std::vector<float> vertexScore(vertexCount_);
+	for(size_t v = 0; v < vertexCount_; ++v)
+	{
+		vertexScore[v] = vertexCacheScore(-1, remainingTris[v], cacheSize_);
+	}
+
+	std::vector<float> triScore(triCount);
+	std::vector<bool> triAdded(triCount, false);
+	for(size_t t = 0; t < triCount; ++t)
+	{
+		triScore[t] = vertexScore[indices_[t * 3 + 0]] +
+					  vertexScore[indices_[t * 3 + 1]] +
+					  vertexScore[indices_[t * 3 + 2]];
+	}
+
+	static uint32_t const NoTriangle = ~0u;
+	uint32_t best = uint32_t(std::max_element(triScore.begin(), triScore.end()) - triScore.begin());
+	size_t scanCursor = 0;
+
+	std::vector<uint32_t> output;
+	output.reserve(indices_.size());
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> newCache;
+	cache.reserve(cacheSize_ + 3);
+	newCache.reserve(cacheSize_ + 3);
+
+	while(best != NoTriangle)
+	{
+		triAdded[best] = true;
+		uint32_t const* const tri = &indices_[best * 3];
+
+		// most recent first, the oldest fall out the end
+		newCache.clear();
+		for(int i = 0; i < 3; ++i)
+		{
+			uint32_t const v = tri[i];
+			output.push_back(v);
+			if(std::find(newCache.begin(), newCache.end(), v) == newCache.end()) newCache.push_back(v);
+
+			// retire the triangle from the vertex's list
+			uint32_t* const tris = &vertexTris[vertexTriStart[v]];
+			uint32_t* const it = std::find(tris, tris + remainingTris[v], best);
+			if(it != tris + remainingTris[v])
+			{
+				std::swap(*it, tris[remainingTris[v] - 1]);
+				remainingTris[v]--;
+			}
+		}
+		for(auto const v : cache)
+		{
+			if(std::find(newCache.begin(), newCache.end(), v) == newCache.end()) newCache.push_back(v);
+		}
+
+		for(size_t i = 0; i < newCache.size(); ++i)
+		{
+			uint32_t const v = newCache[i];
+			cachePosition[v] = i < cacheSize_ ? int32_t(i) : -1;
+			vertexScore[v] = vertexCacheScore(cachePosition[v], remainingTris[v], cacheSize_);
+		}
+
+		// rescore triangles touching the cache and pick the best of them
+		best = NoTriangle;
+		float bestScore = -1.0f;
+		for(auto const v : newCache)
+		{
+			uint32_t const* const tris = &vertexTris[vertexTriStart[v]];
+			for(uint32_t i = 0; i < remainingTris[v]; ++i)
+			{
+				uint32_t const t = tris[i];
+				float const score = vertexScore[indices_[t * 3 + 0]] +
+									vertexScore[indices_[t * 3 + 1]] +
+									vertexScore[indices_[t * 3 + 2]];
+				triScore[t] = score;
+				if(score > bestScore)
+				{
+					bestScore = score;
+					best = t;
+				}
+			}
+		}
+
+		if(newCache.size() > cacheSize_) newCache.resize(cacheSize_);
+		std::swap(cache, newCache);
+
+		// nothing in the cache is any use, start again with the next unused triangle
+		if(best == NoTriangle)
+		{
+			while(scanCursor < triCount && triAdded[scanCursor]) ++scanCursor;
+			if(scanCursor < triCount) best = uint32_t(scanCursor);
+		}
+	}
+
+	assert(output.size() == indices_.size());
+	indices_.swap(output);
+}
+
+/**
+Clusters of consecutive triangles are kept together (so the vertex cache ordering mostly survives)
+and the clusters are sorted by how far out they face from the middle of the mesh, front most first.
+Outward facing clusters are likely to occlude others so drawing them first saves overdraw.
+*/
+auto MeshCooker::optimiseOverdraw(std::vector<uint32_t>& indices_, std::vector<Math::vec3> const& positions_, uint32_t const clusterSize_) -> void
+{
+	size_t const triCount = indices_.size() / 3;
+	if(triCount <= clusterSize_ || clusterSize_ == 0) return;
+
+	// area weighted mesh centroid
+	Math::vec3 meshCentroid(0, 0, 0);
+	float meshArea = 0.0f;
+	for(size_t t = 0; t < triCount; ++t)
+	{
+		Math::vec3 const& a = positions_[indices_[t * 3 + 0]];
+		Math::vec3 const& b = positions_[indices_[t * 3 + 1]];
+		Math::vec3 const& c = positions_[indices_[t * 3 + 2]];
+		float const area = Math::Length(Math::cross(b - a, c - a));
+		meshCentroid += (a + b + c) * (area / 3.0f);
+		meshArea += area;
+	}
+	if(!(meshArea > 0.0f)) return;
+	meshCentroid /= meshArea;
+
+	size_t const clusterCount = (triCount + clusterSize_ - 1) / clusterSize_;
+	std::vector<std::pair<float, uint32_t>> clusterSort(clusterCount);
+	for(size_t cluster = 0; cluster < clusterCount; ++cluster)
+	{
+		size_t const begin = cluster * clusterSize_;
+		size_t const end = std::min(begin + clusterSize_, triCount);
+
+		Math::vec3 centroid(0, 0, 0);
+		Math::vec3 normal(0, 0, 0);
+		float area = 0.0f;
+		for(size_t t = begin; t < end; ++t)
+		{
+			Math::vec3 const& a = positions_[indices_[t * 3 + 0]];
+			Math::vec3 const& b = positions_[indices_[t * 3 + 1]];
+			Math::vec3 const& c = positions_[indices_[t * 3 + 2]];
+			Math::vec3 const n = Math::cross(b - a, c - a);
+			float const triArea = Math::Length(n);
+			centroid += (a + b + c) * (triArea / 3.0f);
+			normal += n;
+			area += triArea;
+		}
+
+		float sortKey = 0.0f;
+		float const normalLength = Math::Length(normal);
+		if(area > 0.0f && normalLength > 0.0f)
+		{
+			centroid /= area;
+			sortKey = Math::dot(centroid - meshCentroid, normal / normalLength);
+		}
+		clusterSort[cluster] = { sortKey, uint32_t(cluster) };
+	}
+
+	std::stable_sort(clusterSort.begin(), clusterSort.end(),
+					 [](auto const& a_, auto const& b_) { return a_.first > b_.first; });
+
+	std::vector<uint32_t> output;
+	output.reserve(indices_.size());
+	for(auto const& entry : clusterSort)
+	{
+		size_t const begin = size_t(entry.second) * clusterSize_;
+		size_t const end = std::min(begin + clusterSize_, triCount);
+		output.insert(output.end(), indices_.begin() + begin * 3, indices_.begin() + end * 3);
+	}
+	indices_.swap(output);
+}
+
+auto MeshCooker::optimiseVertexFetch(std::vector<uint32_t>& indices_, size_t const vertexCount_) -> std::vector<uint32_t>
+{
+	std::vector<uint32_t> oldToNew(vertexCount_, ~0u);
+	uint32_t next = 0;
+	for(auto& index : indices_)
+	{
+		if(oldToNew[index] == ~0u) oldToNew[index] = next++;
+		index = oldToNew[index];
+	}
+	return oldToNew;
+}
+
+auto MeshCooker::process(std::shared_ptr<MeshMod::Mesh const> const& mesh_, MeshCookerParameters const& params_, CookedData& out_) -> bool
+{
+	using namespace MeshMod;
+
+	out_.vertices.clear();
+	out_.indices.clear();
+	out_.index16 = false;
+
+	if(mesh_->getPolygons().getCount() == 0) return false;
+
+	// triangulate and normals change the mesh, so they happen on a copy and the callers mesh is left alone
+	std::shared_ptr<Mesh> const mesh = mesh_->clone();
+	BasicMeshOps::triangulate(mesh);
+	BasicMeshOps::computeVertexNormals(mesh, false);
+
+	auto const& polygons = mesh->getPolygons();
+	auto const& vertices = mesh->getVertices();
+	auto const& positions = vertices.positions();
+	auto const& normals = vertices.getAttribute<VertexData::Normals>();
+
+	// gather the triangles
+	std::vector<uint32_t> corners;
+	corners.reserve(polygons.getCount() * 3);
+	VertexIndexContainer faceVertexIndices;
+	polygons.forEachValid([&](PolygonIndex const polygonIndex_)
+	{
+		faceVertexIndices.clear();
+		polygons.getVertexIndices(polygonIndex_, faceVertexIndices);
+		// points and lines are left by triangulate
+		if(faceVertexIndices.size() != 3) return;
+		for(auto const vertexIndex : faceVertexIndices)
+		{
+			corners.push_back(uint32_t(vertexIndex));
+		}
+	});
+	if(corners.empty()) return false;
+
+	// quantise to the aabb of the used vertices
+	Math::vec3 minPos = positions[VertexIndex(corners[0])].getVec3();
+	Math::vec3 maxPos = minPos;
+	for(auto const corner : corners)
+	{
+		Math::vec3 const pos = positions[VertexIndex(corner)].getVec3();
+		minPos = Math::min(minPos, pos);
+		maxPos = Math::max(maxPos, pos);
+	}
+	out_.positionOffset = minPos;
+	out_.positionScale = Math::max(maxPos - minPos, Math::vec3(1e-20f, 1e-20f, 1e-20f));
+
+	// weld vertices whose quantised data is identical
+	std::unordered_map<CookedVertex, uint32_t, CookedVertexHash, CookedVertexEqual> weldMap;
+	std::vector<uint32_t> meshToCooked(vertices.getCount(), ~0u);
+	std::vector<Math::vec3> cookedPositions;
+	std::vector<uint32_t> indices;
+	indices.reserve(corners.size());
+	for(auto const corner : corners)
+	{
+		if(meshToCooked[corner] == ~0u)
+		{
+			Math::vec3 const pos = positions[VertexIndex(corner)].getVec3();
+			auto const oct = Math::EncodeOctahedral(normals[VertexIndex(corner)].getVec3());
+
+			CookedVertex cv;
+			cv.x = quantiseUnorm16(pos.x, out_.positionOffset.x, out_.positionScale.x);
+			cv.y = quantiseUnorm16(pos.y, out_.positionOffset.y, out_.positionScale.y);
+			cv.z = quantiseUnorm16(pos.z, out_.positionOffset.z, out_.positionScale.z);
+			cv.padd = 0;
+			cv.nx = oct[0];
+			cv.ny = oct[1];
+
+			auto const ins = weldMap.emplace(cv, uint32_t(out_.vertices.size()));
+			if(ins.second)
+			{
+				out_.vertices.push_back(cv);
+				cookedPositions.push_back(pos);
+			}
+			meshToCooked[corner] = ins.first->second;
+		}
+		indices.push_back(meshToCooked[corner]);
+	}
+
+	// welding can collapse triangles
+	for(size_t t = 0; t < indices.size() / 3; ++t)
+	{
+		uint32_t const i0 = indices[t * 3 + 0];
+		uint32_t const i1 = indices[t * 3 + 1];
+		uint32_t const i2 = indices[t * 3 + 2];
+		if(i0 == i1 || i1 == i2 || i2 == i0) continue;
+		out_.indices.push_back(i0);
+		out_.indices.push_back(i1);
+		out_.indices.push_back(i2);
+	}
+
+	if(params_.optimiseVertexCache)
+	{
+		optimiseVertexCache(out_.indices, out_.vertices.size(), params_.vertexCacheSize);
+	}
+	if(params_.optimiseOverdraw)
+	{
+		optimiseOverdraw(out_.indices, cookedPositions, params_.overdrawClusterSize);
+	}
+
+	// renumber and drop any vertices only used by collapsed triangles
+	std::vector<uint32_t> const oldToNew = optimiseVertexFetch(out_.indices, out_.vertices.size());
+	std::vector<CookedVertex> fetchOrdered(out_.vertices.size());
+	size_t usedCount = 0;
+	for(size_t i = 0; i < oldToNew.size(); ++i)
+	{
+		if(oldToNew[i] == ~0u) continue;
+		fetchOrdered[oldToNew[i]] = out_.vertices[i];
+		usedCount++;
+	}
+	fetchOrdered.resize(usedCount);
+	out_.vertices.swap(fetchOrdered);
+
+	// 0xFFFF is left free for primitive restart
+	out_.index16 = params_.allow16BitIndices && out_.vertices.size() < 0xFFFF;
+	return true;
+}
+
+auto MeshCooker::saveTo(CookedData const& data_, uint64_t const regenMarker_, std::vector<uint8_t>& result_) -> bool
+{
+	using namespace Binny;
+	using namespace std::string_literals;
+	BundleWriter writer;
+	// quantised vertices don't shrink much, uncompressed they are used where they are loaded
+	writer.setStoreUncompressed();
+
+	bool okay;
+	okay = writer.addChunk(
+			"CookedMesh"s,
+			CookedMeshId,
+			CookedMesh::MajorVersion,
+			CookedMesh::MinorVersion,
+			0,
+			{},
+			[&data_](WriteHelper& h)
+			{
+				h.allow_nan(false);
+				h.allow_infinity(false);
+
+				// header
+				h.write_as<uint32_t>(data_.index16 ? CookedMeshFlags::Index16 : 0, "flags"s);
+				h.write_as<uint32_t>(data_.vertices.size(), "vertex count"s);
+				h.write_as<uint32_t>(data_.indices.size(), "index count"s);
+				h.write_as<uint32_t>(sizeof(CookedVertex), "sizeof CookedVertex when this was built"s);
+				h.write(data_.positionScale.x, data_.positionScale.y, data_.positionScale.z, "position scale"s);
+				h.write(data_.positionOffset.x, data_.positionOffset.y, data_.positionOffset.z, "position offset"s);
+				h.align(8);
+
+				h.use_label("Vertices"s, ""s, true, true, "ptr to the vertices"s);
+				h.use_label("Indices"s, ""s, true, true, "ptr to the indices"s);
+
+				h.align();
+				h.write_label("Vertices"s, false);
+				h.write_byte_array((uint8_t const*) data_.vertices.data(), data_.vertices.size() * sizeof(CookedVertex));
+
+				h.align();
+				h.write_label("Indices"s, false);
+				if(data_.index16)
+				{
+					std::vector<uint16_t> indices16(data_.indices.begin(), data_.indices.end());
+					h.write_byte_array((uint8_t const*) indices16.data(), indices16.size() * sizeof(uint16_t));
+				} else
+				{
+					h.write_byte_array((uint8_t const*) data_.indices.data(), data_.indices.size() * sizeof(uint32_t));
+				}
+			}
+	);
+	if(!okay) return false;
+
+	okay = writer.build(regenMarker_, result_);
+	if(!okay) return false;
+	return true;
+}
+
+auto MeshCooker::cook(std::shared_ptr<MeshMod::Mesh const> const& mesh_, MeshCookerParameters const& params_, uint64_t const regenMarker_, std::vector<uint8_t>& result_) -> bool
+{
+	CookedData data;
+	if(!process(mesh_, params_, data)) return false;
+	return saveTo(data, regenMarker_, result_);
+}
+
+}
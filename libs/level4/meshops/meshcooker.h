@@ -0,0 +1,128 @@
+#pragma once
+#ifndef WYRD_MESHOPS_MESHCOOKER_H_
+#define WYRD_MESHOPS_MESHCOOKER_H_
+
+#include "core/core.h"
+#include "core/utils.h"
+#include "math/vector_math.h"
+#include <istream>
+#include <memory>
+#include <vector>
+
+namespace MeshMod {
+class Mesh;
+}
+
+namespace MeshOps {
+
+// 12 byte quantised vertex
+struct CookedVertex
+{
+	uint16_t x, y, z;	// unorm16 position within the meshes aabb
+	uint16_t padd;
+	int16_t nx, ny;		// snorm16 octahedral encoded normal
+};
+static_assert(sizeof(CookedVertex) == 12);
+
+enum CookedMeshFlags
+{
+	Index16 = Core::Bit(0),		// indices are uint16_t else uint32_t
+};
+
+// A cooked mesh is loaded straight from its bundle chunk, binny fixes up the
+// pointers so the vertex and index data can be handed straight to a buffer
+class CookedMesh
+{
+public:
+	friend class MeshCooker;
+
+	static bool createFromStream(std::istream& in_, std::vector<std::shared_ptr<CookedMesh>>& out_);
+	// the meshes point into memory_ and keep owner_ alive, it is fixed up so can only be read once
+	static bool createFromMemory(std::shared_ptr<void> owner_, uint8_t* memory_, size_t size_, std::vector<std::shared_ptr<CookedMesh>>& out_);
+
+	auto getVertexCount() const -> uint32_t { return vertexCount; }
+	auto getIndexCount() const -> uint32_t { return indexCount; }
+	auto is16BitIndices() const -> bool { return flags & CookedMeshFlags::Index16; }
+
+	auto getVertices() const -> CookedVertex const* { return vertices; }
+	auto getIndexData() const -> void const* { return indices; }
+	auto getIndexDataSize() const -> size_t { return size_t(indexCount) * (is16BitIndices() ? sizeof(uint16_t) : sizeof(uint32_t)); }
+	auto getIndex(uint32_t i_) const -> uint32_t
+	{
+		assert(i_ < indexCount);
+		return is16BitIndices() ? ((uint16_t const*) indices)[i_] : ((uint32_t const*) indices)[i_];
+	}
+
+	// position = offset + (quantised / 65535) * scale
+	auto getPositionScale() const -> Math::vec3 { return positionScale; }
+	auto getPositionOffset() const -> Math::vec3 { return positionOffset; }
+
+	auto decodePosition(CookedVertex const& vertex_) const -> Math::vec3;
+	static auto decodeNormal(CookedVertex const& vertex_) -> Math::vec3;
+
+private:
+	static const uint16_t MajorVersion = 1;
+	static const uint16_t MinorVersion = 0;
+
+	CookedMesh() {};
+	~CookedMesh() = delete; // destructor are never run, memory is just released
+
+	uint32_t flags;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t sizeOfCookedVertex;
+	Math::vec3 positionScale;
+	Math::vec3 positionOffset;
+	CookedVertex* vertices;
+	void* indices;
+};
+
+struct MeshCookerParameters
+{
+	bool optimiseVertexCache = true;	// Tom Forsyth's linear speed vertex cache optimisation
+	bool optimiseOverdraw = true;		// reorder clusters of triangles so outward facing ones are first
+	bool allow16BitIndices = true;		// if there are few enough vertices
+	uint32_t vertexCacheSize = 32;		// simulated post transform cache size
+	uint32_t overdrawClusterSize = 64;	// triangles per cluster when optimising overdraw
+};
+
+/**
+	MeshCooker turns a mesh into compact quantised vertices and indices ready for the GPU.
+	Vertices are welded on their quantised data, triangles ordered for the vertex cache and
+	overdraw, and vertices renumbered in first use order for fetch locality.
+*/
+class MeshCooker
+{
+public:
+	// the cooked data before being written to a bundle
+	struct CookedData
+	{
+		Math::vec3 positionScale;
+		Math::vec3 positionOffset;
+		std::vector<CookedVertex> vertices;
+		std::vector<uint32_t> indices;
+		bool index16;
+	};
+
+	//! triangulates and computes normals on a copy of the mesh if required, then cooks it
+	static auto process(std::shared_ptr<MeshMod::Mesh const> const& mesh_, MeshCookerParameters const& params_, CookedData& out_) -> bool;
+
+	//! write cooked data to an empty byte vector as a bundle with a single CookedMesh chunk
+	static auto saveTo(CookedData const& data_, uint64_t const regenMarker_, std::vector<uint8_t>& result_) -> bool;
+
+	//! process then saveTo
+	static auto cook(std::shared_ptr<MeshMod::Mesh const> const& mesh_, MeshCookerParameters const& params_, uint64_t const regenMarker_, std::vector<uint8_t>& result_) -> bool;
+
+	//! reorder triangles for a post transform cache of cacheSize_ vertices
+	static auto optimiseVertexCache(std::vector<uint32_t>& indices_, size_t const vertexCount_, uint32_t const cacheSize_) -> void;
+
+	//! reorder clusters of clusterSize_ triangles so ones likely to occlude others are drawn first
+	static auto optimiseOverdraw(std::vector<uint32_t>& indices_, std::vector<Math::vec3> const& positions_, uint32_t const clusterSize_) -> void;
+
+	//! renumber vertices in the order the indices first use them, returns the old to new remap
+	static auto optimiseVertexFetch(std::vector<uint32_t>& indices_, size_t const vertexCount_) -> std::vector<uint32_t>;
+};
+
+};
+
+#endif
@@ -120,6 +120,7 @@ void Raycaster::transferTo( LayeredTexture& image ) {
 	// get base position and normal vertex pointers
 	auto const posEle = vertCon.getElement<VertexData::Positions>();
 	auto const normEle = vertCon.getElement<VertexData::Normals>();
+	assert(!normEle || !normEle->isStale());
 
 	// get tracing uv vertex pointer
 	auto const uvEle = vertCon.getElement<VertexData::UVs>( traceUVSetName );
@@ -6,15 +6,118 @@
 #include "meshops/basicmeshops.h"
 #include "geometry/ray.h"
 #include "geometry/watertightray.h"
-#include "enkiTS/src/TaskScheduler.h"
+#include "core/sharedtasks.h"
 #include "meshops/layeredtexture.h"
 #include "tacticalmap/builder.h"
 
 #include <algorithm>
 #include <tuple>
 #include <array>
+#include <atomic>
+#include <chrono>
 
-extern enki::TaskScheduler g_EnkiTS;
+
+namespace {
+
+using BuildClock = std::chrono::steady_clock;
+
+// seconds since start_, which is moved on to now
+double Lap(BuildClock::time_point& start_)
+{
+	auto const now = BuildClock::now();
+	double const seconds = std::chrono::duration<double>(now - start_).count();
+	start_ = now;
+	return seconds;
+}
+
+// calls func(x, z) for every tile a triangles XZ footprint touches, a to c are relative to the
+// maps bottom left so tile (x,z) covers [x, x+1] by [z, z+1]. Conservative, a tile is visited if
+// any part of it overlaps the triangle.
+template<typename Func>
+void rasteriseTriangleFootprint(Math::vec2 a, Math::vec2 b, Math::vec2 c,
+								int32_t const width, int32_t const height, Func&& func)
+{
+	// grow every tile slightly so rounding can only add tiles not lose them
+	float const epsilon = 1e-4f;
+
+	Math::vec2 const lo = Math::min(a, Math::min(b, c));
+	Math::vec2 const hi = Math::max(a, Math::max(b, c));
+	int32_t const xmin = std::max((int32_t) std::floor(lo.x - epsilon), 0);
+	int32_t const zmin = std::max((int32_t) std::floor(lo.y - epsilon), 0);
+	int32_t const xmax = std::min((int32_t) std::floor(hi.x + epsilon), width - 1);
+	int32_t const zmax = std::min((int32_t) std::floor(hi.y + epsilon), height - 1);
+	if(xmin > xmax || zmin > zmax) return;
+
+	// edge function of p->q, positive on the left
+	struct Edge
+	{
+		float dx, dz, c;
+		// largest value over the (grown) tile, if < 0 the tile is entirely on the right
+		float maxOverTile(int32_t x, int32_t z, float eps) const
+		{
+			float const px = (-dz > 0.0f) ? float(x + 1) + eps : float(x) - eps;
+			float const pz = (dx > 0.0f) ? float(z + 1) + eps : float(z) - eps;
+			return dx * pz - dz * px + c;
+		}
+		float minOverTile(int32_t x, int32_t z, float eps) const
+		{
+			float const px = (-dz > 0.0f) ? float(x) - eps : float(x + 1) + eps;
+			float const pz = (dx > 0.0f) ? float(z) - eps : float(z + 1) + eps;
+			return dx * pz - dz * px + c;
+		}
+	};
+	auto makeEdge = [](Math::vec2 const& p, Math::vec2 const& q) -> Edge
+	{
+		float const dx = q.x - p.x;
+		float const dz = q.y - p.y;
+		return { dx, dz, dz * p.x - dx * p.y };
+	};
+
+	float const area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	float const scale = Math::square(std::max(hi.x - lo.x, hi.y - lo.y));
+	if(std::abs(area) <= 1e-6f * scale)
+	{
+		// degenerate in XZ (vertical walls etc.) so treat as the longest edge, tiles must straddle it
+		float const lab = Math::dot(b - a, b - a);
+		float const lbc = Math::dot(c - b, c - b);
+		float const lca = Math::dot(a - c, a - c);
+		Edge const edge = (lab >= lbc && lab >= lca) ? makeEdge(a, b) :
+						  (lbc >= lca) ? makeEdge(b, c) : makeEdge(c, a);
+		bool const isPoint = std::max(lab, std::max(lbc, lca)) == 0.0f;
+		for(int32_t z = zmin; z <= zmax; ++z)
+		{
+			for(int32_t x = xmin; x <= xmax; ++x)
+			{
+				if(isPoint || (edge.maxOverTile(x, z, epsilon) >= 0.0f && edge.minOverTile(x, z, epsilon) <= 0.0f))
+				{
+					func(x, z);
+				}
+			}
+		}
+		return;
+	}
+
+	// counter clockwise so inside is left of every edge
+	if(area < 0.0f) std::swap(b, c);
+	Edge const e0 = makeEdge(a, b);
+	Edge const e1 = makeEdge(b, c);
+	Edge const e2 = makeEdge(c, a);
+
+	for(int32_t z = zmin; z <= zmax; ++z)
+	{
+		for(int32_t x = xmin; x <= xmax; ++x)
+		{
+			if(e0.maxOverTile(x, z, epsilon) >= 0.0f &&
+			   e1.maxOverTile(x, z, epsilon) >= 0.0f &&
+			   e2.maxOverTile(x, z, epsilon) >= 0.0f)
+			{
+				func(x, z);
+			}
+		}
+	}
+}
+
+}
 
 TacticalMapBuilder::TacticalMapBuilder( Math::vec2 const bottomLeft_,
 										TileCoord_t width_,
@@ -24,15 +127,15 @@ TacticalMapBuilder::TacticalMapBuilder( Math::vec2 const bottomLeft_,
 		width( width_ ),
 		height( height_ ),
 		name(name_),
-		tileBuilders( width_ * height_ )
+		tileBuilders( width_ * height_ ),
+		dirtyTiles( width_ * height_, 1 )
 {
 }
 
 TacticalMapBuilder::~TacticalMapBuilder()
 {
 	tacticalLevelDataHeap.clear();
-	smoothLayerTexture.reset();
-	globalFragmentTexture.reset();
+	structuralBoxs.clear();
 	tileBuilders.clear();
 	solids.clear();
 }
@@ -40,84 +143,34 @@ TacticalMapBuilder::~TacticalMapBuilder()
 TacticalMapTileBuilder::~TacticalMapTileBuilder()
 {
 	layers.clear();
-	bonds.clear();
-	structuralBoxs.clear();
 	destructables.clear();
 	boxes.clear();
-	polygons.clear();
 }
 
 std::shared_ptr<TacticalMap> TacticalMapBuilder::build()
 {
-	using namespace MeshMod;
-
-	VertexIndexContainer polyIndices;
-	polyIndices.reserve(10);
-
-	// work out which polygons from which mesh intersect which tile
-	// ultimately rasterasation would be better but current just using bounding area of polys
-	for (size_t i = 0; i < solids.size(); i++)
+	buildStats = TacticalMapBuildStats{};
+	auto const buildStart = BuildClock::now();
+	auto lap = buildStart;
+	auto const finishStats = [this, buildStart, &lap]()
 	{
-		auto& [mesh, box, levelDataOffset] = solids[i];
-		auto levelData = (TacticalMapLevelDataHeader*)(tacticalLevelDataHeap.data() + levelDataOffset);
-
-		if(mesh)
-		{
-			polyIndices.clear();
-			auto localMesh = mesh;
-
-			mesh->getPolygons().visitValid(
-					[this, i, localMesh, &polyIndices]( PolygonIndex polygonIndex )
-					{
-						polyIndices.clear();
-						Vertices const& vertices = localMesh->getVertices();
-						Polygons const& polygons = localMesh->getPolygons();
-
-						Geometry::AABB polyBox;
-						polygons.getVertexIndices( polygonIndex, polyIndices );
-						for(auto vi : polyIndices)
-						{
-							auto const vpos = vertices.position( vi );
-							Math::vec3 pos( vpos.x, vpos.y, vpos.z );
-							polyBox.expandBy( pos );
-						}
-
-						insertBox( polyBox,
-								   [i, polygonIndex]( TacticalMapTileBuilder& tileBuilder )
-								   {
-									   tileBuilder.polygons[i].insert( polygonIndex );
-								   } );
-					} );
-			if(levelData->flags & TacticalMapLevelFlags ::Destructable)
-			{
-				Geometry::AABB localBox = box;
-				insertBox( box,
-						   [i, localBox]( TacticalMapTileBuilder& tileBuilder )
-						   {
-							   tileBuilder.destructables[i] = localBox;
-						   } );
-			}
-		} else
-		{
-			Geometry::AABB localBox = box;
-			size_t localLevelDataOffset = levelDataOffset;
-			insertBox( box,
-					   [this, i, localBox, localLevelDataOffset]( TacticalMapTileBuilder& tileBuilder )
-					   {
-							auto levelData = (TacticalMapLevelDataHeader*)(tacticalLevelDataHeap.data() + localLevelDataOffset);
+		buildStats.writeMap = Lap(lap);
+		buildStats.total = std::chrono::duration<double>(lap - buildStart).count();
+	};
 
-						   tileBuilder.boxes[i] = localBox;
-						   if(levelData->flags & TacticalMapLevelFlags ::Destructable)
-						   {
-							   tileBuilder.destructables[i] = localBox;
-						   }
-					   } );
-
-		}
-	}
-
-	// start to order and map things in this tile
+	// work out which polygons from which mesh intersect which tile
+	binTriangles();
+	buildStats.binTriangles = Lap(lap);
+	insertSolidBoxes();
+	buildStats.insertSolidBoxes = Lap(lap);
+	generateStructuralBoxes();
+	buildStats.structuralBoxes = Lap(lap);
+
+	// start to order and map things in the dirty tiles
+	boxFragmentMismatches = 0;
 	generateLayers();
+	buildStats.layers = Lap(lap);
+	calculateMapHeights();
 
 	//------- now generate the actual tactical map
 	// calculate size of memory chunk we need to allocate
@@ -132,190 +185,253 @@ std::shared_ptr<TacticalMap> TacticalMapBuilder::build()
 			levelCount += (uint32_t)tileBuilder.layers.size();
 		}
 	}
-	size_t const levelMemorySize = sizeof(TacticalMapTileLevel) * levelCount;
-	size_t const levelDataMemorySize = tacticalLevelDataSize * levelCount;
-	size_t const mapMemorySize = sizeof(TacticalMapTile) * width * height;
-	size_t const memorySize = sizeof(TacticalMap) + 
-								levelMemorySize + 
-								levelDataMemorySize + 
-								mapMemorySize;
-
-	auto memory = (uint8_t*) malloc(memorySize);
 
-	auto const levels = (TacticalMapTileLevel*)(memory + sizeof(TacticalMap));
-	auto const levelDatasByte = ((uint8_t*)levels) + levelMemorySize;
-	auto const map = (TacticalMapTile*)(levelDatasByte + levelDataMemorySize);
-
-	assert((((uint8_t*)map) + mapMemorySize) - memory == memorySize);
-
-	minHeight = FLT_MAX;
-	maxHeight = -FLT_MAX;
+	// always a new map, maps are shared with readers and damaged versions share their levels. only the
+	// dirty tiles layers were regenerated, the rest still have theirs from the last build so just get written again
+	auto result = TacticalMap::allocate(width, height, tileLayout, levelCount, tacticalLevelDataSize, name);
+	TacticalMap* tmap = result.get();
+	tmap->bottomLeft = bottomLeft;
+	tmap->minHeight = minHeight;
+	tmap->maxHeight = maxHeight;
 
 	// now update the real non builder data
+	for (auto y = 0; y < height; ++y)
+	{
+		for (auto x = 0; x < width; ++x)
+		{
+			tmap->getTile(x, y).levelCount = (uint16_t)tileBuilders[y * width + x].layers.size();
+		}
+	}
+
+	// levels are stored in tile memory order, so neighbouring tiles levels are close in either layout
 	auto globalLevelIndex = 0u;
+	for (auto i = 0u; i < tmap->getTileCount(); ++i)
+	{
+		TacticalMapTile& tile = tmap->map[i];
+		if (tile.levelCount > 0)
+		{
+			tile.levelStartIndex = globalLevelIndex;
+		}
+		else
+		{
+			tile.levelStartIndex = ~0;
+		}
+		globalLevelIndex += tile.levelCount;
+	}
+	assert(globalLevelIndex == levelCount);
+
 	for (auto y = 0; y < height; ++y)
 	{
 		for (auto x = 0; x < width; ++x)
 		{
-			if (levelCount > 0)
+			TacticalMapTile& tile = tmap->getTile(x, y);
+			if (tile.levelCount == 0) continue;
+
+			bool const okay = writeTileLevels(tileBuilders[y * width + x],
+											  tile,
+											  tmap->levels + tile.levelStartIndex,
+											  tmap->levelDataHeap + (tile.levelStartIndex * tacticalLevelDataSize));
+			if (!okay)
 			{
-				assert(globalLevelIndex <= levelCount);
+				LOG_F(ERROR, "Tile %d, %d has levels outside the heights a tactical map can hold", x, y);
+				return nullptr;
 			}
-			auto const tileIndex = y * width + x;
-			auto const& tileBuilder = tileBuilders[tileIndex];
+		}
+	}
 
-			map[tileIndex].levelCount = (uint32_t)tileBuilder.layers.size();
-			if (map[tileIndex].levelCount > 0)
-			{
-				map[tileIndex].levelStartIndex = globalLevelIndex;
-			}
-			else
+	tmap->updateSummary(TacticalMap::TileRect{ 0, 0, width, height });
+
+	// verify
+	for (auto y = 0; y < height; ++y)
+	{
+		for (auto x = 0; x < width; ++x)
+		{
+			TacticalMapTile const& tile = tmap->getTile(x, y);
+			for (auto levelChk = 0u; levelChk < tile.levelCount; levelChk++)
 			{
-				map[tileIndex].levelStartIndex = ~0;
+				auto const* levelData = tmap->getLevelData(tile, levelChk);
+				assert(levelData->levelNum == levelChk);
+				assert(levelData->layer <= 31);
+				assert(tmap->getLevel(tile, levelChk).layer == levelData->layer);
 			}
+		}
+	}
 
-			for (auto layerIndex = 0u; layerIndex < tileBuilder.layers.size(); ++layerIndex)
-			{
-				assert(map[tileIndex].levelCount != 0);
+	std::fill(dirtyTiles.begin(), dirtyTiles.end(), 0);
+	finishStats();
+	return result;
+}
 
-				auto const& layer = tileBuilder.layers[layerIndex];
-				auto const levelIndex = globalLevelIndex + layerIndex;
-				assert(levelIndex < levelCount);
-				auto& level = levels[levelIndex];
-				auto* levelDataByte = levelDatasByte + ((levelIndex) * tacticalLevelDataSize);
-				auto* levelData = (TacticalMapLevelDataHeader*) levelDataByte;
-				assert((uint8_t*)levelData < (uint8_t*)map);
 
-				uint32_t const floorSolidIndex = layer.floorDominantSolidIndex;
-				uint32_t const ceilSolidIndex = layer.ceilDominantSolidIndex;
+// writes a tiles levels and their level data, levels and levelDatasByte point to the tiles first level.
+// false if the levels heights can't be quantised
+bool TacticalMapBuilder::writeTileLevels( TacticalMapTileBuilder const& tileBuilder,
+										  TacticalMapTile& tile,
+										  TacticalMapTileLevel* levels,
+										  uint8_t* levelDatasByte ) const
+{
+	// the tiles levels are quantised above its lowest level
+	float lowestHeight = 0.0f;
+	if (!tileBuilder.layers.empty())
+	{
+		lowestHeight = FLT_MAX;
+		for (auto const& layer : tileBuilder.layers)
+		{
+			lowestHeight = std::min(lowestHeight, layer.minHeight);
+		}
+	}
+	if (!TacticalMap::encodeTileBaseHeight(lowestHeight, tile.baseHeight)) return false;
 
-				uint32_t solidIndex = floorSolidIndex;
-				if (floorSolidIndex == ~0)
-				{
-					solidIndex = ceilSolidIndex;
-				}
-				assert(solidIndex != ~0);
+	for (auto layerIndex = 0u; layerIndex < tileBuilder.layers.size(); ++layerIndex)
+	{
+		auto const& layer = tileBuilder.layers[layerIndex];
+		auto& level = levels[layerIndex];
+		auto* levelDataByte = levelDatasByte + (layerIndex * tacticalLevelDataSize);
+		auto* levelData = (TacticalMapLevelDataHeader*) levelDataByte;
 
-				auto const& solid = solids[solidIndex];
+		uint32_t const floorSolidIndex = layer.floorDominantSolidIndex;
+		uint32_t const ceilSolidIndex = layer.ceilDominantSolidIndex;
 
-				level.baseHeight = layer.minHeight;
-				level.floorPlane = layer.floorPlane;
+		uint32_t solidIndex = floorSolidIndex;
+		if (floorSolidIndex == InvalidSolidIndex)
+		{
+			solidIndex = ceilSolidIndex;
+		}
+		assert(solidIndex != InvalidSolidIndex);
 
-				std::memcpy(levelData, tacticalLevelDataHeap.data() + solid.extraLevelDataOffset, tacticalLevelDataSize);
+		auto const& solid = solids[solidIndex];
 
-				assert(levelData->layer <= 31);
-				levelData->flags = 0;
-				levelData->instance = 0;
-				levelData->levelNum = (uint8_t) layerIndex;
-
-				assert(!std::isnan(level.baseHeight));
-				assert(level.baseHeight < 1e6f);
-
-				// world structural type trumps everything
-				// none always loses
-				// floor trumps walls
-				StructuralType stype = StructuralType::NotStructural;
-				uint8_t structuralIntegrity = 255;
-
-				// look up the destruction data in the solids and
-				// decide on the type and integrity
-				for (auto solidIndex : layer.destructionSolidIndices)
-				{
-					auto const& sbox = tileBuilder.structuralBoxs[solidIndex];
-					uint8_t si = (uint8_t)Math::clamp(sbox.structuralIntegrity, 0, 255);
-					structuralIntegrity = std::min(structuralIntegrity, si);
+		std::memcpy(levelData, tacticalLevelDataHeap.data() + solid.extraLevelDataOffset, tacticalLevelDataSize);
 
-					switch (sbox.structuralType)
-					{
-					case StructuralType::NotStructural: break;
-					case StructuralType::Wall:
-						if (stype == StructuralType::NotStructural)
-						{
-							stype = StructuralType::Wall;
-						}
-						break;
-					case StructuralType::Floor:
-						if (stype != StructuralType::World)
-						{
-							stype = StructuralType::Floor;
-						}
-						break;
-					case StructuralType::World:
-						stype = StructuralType::World;
-						break;
-					}
-				}
-				levelData->structuralType = stype;
-				levelData->structuralIntegrity = structuralIntegrity;
+		assert(levelData->layer <= 31);
+		levelData->flags = 0;
+		levelData->instance = 0;
+		levelData->levelNum = (uint8_t) layerIndex;
+
+		assert(!std::isnan(layer.minHeight));
+		assert(layer.minHeight < 1e6f);
+
+		// world structural type trumps everything
+		// none always loses
+		// floor trumps walls
+		StructuralType stype = StructuralType::NotStructural;
+		uint8_t structuralIntegrity = 255;
 
-				if (!std::isnan(layer.ceilPlane.d))
+		// look up the destruction data in the solids and
+		// decide on the type and integrity
+		for (auto solidIndex : layer.destructionSolidIndices)
+		{
+			auto const& sbox = structuralBoxs[solidIndex];
+			uint8_t si = (uint8_t)Math::clamp(sbox.structuralIntegrity, 0, 255);
+			structuralIntegrity = std::min(structuralIntegrity, si);
+
+			switch (sbox.structuralType)
+			{
+			case StructuralType::NotStructural: break;
+			case StructuralType::Wall:
+				if (stype == StructuralType::NotStructural)
 				{
-					levelData->flags |= TacticalMapLevelFlags ::RoofValid;
-					level.roofPlane = layer.ceilPlane;
-					level.roofDeltaHeight = layer.maxHeight - layer.minHeight;
+					stype = StructuralType::Wall;
 				}
-				else
+				break;
+			case StructuralType::Floor:
+				if (stype != StructuralType::World)
 				{
-					level.roofDeltaHeight = FLT_MAX;
-					maxHeight = FLT_MAX;
+					stype = StructuralType::Floor;
 				}
-				minHeight = std::min(minHeight, layer.minHeight);
-				maxHeight = std::max(maxHeight, layer.maxHeight);
-			}
-			// verify indices
-			for (auto levelIndex = 0u; levelIndex < map[tileIndex].levelCount; ++levelIndex)
-			{
-				auto const& level = levels[map[tileIndex].levelStartIndex + levelIndex];
-				auto* levelDataByte = levelDatasByte + ((map[tileIndex].levelStartIndex + levelIndex) * tacticalLevelDataSize);
-				auto* levelData = (TacticalMapLevelDataHeader*) levelDataByte;
-				assert(levelData->levelNum == levelIndex);
+				break;
+			case StructuralType::World:
+				stype = StructuralType::World;
+				break;
 			}
+		}
+		levelData->structuralType = stype;
+		levelData->structuralIntegrity = structuralIntegrity;
 
-			globalLevelIndex += (uint32_t)tileBuilder.layers.size();
+		if (!std::isnan(layer.ceilPlane.d))
+		{
+			levelData->flags |= TacticalMapLevelFlags ::RoofValid;
 		}
+
+		bool const okay = TacticalMap::encodeLevel(tile.baseHeight,
+												   layer.minHeight,
+												   layer.maxHeight - layer.minHeight,
+												   layer.floorPlane.normal(),
+												   layer.ceilPlane.normal(),
+												   levelData->flags,
+												   levelData->layer,
+												   level);
+		if (!okay) return false;
 	}
-	// verify
-	for (auto y = 0; y < height; ++y)
+	return true;
+}
+
+void TacticalMapBuilder::calculateMapHeights()
+{
+	minHeight = FLT_MAX;
+	maxHeight = -FLT_MAX;
+	bool roofless = false;
+	for (auto const& tileBuilder : tileBuilders)
 	{
-		for (auto x = 0; x < width; ++x)
+		for (auto const& layer : tileBuilder.layers)
 		{
-			auto const tileIndex = y * width + x;
-			TacticalMapTile const& tile = map[tileIndex];
-			for (auto levelChk = 0u; levelChk < tile.levelCount; levelChk++)
+			roofless |= std::isnan(layer.ceilPlane.d);
+			minHeight = std::min(minHeight, layer.minHeight);
+			maxHeight = std::max(maxHeight, layer.maxHeight);
+		}
+	}
+	// a level without a roof is open to the sky
+	if (roofless)
+	{
+		maxHeight = FLT_MAX;
+	}
+}
+
+// the boxes and destructables of every tile are refilled, removed solids are left out
+void TacticalMapBuilder::insertSolidBoxes()
+{
+	for (auto& tileBuilder : tileBuilders)
+	{
+		tileBuilder.boxes.clear();
+		tileBuilder.destructables.clear();
+	}
+
+	for (size_t i = 0; i < solids.size(); i++)
+	{
+		if (isSolidRemoved(i)) continue;
+
+		auto& [mesh, box, levelDataOffset] = solids[i];
+		auto levelData = (TacticalMapLevelDataHeader*)(tacticalLevelDataHeap.data() + levelDataOffset);
+
+		if(mesh)
+		{
+			if(levelData->flags & TacticalMapLevelFlags ::Destructable)
 			{
-				auto const& level = levels[tile.levelStartIndex + levelChk];
-				auto* levelDataByte = levelDatasByte + ((map[tileIndex].levelStartIndex + levelChk) * tacticalLevelDataSize);
-				auto* levelData = (TacticalMapLevelDataHeader*) levelDataByte;
-				assert(levelData->levelNum == levelChk);
-				assert(levelData->layer <= 31);
+				Geometry::AABB localBox = box;
+				insertBox( box,
+						   [i, localBox]( TacticalMapTileBuilder& tileBuilder )
+						   {
+							   tileBuilder.destructables[i] = localBox;
+						   } );
 			}
+		} else
+		{
+			Geometry::AABB localBox = box;
+			size_t localLevelDataOffset = levelDataOffset;
+			insertBox( box,
+					   [this, i, localBox, localLevelDataOffset]( TacticalMapTileBuilder& tileBuilder )
+					   {
+							auto levelData = (TacticalMapLevelDataHeader*)(tacticalLevelDataHeap.data() + localLevelDataOffset);
+
+						   tileBuilder.boxes[i] = localBox;
+						   if(levelData->flags & TacticalMapLevelFlags ::Destructable)
+						   {
+							   tileBuilder.destructables[i] = localBox;
+						   }
+					   } );
+
 		}
 	}
-	TacticalMap* tmap = new(memory) TacticalMap();
-	tmap->width = width;
-	tmap->height = height;
-	tmap->levelCount = levelCount;
-	tmap->bottomLeft = bottomLeft;
-	tmap->minHeight = minHeight;
-	tmap->maxHeight = maxHeight;
-	tmap->sizeOfTacticalMapTile = sizeof(TacticalMapTile);
-	tmap->sizeOfTacticalMapTileLevel = sizeof(TacticalMapTileLevel);
-	tmap->sizeOfTacticalLevelData = tacticalLevelDataSize;
-	char* tname = (char*) malloc(name.size()+1);
-	std::memcpy(tname, name.data(), name.size());
-	tname[name.size()] = '\0';
-	tmap->name = tname;
-
-	tmap->levels = levels;
-	tmap->map = map;
-	tmap->levelDataHeap = levelDatasByte;
-
-	return std::shared_ptr<TacticalMap>(tmap,
-		[](TacticalMap* ptr)
-	{
-		if(ptr) free((void*)ptr->name);
-		free(ptr);
-	});
 }
 
 void TacticalMapBuilder::insertBox( Geometry::AABB const& box,
@@ -357,17 +473,119 @@ void TacticalMapBuilder::insertBox( Geometry::AABB const& box,
 	}
 }
 
-void TacticalMapBuilder::addMeshAt( MeshMod::MeshPtr const& mesh, TacticalMapLevelDataHeader const* levelData, Math::mat4x4 const& transform )
+/**
+Bins every triangle into the tiles its XZ footprint touches.
+Each pass is parallel over all triangles, the first counts per tile, then a prefix sum gives each
+tile its range of binnedTriangles and the second scatters into them. Scatter order depends on
+the threads so each tiles range is then sorted, which also keeps each solid's triangles together.
+*/
+void TacticalMapBuilder::binTriangles()
 {
 	using namespace MeshMod;
-	Geometry::AABB wipAABB;
 
-	auto wip = std::shared_ptr<Mesh>(mesh->clone());
-	MeshOps::BasicMeshOps::transform(wip, transform);
-	MeshOps::BasicMeshOps::triangulate( wip);
-	MeshOps::BasicMeshOps::computeFacePlaneEquations(wip);
-	MeshOps::BasicMeshOps::computeAABB( wip, wipAABB );
+	solidTriangleStart.resize(solids.size() + 1);
+	uint32_t triangleCount = 0;
+	for(size_t i = 0; i < solids.size(); ++i)
+	{
+		solidTriangleStart[i] = triangleCount;
+		if(solids[i].mesh)
+		{
+			triangleCount += (uint32_t) solids[i].mesh->getPolygons().getCount();
+		}
+	}
+	solidTriangleStart[solids.size()] = triangleCount;
+
+	size_t const tileCount = (size_t) width * (size_t) height;
+	std::vector<std::atomic<uint32_t>> tileCursors(tileCount);
+	for(auto& cursor : tileCursors)
+	{
+		cursor.store(0, std::memory_order_relaxed);
+	}
+
+	// calls func(x, z, triangleIndex) for each tile of each triangle in [start, end)
+	auto rasteriseRange = [this](uint32_t start, uint32_t end, auto&& func)
+	{
+		VertexIndexContainer polyIndices;
+		polyIndices.reserve(3);
+		size_t solidIndex = std::upper_bound(solidTriangleStart.begin(), solidTriangleStart.end(), start) -
+							solidTriangleStart.begin() - 1;
+		for(uint32_t triangleIndex = start; triangleIndex < end; ++triangleIndex)
+		{
+			while(triangleIndex >= solidTriangleStart[solidIndex + 1])
+			{
+				solidIndex++;
+			}
+			auto const& mesh = solids[solidIndex].mesh;
+			PolygonIndex const polygonIndex = PolygonIndex(triangleIndex - solidTriangleStart[solidIndex]);
+			Polygons const& polygons = mesh->getPolygons();
+			if(!polygons.isValid(polygonIndex)) continue;
+
+			Vertices const& vertices = mesh->getVertices();
+			polyIndices.clear();
+			polygons.getVertexIndices(polygonIndex, polyIndices);
+			assert(polyIndices.size() == 3);
+
+			Math::vec2 const p0 = worldToLocal(vertices.position(polyIndices[0]).getVec3());
+			Math::vec2 const p1 = worldToLocal(vertices.position(polyIndices[1]).getVec3());
+			Math::vec2 const p2 = worldToLocal(vertices.position(polyIndices[2]).getVec3());
+			rasteriseTriangleFootprint(p0, p1, p2, width, height,
+									   [&func, triangleIndex](int32_t x, int32_t z)
+									   {
+										   func(x, z, triangleIndex);
+									   });
+		}
+	};
+
+	// pass 1 count
+	Core::ParallelFor( triangleCount, 1024,
+					   [&]( uint32_t const begin_, uint32_t const end_, uint32_t )
+					   {
+						   rasteriseRange(begin_, end_,
+										  [this, &tileCursors](int32_t x, int32_t z, uint32_t)
+										  {
+											  tileCursors[z * width + x].fetch_add(1, std::memory_order_relaxed);
+										  });
+					   } );
+
+	// prefix sum, the cursors become each tiles write position
+	uint32_t binnedCount = 0;
+	for(size_t i = 0; i < tileCount; ++i)
+	{
+		auto& tileBuilder = tileBuilders[i];
+		tileBuilder.binnedTriangleStart = binnedCount;
+		tileBuilder.binnedTriangleCount = tileCursors[i].load(std::memory_order_relaxed);
+		tileCursors[i].store(binnedCount, std::memory_order_relaxed);
+		binnedCount += tileBuilder.binnedTriangleCount;
+	}
+	binnedTriangles.resize(binnedCount);
+
+	// pass 2 scatter
+	Core::ParallelFor( triangleCount, 1024,
+					   [&]( uint32_t const begin_, uint32_t const end_, uint32_t )
+					   {
+						   rasteriseRange(begin_, end_,
+										  [this, &tileCursors](int32_t x, int32_t z, uint32_t triangleIndex)
+										  {
+											  uint32_t const slot = tileCursors[z * width + x].fetch_add(1, std::memory_order_relaxed);
+											  binnedTriangles[slot] = triangleIndex;
+										  });
+					   } );
 
+	// pass 3 sort each tile
+	Core::ParallelFor( (uint32_t) tileCount, 1,
+					   [this]( uint32_t const begin_, uint32_t const end_, uint32_t )
+					   {
+						   for(auto i = begin_; i < end_; ++i)
+						   {
+							   auto const& tileBuilder = tileBuilders[i];
+							   auto const begin = binnedTriangles.begin() + tileBuilder.binnedTriangleStart;
+							   std::sort(begin, begin + tileBuilder.binnedTriangleCount);
+						   }
+					   } );
+}
+
+uint32_t TacticalMapBuilder::addMeshAt( MeshMod::MeshPtr const& mesh, TacticalMapLevelDataHeader const* levelData, Math::mat4x4 const& transform )
+{
 	assert(levelData->layer <= 31);
 	assert(levelData->nameCrc != 0);
 
@@ -375,243 +593,397 @@ void TacticalMapBuilder::addMeshAt( MeshMod::MeshPtr const& mesh, TacticalMapLev
 	tacticalLevelDataHeap.resize(heapOffset + tacticalLevelDataSize);
 	auto ptr = tacticalLevelDataHeap.data() + heapOffset;
 	std::memcpy(ptr, levelData, tacticalLevelDataSize);
-	solids.emplace_back(wip, wipAABB, heapOffset);
+	solids.emplace_back(nullptr, Geometry::AABB(), heapOffset);
+	solidSources.push_back({ mesh, Geometry::AABB(), false });
+
+	placeSolid(solids.size() - 1, transform);
+	return (uint32_t)(solids.size() - 1);
 }
 
-void TacticalMapBuilder::addBoxAt( Geometry::AABB const& box, TacticalMapLevelDataHeader const* levelData, Math::mat4x4 const& transform )
+uint32_t TacticalMapBuilder::addBoxAt( Geometry::AABB const& box, TacticalMapLevelDataHeader const* levelData, Math::mat4x4 const& transform )
 {
 	auto heapOffset = tacticalLevelDataHeap.size();
 	tacticalLevelDataHeap.resize(heapOffset + tacticalLevelDataSize);
 	auto ptr = tacticalLevelDataHeap.data() + heapOffset;
 	std::memcpy(ptr, levelData, tacticalLevelDataSize);
-	solids.emplace_back( nullptr, box.transformAffine( transform ), heapOffset);
+	solids.emplace_back( nullptr, Geometry::AABB(), heapOffset);
+	solidSources.push_back({ nullptr, box, false });
+
+	placeSolid(solids.size() - 1, transform);
+	return (uint32_t)(solids.size() - 1);
+}
+
+void TacticalMapBuilder::removeSolid( uint32_t solidId_ )
+{
+	assert(solidId_ < solids.size());
+	if (isSolidRemoved(solidId_)) return;
+
+	auto& solid = solids[solidId_];
+	markDirty(solid.aabb);
+	solid.mesh.reset();
+	solidSources[solidId_] = { nullptr, Geometry::AABB(), true };
+}
+
+void TacticalMapBuilder::updateSolidTransform( uint32_t solidId_, Math::mat4x4 const& transform_ )
+{
+	assert(solidId_ < solids.size());
+	assert(!isSolidRemoved(solidId_));
+
+	// both where it was and where it is now need rebuilding
+	markDirty(solids[solidId_].aabb);
+	placeSolid(solidId_, transform_);
+}
+
+void TacticalMapBuilder::placeSolid( size_t solidIndex, Math::mat4x4 const& transform )
+{
+	using namespace MeshMod;
+	auto& solid = solids[solidIndex];
+	auto const& source = solidSources[solidIndex];
+
+	if(source.mesh)
+	{
+		auto wip = std::shared_ptr<Mesh>(source.mesh->clone());
+		MeshOps::BasicMeshOps::transform(wip, transform);
+		MeshOps::BasicMeshOps::triangulate( wip);
+		MeshOps::BasicMeshOps::computeFacePlaneEquations(wip);
+		MeshOps::BasicMeshOps::computeAABB( wip, solid.aabb );
+		solid.mesh = wip;
+	} else
+	{
+		solid.aabb = source.box.transformAffine( transform );
+	}
+
+	markDirty(solid.aabb);
+}
+
+// dirties every tile the box can bin into, plus the tiles that smooth with them
+void TacticalMapBuilder::markDirty( Geometry::AABB const& box )
+{
+	// binning is conservative and boxes fatten slivers so a tile either side can be touched,
+	// then one more for the smoothing halo
+	static int const border = 2;
+
+	Math::vec2 const lo = worldToLocal(box.getMinExtent());
+	Math::vec2 const hi = worldToLocal(box.getMaxExtent());
+	TileCoord_t const x0 = std::max((TileCoord_t) std::floor(lo.x) - border, 0);
+	TileCoord_t const z0 = std::max((TileCoord_t) std::floor(lo.y) - border, 0);
+	TileCoord_t const x1 = std::min((TileCoord_t) std::floor(hi.x) + border, width - 1);
+	TileCoord_t const z1 = std::min((TileCoord_t) std::floor(hi.y) + border, height - 1);
+
+	for(auto z = z0; z <= z1; ++z)
+	{
+		for(auto x = x0; x <= x1; ++x)
+		{
+			dirtyTiles[z * width + x] = 1;
+		}
+	}
 }
 
 void TacticalMapBuilder::generateLayers()
 {
+	// regions are independent so can run in parallel and only need memory for their own fragments
+	TileCoord_t const regionsWide = (width + regionSize - 1) / regionSize;
+	TileCoord_t const regionsHigh = (height + regionSize - 1) / regionSize;
+
+	// per thread scratch, a build that can't get the task threads runs as thread 0
+	uint32_t const threadCount = std::max( g_EnkiTS.GetNumTaskThreads(), 1u );
+	fragmentScratches.resize( threadCount );
+	fragmentArenas.resize( threadCount );
+	regionStats.assign( threadCount, RegionStats{} );
+
+	Core::ParallelFor( regionsWide * regionsHigh, 1,
+					   [this, regionsWide]( uint32_t const begin_, uint32_t const end_, uint32_t const threadnum_ )
+					   {
+						   for(auto i = begin_; i < end_; ++i)
+						   {
+							   generateLayersForRegion( i % regionsWide, i / regionsWide, threadnum_ );
+						   }
+					   } );
+
+	fragmentScratches.clear();
+	fragmentArenas.clear();
+
+	for(auto const& stats : regionStats)
+	{
+		buildStats.fragments += stats.fragments;
+		buildStats.smoothing += stats.smoothing;
+		buildStats.planes += stats.planes;
+		buildStats.destruction += stats.destruction;
+		buildStats.threadBusy.push_back( stats.busy );
+		buildStats.regionsBuilt += stats.regions;
+		buildStats.peakFragmentBytes += stats.peakFragmentBytes;
+	}
+	regionStats.clear();
+}
+
+/**
+Runs all the layer phases for the dirty tiles of one region.
+Smoothing reads a sample past each edge so fragments are also generated for a one tile halo.
+Halo tiles belong to other regions, they are generated again here into local tile builders rather
+than shared. Every tile is a pure function of the inputs so regions give the same result however
+they are scheduled.
+*/
+void TacticalMapBuilder::generateLayersForRegion( TileCoord_t regionX, TileCoord_t regionZ, uint32_t threadNum )
+{
+	// only the rectangle around the regions dirty tiles is regenerated
+	TileCoord_t x0 = width;
+	TileCoord_t z0 = height;
+	TileCoord_t x1 = 0;
+	TileCoord_t z1 = 0;
+	for(auto z = regionZ * regionSize; z < std::min( (regionZ + 1) * regionSize, height ); ++z)
+	{
+		for(auto x = regionX * regionSize; x < std::min( (regionX + 1) * regionSize, width ); ++x)
+		{
+			if(dirtyTiles[z * width + x])
+			{
+				x0 = std::min( x0, x );
+				z0 = std::min( z0, z );
+				x1 = std::max( x1, x + 1 );
+				z1 = std::max( z1, z + 1 );
+			}
+		}
+	}
+	if(x0 >= x1 || z0 >= z1) return;
+
+	RegionStats& stats = regionStats[threadNum];
+	auto const regionStart = BuildClock::now();
+	auto lap = regionStart;
+
+	TileCoord_t const hx0 = std::max( x0 - 1, 0 );
+	TileCoord_t const hz0 = std::max( z0 - 1, 0 );
+	TileCoord_t const hx1 = std::min( x1 + 1, width );
+	TileCoord_t const hz1 = std::min( z1 + 1, height );
+	TileCoord_t const tilesWide = hx1 - hx0;
+	TileCoord_t const tilesHigh = hz1 - hz0;
+
+	auto isOwned = [=]( TileCoord_t x, TileCoord_t z )
+	{
+		return x >= x0 && x < x1 && z >= z0 && z < z1;
+	};
+
 	// phase 1 generates the height fields
 	// cleans them up and generates mean and std basic statistics for outlier removal
+	std::vector<TacticalMapTileBuilder> haloTiles( (tilesWide * tilesHigh) - ((x1 - x0) * (z1 - z0)) );
+	std::vector<TacticalMapTileBuilder const*> regionTiles( tilesWide * tilesHigh );
+	size_t haloIndex = 0;
+	for(auto z = hz0; z < hz1; ++z)
 	{
-		enki::TaskSet phase1( width * height,
-							  [this]( enki::TaskSetPartition range, uint32_t threadnum )
-							  {
-								  for(auto i = range.start; i < range.end; ++i)
-								  {
-									  TileCoord_t x = i % width;
-									  TileCoord_t z = i / width;
-									  generateHeightFragmentsForTileAt( x, z );
-								  }
-							  } );
-//		phase1.m_MinRange = 10000;
-		g_EnkiTS.AddTaskSetToPipe( &phase1 );
-		g_EnkiTS.WaitforTask( &phase1 );
+		for(auto x = hx0; x < hx1; ++x)
+		{
+			TacticalMapTileBuilder& target = isOwned( x, z ) ? tileBuilders[z * width + x] : haloTiles[haloIndex++];
+			generateHeightFragmentsForTileAt( x, z, threadNum, target );
+			regionTiles[(z - hz0) * tilesWide + (x - hx0)] = &target;
+		}
 	}
+	assert( haloIndex == haloTiles.size() );
+	stats.fragments += Lap( lap );
 
-	// phase 2 smooths the normals and heightfields across the entire map
-	generateGlobalFragmentTexture();
-	smoothGlobalFragmentTexture();
-
-	// phase 3 - determine planes
+	// phase 2 smooths the normals and heightfields across the region
+	std::unique_ptr<MeshOps::LayeredTexture> smoothTexture;
 	{
-		enki::TaskSet phase3( width * height,
-							  [this]( enki::TaskSetPartition range, uint32_t threadnum )
-							  {
-								  for(auto i = range.start; i < range.end; ++i)
-								  {
-									  TileCoord_t x = i % width;
-									  TileCoord_t z = i / width;
-									  generatePlanesForTileAt( x, z );
-								  }
-							  } );
-
-		g_EnkiTS.AddTaskSetToPipe( &phase3 );
-		g_EnkiTS.WaitforTask( &phase3 );
+		auto const fragmentTexture = generateFragmentTexture( regionTiles, tilesWide, tilesHigh );
+		smoothTexture = smoothFragmentTexture( *fragmentTexture, hx0, hz0, x0, z0, x1, z1 );
 	}
 
-	// phase 4 - plane level data
+	// nothing refers to the fragments once the smoothed heights exist
+	haloTiles.clear();
+	for(auto z = z0; z < z1; ++z)
 	{
-		enki::TaskSet phase3( width * height,
-							  [this]( enki::TaskSetPartition range, uint32_t threadnum )
-							  {
-								  for(auto i = range.start; i < range.end; ++i)
-								  {
-									  TileCoord_t x = i % width;
-									  TileCoord_t z = i / width;
-									  generatePlanesForTileAt( x, z );
-								  }
-							  } );
-
-		g_EnkiTS.AddTaskSetToPipe( &phase3 );
-		g_EnkiTS.WaitforTask( &phase3 );
+		for(auto x = x0; x < x1; ++x)
+		{
+			auto& tileBuilder = tileBuilders[z * width + x];
+			tileBuilder.fragmentStarts = nullptr;
+			tileBuilder.fragments = nullptr;
+			for(auto& layer : tileBuilder.layers)
+			{
+				layer.validFloorFragments = {};
+				layer.validCeilFragments = {};
+			}
+		}
 	}
+	stats.peakFragmentBytes = std::max( stats.peakFragmentBytes, fragmentArenas[threadNum].getAllocatedBytes() );
+	fragmentArenas[threadNum].reset();
+	stats.smoothing += Lap( lap );
 
-	// phase 5 - destruction
+	// phase 3 - determine planes, they only depend on the smoothed texture so one pass is enough
+	for(auto z = z0; z < z1; ++z)
 	{
-		enki::TaskSet phase4( width * height,
-							  [this]( enki::TaskSetPartition range, uint32_t threadnum )
-							  {
-								  for(auto i = range.start; i < range.end; ++i)
-								  {
-									  TileCoord_t x = i % width;
-									  TileCoord_t z = i / width;
-									  generateStructuralBoxesForTileAt( x, z );
-								  }
-							  } );
-
-		g_EnkiTS.AddTaskSetToPipe( &phase4 );
-		g_EnkiTS.WaitforTask( &phase4 );
+		for(auto x = x0; x < x1; ++x)
+		{
+			generatePlanesForTileAt( x, z, *smoothTexture, x0, z0 );
+		}
 	}
+	stats.planes += Lap( lap );
 
+	// phase 4 - destruction
+	for(auto z = z0; z < z1; ++z)
+	{
+		for(auto x = x0; x < x1; ++x)
+		{
+			generateStructuralBoxesForTileAt( x, z );
+		}
+	}
+	stats.destruction += Lap( lap );
+	stats.busy += std::chrono::duration<double>( lap - regionStart ).count();
+	stats.regions++;
 }
 
-void TacticalMapBuilder::generateGlobalFragmentTexture()
+// regionTiles is tilesWide by tilesHigh
+auto TacticalMapBuilder::generateFragmentTexture( std::vector<TacticalMapTileBuilder const*> const& regionTiles,
+												  TileCoord_t tilesWide,
+												  TileCoord_t tilesHigh ) const -> std::unique_ptr<FragmentTexture>
 {
-	// construct single global layered texture for the entire map
-	int const totalWidth = (int) width * fragmentSubSamples;
-	int const totalHeight = (int) height * fragmentSubSamples;
+	int const totalWidth = (int) tilesWide * fragmentSubSamples;
+	int const totalHeight = (int) tilesHigh * fragmentSubSamples;
 	int numLayers = 0;
 
-	// find max layers for map
-	for(auto y = 0; y < height; ++y)
+	// find max layers for the region
+	for(auto const tileBuilder : regionTiles)
 	{
-		for(auto x = 0; x < width; ++x)
-		{
-			auto const& tileBuilder = tileBuilders[y * width + x];
-			numLayers = std::max( numLayers, tileBuilder.maxLayers );
-		}
+		numLayers = std::max( numLayers, tileBuilder->maxLayers );
 	}
 
-	globalFragmentTexture = std::make_unique<TacticalMapBuilder::FragmentTexture>( totalWidth, totalHeight );
+	auto fragmentTexture = std::make_unique<FragmentTexture>( totalWidth, totalHeight );
 
 	for(auto layerIndex = 0; layerIndex < numLayers; ++layerIndex)
 	{
 		std::string const layerName = std::string( "Layer_" ) + std::to_string( layerIndex );
-		globalFragmentTexture->addLayer<TMapTBHeightFragment const*>( layerName, 2 );
+		fragmentTexture->addLayer<TMapTBHeightFragment const*>( layerName, 2 );
 	}
 
-	enki::TaskSet task( numLayers, [&]( enki::TaskSetPartition range, uint32_t threadnum )
+	for(auto layerIndex = 0; layerIndex < numLayers; ++layerIndex)
 	{
-		for(auto layerIndex = range.start; layerIndex < range.end; ++layerIndex)
+		auto& heightlayer = fragmentTexture->getLayer( layerIndex );
+		for(auto tileZ = 0; tileZ < tilesHigh; ++tileZ)
 		{
-			for(auto z = 0; z < totalHeight; ++z)
+			for(auto tileX = 0; tileX < tilesWide; ++tileX)
 			{
-				for(auto x = 0; x < totalWidth; ++x)
-				{
-					auto const tileZ = z / fragmentSubSamples;
-					auto const tileX = x / fragmentSubSamples;
-
-					auto const tileIndex = tileZ * width + tileX;
-					auto const& tileBuilder = tileBuilders[tileIndex];
-					if(layerIndex >= tileBuilder.layers.size())
-						continue;
-
-					auto const& slayer = tileBuilder.layers[layerIndex];
-					auto& heightlayer = globalFragmentTexture->getLayer(layerIndex);
+				auto const& tileBuilder = *regionTiles[tileZ * tilesWide + tileX];
+				if(layerIndex >= (int) tileBuilder.layers.size())
+					continue;
 
-					auto const sx = x - (tileX * fragmentSubSamples);
-					auto const sz = z - (tileZ * fragmentSubSamples);
-
-					auto const index = (sz * fragmentSubSamples) + sx;
-					heightlayer.setAt( x, z, 0, slayer.validFloorFragments[index] );
-					heightlayer.setAt( x, z, 1, slayer.validCeilFragments[index] );
+				auto const& slayer = tileBuilder.layers[layerIndex];
+				for(auto sz = 0; sz < fragmentSubSamples; ++sz)
+				{
+					for(auto sx = 0; sx < fragmentSubSamples; ++sx)
+					{
+						auto const x = (tileX * fragmentSubSamples) + sx;
+						auto const z = (tileZ * fragmentSubSamples) + sz;
+						auto const index = (sz * fragmentSubSamples) + sx;
+						heightlayer.setAt( x, z, 0, slayer.validFloorFragments[index] );
+						heightlayer.setAt( x, z, 1, slayer.validCeilFragments[index] );
+					}
 				}
 			}
 		}
-	} );
+	}
 
-	g_EnkiTS.AddTaskSetToPipe( &task );
-	g_EnkiTS.WaitforTask( &task );
+	return fragmentTexture;
 }
 
-void TacticalMapBuilder::smoothGlobalFragmentTexture()
+// fragmentTexture starts at tile (textureX, textureZ), the smoothed texture returned covers tiles
+// [x0, x1) by [z0, z1). Samples are clamped to the edge of the whole map not the fragment texture
+auto TacticalMapBuilder::smoothFragmentTexture( FragmentTexture const& srcTex,
+												TileCoord_t textureX, TileCoord_t textureZ,
+												TileCoord_t x0, TileCoord_t z0,
+												TileCoord_t x1, TileCoord_t z1 ) const -> std::unique_ptr<MeshOps::LayeredTexture>
 {
 	using namespace std::string_literals;
-	auto const& srcTex = globalFragmentTexture;
 
-	// clone the layer structure of the global fragment texture to a dual height map texture
-	smoothLayerTexture = std::make_unique<MeshOps::LayeredTexture>( srcTex->getWidth(), srcTex->getHeight());
-	for(auto i = 0u; i < srcTex->getLayerCount(); ++i)
+	int const lastX = ((int) width * fragmentSubSamples) - 1;
+	int const lastZ = ((int) height * fragmentSubSamples) - 1;
+	int const srcX = (int) textureX * fragmentSubSamples;
+	int const srcZ = (int) textureZ * fragmentSubSamples;
+	int const dstX = (int) x0 * fragmentSubSamples;
+	int const dstZ = (int) z0 * fragmentSubSamples;
+
+	// clone the layer structure of the fragment texture to a dual height map texture
+	auto smoothTexture = std::make_unique<MeshOps::LayeredTexture>( (x1 - x0) * fragmentSubSamples,
+																	(z1 - z0) * fragmentSubSamples );
+	for(auto i = 0u; i < srcTex.getLayerCount(); ++i)
 	{
-		auto const& srcLayer = srcTex->getLayer( i );
-		smoothLayerTexture->addLayer<float>( std::string(srcLayer.getName()) + "_smooth"s, 2 );
-		smoothLayerTexture->addLayer<uint32_t>( std::string(srcLayer.getName()) + "_solidIndex"s, 2 );
+		auto const& srcLayer = srcTex.getLayer( i );
+		smoothTexture->addLayer<float>( std::string(srcLayer.getName()) + "_smooth"s, 2 );
+		smoothTexture->addLayer<uint32_t>( std::string(srcLayer.getName()) + "_solidIndex"s, 2 );
 	}
 
-	enki::TaskSet task( srcTex->getLayerCount(), [&]( enki::TaskSetPartition range, uint32_t threadnum )
+	for(auto layerIndex = 0u; layerIndex < srcTex.getLayerCount(); ++layerIndex)
 	{
-		for(auto layerIndex = range.start; layerIndex < range.end; ++layerIndex)
+		auto const& slayer = srcTex.getLayer( layerIndex );
+		MeshOps::ITextureLayer& heightlayer = smoothTexture->getLayer(layerIndex * 2);
+		MeshOps::ITextureLayer& solidlayer = smoothTexture->getLayer((layerIndex * 2) + 1);
+
+		for(int z = 0; z < (int) smoothTexture->getHeight(); ++z)
 		{
-			auto& slayer = srcTex->getLayer( layerIndex );
-			MeshOps::ITextureLayer& heightlayer = smoothLayerTexture->getLayer(layerIndex * 2);
-			MeshOps::ITextureLayer& solidlayer = smoothLayerTexture->getLayer((layerIndex * 2) + 1);
+			int const gz = dstZ + z;
+			int const zm1 = std::max( gz - 1, 0 ) - srcZ;
+			int const zp1 = std::min( gz + 1, lastZ ) - srcZ;
+			int const zc = gz - srcZ;
 
-			for(int z = 0; z < (int) srcTex->getHeight(); ++z)
+			for(int x = 0; x < (int) smoothTexture->getWidth(); ++x)
 			{
-				int const zm1 = std::max( z - 1, 0 );
-				int const zp1 = std::min( z + 1, (int) srcTex->getHeight() - 1 );
-
-				for(int x = 0; x < (int) srcTex->getWidth(); ++x)
+				int const gx = dstX + x;
+				int const xm1 = std::max( gx - 1, 0 ) - srcX;
+				int const xp1 = std::min( gx + 1, lastX ) - srcX;
+				int const xc = gx - srcX;
+
+				std::array<std::pair<int,int>, 9> filterIndices = {
+						std::pair{ zm1, xm1 }, std::pair{ zm1, xc }, std::pair{ zm1, xp1 },
+						std::pair{  zc, xm1 }, std::pair{  zc, xc }, std::pair{  zc, xp1 },
+						std::pair{ zp1, xm1 }, std::pair{ zp1, xc }, std::pair{ zp1, xp1 }
+				};
+
+				float ft = 0;
+				float ct = 0;
+				int fcount = 0;
+				int ccount = 0;
+				for(auto j = 0u; j < filterIndices.size(); ++j)
 				{
-					int const xm1 = std::max( x - 1, 0 );
-					int const xp1 = std::min( x + 1, (int) srcTex->getWidth() - 1 );
-
-					std::array<std::pair<int,int>, 9> filterIndices = {
-							std::pair{ zm1, xm1 }, std::pair{ zm1, x }, std::pair{ zm1, xp1 },
-							std::pair{   z, xm1 }, std::pair{   z, x }, std::pair{   z, xp1 },
-							std::pair{ zp1, xm1 }, std::pair{ zp1, x }, std::pair{ zp1, xp1 }
-					};
-
-					float ft = 0;
-					float ct = 0;
-					int fcount = 0;
-					int ccount = 0;
-					for(auto j = 0u; j < filterIndices.size(); ++j)
+					auto const [iz, ix] = filterIndices[j];
+					auto floorHeight = slayer.getAt<TMapTBHeightFragment const*>(ix, iz, 0);
+					auto ceilHeight = slayer.getAt<TMapTBHeightFragment const*>(ix, iz, 1);
+
+					if(floorHeight != nullptr)
 					{
-						auto const [iz, ix] = filterIndices[j];
-						auto floorHeight = slayer.getAt<TMapTBHeightFragment const*>(ix, iz, 0);
-						auto ceilHeight = slayer.getAt<TMapTBHeightFragment const*>(ix, iz, 1);
-
-						if(floorHeight != nullptr)
-						{
-							fcount++;
-							ft += floorHeight->t;
-							solidlayer.setAt<uint32_t>(x, z, 0, (uint32_t)floorHeight->solidIndex);
-						}
-						if(ceilHeight != nullptr)
-						{
-							ccount++;
-							ct += ceilHeight->t;
-							solidlayer.setAt<uint32_t>(x, z, 1, (uint32_t)ceilHeight->solidIndex);
-						}
+						fcount++;
+						ft += floorHeight->t;
+						solidlayer.setAt<uint32_t>(x, z, 0, (uint32_t)floorHeight->solidIndex);
 					}
-					// TODO see if this average filter is okay...
-					if(fcount > 0)
+					if(ceilHeight != nullptr)
 					{
-						heightlayer.setAt( x, z, 0, ft / (float) fcount );
-					} else
-					{
-						heightlayer.setAt( x, z, 0, std::numeric_limits<float>::quiet_NaN());
-						solidlayer.setAt<uint32_t>(x, z, 0, ~0);
+						ccount++;
+						ct += ceilHeight->t;
+						solidlayer.setAt<uint32_t>(x, z, 1, (uint32_t)ceilHeight->solidIndex);
 					}
+				}
+				// TODO see if this average filter is okay...
+				if(fcount > 0)
+				{
+					heightlayer.setAt( x, z, 0, ft / (float) fcount );
+				} else
+				{
+					heightlayer.setAt( x, z, 0, std::numeric_limits<float>::quiet_NaN());
+					solidlayer.setAt<uint32_t>(x, z, 0, InvalidSolidIndex);
+				}
 
-					if(ccount > 0)
-					{
-						heightlayer.setAt( x, z, 1, ct / (float) ccount );
-					} else
-					{
-						heightlayer.setAt( x, z, 1, std::numeric_limits<float>::quiet_NaN());
-						solidlayer.setAt<uint32_t>(x, z, 1, ~0);
-					}
+				if(ccount > 0)
+				{
+					heightlayer.setAt( x, z, 1, ct / (float) ccount );
+				} else
+				{
+					heightlayer.setAt( x, z, 1, std::numeric_limits<float>::quiet_NaN());
+					solidlayer.setAt<uint32_t>(x, z, 1, InvalidSolidIndex);
 				}
 			}
 		}
-	} );
+	}
 
-	g_EnkiTS.AddTaskSetToPipe( &task );
-	g_EnkiTS.WaitforTask( &task );
+	return smoothTexture;
 }
 
-void TacticalMapBuilder::generatePlanesForTileAt( TileCoord_t x, TileCoord_t z )
+void TacticalMapBuilder::generatePlanesForTileAt( TileCoord_t x, TileCoord_t z,
+												  MeshOps::LayeredTexture const& smoothTexture,
+												  TileCoord_t textureX, TileCoord_t textureZ )
 {
 	auto& tileBuilder = tileBuilders[z * width + x];
 	if(tileBuilder.layers.size() == 0)
@@ -621,13 +993,15 @@ void TacticalMapBuilder::generatePlanesForTileAt( TileCoord_t x, TileCoord_t z )
 
 	auto const tileGlobalX = (x * fragmentSubSamples);
 	auto const tileGlobalZ = (z * fragmentSubSamples);
+	auto const tileTextureX = (x - textureX) * fragmentSubSamples;
+	auto const tileTextureZ = (z - textureZ) * fragmentSubSamples;
 	float const globalFX = (float) tileGlobalX + bottomLeft.x;
 	float const globalFZ = (float) tileGlobalZ + bottomLeft.y;
 
 	for(auto layerIndex = 0u; layerIndex < tileBuilder.layers.size(); ++layerIndex)
 	{
-		auto const& texLayer = smoothLayerTexture->getLayer(layerIndex * 2);
-		auto const& solidIndexLayer = smoothLayerTexture->getLayer((layerIndex * 2) + 1);
+		auto const& texLayer = smoothTexture.getLayer(layerIndex * 2);
+		auto const& solidIndexLayer = smoothTexture.getLayer((layerIndex * 2) + 1);
 		auto& layer = tileBuilder.layers[layerIndex];
 
 		Math::vec3 fPoints[fragmentSubSamples * fragmentSubSamples];
@@ -638,8 +1012,8 @@ void TacticalMapBuilder::generatePlanesForTileAt( TileCoord_t x, TileCoord_t z )
 		float maxHeight = -FLT_MAX;
 
 		// pick any solidIndex as dominance phase should ensure all the same
-		uint32_t floorSolidIndex = ~0;
-		uint32_t ceilSolidIndex = ~0;
+		uint32_t floorSolidIndex = InvalidSolidIndex;
+		uint32_t ceilSolidIndex = InvalidSolidIndex;
 
 		for(auto lz = 0u; lz < fragmentSubSamples; ++lz)
 		{
@@ -648,10 +1022,10 @@ void TacticalMapBuilder::generatePlanesForTileAt( TileCoord_t x, TileCoord_t z )
 				float const fx = globalFX + (float) lx / (float) fragmentSubSamples;
 				float const fz = globalFZ + (float) lz / (float) fragmentSubSamples;
 
-				float floorHeight = texLayer.getAt<float>( tileGlobalX + lx, tileGlobalZ + lz, 0 );
-				float ceilHeight = texLayer.getAt<float>( tileGlobalX + lx, tileGlobalZ + lz, 1 );
-				uint32_t floorSI = solidIndexLayer.getAt<uint32_t>( tileGlobalX + lx, tileGlobalZ + lz, 0 );
-				uint32_t ceilSI = solidIndexLayer.getAt<uint32_t>( tileGlobalX + lx, tileGlobalZ + lz, 1 );
+				float floorHeight = texLayer.getAt<float>( tileTextureX + lx, tileTextureZ + lz, 0 );
+				float ceilHeight = texLayer.getAt<float>( tileTextureX + lx, tileTextureZ + lz, 1 );
+				uint32_t floorSI = solidIndexLayer.getAt<uint32_t>( tileTextureX + lx, tileTextureZ + lz, 0 );
+				uint32_t ceilSI = solidIndexLayer.getAt<uint32_t>( tileTextureX + lx, tileTextureZ + lz, 1 );
 
 				if(!std::isnan( floorHeight ))
 				{
@@ -752,7 +1126,7 @@ void TacticalMapBuilder::getValidFragmentsForTile( TacticalMapTileBuilder& tileB
 		{
 			for(int sx = 0; sx < fragmentSubSamples; ++sx)
 			{
-				auto const& heightFrags = tileBuilder.heightMaps[sz * fragmentSubSamples + sx];
+				auto const heightFrags = tileBuilder.heightMap( sz * fragmentSubSamples + sx );
 				TMapTBHeightFragment const *bfrag = (hmIndex < heightFrags.size()) ? &heightFrags[hmIndex]
 																				   : nullptr;
 				TMapTBHeightFragment const *tfrag = (hmIndex + 1 < heightFrags.size()) ? &heightFrags[hmIndex + 1]
@@ -780,9 +1154,16 @@ void TacticalMapBuilder::getValidFragmentsForTile( TacticalMapTileBuilder& tileB
 	}
 }
 
-void TacticalMapBuilder::generateHeightFragmentsForTileAt( TileCoord_t x, TileCoord_t z )
+// boxes and triangles come from the tile at (x, z), the results go in target
+void TacticalMapBuilder::generateHeightFragmentsForTileAt( TileCoord_t x, TileCoord_t z, uint32_t threadNum,
+														   TacticalMapTileBuilder& target )
 {
-	auto& tileBuilder = tileBuilders[z * width + x];
+	auto const& tileBuilder = tileBuilders[z * width + x];
+	auto& heightMaps = fragmentScratches[threadNum];
+	for(auto& heightMap : heightMaps)
+	{
+		heightMap.clear();
+	}
 
 	// generate a ray bundle
 	typedef std::tuple<Geometry::WaterTightRay, int, int> RayTuple;
@@ -806,120 +1187,213 @@ void TacticalMapBuilder::generateHeightFragmentsForTileAt( TileCoord_t x, TileCo
 		}
 	}
 
-	// boxes are easiest, lets start with them
-	// TODO we know this an AABB so we don't need to use ray casting at all
-	// but it fairly fast and
-	// provides some sanity test for me for the next harder stage
-	for(auto const& [solidIndex, box] : tileBuilder.boxes)
+	// boxes are axis aligned so don't need ray casting at all
+	generateBoxFragmentsForTile( tileBuilder, heightMaps, lb, inc );
+	if(validateBoxFragments)
 	{
-		// todo simd and parallel this raybundle (tho see above before you do!)
-		for(auto const[ray, sx, sz] : rayBundle)
+		validateBoxFragmentsForTileAt( x, z, heightMaps, lb, inc );
+	}
+
+	// lets do the triangles (if this is too slow use KDTree/RayCaster)
+	using namespace MeshMod;
+	VertexIndexContainer polyVertIndices;
+	polyVertIndices.reserve( 3 );
+
+	visitTileTriangles( tileBuilder, [&]( size_t solidIndex, PolygonIndex polygonIndex )
+	{
+		auto const& mesh = solids[solidIndex].mesh;
+		Vertices const& vertices = mesh->getVertices();
+		Polygons const& polygons = mesh->getPolygons();
+		auto const& planeEqs = polygons.getAttribute<PolygonData::PlaneEquations>();
+
+		polyVertIndices.clear();
+		polygons.getVertexIndices( polygonIndex, polyVertIndices );
+		assert( polyVertIndices.size() == 3 );
+		Math::vec3 v0, v1, v2;
+		v0 = vertices.position( polyVertIndices[0] ).getVec3();
+		v1 = vertices.position( polyVertIndices[1] ).getVec3();
+		v2 = vertices.position( polyVertIndices[2] ).getVec3();
+
+		// todo simd and parallel this raybundle
+		for(auto const& [ray, sx, sz] : rayBundle)
 		{
-			float minT, maxT;
-			bool hit = ray.intersectsAABB( box, minT, maxT );
+			float v, w, t;
+			bool hit = ray.intersectsTriangle( v0, v1, v2, v, w, t );
 			if(hit)
 			{
-				if(std::isfinite( minT ))
-				{
-					tileBuilder.heightMaps[sz * fragmentSubSamples + sx].push_back( { downVector, minT + rayMinHeight, solidIndex } );
-				}
-				if(std::isfinite( maxT ))
-				{
-					tileBuilder.heightMaps[sz * fragmentSubSamples + sx].push_back( { upVector, maxT + rayMinHeight, solidIndex } );
-				}
+				t = t + rayMinHeight;
+				heightMaps[sz * fragmentSubSamples + sx].emplace_back(
+						planeEqs[polygonIndex].planeEq.normal(), t, solidIndex );
 			}
 		}
-	}
-	// lets do the triangles (if this is too slow use KDTree/RayCaster)
-	for(auto const[solidIndex, polygonIndexList] : tileBuilder.polygons)
+	} );
+	processHeightsForTile( target, heightMaps, fragmentArenas[threadNum] );
+
+}
+
+void TacticalMapBuilder::generateBoxFragmentsForTile( TacticalMapTileBuilder const& tileBuilder,
+													  FragmentScratch& heightMaps,
+													  Math::vec2 const& lb,
+													  Math::vec2 const& inc ) const
+{
+	static Math::vec3 const upVector( 0, 1, 0 );
+	static Math::vec3 const downVector( 0, -1, 0 );
+	float const lastSample = (float) (fragmentSubSamples - 1);
+
+	for(auto const& [solidIndex, box] : tileBuilder.boxes)
 	{
-		auto [mesh, box, levelData] = solids[solidIndex];
+		// sub sample s is at lb + s * inc, find the ones inside the boxes footprint (inclusive)
+		Math::vec3 const bmin = box.getMinExtent();
+		Math::vec3 const bmax = box.getMaxExtent();
+		int const sx0 = (int) Math::clamp( std::ceil( (bmin.x - lb.x) / inc.x ), 0.0f, lastSample + 1.0f );
+		int const sx1 = (int) Math::clamp( std::floor( (bmax.x - lb.x) / inc.x ), -1.0f, lastSample );
+		int const sz0 = (int) Math::clamp( std::ceil( (bmin.z - lb.y) / inc.y ), 0.0f, lastSample + 1.0f );
+		int const sz1 = (int) Math::clamp( std::floor( (bmax.z - lb.y) / inc.y ), -1.0f, lastSample );
+
+		// every covered column sees the same bottom and top
+		for(int sz = sz0; sz <= sz1; ++sz)
+		{
+			for(int sx = sx0; sx <= sx1; ++sx)
+			{
+				auto& heightMap = heightMaps[sz * fragmentSubSamples + sx];
+				heightMap.emplace_back( downVector, bmin.y, solidIndex );
+				heightMap.emplace_back( upVector, bmax.y, solidIndex );
+			}
+		}
+	}
+}
 
-		using namespace MeshMod;
-		Vertices const& vertices = mesh->getVertices();
-		Polygons const& polygons = mesh->getPolygons();
-		auto const& planeEqs = polygons.getAttribute<PolygonData::PlaneEquations>();
-		VertexIndexContainer polyVertIndices;
-		polyVertIndices.reserve( 3 );
+// called after generateBoxFragmentsForTile and before anything else adds fragments
+void TacticalMapBuilder::validateBoxFragmentsForTileAt( TileCoord_t x, TileCoord_t z,
+														FragmentScratch const& heightMaps,
+														Math::vec2 const& lb,
+														Math::vec2 const& inc )
+{
+	static Math::vec3 const rayDir( 0, 1, 0 );
+	auto const& tileBuilder = tileBuilders[z * width + x];
 
-		for(auto const polygonIndex : polygonIndexList)
+	uint32_t mismatches = 0;
+	std::vector<float> rayTs;
+	for(int sz = 0; sz < fragmentSubSamples; ++sz)
+	{
+		for(int sx = 0; sx < fragmentSubSamples; ++sx)
 		{
-			polyVertIndices.clear();
-			polygons.getVertexIndices( polygonIndex, polyVertIndices );
-			assert( polyVertIndices.size() == 3 );
-			Math::vec3 v0, v1, v2;
-			v0 = vertices.position( polyVertIndices[0] ).getVec3();
-			v1 = vertices.position( polyVertIndices[1] ).getVec3();
-			v2 = vertices.position( polyVertIndices[2] ).getVec3();
-
-			// todo simd and parallel this raybundle
-			for(auto const[ray, sx, sz] : rayBundle)
+			Math::vec3 const origin( lb.x + (sx * inc.x), rayMinHeight, lb.y + (sz * inc.y));
+			Geometry::WaterTightRay const ray( origin, rayDir );
+
+			// the ray path gives infinite or nan distances for rays exactly on a side of a box
+			// so those samples can't be compared
+			bool onSide = false;
+			rayTs.clear();
+			for(auto const& [solidIndex, box] : tileBuilder.boxes)
 			{
-				float v, w, t;
-				bool hit = ray.intersectsTriangle( v0, v1, v2, v, w, t );
-				if(hit)
+				Math::vec3 const bmin = box.getMinExtent();
+				Math::vec3 const bmax = box.getMaxExtent();
+				onSide |= (origin.x == bmin.x || origin.x == bmax.x || origin.z == bmin.z || origin.z == bmax.z);
+
+				float minT, maxT;
+				if(ray.intersectsAABB( box, minT, maxT ))
 				{
-					t = t + rayMinHeight;
-					tileBuilder.heightMaps[sz * fragmentSubSamples + sx].push_back(
-							{planeEqs[polygonIndex].planeEq.normal(), t, solidIndex } );
+					if(std::isfinite( minT )) rayTs.push_back( minT + rayMinHeight );
+					if(std::isfinite( maxT )) rayTs.push_back( maxT + rayMinHeight );
+				}
+			}
+			if(onSide) continue;
+
+			auto const& heightMap = heightMaps[sz * fragmentSubSamples + sx];
+			if(heightMap.size() != rayTs.size())
+			{
+				mismatches++;
+				continue;
+			}
+			for(size_t i = 0; i < rayTs.size(); ++i)
+			{
+				// the ray path loses precision adding rayMinHeight back on
+				float const tolerance = 1e-4f + 1e-6f * (std::abs( rayMinHeight ) + std::abs( rayTs[i] ));
+				if(std::abs( heightMap[i].t - rayTs[i] ) > tolerance)
+				{
+					mismatches++;
+					break;
 				}
 			}
 		}
 	}
-	processHeightsForTile( tileBuilder );
 
+	if(mismatches > 0)
+	{
+		LOG_F(WARNING, "Tile %d, %d has %u box fragment columns that differ from ray casting", x, z, mismatches);
+		boxFragmentMismatches += mismatches;
+	}
 }
 
-void TacticalMapBuilder::processHeightsForTile( TacticalMapTileBuilder& tileBuilder )
+void TacticalMapBuilder::processHeightsForTile( TacticalMapTileBuilder& tileBuilder,
+												  FragmentScratch& heightMaps,
+												  TMapTBFragmentArena& arena )
 {
 	// count and sort fragments
+	tileBuilder.layers.clear();
 	tileBuilder.maxLayers = 0;
-	TacticalMapTileBuilder::TMapTBHeightFragmentList cloneList;
+	uint32_t fragmentCount = 0;
 
-	for(int sz = 0; sz < fragmentSubSamples; ++sz)
+	for(auto& fragList : heightMaps)
 	{
-		for(int sx = 0; sx < fragmentSubSamples; ++sx)
+		// usually only a handful per sub sample so insertion sort
+		for(size_t i = 1; i < fragList.size(); ++i)
 		{
-			auto& fragList = tileBuilder.heightMaps[sz * fragmentSubSamples + sx];
-
-			std::sort( fragList.begin(), fragList.end(),
-					   []( TMapTBHeightFragment const& lhs, TMapTBHeightFragment const& rhs )
-					   {
-						   return lhs.t < rhs.t;
-					   } );
+			TMapTBHeightFragment const frag = fragList[i];
+			size_t j = i;
+			while(j > 0 && frag.t < fragList[j - 1].t)
+			{
+				fragList[j] = fragList[j - 1];
+				j--;
+			}
+			fragList[j] = frag;
+		}
 
-			// by counting crossing we know in/out
-			bool outside = true;
+		// by counting crossing we know in/out
+		// and compact the accepted ones in place
+		bool outside = true;
+		size_t accepted = 0;
+		for(size_t i = 0; i < fragList.size(); i++)
+		{
+			auto const& frag = fragList[i];
+			float const ny = frag.normal().y;
+			bool reject = false;
+			reject |= (outside && (ny < -0.9f));
+			reject |= (!outside && (ny > 0.9f));
 
-			if(fragList.size() > 0)
+			if(!reject)
 			{
-				cloneList = fragList;
-				fragList.clear();
-				float const closeEnough = 0.01f; // 1cm
-				float lastT = -FLT_MAX;
-				size_t lastSolid = ~0;
-
-				for(auto i = 0u; i < cloneList.size(); i++)
-				{
-					auto& frag = cloneList[i];
-					bool reject = false;
-					reject |= (outside && (frag.n.y < -0.9f));
-					reject |= (!outside && (frag.n.y > 0.9f));
+				fragList[accepted++] = frag;
+				outside ^= true;
+			}
+		}
+		fragList.resize( accepted );
+		tileBuilder.maxLayers = std::max( tileBuilder.maxLayers, (int) fragList.size());
+		fragmentCount += (uint32_t) fragList.size();
+	}
 
-					// reject very close fragment from the same objects
-//					reject |= (frag.solidIndex == lastSolid) && (abs( frag.t - lastT ) < closeEnough);
+	// copy the tiles fragments into the arena
+	tileBuilder.fragmentStarts = nullptr;
+	tileBuilder.fragments = nullptr;
+	if(fragmentCount > 0)
+	{
+		size_t const startsSize = sizeof(uint32_t) * (heightMaps.size() + 1);
+		uint8_t* const memory = arena.alloc( startsSize + sizeof(TMapTBHeightFragment) * fragmentCount );
+		auto const starts = (uint32_t*) memory;
+		auto const fragments = (TMapTBHeightFragment*) (memory + startsSize);
 
-					if(!reject)
-					{
-						fragList.push_back( frag );
-						lastT = frag.t;
-						lastSolid = frag.solidIndex;
-						outside ^= true;
-					}
-				}
-				tileBuilder.maxLayers = std::max( tileBuilder.maxLayers, (int) fragList.size());
-			}
+		uint32_t start = 0;
+		for(size_t i = 0; i < heightMaps.size(); ++i)
+		{
+			starts[i] = start;
+			std::copy( heightMaps[i].begin(), heightMaps[i].end(), fragments + start );
+			start += (uint32_t) heightMaps[i].size();
 		}
+		starts[heightMaps.size()] = start;
+
+		tileBuilder.fragmentStarts = starts;
+		tileBuilder.fragments = fragments;
 	}
 
 	// integer round to nearest is wanted (not trunc to zero)
@@ -947,19 +1421,20 @@ void TacticalMapBuilder::calculateHeightMapMeanAndStandardDeviation( TacticalMap
 		std::vector<size_t> floorSolidIndexHistogram(solids.size());
 		std::vector<size_t> ceilSolidIndexHistogram(solids.size());
 
-		for(auto const& heightFrags : tileBuilder.heightMaps)
+		for(size_t i = 0; i < fragmentSubSamples * fragmentSubSamples; ++i)
 		{
+			auto const heightFrags = tileBuilder.heightMap( i );
 			TMapTBHeightFragment const *bfrag = (hmIndex < heightFrags.size()) ? &heightFrags[hmIndex] : nullptr;
 			TMapTBHeightFragment const *tfrag = (hmIndex + 1 < heightFrags.size()) ? &heightFrags[hmIndex + 1]
 																				   : nullptr;
 
-			if(bfrag && bfrag->n.y > maxFloorInclination)
+			if(bfrag && bfrag->normal().y > maxFloorInclination)
 			{
 				layer.floorMean += bfrag->t;
 				floorSolidIndexHistogram[bfrag->solidIndex]++;
 				floorValidFragmentCount++;
 			}
-			if(tfrag && tfrag->n.y < -maxFloorInclination)
+			if(tfrag && tfrag->normal().y < -maxFloorInclination)
 			{
 				layer.ceilMean += tfrag->t;
 				floorSolidIndexHistogram[tfrag->solidIndex]++;
@@ -994,8 +1469,9 @@ void TacticalMapBuilder::calculateHeightMapMeanAndStandardDeviation( TacticalMap
 		}
 
 		// now std deviation
-		for(auto const& heightFrags : tileBuilder.heightMaps)
+		for(size_t i = 0; i < fragmentSubSamples * fragmentSubSamples; ++i)
 		{
+			auto const heightFrags = tileBuilder.heightMap( i );
 			TMapTBHeightFragment const *bfrag = (hmIndex < heightFrags.size()) ? &heightFrags[hmIndex] : nullptr;
 			TMapTBHeightFragment const *tfrag = (hmIndex + 1 < heightFrags.size()) ? &heightFrags[hmIndex + 1]
 																				   : nullptr;
@@ -1026,28 +1502,27 @@ void TacticalMapBuilder::calculateHeightMapMeanAndStandardDeviation( TacticalMap
 
 }
 
-void TacticalMapBuilder::generateStructuralBoxesForTileAt( TileCoord_t x, TileCoord_t z )
+void TacticalMapBuilder::generateStructuralBoxes()
 {
-	auto& tileBuilder = tileBuilders[z * width + x];
-
-	Math::vec3 bl( bottomLeft.x, 0, bottomLeft.y );
-	Math::vec3 tr( bl + Math::vec3( extentIncrement.x, 0, extentIncrement.y ));
-
 	// pass 1 determine structural type and calculate bonds
-	tileBuilder.structuralBoxs.clear();
-	tileBuilder.structuralBoxs.resize(solids.size());
-	for (size_t i = 0; i < tileBuilder.structuralBoxs.size(); i++)
+	structuralBoxs.clear();
+	structuralBoxs.resize(solids.size());
+	for (size_t i = 0; i < structuralBoxs.size(); i++)
 	{
+		if (isSolidRemoved(i)) continue;
+
 		WorldSolid const& solid = solids[i];
-		auto& sbox = tileBuilder.structuralBoxs[i];
+		auto& sbox = structuralBoxs[i];
 		sbox.structuralIntegrity = 0;
 		sbox.structuralType = DetermineStructuralType(solid);
 
 		Geometry::AABB bbox = solid.aabb;
 		bbox.expandBy(Math::vec3(1.01f, 1.01f, 1.01f));
-		for (size_t j = i + 1; j < tileBuilder.structuralBoxs.size(); j++)
+		for (size_t j = i + 1; j < structuralBoxs.size(); j++)
 		{
-			TMapTBStructuralBox& osbox = tileBuilder.structuralBoxs[j];
+			if (isSolidRemoved(j)) continue;
+
+			TMapTBStructuralBox& osbox = structuralBoxs[j];
 			WorldSolid const& other = solids[j];
 			Geometry::AABB obox = other.aabb;
 			if (bbox.intersects(obox))
@@ -1060,16 +1535,14 @@ void TacticalMapBuilder::generateStructuralBoxesForTileAt( TileCoord_t x, TileCo
 		}
 	}
 
-	
 	// pass 2 calculate structural integrity
-	for (size_t i = 0; i < tileBuilder.structuralBoxs.size(); i++)
+	for (size_t i = 0; i < structuralBoxs.size(); i++)
 	{
-		TMapTBStructuralBox& sbox = tileBuilder.structuralBoxs[i];
+		TMapTBStructuralBox& sbox = structuralBoxs[i];
 
 		bool hasDownwardBond = false;
 		for (auto const& bond : sbox.bonds)
 		{
-			TMapTBStructuralBox& osbox = tileBuilder.structuralBoxs[bond.otherIndex];
 			switch (bond.direction)
 			{
 			case Cardinal::Above: sbox.structuralIntegrity++; break;
@@ -1087,6 +1560,11 @@ void TacticalMapBuilder::generateStructuralBoxesForTileAt( TileCoord_t x, TileCo
 			sbox.structuralType = StructuralType::World;
 		}
 	}
+}
+
+void TacticalMapBuilder::generateStructuralBoxesForTileAt( TileCoord_t x, TileCoord_t z )
+{
+	auto& tileBuilder = tileBuilders[z * width + x];
 
 	// propogate structural boxes into the layers
 	for (auto const&[solidIndex, box] : tileBuilder.destructables)
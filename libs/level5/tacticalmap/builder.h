@@ -17,14 +17,88 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <array>
+#include <atomic>
 
 static int const fragmentSubSamples = 16; // ^2 samples per tile
+static uint32_t const InvalidSolidIndex = ~0u; // no solid covers the sample
 
+// 12 bytes, there can be hundreds of these per tile so the normal is octahedral encoded
 struct TMapTBHeightFragment
 {
-	Math::vec3 n;
+	TMapTBHeightFragment() = default;
+	TMapTBHeightFragment(Math::vec3 const& n_, float t_, size_t solidIndex_) :
+		t(t_), solidIndex((uint32_t)solidIndex_)
+	{
+		assert(solidIndex_ < InvalidSolidIndex);
+		auto const oct = Math::EncodeOctahedral(n_);
+		nx = oct[0];
+		ny = oct[1];
+	}
+
+	Math::vec3 normal() const { return Math::DecodeOctahedral(nx, ny); }
+
 	float t;
-	size_t solidIndex;
+	uint32_t solidIndex;
+	int16_t nx, ny;
+};
+
+// a view of one sub samples fragments
+struct TMapTBFragmentSpan
+{
+	TMapTBHeightFragment const* first = nullptr;
+	uint32_t count = 0;
+
+	size_t size() const { return count; }
+	TMapTBHeightFragment const& operator[](size_t i_) const { assert(i_ < count); return first[i_]; }
+	TMapTBHeightFragment const* begin() const { return first; }
+	TMapTBHeightFragment const* end() const { return first + count; }
+};
+
+// Simple block allocator, one per thread so tiles can allocate fragments without locks.
+// Blocks never move so pointers stay valid until reset
+class TMapTBFragmentArena
+{
+public:
+	static size_t const BlockSize = 4 * 1024 * 1024;
+
+	// 4 byte aligned
+	uint8_t* alloc(size_t size_)
+	{
+		size_ = (size_ + 3) & ~size_t(3);
+		if(size_ > BlockSize)
+		{
+			// too big to share a block so gets its own
+			blocks.emplace_back(new uint8_t[size_]);
+			allocatedBytes += size_;
+			return blocks.back().get();
+		}
+		if(current == nullptr || used + size_ > BlockSize)
+		{
+			blocks.emplace_back(new uint8_t[BlockSize]);
+			allocatedBytes += BlockSize;
+			current = blocks.back().get();
+			used = 0;
+		}
+		uint8_t* ptr = current + used;
+		used += size_;
+		return ptr;
+	}
+
+	void reset()
+	{
+		blocks.clear();
+		current = nullptr;
+		used = 0;
+		allocatedBytes = 0;
+	}
+
+	size_t getAllocatedBytes() const { return allocatedBytes; }
+
+private:
+	std::vector<std::unique_ptr<uint8_t[]>> blocks;
+	uint8_t* current = nullptr;
+	size_t used = 0;
+	size_t allocatedBytes = 0;
 };
 
 struct Bond
@@ -73,24 +147,27 @@ struct TMapTBLayer
 struct TacticalMapTileBuilder
 {
 	~TacticalMapTileBuilder();
-	using MeshPolygons = std::unordered_set<MeshMod::PolygonIndex>;
-	using TMapTBHeightFragmentList = std::vector<TMapTBHeightFragment>;
 	using TMapTBLayerList = std::vector<TMapTBLayer>;
 	int maxLayers;
 
-	std::unordered_map<size_t, MeshPolygons> polygons;
+	// this tiles range of TacticalMapBuilder::binnedTriangles
+	uint32_t binnedTriangleStart = 0;
+	uint32_t binnedTriangleCount = 0;
 	std::unordered_map<size_t, Geometry::AABB> boxes;
 	std::unordered_map<size_t, Geometry::AABB> destructables;
 
-	using StructuralBoxList = std::vector<TMapTBStructuralBox>;
-	using BondList = std::vector<Bond>;
-	StructuralBoxList structuralBoxs;
-	BondList bonds;
-
-	// TODO using a vector for std::sort but this isn't ideal
-	std::array<TMapTBHeightFragmentList, fragmentSubSamples * fragmentSubSamples> heightMaps;
+	// sub sample i's fragments are fragments[fragmentStarts[i], fragmentStarts[i + 1]) sorted by t
+	// both are in a TacticalMapBuilder fragment arena and null if the tile has no fragments
+	uint32_t const* fragmentStarts = nullptr;
+	TMapTBHeightFragment const* fragments = nullptr;
 	TMapTBLayerList layers;
 
+	TMapTBFragmentSpan heightMap(size_t i_) const
+	{
+		if(fragmentStarts == nullptr) return {};
+		return { fragments + fragmentStarts[i_], fragmentStarts[i_ + 1] - fragmentStarts[i_] };
+	}
+
 };
 
 
@@ -126,15 +203,40 @@ public:
 	std::vector<WorldSolid> solids;
 
 	std::vector<TacticalMapTileBuilder> tileBuilders;
-	std::unique_ptr<FragmentTexture> globalFragmentTexture;
-	std::unique_ptr<MeshOps::LayeredTexture > smoothLayerTexture;
+
+	// a global triangle index is solidTriangleStart[solidIndex] + polygonIndex
+	// binnedTriangles holds each tiles sorted global triangle indices back to back
+	std::vector<uint32_t> solidTriangleStart;
+	std::vector<uint32_t> binnedTriangles;
+
+	// structural type and integrity of each solid, doesn't depend on the tile
+	using StructuralBoxList = std::vector<TMapTBStructuralBox>;
+	StructuralBoxList structuralBoxs;
+
+	// per thread lists the fragments for the tile being generated are collected in
+	using FragmentScratch = std::array<std::vector<TMapTBHeightFragment>, fragmentSubSamples * fragmentSubSamples>;
 
 	void setMinimumHeight(float height_) final { rayMinHeight = height_; };
 	void setMaximumFloorInclination(float angleInRadians_) final { maxFloorInclination = angleInRadians_; };
 	void setLevelDataSize(uint32_t size_) final { tacticalLevelDataSize = size_; }
-	void addMeshAt(MeshMod::MeshPtr const& mesh, TacticalMapLevelDataHeader const* levelData, Math::mat4x4 const& transform) final;
-	void addBoxAt( Geometry::AABB const& box, TacticalMapLevelDataHeader const* levelData, Math::mat4x4 const& transform) final;
+	void setValidateBoxFragments(bool validate_) final { validateBoxFragments = validate_; }
+	void setRegionSize(uint32_t tiles_) final { assert(tiles_ > 0); regionSize = (TileCoord_t) tiles_; }
+	void setTileLayout(TacticalMapTileLayout layout_) final { tileLayout = layout_; }
+	uint32_t addMeshAt(MeshMod::MeshPtr const& mesh, TacticalMapLevelDataHeader const* levelData, Math::mat4x4 const& transform) final;
+	uint32_t addBoxAt( Geometry::AABB const& box, TacticalMapLevelDataHeader const* levelData, Math::mat4x4 const& transform) final;
+	void removeSolid(uint32_t solidId_) final;
+	void updateSolidTransform(uint32_t solidId_, Math::mat4x4 const& transform_) final;
 	std::shared_ptr<TacticalMap> build() override;
+	TacticalMapBuildStats const& getBuildStats() const final { return buildStats; }
+
+	// removed solids keep their index so others don't move but are otherwise ignored
+	bool isSolidRemoved(size_t solidIndex_) const { return solidSources[solidIndex_].removed; }
+
+	// how many box fragments validation found different during the last build
+	uint32_t getBoxFragmentMismatches() const { return boxFragmentMismatches.load(); }
+
+	// calls func(solidIndex, polygonIndex) for each triangle binned into the tile, in solid order
+	template<typename Func> void visitTileTriangles(TacticalMapTileBuilder const& tileBuilder, Func&& func) const;
 
 private:
 
@@ -151,20 +253,63 @@ private:
 	float maxFloorInclination = Math::degreesToRadians(30.0f);
 	uint32_t tacticalLevelDataSize = sizeof(TacticalMapLevelDataHeader);
 	std::vector<uint8_t> tacticalLevelDataHeap;
+	std::vector<FragmentScratch> fragmentScratches;
+	std::vector<TMapTBFragmentArena> fragmentArenas;
+	// per thread layer phase times, merged into buildStats after the regions are done
+	struct RegionStats
+	{
+		double fragments = 0;
+		double smoothing = 0;
+		double planes = 0;
+		double destruction = 0;
+		double busy = 0;
+		uint32_t regions = 0;
+		size_t peakFragmentBytes = 0;
+	};
+	std::vector<RegionStats> regionStats;
+	TacticalMapBuildStats buildStats;
+	TileCoord_t regionSize = 16;
+	TacticalMapTileLayout tileLayout = TacticalMapTileLayout::RowMajor;
+
+	// what each solid was added from so it can be placed again with a new transform
+	struct SolidSource
+	{
+		MeshMod::MeshPtr mesh;
+		Geometry::AABB box;
+		bool removed = false;
+	};
+	std::vector<SolidSource> solidSources;
+
+	// tiles whose layers the next build must regenerate, everything is dirty before the first build
+	std::vector<uint8_t> dirtyTiles;
+	bool validateBoxFragments = false;
+	std::atomic<uint32_t> boxFragmentMismatches{ 0 };
+
+	void placeSolid(size_t solidIndex, Math::mat4x4 const& transform);
+	void markDirty(Geometry::AABB const& box);
 
 	// building functions
+	void binTriangles();
+	void insertSolidBoxes();
+	bool writeTileLevels(TacticalMapTileBuilder const& tileBuilder, TacticalMapTile& tile, TacticalMapTileLevel* levels, uint8_t* levelDatasByte) const;
+	void calculateMapHeights();
 	void generateLayers();
-	void generateHeightFragmentsForTileAt(TileCoord_t x, TileCoord_t z);
-	void generatePlanesForTileAt(TileCoord_t x, TileCoord_t z);
+	void generateLayersForRegion(TileCoord_t regionX, TileCoord_t regionZ, uint32_t threadNum);
+	void generateHeightFragmentsForTileAt(TileCoord_t x, TileCoord_t z, uint32_t threadNum, TacticalMapTileBuilder& target);
+	void generateBoxFragmentsForTile(TacticalMapTileBuilder const& tileBuilder, FragmentScratch& heightMaps, Math::vec2 const& lb, Math::vec2 const& inc) const;
+	void validateBoxFragmentsForTileAt(TileCoord_t x, TileCoord_t z, FragmentScratch const& heightMaps, Math::vec2 const& lb, Math::vec2 const& inc);
+	void generatePlanesForTileAt(TileCoord_t x, TileCoord_t z, MeshOps::LayeredTexture const& smoothTexture, TileCoord_t textureX, TileCoord_t textureZ);
+	void generateStructuralBoxes();
 	void generateStructuralBoxesForTileAt(TileCoord_t x, TileCoord_t z);
 
 	void getValidFragmentsForTile(	TacticalMapTileBuilder& tileBuilder);
-	void processHeightsForTile( TacticalMapTileBuilder& tileBuilder );
+	void processHeightsForTile( TacticalMapTileBuilder& tileBuilder, FragmentScratch& heightMaps, TMapTBFragmentArena& arena );
 
 	void calculateHeightMapMeanAndStandardDeviation( TacticalMapTileBuilder& tileBuilder );
 
-	void generateGlobalFragmentTexture();
-	void smoothGlobalFragmentTexture();
+	auto generateFragmentTexture(std::vector<TacticalMapTileBuilder const*> const& regionTiles, TileCoord_t tilesWide, TileCoord_t tilesHigh) const -> std::unique_ptr<FragmentTexture>;
+	auto smoothFragmentTexture(FragmentTexture const& fragmentTexture, TileCoord_t textureX, TileCoord_t textureZ,
+			TileCoord_t x0, TileCoord_t z0, TileCoord_t x1, TileCoord_t z1) const -> std::unique_ptr<MeshOps::LayeredTexture>;
 	
 	auto DetermineStructuralType(WorldSolid const& solid_)->StructuralType;
 
@@ -184,5 +329,22 @@ inline void TacticalMapBuilder::worldToLocal(Math::vec3 const& world, TileCoord_
 	outY = (TileCoord_t) std::floor(local.y);
 }
 
+template<typename Func>
+inline void TacticalMapBuilder::visitTileTriangles(TacticalMapTileBuilder const& tileBuilder, Func&& func) const
+{
+	// the bin is sorted so the solid only ever moves forward
+	size_t solidIndex = 0;
+	uint32_t const* const bin = binnedTriangles.data() + tileBuilder.binnedTriangleStart;
+	for(uint32_t i = 0; i < tileBuilder.binnedTriangleCount; ++i)
+	{
+		uint32_t const triangleIndex = bin[i];
+		while(solidIndex + 1 < solids.size() && triangleIndex >= solidTriangleStart[solidIndex + 1])
+		{
+			solidIndex++;
+		}
+		func(solidIndex, MeshMod::PolygonIndex(triangleIndex - solidTriangleStart[solidIndex]));
+	}
+}
+
 #endif //NATIVESNAPSHOT_TACTICALMAP_BUILDER_H
 
@@ -0,0 +1,192 @@
+#include "core/core.h"
+#include "core/sharedtasks.h"
+#include "tacticalmap.h"
+#include <atomic>
+#include <cmath>
+
+namespace {
+// each sight line walks many tiles, so smaller batches than lookups are worth splitting
+static const size_t SightQueriesPerTask = 256;
+// heights up an agent traced to for cover
+static const int CoverSamples = 4;
+
+// floors and roofs at the edges of solids can pick up a side face normal, anything steeper than this
+// is taken as flat rather than extrapolated across the tile
+static const float SteepestSlabNormalY = 0.25f;
+
+// height of the plane through height_ at the tile centre at world x z
+float PlaneHeight(Math::vec3 const& normal_, float const height_, float const dx_, float const dz_)
+{
+	if(std::abs(normal_.y) < SteepestSlabNormalY) return height_;
+	return height_ - ((normal_.x * dx_) + (normal_.z * dz_)) / normal_.y;
+}
+
+// runs func_(i) for every query, large batches are split across the task threads
+template<typename Func>
+void VisitSightQueries(size_t const count_, Func&& func_)
+{
+	Core::ParallelFor((uint32_t) count_, (uint32_t) SightQueriesPerTask,
+					  [&func_](uint32_t const begin_, uint32_t const end_, uint32_t)
+					  {
+						  for(auto i = begin_; i < end_; ++i)
+						  {
+							  func_(i);
+						  }
+					  });
+}
+
+}
+
+bool TacticalMap::isOpenInTile(int x_, int z_, Math::vec3 const& a_, Math::vec3 const& b_, uint32_t const levelMask_) const
+{
+	TacticalMapTile const& tile = getTile(x_, z_);
+	if(tile.levelCount == 0) return true;
+
+	float const centreX = bottomLeft.x + x_;
+	float const centreZ = bottomLeft.y + z_;
+	float const adx = a_.x - centreX;
+	float const adz = a_.z - centreZ;
+	float const bdx = b_.x - centreX;
+	float const bdz = b_.z - centreZ;
+
+	// floors and roofs are planes and the segment is straight, so its inside if both ends are
+	float floorA = 0, floorB = 0;
+	float roofA = 0, roofB = 0;
+	auto const inside = [&]()
+	{
+		return a_.y >= floorA && a_.y <= roofA && b_.y >= floorB && b_.y <= roofB;
+	};
+
+	for(auto levelIndex = 0u; levelIndex < tile.levelCount; ++levelIndex)
+	{
+		TacticalMapTileLevel const& level = getLevel(tile, levelIndex);
+		bool const blocks = !isLevelDestroyed(tile, levelIndex) &&
+							(Core::Bit(level.layer) & levelMask_) != 0;
+
+		// a floor that doesn't block leaves the open space below carrying on up to this levels roof
+		if(blocks || levelIndex == 0)
+		{
+			if(levelIndex != 0 && inside()) return true;
+
+			float const floorHeight = getLevelHeight(tile, level);
+			Math::vec3 const floorNormal = getFloorNormal(level);
+			floorA = PlaneHeight(floorNormal, floorHeight, adx, adz);
+			floorB = PlaneHeight(floorNormal, floorHeight, bdx, bdz);
+		}
+
+		float const roofHeight = getRoofHeight(tile, level);
+		if(std::isinf(roofHeight))
+		{
+			roofA = roofB = roofHeight;
+		} else
+		{
+			Math::vec3 const roofNormal = getRoofNormal(level);
+			roofA = PlaneHeight(roofNormal, roofHeight, adx, adz);
+			roofB = PlaneHeight(roofNormal, roofHeight, bdx, bdz);
+		}
+	}
+
+	// there is no floor above the top roof to say how thick it is, so above it is open
+	if(inside()) return true;
+	return a_.y >= roofA && b_.y >= roofB;
+}
+
+bool TacticalMap::traceLineOfSight(Math::vec3 const& from_, Math::vec3 const& to_, uint32_t const levelMask_,
+								   float* blockedAt_) const
+{
+	// tile x covers [x, x + 1) in these coordinates
+	float const ux = from_.x - bottomLeft.x + 0.5f;
+	float const uz = from_.z - bottomLeft.y + 0.5f;
+	Math::vec3 const delta = to_ - from_;
+
+	// clip to the map, off the map is open
+	float tEnter = 0.0f;
+	float tExit = 1.0f;
+	auto const clip = [&tEnter, &tExit](float const start_, float const d_, float const size_)
+	{
+		if(d_ == 0.0f) return start_ >= 0.0f && start_ < size_;
+		float t0 = (0.0f - start_) / d_;
+		float t1 = (size_ - start_) / d_;
+		if(t0 > t1) std::swap(t0, t1);
+		tEnter = std::max(tEnter, t0);
+		tExit = std::min(tExit, t1);
+		return tEnter <= tExit;
+	};
+	if(!clip(ux, delta.x, (float) width) || !clip(uz, delta.z, (float) height)) return true;
+
+	// 2d dda over the tiles the segment crosses
+	int x = Math::clamp((int) std::floor(ux + tEnter * delta.x), 0, width - 1);
+	int z = Math::clamp((int) std::floor(uz + tEnter * delta.z), 0, height - 1);
+	int const stepX = delta.x > 0.0f ? 1 : -1;
+	int const stepZ = delta.z > 0.0f ? 1 : -1;
+	float const infinity = std::numeric_limits<float>::infinity();
+	float const tDeltaX = delta.x != 0.0f ? std::abs(1.0f / delta.x) : infinity;
+	float const tDeltaZ = delta.z != 0.0f ? std::abs(1.0f / delta.z) : infinity;
+	float tMaxX = delta.x != 0.0f ? ((float) (stepX > 0 ? x + 1 : x) - ux) / delta.x : infinity;
+	float tMaxZ = delta.z != 0.0f ? ((float) (stepZ > 0 ? z + 1 : z) - uz) / delta.z : infinity;
+
+	float t = tEnter;
+	while(true)
+	{
+		float const tNext = std::min(std::min(tMaxX, tMaxZ), tExit);
+		if(!isOpenInTile(x, z, from_ + (delta * t), from_ + (delta * tNext), levelMask_))
+		{
+			if(blockedAt_ != nullptr) *blockedAt_ = t;
+			return false;
+		}
+		if(tNext >= tExit) break;
+
+		if(tMaxX < tMaxZ)
+		{
+			x += stepX;
+			tMaxX += tDeltaX;
+		} else
+		{
+			z += stepZ;
+			tMaxZ += tDeltaZ;
+		}
+		if(x < 0 || x >= width || z < 0 || z >= height) break;
+		t = tNext;
+	}
+
+	return true;
+}
+
+float TacticalMap::queryCover(Math::vec3 const& position_, Math::vec3 const& threat_, float const agentHeight_,
+							  uint32_t const levelMask_) const
+{
+	int hidden = 0;
+	for(int i = 0; i < CoverSamples; ++i)
+	{
+		float const height = agentHeight_ * ((float) i + 0.5f) / (float) CoverSamples;
+		if(!traceLineOfSight(threat_, position_ + Math::vec3(0, height, 0), levelMask_)) hidden++;
+	}
+	return (float) hidden / (float) CoverSamples;
+}
+
+size_t TacticalMap::traceLineOfSightBatch(TacticalMapSightQuery const* queries_, size_t const count_,
+										  uint32_t const levelMask_, uint8_t* out_) const
+{
+	assert((queries_ != nullptr && out_ != nullptr) || count_ == 0);
+	std::atomic<size_t> visible{ 0 };
+	VisitSightQueries(count_, [this, queries_, levelMask_, out_, &visible](size_t i)
+	{
+		bool const clear = traceLineOfSight(queries_[i].from, queries_[i].to, levelMask_);
+		out_[i] = clear ? 1 : 0;
+		if(clear) visible.fetch_add(1, std::memory_order_relaxed);
+	});
+	return visible.load();
+}
+
+size_t TacticalMap::queryCoverBatch(TacticalMapSightQuery const* queries_, size_t const count_, float const agentHeight_,
+									uint32_t const levelMask_, float* out_) const
+{
+	assert((queries_ != nullptr && out_ != nullptr) || count_ == 0);
+	std::atomic<size_t> hidden{ 0 };
+	VisitSightQueries(count_, [this, queries_, agentHeight_, levelMask_, out_, &hidden](size_t i)
+	{
+		out_[i] = queryCover(queries_[i].to, queries_[i].from, agentHeight_, levelMask_);
+		if(out_[i] >= 1.0f) hidden.fetch_add(1, std::memory_order_relaxed);
+	});
+	return hidden.load();
+}
@@ -0,0 +1,767 @@
+#include "core/core.h"
+#include "core/sharedtasks.h"
+#include "pathfinder.h"
+#include <algorithm>
+#include <numeric>
+#include <queue>
+#include <cmath>
+#include <thread>
+
+namespace {
+static float const DiagonalCost = 1.41421356f;
+static float const NoPath = std::numeric_limits<float>::infinity();
+
+// admissible for 8 way movement with diagonal steps costing sqrt 2
+float OctileDistance(int dx_, int dz_)
+{
+	float const dx = (float) std::abs(dx_);
+	float const dz = (float) std::abs(dz_);
+	return (dx + dz) + ((DiagonalCost - 2.0f) * std::min(dx, dz));
+}
+
+using OpenEntry = std::pair<float, uint32_t>;
+using OpenQueue = std::priority_queue<OpenEntry, std::vector<OpenEntry>, std::greater<OpenEntry>>;
+
+class TacticalMapPathBatch : public ITacticalMapPathBatch, public enki::ITaskSet
+{
+public:
+	TacticalMapPathBatch(std::shared_ptr<TacticalMapPathGraph const> graph_,
+						 TacticalMapPathQuery const* queries_,
+						 size_t count_,
+						 TacticalMapPath* out_) :
+			enki::ITaskSet((uint32_t) count_),
+			graph(std::move(graph_)),
+			queries(queries_),
+			out(out_) {}
+
+	~TacticalMapPathBatch() override { wait(); }
+
+	// enkiTS takes tasks from one outside thread at a time, if another has the scheduler the
+	// batch is done now on this thread instead
+	void submit()
+	{
+		std::unique_lock<std::recursive_mutex> lock(Core::SharedTasksMutex, std::try_to_lock);
+		if(lock.owns_lock() && g_EnkiTS.GetNumTaskThreads() > 1)
+		{
+			g_EnkiTS.AddTaskSetToPipe(this);
+			submitted = true;
+			return;
+		}
+		ExecuteRange({ 0, m_SetSize }, 0);
+	}
+
+	void ExecuteRange(enki::TaskSetPartition range_, uint32_t) override
+	{
+		for(auto i = range_.start; i < range_.end; ++i)
+		{
+			graph->findPath(queries[i], out[i]);
+		}
+	}
+
+	bool isComplete() const override { return !submitted || GetIsComplete(); }
+
+	// waiting runs tasks on the waiting thread so needs the scheduler too, without it just wait for the workers
+	void wait() override
+	{
+		if(!submitted) return;
+		std::unique_lock<std::recursive_mutex> lock(Core::SharedTasksMutex, std::try_to_lock);
+		if(lock.owns_lock())
+		{
+			g_EnkiTS.WaitforTask(this);
+			return;
+		}
+		while(!GetIsComplete())
+		{
+			std::this_thread::yield();
+		}
+	}
+
+private:
+	// keeps the graph the batch started with alive if the pathfinder updates while it runs
+	std::shared_ptr<TacticalMapPathGraph const> graph;
+	TacticalMapPathQuery const* queries;
+	TacticalMapPath* out;
+	bool submitted = false;
+};
+
+}
+
+TacticalMapPathGraph::TacticalMapPathGraph(std::shared_ptr<TacticalMap const> map_,
+										   TacticalMapPathSettings const& settings_) :
+		map(std::move(map_)),
+		settings(settings_)
+{
+	assert(map);
+	assert(settings.clusterSize > 0);
+
+	clustersWide = (map->getWidth() + settings.clusterSize - 1) / settings.clusterSize;
+	clustersHigh = (map->getHeight() + settings.clusterSize - 1) / settings.clusterSize;
+	buildLevelNodes(levelNodes);
+
+	borderPortals.resize(clustersWide * clustersHigh * 2);
+	clusterPortals.resize(clustersWide * clustersHigh);
+
+	std::vector<uint32_t> borders(borderPortals.size());
+	std::iota(borders.begin(), borders.end(), 0);
+	std::vector<uint32_t> clusters(clusterPortals.size());
+	std::iota(clusters.begin(), clusters.end(), 0);
+	buildClusters(borders, clusters);
+}
+
+void TacticalMapPathGraph::buildLevelNodes(std::vector<LevelNode>& out_) const
+{
+	out_.assign(map->levelCount, LevelNode{0, 0, 0.0f, 0.0f, false});
+
+	for(auto z = 0; z < map->getHeight(); ++z)
+	{
+		for(auto x = 0; x < map->getWidth(); ++x)
+		{
+			TacticalMapTile const& tile = map->getTile(x, z);
+			for(auto levelIndex = 0u; levelIndex < tile.levelCount; ++levelIndex)
+			{
+				TacticalMapTileLevel const& level = map->getLevel(tile, levelIndex);
+
+				LevelNode& node = out_[tile.levelStartIndex + levelIndex];
+				node.x = (int16_t) x;
+				node.z = (int16_t) z;
+				node.floor = TacticalMap::getLevelHeight(tile, level);
+				node.roof = TacticalMap::getRoofHeight(tile, level);
+
+				// levels whose structure has failed are treated as gone
+				node.walkable = !map->isLevelDestroyed(tile, levelIndex) &&
+								(Core::Bit(level.layer) & settings.levelMask) != 0 &&
+								(node.roof - node.floor) >= settings.agentHeight;
+			}
+		}
+	}
+}
+
+bool TacticalMapPathGraph::connects(LevelNode const& a_, LevelNode const& b_) const
+{
+	if(!a_.walkable || !b_.walkable) return false;
+	if(std::abs(b_.floor - a_.floor) > settings.maxStepHeight) return false;
+
+	// the agent has to fit under both roofs while stepping between the floors
+	float const headroom = std::min(a_.roof, b_.roof) - std::max(a_.floor, b_.floor);
+	return headroom >= settings.agentHeight;
+}
+
+template<typename Func>
+void TacticalMapPathGraph::visitNeighbours(uint32_t level_, Func&& func_) const
+{
+	static int const directions[8][2] = {
+			{1, 0}, {-1, 0}, {0, 1}, {0, -1},
+			{1, 1}, {1, -1}, {-1, 1}, {-1, -1}
+	};
+
+	LevelNode const& node = levelNodes[level_];
+
+	// diagonals can't cut corners, a level on each side has to join both ends
+	auto const cornerPassable = [this, &node](int x_, int z_, LevelNode const& to_)
+	{
+		TacticalMapTile const& tile = map->getTile(x_, z_);
+		for(auto levelIndex = 0u; levelIndex < tile.levelCount; ++levelIndex)
+		{
+			LevelNode const& corner = levelNodes[tile.levelStartIndex + levelIndex];
+			if(connects(node, corner) && connects(corner, to_)) return true;
+		}
+		return false;
+	};
+
+	for(auto const& direction : directions)
+	{
+		int const x = node.x + direction[0];
+		int const z = node.z + direction[1];
+		if(x < 0 || x >= map->getWidth() || z < 0 || z >= map->getHeight()) continue;
+
+		bool const diagonal = direction[0] != 0 && direction[1] != 0;
+		TacticalMapTile const& tile = map->getTile(x, z);
+		for(auto levelIndex = 0u; levelIndex < tile.levelCount; ++levelIndex)
+		{
+			uint32_t const neighbour = tile.levelStartIndex + levelIndex;
+			LevelNode const& to = levelNodes[neighbour];
+			if(!connects(node, to)) continue;
+			if(diagonal)
+			{
+				if(!cornerPassable(x, node.z, to)) continue;
+				if(!cornerPassable(node.x, z, to)) continue;
+			}
+			func_(neighbour, diagonal ? DiagonalCost : 1.0f);
+		}
+	}
+}
+
+uint32_t TacticalMapPathGraph::getClusterOf(LevelNode const& node_) const
+{
+	return (node_.z / settings.clusterSize) * clustersWide + (node_.x / settings.clusterSize);
+}
+
+auto TacticalMapPathGraph::makeClusterRegion(uint32_t cluster_) const -> Region
+{
+	int const clusterSize = (int) settings.clusterSize;
+	Region region;
+	region.x0 = (int) (cluster_ % clustersWide) * clusterSize;
+	region.z0 = (int) (cluster_ / clustersWide) * clusterSize;
+	region.x1 = std::min(region.x0 + clusterSize, map->getWidth());
+	region.z1 = std::min(region.z0 + clusterSize, map->getHeight());
+
+	region.tileBase.resize((region.x1 - region.x0) * (region.z1 - region.z0));
+	for(auto z = region.z0; z < region.z1; ++z)
+	{
+		for(auto x = region.x0; x < region.x1; ++x)
+		{
+			TacticalMapTile const& tile = map->getTile(x, z);
+			region.tileBase[(z - region.z0) * (region.x1 - region.x0) + (x - region.x0)] = (uint32_t) region.levels.size();
+			for(auto levelIndex = 0u; levelIndex < tile.levelCount; ++levelIndex)
+			{
+				region.levels.push_back(tile.levelStartIndex + levelIndex);
+			}
+		}
+	}
+	return region;
+}
+
+uint32_t TacticalMapPathGraph::toLocal(Region const& region_, uint32_t level_) const
+{
+	LevelNode const& node = levelNodes[level_];
+	assert(region_.contains(node.x, node.z));
+	TacticalMapTile const& tile = map->getTile(node.x, node.z);
+	uint32_t const tileIndex = (node.z - region_.z0) * (region_.x1 - region_.x0) + (node.x - region_.x0);
+	return region_.tileBase[tileIndex] + (level_ - tile.levelStartIndex);
+}
+
+float TacticalMapPathGraph::searchLocal(Region const& region_, uint32_t start_, uint32_t goal_,
+										 std::vector<uint32_t>* path_) const
+{
+	size_t const count = region_.levels.size();
+	std::vector<float> costs(count, NoPath);
+	std::vector<uint32_t> parents(count, InvalidIndex);
+	std::vector<bool> closed(count, false);
+
+	LevelNode const& goalNode = levelNodes[goal_];
+	auto const heuristic = [this, &goalNode](uint32_t level_)
+	{
+		LevelNode const& node = levelNodes[level_];
+		return OctileDistance(node.x - goalNode.x, node.z - goalNode.z);
+	};
+
+	uint32_t const localStart = toLocal(region_, start_);
+	uint32_t const localGoal = toLocal(region_, goal_);
+
+	OpenQueue open;
+	costs[localStart] = 0.0f;
+	open.push({heuristic(start_), localStart});
+	while(!open.empty())
+	{
+		uint32_t const local = open.top().second;
+		open.pop();
+		if(closed[local]) continue;
+		closed[local] = true;
+		if(local == localGoal) break;
+
+		float const cost = costs[local];
+		visitNeighbours(region_.levels[local], [&](uint32_t next_, float step_)
+		{
+			LevelNode const& next = levelNodes[next_];
+			if(!region_.contains(next.x, next.z)) return;
+
+			uint32_t const localNext = toLocal(region_, next_);
+			float const nextCost = cost + step_;
+			if(nextCost >= costs[localNext]) return;
+
+			costs[localNext] = nextCost;
+			parents[localNext] = local;
+			open.push({nextCost + heuristic(next_), localNext});
+		});
+	}
+
+	if(costs[localGoal] == NoPath) return NoPath;
+
+	if(path_ != nullptr)
+	{
+		path_->clear();
+		for(uint32_t local = localGoal; local != InvalidIndex; local = parents[local])
+		{
+			path_->push_back(region_.levels[local]);
+		}
+		std::reverse(path_->begin(), path_->end());
+	}
+	return costs[localGoal];
+}
+
+void TacticalMapPathGraph::costsFrom(Region const& region_, uint32_t start_, std::vector<float>& costs_) const
+{
+	costs_.assign(region_.levels.size(), NoPath);
+	std::vector<bool> closed(region_.levels.size(), false);
+
+	OpenQueue open;
+	uint32_t const localStart = toLocal(region_, start_);
+	costs_[localStart] = 0.0f;
+	open.push({0.0f, localStart});
+	while(!open.empty())
+	{
+		uint32_t const local = open.top().second;
+		open.pop();
+		if(closed[local]) continue;
+		closed[local] = true;
+
+		float const cost = costs_[local];
+		visitNeighbours(region_.levels[local], [&](uint32_t next_, float step_)
+		{
+			LevelNode const& next = levelNodes[next_];
+			if(!region_.contains(next.x, next.z)) return;
+
+			uint32_t const localNext = toLocal(region_, next_);
+			float const nextCost = cost + step_;
+			if(nextCost >= costs_[localNext]) return;
+
+			costs_[localNext] = nextCost;
+			open.push({nextCost, localNext});
+		});
+	}
+}
+
+uint32_t TacticalMapPathGraph::findLevel(Math::vec3 const& world_) const
+{
+	TacticalMap::TileCoord_t x, z;
+	map->worldToLocal(world_, x, z);
+
+	auto const[level, levelData] = map->lookupInTile(map->getTile(x, z), world_.y, settings.lookupRange, settings.levelMask);
+	if(level == nullptr) return InvalidIndex;
+
+	uint32_t const index = (uint32_t) (level - map->levels);
+	if(!levelNodes[index].walkable) return InvalidIndex;
+	return index;
+}
+
+void TacticalMapPathGraph::findBorderPortals(uint32_t border_, std::vector<std::pair<uint32_t, uint32_t>>& out_) const
+{
+	out_.clear();
+
+	uint32_t const cluster = border_ / 2;
+	bool const east = (border_ & 1) == 0;
+	uint32_t const clusterX = cluster % clustersWide;
+	uint32_t const clusterZ = cluster / clustersWide;
+	if(east && clusterX + 1 >= clustersWide) return;
+	if(!east && clusterZ + 1 >= clustersHigh) return;
+
+	int const clusterSize = (int) settings.clusterSize;
+	int const start = east ? (int) clusterZ * clusterSize : (int) clusterX * clusterSize;
+	int const end = std::min(start + clusterSize, east ? map->getHeight() : map->getWidth());
+	int const inside = (east ? (int) clusterX + 1 : (int) clusterZ + 1) * clusterSize - 1;
+
+	// runs of crossings along the border that are joined on both sides get one portal in their middle
+	using Crossing = std::pair<uint32_t, uint32_t>;
+	using Run = std::vector<Crossing>;
+	std::vector<Run> open;
+	auto const close = [&out_](Run const& run_) { out_.push_back(run_[run_.size() / 2]); };
+
+	std::vector<Run> next;
+	std::vector<bool> extended;
+	for(auto position = start; position < end; ++position)
+	{
+		TacticalMapTile const& insideTile = east ? map->getTile(inside, position) : map->getTile(position, inside);
+		TacticalMapTile const& outsideTile = east ? map->getTile(inside + 1, position) : map->getTile(position, inside + 1);
+
+		next.clear();
+		extended.assign(open.size(), false);
+		for(auto insideIndex = 0u; insideIndex < insideTile.levelCount; ++insideIndex)
+		{
+			uint32_t const a = insideTile.levelStartIndex + insideIndex;
+			for(auto outsideIndex = 0u; outsideIndex < outsideTile.levelCount; ++outsideIndex)
+			{
+				uint32_t const b = outsideTile.levelStartIndex + outsideIndex;
+				if(!connects(levelNodes[a], levelNodes[b])) continue;
+
+				auto run = std::find_if(open.begin(), open.end(), [&](Run const& run_)
+				{
+					if(extended[&run_ - open.data()]) return false;
+					return connects(levelNodes[run_.back().first], levelNodes[a]) &&
+						   connects(levelNodes[run_.back().second], levelNodes[b]);
+				});
+				if(run != open.end())
+				{
+					extended[run - open.begin()] = true;
+					next.push_back(std::move(*run));
+					next.back().push_back({a, b});
+				} else
+				{
+					next.push_back(Run{{a, b}});
+				}
+			}
+		}
+
+		for(auto i = 0u; i < open.size(); ++i)
+		{
+			if(!extended[i]) close(open[i]);
+		}
+		std::swap(open, next);
+	}
+
+	for(auto const& run : open)
+	{
+		close(run);
+	}
+}
+
+void TacticalMapPathGraph::addBorderPortals(uint32_t border_, std::vector<std::pair<uint32_t, uint32_t>> const& pairs_)
+{
+	uint32_t const cluster = border_ / 2;
+	uint32_t const otherCluster = (border_ & 1) == 0 ? cluster + 1 : cluster + clustersWide;
+
+	auto const allocatePortal = [this]()
+	{
+		if(freePortals.empty())
+		{
+			portals.emplace_back();
+			return (uint32_t) (portals.size() - 1);
+		}
+		uint32_t const index = freePortals.back();
+		freePortals.pop_back();
+		return index;
+	};
+
+	for(auto const& [a, b] : pairs_)
+	{
+		uint32_t const insidePortal = allocatePortal();
+		uint32_t const outsidePortal = allocatePortal();
+		portals[insidePortal] = {a, cluster, outsidePortal, {}};
+		portals[outsidePortal] = {b, otherCluster, insidePortal, {}};
+
+		borderPortals[border_].push_back(insidePortal);
+		borderPortals[border_].push_back(outsidePortal);
+		clusterPortals[cluster].push_back(insidePortal);
+		clusterPortals[otherCluster].push_back(outsidePortal);
+		portalCount += 2;
+	}
+}
+
+void TacticalMapPathGraph::removeBorderPortals(uint32_t border_)
+{
+	for(auto const index : borderPortals[border_])
+	{
+		auto& inCluster = clusterPortals[portals[index].cluster];
+		inCluster.erase(std::remove(inCluster.begin(), inCluster.end(), index), inCluster.end());
+		portals[index] = PortalNode{};
+		freePortals.push_back(index);
+		portalCount--;
+	}
+	borderPortals[border_].clear();
+}
+
+void TacticalMapPathGraph::buildClusterEdges(uint32_t cluster_)
+{
+	auto const& nodes = clusterPortals[cluster_];
+	if(nodes.empty()) return;
+
+	Region const region = makeClusterRegion(cluster_);
+	std::vector<float> costs;
+	for(auto const from : nodes)
+	{
+		PortalNode& portal = portals[from];
+		portal.intraEdges.clear();
+		costsFrom(region, portal.level, costs);
+		for(auto const to : nodes)
+		{
+			if(to == from) continue;
+			float const cost = costs[toLocal(region, portals[to].level)];
+			if(cost != NoPath) portal.intraEdges.push_back({to, cost});
+		}
+	}
+}
+
+void TacticalMapPathGraph::buildClusters(std::vector<uint32_t> const& borders_, std::vector<uint32_t> const& clusters_)
+{
+	// portals are found in parallel but added in border order so the graph is the same every build
+	std::vector<std::vector<std::pair<uint32_t, uint32_t>>> borderPairs(borders_.size());
+	if(!borders_.empty())
+	{
+		Core::ParallelFor((uint32_t) borders_.size(), 1,
+						  [this, &borders_, &borderPairs](uint32_t const begin_, uint32_t const end_, uint32_t)
+						  {
+							  for(auto i = begin_; i < end_; ++i)
+							  {
+								  findBorderPortals(borders_[i], borderPairs[i]);
+							  }
+						  });
+	}
+
+	for(auto i = 0u; i < borders_.size(); ++i)
+	{
+		addBorderPortals(borders_[i], borderPairs[i]);
+	}
+
+	// each cluster only touches its own portals edges
+	if(!clusters_.empty())
+	{
+		Core::ParallelFor((uint32_t) clusters_.size(), 1,
+						  [this, &clusters_](uint32_t const begin_, uint32_t const end_, uint32_t)
+						  {
+							  for(auto i = begin_; i < end_; ++i)
+							  {
+								  buildClusterEdges(clusters_[i]);
+							  }
+						  });
+	}
+}
+
+uint32_t TacticalMapPathGraph::updateMap(std::shared_ptr<TacticalMap const> map_)
+{
+	assert(map_);
+	auto const oldMap = std::move(map);
+	map = std::move(map_);
+
+	uint32_t const clusterCount = clustersWide * clustersHigh;
+	std::vector<LevelNode> newLevelNodes;
+	buildLevelNodes(newLevelNodes);
+
+	// a differently shaped map shares nothing with the old one
+	if(map->getWidth() != oldMap->getWidth() || map->getHeight() != oldMap->getHeight() ||
+	   newLevelNodes.size() != levelNodes.size())
+	{
+		*this = TacticalMapPathGraph(map, settings);
+		return clustersWide * clustersHigh;
+	}
+
+	std::vector<bool> dirtyClusters(clusterCount, false);
+	for(auto i = 0u; i < newLevelNodes.size(); ++i)
+	{
+		LevelNode const& oldNode = levelNodes[i];
+		LevelNode const& newNode = newLevelNodes[i];
+		if(oldNode.x == newNode.x && oldNode.z == newNode.z &&
+		   oldNode.floor == newNode.floor && oldNode.roof == newNode.roof &&
+		   oldNode.walkable == newNode.walkable)
+			continue;
+		dirtyClusters[getClusterOf(oldNode)] = true;
+		dirtyClusters[getClusterOf(newNode)] = true;
+	}
+	levelNodes = std::move(newLevelNodes);
+
+	// every border of a changed cluster is rebuilt, which changes the portals of the clusters across them
+	std::vector<bool> dirtyBorders(clusterCount * 2, false);
+	std::vector<bool> edgeClusters(clusterCount, false);
+	uint32_t rebuilt = 0;
+	for(auto cluster = 0u; cluster < clusterCount; ++cluster)
+	{
+		if(!dirtyClusters[cluster]) continue;
+		rebuilt++;
+
+		uint32_t const clusterX = cluster % clustersWide;
+		uint32_t const clusterZ = cluster / clustersWide;
+		edgeClusters[cluster] = true;
+		if(clusterX + 1 < clustersWide)
+		{
+			dirtyBorders[cluster * 2] = true;
+			edgeClusters[cluster + 1] = true;
+		}
+		if(clusterZ + 1 < clustersHigh)
+		{
+			dirtyBorders[cluster * 2 + 1] = true;
+			edgeClusters[cluster + clustersWide] = true;
+		}
+		if(clusterX > 0)
+		{
+			dirtyBorders[(cluster - 1) * 2] = true;
+			edgeClusters[cluster - 1] = true;
+		}
+		if(clusterZ > 0)
+		{
+			dirtyBorders[(cluster - clustersWide) * 2 + 1] = true;
+			edgeClusters[cluster - clustersWide] = true;
+		}
+	}
+	if(rebuilt == 0) return 0;
+
+	std::vector<uint32_t> borders;
+	for(auto border = 0u; border < dirtyBorders.size(); ++border)
+	{
+		if(!dirtyBorders[border]) continue;
+		removeBorderPortals(border);
+		borders.push_back(border);
+	}
+	std::vector<uint32_t> clusters;
+	for(auto cluster = 0u; cluster < clusterCount; ++cluster)
+	{
+		if(edgeClusters[cluster]) clusters.push_back(cluster);
+	}
+	buildClusters(borders, clusters);
+
+	return rebuilt;
+}
+
+bool TacticalMapPathGraph::findPath(TacticalMapPathQuery const& query_, TacticalMapPath& out_) const
+{
+	out_.found = false;
+	out_.cost = 0.0f;
+	out_.points.clear();
+
+	uint32_t const start = findLevel(query_.start);
+	uint32_t const goal = findLevel(query_.goal);
+	if(start == InvalidIndex || goal == InvalidIndex) return false;
+
+	Math::vec2 const bottomLeft = map->getBottomLeft();
+	auto const output = [this, &out_, &bottomLeft](std::vector<uint32_t> const& levels_, float cost_)
+	{
+		out_.found = true;
+		out_.cost = cost_;
+		out_.points.reserve(levels_.size());
+		for(auto const level : levels_)
+		{
+			LevelNode const& node = levelNodes[level];
+			out_.points.emplace_back(bottomLeft.x + node.x, node.floor, bottomLeft.y + node.z);
+		}
+		return true;
+	};
+
+	uint32_t const startCluster = getClusterOf(levelNodes[start]);
+	uint32_t const goalCluster = getClusterOf(levelNodes[goal]);
+	Region const startRegion = makeClusterRegion(startCluster);
+
+	// paths within a cluster don't need the portal graph, unless they have to leave it
+	std::vector<uint32_t> levels;
+	if(startCluster == goalCluster)
+	{
+		float const cost = searchLocal(startRegion, start, goal, &levels);
+		if(cost != NoPath) return output(levels, cost);
+	}
+
+	// start and goal join the portal graph through the portals of their clusters
+	Region const goalRegion = startCluster == goalCluster ? startRegion : makeClusterRegion(goalCluster);
+	std::vector<float> startCosts;
+	std::vector<float> goalCosts;
+	costsFrom(startRegion, start, startCosts);
+	costsFrom(goalRegion, goal, goalCosts);
+
+	uint32_t const startNode = (uint32_t) portals.size();
+	uint32_t const goalNode = startNode + 1;
+	auto const levelOf = [&](uint32_t node_)
+	{
+		if(node_ == startNode) return start;
+		if(node_ == goalNode) return goal;
+		return portals[node_].level;
+	};
+	LevelNode const& goalLevelNode = levelNodes[goal];
+	auto const heuristic = [&](uint32_t node_)
+	{
+		LevelNode const& node = levelNodes[levelOf(node_)];
+		return OctileDistance(node.x - goalLevelNode.x, node.z - goalLevelNode.z);
+	};
+
+	std::vector<float> costs(portals.size() + 2, NoPath);
+	std::vector<uint32_t> parents(portals.size() + 2, InvalidIndex);
+	std::vector<bool> closed(portals.size() + 2, false);
+	OpenQueue open;
+	costs[startNode] = 0.0f;
+	open.push({heuristic(startNode), startNode});
+	while(!open.empty())
+	{
+		uint32_t const node = open.top().second;
+		open.pop();
+		if(closed[node]) continue;
+		closed[node] = true;
+		if(node == goalNode) break;
+
+		float const cost = costs[node];
+		auto const relax = [&](uint32_t next_, float step_)
+		{
+			float const nextCost = cost + step_;
+			if(nextCost >= costs[next_]) return;
+			costs[next_] = nextCost;
+			parents[next_] = node;
+			open.push({nextCost + heuristic(next_), next_});
+		};
+
+		if(node == startNode)
+		{
+			for(auto const portal : clusterPortals[startCluster])
+			{
+				float const step = startCosts[toLocal(startRegion, portals[portal].level)];
+				if(step != NoPath) relax(portal, step);
+			}
+			continue;
+		}
+
+		PortalNode const& portal = portals[node];
+		relax(portal.partner, 1.0f);
+		for(auto const& [to, step] : portal.intraEdges)
+		{
+			relax(to, step);
+		}
+		if(portal.cluster == goalCluster)
+		{
+			float const step = goalCosts[toLocal(goalRegion, portal.level)];
+			if(step != NoPath) relax(goalNode, step);
+		}
+	}
+	if(costs[goalNode] == NoPath) return false;
+
+	std::vector<uint32_t> abstractPath;
+	for(uint32_t node = goalNode; node != InvalidIndex; node = parents[node])
+	{
+		abstractPath.push_back(node);
+	}
+	std::reverse(abstractPath.begin(), abstractPath.end());
+
+	// refine each step of the abstract path, steps across a border are already a single tile step
+	levels.assign(1, start);
+	float totalCost = 0.0f;
+	std::vector<uint32_t> segment;
+	for(auto i = 1u; i < abstractPath.size(); ++i)
+	{
+		uint32_t const from = abstractPath[i - 1];
+		uint32_t const to = abstractPath[i];
+		if(from != startNode && to != goalNode && portals[from].partner == to)
+		{
+			levels.push_back(portals[to].level);
+			totalCost += 1.0f;
+			continue;
+		}
+
+		uint32_t const cluster = from == startNode ? startCluster : portals[from].cluster;
+		float cost;
+		if(cluster == startCluster) cost = searchLocal(startRegion, levelOf(from), levelOf(to), &segment);
+		else if(cluster == goalCluster) cost = searchLocal(goalRegion, levelOf(from), levelOf(to), &segment);
+		else cost = searchLocal(makeClusterRegion(cluster), levelOf(from), levelOf(to), &segment);
+		assert(cost != NoPath);
+
+		totalCost += cost;
+		levels.insert(levels.end(), segment.begin() + 1, segment.end());
+	}
+
+	return output(levels, totalCost);
+}
+
+TacticalMapPathfinder::TacticalMapPathfinder(std::shared_ptr<TacticalMap const> map_,
+											 TacticalMapPathSettings const& settings_) :
+		graph(std::make_shared<TacticalMapPathGraph>(std::move(map_), settings_))
+{
+}
+
+bool TacticalMapPathfinder::findPath(TacticalMapPathQuery const& query_, TacticalMapPath& out_) const
+{
+	return std::atomic_load(&graph)->findPath(query_, out_);
+}
+
+ITacticalMapPathBatch::Ptr TacticalMapPathfinder::findPathsAsync(TacticalMapPathQuery const* queries_, size_t count_,
+																  TacticalMapPath* out_) const
+{
+	auto batch = std::make_shared<TacticalMapPathBatch>(std::atomic_load(&graph), queries_, count_, out_);
+	if(count_ > 0) batch->submit();
+	return batch;
+}
+
+uint32_t TacticalMapPathfinder::updateMap(std::shared_ptr<TacticalMap const> map_)
+{
+	// the current graph may be in use by searches on other threads, so the update is done on a copy
+	// and swapped in when finished. updates from several threads take turns
+	std::lock_guard<std::mutex> lock(updateMutex);
+	auto next = std::make_shared<TacticalMapPathGraph>(*std::atomic_load(&graph));
+	uint32_t const rebuilt = next->updateMap(std::move(map_));
+	std::atomic_store(&graph, std::shared_ptr<TacticalMapPathGraph const>(std::move(next)));
+	return rebuilt;
+}
+
+uint32_t TacticalMapPathfinder::getPortalCount() const
+{
+	return std::atomic_load(&graph)->getPortalCount();
+}
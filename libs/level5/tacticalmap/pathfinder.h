@@ -0,0 +1,106 @@
+#pragma once
+#ifndef NATIVESNAPSHOT_TACTICALMAP_PATHFINDER_H
+#define NATIVESNAPSHOT_TACTICALMAP_PATHFINDER_H
+
+#include "core/core.h"
+#include "math/vector_math.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "tacticalmap/tacticalmap.h"
+
+// the clusters and portals for one version of the map. once a pathfinder publishes a graph it is never
+// changed, updates are made to a copy
+class TacticalMapPathGraph
+{
+public:
+	TacticalMapPathGraph(std::shared_ptr<TacticalMap const> map_, TacticalMapPathSettings const& settings_);
+
+	bool findPath(TacticalMapPathQuery const& query_, TacticalMapPath& out_) const;
+	uint32_t updateMap(std::shared_ptr<TacticalMap const> map_);
+	uint32_t getPortalCount() const { return portalCount; }
+
+private:
+	static constexpr uint32_t InvalidIndex = ~0u;
+
+	// one per level in the map, indexed the same as the maps levels
+	struct LevelNode
+	{
+		int16_t x, z;
+		float floor;
+		float roof;
+		bool walkable;
+	};
+
+	// an end of a portal, the other end is its partner on the far side of the cluster border
+	struct PortalNode
+	{
+		uint32_t level = InvalidIndex;
+		uint32_t cluster = InvalidIndex;
+		uint32_t partner = InvalidIndex;
+		std::vector<std::pair<uint32_t, float>> intraEdges; // to the other portals in the cluster
+	};
+
+	// a rectangle of tiles local searches are limited to, with its levels given dense indices
+	struct Region
+	{
+		int x0, z0, x1, z1;
+		std::vector<uint32_t> tileBase;
+		std::vector<uint32_t> levels;
+
+		bool contains(int x_, int z_) const { return x_ >= x0 && x_ < x1 && z_ >= z0 && z_ < z1; }
+	};
+
+	void buildLevelNodes(std::vector<LevelNode>& out_) const;
+	bool connects(LevelNode const& a_, LevelNode const& b_) const;
+	// calls func_(neighbourLevel, cost) for every level a step from level_
+	template<typename Func>
+	void visitNeighbours(uint32_t level_, Func&& func_) const;
+
+	uint32_t getClusterOf(LevelNode const& node_) const;
+	Region makeClusterRegion(uint32_t cluster_) const;
+	uint32_t toLocal(Region const& region_, uint32_t level_) const;
+	// a* from start_ to goal_ within region_, path_ gets the levels from start to goal
+	float searchLocal(Region const& region_, uint32_t start_, uint32_t goal_, std::vector<uint32_t>* path_) const;
+	// dijkstra from start_ to everywhere in region_, indexed by the regions local indices
+	void costsFrom(Region const& region_, uint32_t start_, std::vector<float>& costs_) const;
+	uint32_t findLevel(Math::vec3 const& world_) const;
+
+	// borders are the east (even) and north (odd) sides of each cluster
+	void findBorderPortals(uint32_t border_, std::vector<std::pair<uint32_t, uint32_t>>& out_) const;
+	void addBorderPortals(uint32_t border_, std::vector<std::pair<uint32_t, uint32_t>> const& pairs_);
+	void removeBorderPortals(uint32_t border_);
+	void buildClusterEdges(uint32_t cluster_);
+	void buildClusters(std::vector<uint32_t> const& borders_, std::vector<uint32_t> const& clusters_);
+
+	std::shared_ptr<TacticalMap const> map;
+	TacticalMapPathSettings settings;
+
+	std::vector<LevelNode> levelNodes;
+	uint32_t clustersWide = 0;
+	uint32_t clustersHigh = 0;
+
+	std::vector<PortalNode> portals;
+	std::vector<uint32_t> freePortals;
+	std::vector<std::vector<uint32_t>> borderPortals;
+	std::vector<std::vector<uint32_t>> clusterPortals;
+	uint32_t portalCount = 0;
+};
+
+class TacticalMapPathfinder : public ITacticalMapPathfinder
+{
+public:
+	TacticalMapPathfinder(std::shared_ptr<TacticalMap const> map_, TacticalMapPathSettings const& settings_);
+
+	bool findPath(TacticalMapPathQuery const& query_, TacticalMapPath& out_) const override;
+	ITacticalMapPathBatch::Ptr findPathsAsync(TacticalMapPathQuery const* queries_, size_t count_, TacticalMapPath* out_) const override;
+	uint32_t updateMap(std::shared_ptr<TacticalMap const> map_) override;
+	uint32_t getPortalCount() const override;
+
+private:
+	// searches take whichever graph is current and hold it till they finish, only touch with atomic_load/store
+	std::shared_ptr<TacticalMapPathGraph const> graph;
+	std::mutex updateMutex;
+};
+
+#endif //NATIVESNAPSHOT_TACTICALMAP_PATHFINDER_H
@@ -1,28 +1,23 @@
+#include "core/core.h"
+#include "core/sharedtasks.h"
 #include "stitcher.h"
 #include <unordered_map>
 #include <algorithm>
 
-Math::vec3 TacticalMapStitcher::rotateVector(Math::vec3 const& v, int rotationInDegrees_)
+int TacticalMapStitcher::getQuarterTurns(int rotationInDegrees_)
 {
 	if(rotationInDegrees_ < 0)
 	{
 		rotationInDegrees_ = 360 - ((-rotationInDegrees_) % 360);
 	}
+	assert((rotationInDegrees_ % 90) == 0);
+	return (rotationInDegrees_ % 360) / 90;
+}
 
-	switch(rotationInDegrees_ % 360)
-	{
-		case 0:
-			return v;
-		case 90:
-			return {v.z, v.y, -v.x};
-		case 180:
-			return -v;
-		case 270:
-			return {-v.z, v.y, v.x};
-		default:
-			assert(false);
-			return {0, 0, 0};
-	}
+void TacticalMapStitcher::Placement::getSourceTile(int x_, int z_, int& outX_, int& outZ_) const
+{
+	outX_ = Math::clamp(xOffset + (xFromX * x_) + (xFromZ * z_), 0, map->getWidth() - 1);
+	outZ_ = Math::clamp(zOffset + (zFromX * x_) + (zFromZ * z_), 0, map->getHeight() - 1);
 }
 
 Geometry::AABB TacticalMapStitcher::rotateAABB(Geometry::AABB const& v, int rotationInDegrees_)
@@ -54,154 +49,263 @@ void TacticalMapStitcher::addTacticalMapInstance(std::shared_ptr<TacticalMap con
 	instances.emplace_back(map_, position_, rotationInDegrees_, mapParcelId_);
 }
 
-std::shared_ptr<TacticalMap> TacticalMapStitcher::build()
+void TacticalMapStitcher::makePlan(Plan& out_) const
 {
 	// determine size of the stitched together map
 	static const float fmininit = std::numeric_limits<float>::max();
 	static const float fmaxinit = -std::numeric_limits<float>::max();
-	Math::vec3 totalMinExtents{fmininit, fmininit, fmininit};
-	Math::vec3 totalMaxExtents{fmaxinit, fmaxinit, fmaxinit};
-	size_t levelCount = 0;
-	uint32_t tacticalLevelDataSize = 0;
+	out_.minExtents = {fmininit, fmininit, fmininit};
+	out_.maxExtents = {fmaxinit, fmaxinit, fmaxinit};
+	out_.levelCount = 0;
+	out_.sizeOfLevelData = 0;
 
-	for(auto[map, position, rotationInDegrees, _] : instances)
+	for(auto const&[map, position, rotationInDegrees, _] : instances)
 	{
 		Geometry::AABB aabb = map->getAABB();
-		Math::vec3 minExtent = position + aabb.getMinExtent();
-		Math::vec3 maxExtent = position + aabb.getMaxExtent();
-		totalMinExtents = Math::min(totalMinExtents, minExtent);
-		totalMaxExtents = Math::max(totalMaxExtents, maxExtent);
-		levelCount += map->levelCount;
-		if(tacticalLevelDataSize != 0)
+		out_.minExtents = Math::min(out_.minExtents, position + aabb.getMinExtent());
+		out_.maxExtents = Math::max(out_.maxExtents, position + aabb.getMaxExtent());
+		if(out_.sizeOfLevelData != 0)
 		{
-			assert(map->sizeOfTacticalLevelData == tacticalLevelDataSize);
+			assert(map->sizeOfTacticalLevelData == out_.sizeOfLevelData);
 		}
-		tacticalLevelDataSize = std::max(tacticalLevelDataSize, map->sizeOfTacticalLevelData);
+		out_.sizeOfLevelData = std::max(out_.sizeOfLevelData, map->sizeOfTacticalLevelData);
 	}
 
-	int width = (int) floor(totalMaxExtents.x - totalMinExtents.x);
-	int height = (int) floor(totalMaxExtents.z - totalMinExtents.z);
+	out_.width = (int) floor(out_.maxExtents.x - out_.minExtents.x);
+	out_.height = (int) floor(out_.maxExtents.z - out_.minExtents.z);
 
-	size_t const levelMemorySize = sizeof(TacticalMapTileLevel) * levelCount;
-	size_t const levelDataMemorySize = tacticalLevelDataSize * levelCount;
-	size_t const mapMemorySize = sizeof(TacticalMapTile) * width * height;
-	size_t const memorySize = sizeof(TacticalMap) +
-							  levelMemorySize +
-							  levelDataMemorySize +
-							  mapMemorySize;
+	// stitched maps take the tile layout of their parcels
+	out_.tileLayout = instances.empty() ?
+					  TacticalMapTileLayout::RowMajor :
+					  std::get<0>(instances.front())->getTileLayout();
 
-	auto const bigmemory = (uint8_t*) malloc(memorySize);
-	auto const biglevels = (TacticalMapTileLevel*) (bigmemory + sizeof(TacticalMap));
-	auto const biglevelDatasByte = ((uint8_t*) biglevels) + levelMemorySize;
-	auto const bigmap = (TacticalMapTile*) (biglevelDatasByte + levelDataMemorySize);
+	out_.placements.clear();
+	out_.placements.reserve(instances.size());
+	for(auto const&[map, position, rotationInDegrees, mapParcelId] : instances)
+	{
+		Placement placement;
+		placement.map = map.get();
+		placement.mapParcelId = mapParcelId;
+		placement.levelBase = out_.levelCount;
+		out_.levelCount += map->levelCount;
 
-	std::memset(biglevels, 0, levelMemorySize);
-	std::memset(biglevelDatasByte, 0, levelDataMemorySize);
-	std::memset(bigmap, 0, mapMemorySize);
+		Math::vec3 const bigMapPos = position + map->getAABB().getMinExtent() - out_.minExtents;
+		placement.destX = (int) std::floor(bigMapPos.x);
+		placement.destZ = (int) std::floor(bigMapPos.z);
+		assert(placement.destX < out_.width);
+		assert(placement.destZ < out_.height);
 
-	TacticalMapTileLevel* curLevels = biglevels;
-	uint8_t* curLevelDatasBytes = biglevelDatasByte;
-	TacticalMapTile* curMap = bigmap;
+		// tile (x, z) is at world (x + bottomLeft) rotated about the origin, which is a whole number
+		// of tiles away for every tile so the quarter turn is folded into integer steps and an offset
+		Math::vec2 const bottomLeft = map->getBottomLeft();
+		float x0 = 0.0f, z0 = 0.0f;
+		switch(getQuarterTurns(rotationInDegrees))
+		{
+			case 0:
+				placement.xFromX = 1; placement.xFromZ = 0; x0 = bottomLeft.x;
+				placement.zFromX = 0; placement.zFromZ = 1; z0 = bottomLeft.y;
+				break;
+			case 1:
+				placement.xFromX = 0; placement.xFromZ = 1; x0 = bottomLeft.y;
+				placement.zFromX = -1; placement.zFromZ = 0; z0 = -bottomLeft.x;
+				break;
+			case 2:
+				placement.xFromX = -1; placement.xFromZ = 0; x0 = -bottomLeft.x;
+				placement.zFromX = 0; placement.zFromZ = -1; z0 = -bottomLeft.y;
+				break;
+			case 3:
+				placement.xFromX = 0; placement.xFromZ = -1; x0 = -bottomLeft.y;
+				placement.zFromX = 1; placement.zFromZ = 0; z0 = bottomLeft.x;
+				break;
+		}
+		placement.xOffset = (int) std::floor(x0 - bottomLeft.x + 0.5f);
+		placement.zOffset = (int) std::floor(z0 - bottomLeft.y + 0.5f);
 
-	for(auto[map, position, rotationInDegrees, mapParcelId] : instances)
-	{
-		Geometry::AABB aabb = map->getAABB();
-		Math::vec3 minExtent = position + aabb.getMinExtent();
-		Math::vec3 maxExtent = position + aabb.getMaxExtent();
+		out_.placements.push_back(placement);
+	}
+}
+
+template<typename Func>
+void TacticalMapStitcher::visitStitchedTiles(Plan const& plan_, Func&& func_) const
+{
+	if(plan_.height <= 0) return;
+
+	Core::ParallelFor((uint32_t) plan_.height, 1,
+					  [&plan_, &func_](uint32_t const begin_, uint32_t const end_, uint32_t)
+					  {
+						  for(auto z = (int) begin_; z < (int) end_; ++z)
+						  {
+							  for(auto i = 0u; i < plan_.placements.size(); ++i)
+							  {
+								  Placement const& placement = plan_.placements[i];
+								  int const localZ = z - placement.destZ;
+								  if(localZ < 0 || localZ >= placement.map->getHeight()) continue;
+
+								  for(auto x = 0; x < placement.map->getWidth(); ++x)
+								  {
+									  func_(i, x, localZ);
+								  }
+							  }
+						  }
+					  });
+}
 
-		// copy level and level data
-		std::memcpy(curLevels, map->levels, map->levelCount * sizeof(TacticalMapTileLevel));
-		std::memcpy(curLevelDatasBytes, map->levelDataHeap, map->levelCount * tacticalLevelDataSize);
+std::shared_ptr<TacticalMap> TacticalMapStitcher::build()
+{
+	Plan plan;
+	makePlan(plan);
+
+	auto result = TacticalMap::allocate((uint16_t) plan.width, (uint16_t) plan.height, plan.tileLayout,
+										plan.levelCount, plan.sizeOfLevelData, name);
+	TacticalMap* tmap = result.get();
+	auto const biglevels = tmap->levels;
+	auto const biglevelDatasByte = tmap->levelDataHeap;
+	uint32_t const tacticalLevelDataSize = plan.sizeOfLevelData;
+
+	// each instance copies its levels and level data into its own range
+	if(!plan.placements.empty())
+	{
+		Core::ParallelFor((uint32_t) plan.placements.size(), 1,
+						  [&](uint32_t const begin_, uint32_t const end_, uint32_t)
+						  {
+							  for(auto i = begin_; i < end_; ++i)
+							  {
+								  Placement const& placement = plan.placements[i];
+								  TacticalMap const* map = placement.map;
+								  std::memcpy(biglevels + placement.levelBase, map->levels,
+											  map->levelCount * sizeof(TacticalMapTileLevel));
 
-		// relocate tiles to the correct orientation and position on the big map
-		// also fixup pointers from the parcel map to the new big map
+								  uint8_t* const levelDatasBytes = biglevelDatasByte +
+																	(size_t(placement.levelBase) * tacticalLevelDataSize);
+								  map->copyLevelData(levelDatasBytes);
+								  for(auto level = 0u; level < map->levelCount; ++level)
+								  {
+									  auto levelData = (TacticalMapLevelDataHeader*) (levelDatasBytes +
+																					  (size_t(level) * tacticalLevelDataSize));
+									  levelData->instance = placement.mapParcelId;
+								  }
+							  }
+						  });
+	}
 
-		Math::vec3 const bigMapPos = (minExtent - totalMinExtents);
+	// relocate tiles to the correct orientation and position on the big map
+	// also fixup level indices from the parcel map to the new big map
+	visitStitchedTiles(plan, [&plan, tmap](uint32_t placementIndex_, int x_, int z_)
+	{
+		Placement const& placement = plan.placements[placementIndex_];
+		int sx, sz;
+		placement.getSourceTile(x_, z_, sx, sz);
 
-		int dsy = (int) std::floor(bigMapPos.z);
-		assert(dsy < height);
-		for(auto y = 0u; y < map->height; ++y)
+		TacticalMapTile const& src = placement.map->getTile(sx, sz);
+		TacticalMapTile& dest = tmap->getTile(placement.destX + x_, placement.destZ + z_);
+		dest = src;
+		if(dest.levelCount != 0)
 		{
-			int dsx = (int) floor(bigMapPos.x);
-			assert(dsx < width);
-			for(auto x = 0u; x < map->width; ++x)
-			{
-				TacticalMap::TileCoord_t ssx = 0;
-				TacticalMap::TileCoord_t ssy = 0;
-
-				Math::vec3 v{(float) x + map->getBottomLeft().x, 0, (float) y + map->getBottomLeft().y};
-				Math::vec3 local = rotateVector(v, rotationInDegrees);
-				map->worldToLocal(local, ssx, ssy);
-
-				int const si = (int) ssy * (int) map->width + (int) ssx;
-				int const di = (int) dsy * (int) width + (int) dsx;
-				TacticalMapTile const* src = &map->map[si];
-				TacticalMapTile* dest = &bigmap[di];
-
-				// pre fixup source check
-				for(auto levelChk = 0u; levelChk < src->levelCount; levelChk++)
-				{
-					auto srcLevelData = map->getLevelData(*src, levelChk);
-					assert(srcLevelData->levelNum == levelChk);
-				}
-
-				// copy it from src to dest (another check for luck)
-				assert((uint8_t*) dest < bigmemory + memorySize);
-				std::memcpy(dest, src, sizeof(TacticalMapTile));
-
-				if(dest->levelCount != 0)
-				{
-					// pre fixup check that dest came over okay
-					auto curLevel = curLevels[dest->levelStartIndex];
-					auto curLevelData = (TacticalMapLevelDataHeader*) (curLevelDatasBytes +
-																	   (dest->levelStartIndex * tacticalLevelDataSize));
-					assert(curLevelData->levelNum == 0);
-
-					// do the fixup
-					dest->levelStartIndex = uint32_t(curLevels - biglevels) + dest->levelStartIndex;
-
-					for(auto levelChk = 0u; levelChk < dest->levelCount; levelChk++)
-					{
-						auto dstLevelDataBytes = biglevelDatasByte +
-												 ((dest->levelStartIndex + levelChk) * tacticalLevelDataSize);
-						auto dstLevelData = (TacticalMapLevelDataHeader*) dstLevelDataBytes;
-						dstLevelData->instance = mapParcelId;
-						// post fixup check
-						assert(dstLevelData->levelNum == levelChk);
-					}
-				}
-				dsx++;
-			}
-			dsy++;
+			assert(placement.map->getLevelData(src, 0)->levelNum == 0);
+			dest.levelStartIndex += placement.levelBase;
 		}
-		curLevels += map->levelCount;
-		curLevelDatasBytes += map->levelCount * tacticalLevelDataSize;
+	});
+
+	tmap->bottomLeft = {plan.minExtents.x, plan.minExtents.z};
+	tmap->minHeight = plan.minExtents.y;
+	tmap->maxHeight = plan.maxExtents.y;
+	tmap->updateSummary(TacticalMap::TileRect{ 0, 0, plan.width, plan.height });
+
+	return result;
+}
+
+std::shared_ptr<TacticalMapVirtualStitch const> TacticalMapStitcher::buildVirtual()
+{
+	Plan plan;
+	makePlan(plan);
+
+	auto result = std::make_shared<TacticalMapVirtualStitch>();
+	result->width = plan.width;
+	result->height = plan.height;
+	result->bottomLeft = {plan.minExtents.x, plan.minExtents.z};
+	result->minHeight = plan.minExtents.y;
+	result->maxHeight = plan.maxExtents.y;
+
+	result->parcels.reserve(instances.size());
+	for(auto const&[map, position, rotationInDegrees, mapParcelId] : instances)
+	{
+		result->parcels.push_back({map, mapParcelId});
 	}
 
-	TacticalMap* tmap = new(bigmemory) TacticalMap();
-	tmap->width = width;
-	tmap->height = height;
-	tmap->levelCount = (uint32_t) levelCount;
-	tmap->bottomLeft = {totalMinExtents.x, totalMinExtents.z};
-	tmap->minHeight = totalMinExtents.y;
-	tmap->maxHeight = totalMaxExtents.y;
-	tmap->sizeOfTacticalMapTile = sizeof(TacticalMapTile);
-	tmap->sizeOfTacticalMapTileLevel = sizeof(TacticalMapTileLevel);
-	tmap->sizeOfTacticalLevelData = tacticalLevelDataSize;
-	char* tname = (char*) malloc(name.size() + 1);
-	std::memcpy(tname, name.data(), name.size());
-	tname[name.size()] = '\0';
-	tmap->name = tname;
-
-	tmap->levels = biglevels;
-	tmap->map = bigmap;
-	tmap->levelDataHeap = biglevelDatasByte;
-
-	return std::shared_ptr<TacticalMap>(
-			tmap,
-			[](TacticalMap* ptr)
-			{
-				if(ptr) free((void*) ptr->name);
-				free(ptr);
-			});
-}
\ No newline at end of file
+	auto& grid = result->grid;
+	grid.assign(size_t(plan.width) * plan.height, {TacticalMapVirtualStitch::InvalidParcel, 0});
+	visitStitchedTiles(plan, [&plan, &grid](uint32_t placementIndex_, int x_, int z_)
+	{
+		Placement const& placement = plan.placements[placementIndex_];
+		int sx, sz;
+		placement.getSourceTile(x_, z_, sx, sz);
+
+		size_t const destIndex = size_t(placement.destZ + z_) * plan.width + (placement.destX + x_);
+		grid[destIndex] = {placementIndex_, placement.map->getTileIndex(sx, sz)};
+	});
+
+	return result;
+}
+
+TacticalMapTile const* TacticalMapVirtualStitch::findTile(Math::vec3 const& world_, Parcel const*& parcel_) const
+{
+	if(grid.empty()) return nullptr;
+
+	// the same tile TacticalMap::worldToLocal gives the built map
+	Math::vec2 local = Math::vec2(world_.x - bottomLeft.x, world_.z - bottomLeft.y) + Math::vec2(0.5f, 0.5f);
+	local = Math::clamp(local, Math::vec2(0, 0), Math::vec2((float) width - 1, (float) height - 1));
+	int const x = (int) std::floor(local.x);
+	int const z = (int) std::floor(local.y);
+
+	Source const& source = grid[size_t(z) * width + x];
+	if(source.parcel == InvalidParcel) return nullptr;
+
+	parcel_ = &parcels[source.parcel];
+	return &parcel_->map->map[source.tileIndex];
+}
+
+auto TacticalMapVirtualStitch::lookupAtWorld(Math::vec3 const& world_, float const range_,
+											 uint32_t const levelMask_) const -> ConstLevelDataPair
+{
+	Parcel const* parcel = nullptr;
+	TacticalMapTile const* tile = findTile(world_, parcel);
+	if(tile == nullptr) return {};
+
+	return parcel->map->lookupInTile(*tile, world_.y, range_, levelMask_);
+}
+
+bool TacticalMapVirtualStitch::lookupVolumeAtWorld(Math::vec3 const& world_, float const range_,
+												   uint32_t const levelMask_, TacticalMapVolume* out_) const
+{
+	assert(out_ != nullptr);
+
+	Parcel const* parcel = nullptr;
+	TacticalMapTile const* tile = findTile(world_, parcel);
+	if(tile == nullptr) return false;
+
+	auto[level, levelData] = parcel->map->lookupInTile(*tile, world_.y, range_, levelMask_);
+	if(level == nullptr || levelData == nullptr) return false;
+
+	out_->floorNormal = TacticalMap::getFloorNormal(*level);
+	out_->levelHeight = TacticalMap::getLevelHeight(*tile, *level);
+	out_->roofNormal = TacticalMap::getRoofNormal(*level);
+	out_->roofHeight = TacticalMap::getRoofHeight(*tile, *level);
+	return true;
+}
+
+bool TacticalMapVirtualStitch::lookupLevelDataAtWorld(Math::vec3 const& world_, float const range_,
+													  uint32_t const levelMask_, TacticalMapLevelDataHeader* out_) const
+{
+	assert(out_ != nullptr);
+
+	Parcel const* parcel = nullptr;
+	TacticalMapTile const* tile = findTile(world_, parcel);
+	if(tile == nullptr) return false;
+
+	auto[level, levelData] = parcel->map->lookupInTile(*tile, world_.y, range_, levelMask_);
+	if(level == nullptr || levelData == nullptr) return false;
+
+	std::memcpy(out_, levelData, parcel->map->sizeOfTacticalLevelData);
+	out_->instance = parcel->mapParcelId;
+	return true;
+}
@@ -9,6 +9,55 @@
 #include <vector>
 #include "tacticalmap/tacticalmap.h"
 
+// a stitched map that shares its parcels tiles and levels, only a grid of which parcel tile each
+// stitched tile comes from is built. lookups give the same results as the map build() makes
+class TacticalMapVirtualStitch
+{
+public:
+	friend class TacticalMapStitcher;
+	using ConstLevelDataPair = TacticalMap::ConstLevelDataPair;
+
+	// the level data is the parcels, so its instance isn't the stitched parcel id
+	ConstLevelDataPair lookupAtWorld(Math::vec3 const& world_, float const range_, uint32_t const levelMask_) const;
+	bool lookupVolumeAtWorld(Math::vec3 const& world_, float const range_, uint32_t const levelMask_, TacticalMapVolume* out_) const;
+	// copies out the level data with the stitched parcel id as its instance
+	bool lookupLevelDataAtWorld(Math::vec3 const& world_, float const range_, uint32_t const levelMask_, TacticalMapLevelDataHeader* out_) const;
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	Math::vec2 getBottomLeft() const { return bottomLeft; }
+	Geometry::AABB getAABB() const
+	{
+		return Geometry::AABB(Math::vec3(bottomLeft.x, minHeight, bottomLeft.y),
+							  Math::vec3(bottomLeft.x + width, maxHeight, bottomLeft.y + height));
+	}
+
+private:
+	struct Parcel
+	{
+		std::shared_ptr<TacticalMap const> map;
+		uint32_t mapParcelId;
+	};
+
+	// parcel is InvalidParcel where no instance covers the tile
+	struct Source
+	{
+		uint32_t parcel;
+		uint32_t tileIndex;
+	};
+	static constexpr uint32_t InvalidParcel = ~0u;
+
+	// returns null where there is no tile
+	TacticalMapTile const* findTile(Math::vec3 const& world_, Parcel const*& parcel_) const;
+
+	int width = 0;
+	int height = 0;
+	Math::vec2 bottomLeft;
+	float minHeight, maxHeight;
+	std::vector<Parcel> parcels;
+	std::vector<Source> grid;
+};
+
 class TacticalMapStitcher : public ITacticalMapStitcher
 {
 public:
@@ -16,8 +65,40 @@ public:
 
 	void addTacticalMapInstance(std::shared_ptr<TacticalMap const>  map_, Math::vec3 const position_, int rotationInDegrees_, int mapParcelId_) override;
 	std::shared_ptr<TacticalMap> build() override;
+	std::shared_ptr<TacticalMapVirtualStitch const> buildVirtual() override;
 private:
-	Math::vec3 rotateVector(Math::vec3 const& v, int rotationInDegrees_);
+	// where an instance lands in the stitched map and which of its tiles go where. the source tile for
+	// stitched tile (destX + x, destZ + z) is (xOffset + xFromX * x + xFromZ * z, zOffset + ...) clamped
+	struct Placement
+	{
+		TacticalMap const* map;
+		uint32_t mapParcelId;
+		uint32_t levelBase;
+		int destX, destZ;
+		int xFromX, xFromZ, xOffset;
+		int zFromX, zFromZ, zOffset;
+
+		void getSourceTile(int x_, int z_, int& outX_, int& outZ_) const;
+	};
+
+	struct Plan
+	{
+		Math::vec3 minExtents;
+		Math::vec3 maxExtents;
+		int width, height;
+		uint32_t levelCount;
+		uint32_t sizeOfLevelData;
+		TacticalMapTileLayout tileLayout;
+		std::vector<Placement> placements;
+	};
+
+	void makePlan(Plan& out_) const;
+	// calls func_(placementIndex, x, z) for every placement over every stitched tile, a row per task
+	// and placements in order so later instances still win where they overlap
+	template<typename Func>
+	void visitStitchedTiles(Plan const& plan_, Func&& func_) const;
+
+	static int getQuarterTurns(int rotationInDegrees_);
 	Geometry::AABB rotateAABB(Geometry::AABB const& v, int rotationInDegrees_);
 	using Instances = std::tuple<std::shared_ptr<TacticalMap const>, Math::vec3, int, unsigned int>;
 	std::vector<Instances> instances;
@@ -0,0 +1,277 @@
+#include "core/core.h"
+#include "tacticalmap.h"
+#include <array>
+#include <cmath>
+
+namespace {
+// a map 65535 tiles wide has 14 levels of summaries
+static const int MaxSummaryLevels = 16;
+
+// where each level of the summaries starts and how many blocks it has, finest first
+struct SummaryLevels
+{
+	int count = 0;
+	uint32_t nodeCount = 0;
+	std::array<uint32_t, MaxSummaryLevels> offset;
+	std::array<int, MaxSummaryLevels> width;
+	std::array<int, MaxSummaryLevels> height;
+
+	SummaryLevels(int mapWidth_, int mapHeight_)
+	{
+		int w = std::max(1, (mapWidth_ + TacticalMap::SummaryBlockSize - 1) / TacticalMap::SummaryBlockSize);
+		int h = std::max(1, (mapHeight_ + TacticalMap::SummaryBlockSize - 1) / TacticalMap::SummaryBlockSize);
+		while(true)
+		{
+			assert(count < MaxSummaryLevels);
+			offset[count] = nodeCount;
+			width[count] = w;
+			height[count] = h;
+			nodeCount += uint32_t(w * h);
+			count++;
+			if(w == 1 && h == 1) break;
+			w = (w + 1) / 2;
+			h = (h + 1) / 2;
+		}
+	}
+};
+
+TacticalMapAreaSummary EmptySummary()
+{
+	float const highest = std::numeric_limits<float>::max();
+	float const lowest = std::numeric_limits<float>::lowest();
+	return TacticalMapAreaSummary{ highest, lowest, highest, lowest, 0, 0, 0 };
+}
+
+uint16_t SaturatingAdd(uint16_t a_, uint32_t b_)
+{
+	return (uint16_t) std::min<uint32_t>(uint32_t(a_) + b_, 0xFFFF);
+}
+
+void Merge(TacticalMapAreaSummary& into_, TacticalMapAreaSummary const& from_)
+{
+	into_.minFloor = std::min(into_.minFloor, from_.minFloor);
+	into_.maxFloor = std::max(into_.maxFloor, from_.maxFloor);
+	into_.minRoof = std::min(into_.minRoof, from_.minRoof);
+	into_.maxRoof = std::max(into_.maxRoof, from_.maxRoof);
+	into_.layerMask |= from_.layerMask;
+	into_.levelCount = SaturatingAdd(into_.levelCount, from_.levelCount);
+	into_.destroyedCount = SaturatingAdd(into_.destroyedCount, from_.destroyedCount);
+}
+
+TacticalMapAreaSummary SummariseTile(TacticalMap const& map_, TacticalMapTile const& tile_)
+{
+	TacticalMapAreaSummary result = EmptySummary();
+	for(auto levelIndex = 0u; levelIndex < tile_.levelCount; ++levelIndex)
+	{
+		result.levelCount = SaturatingAdd(result.levelCount, 1);
+		if(map_.isLevelDestroyed(tile_, levelIndex))
+		{
+			result.destroyedCount = SaturatingAdd(result.destroyedCount, 1);
+			continue;
+		}
+
+		TacticalMapTileLevel const& level = map_.getLevel(tile_, levelIndex);
+		float const floor = TacticalMap::getLevelHeight(tile_, level);
+		float const roof = std::min(TacticalMap::getRoofHeight(tile_, level), std::numeric_limits<float>::max());
+		result.minFloor = std::min(result.minFloor, floor);
+		result.maxFloor = std::max(result.maxFloor, floor);
+		result.minRoof = std::min(result.minRoof, roof);
+		result.maxRoof = std::max(result.maxRoof, roof);
+		result.layerMask |= Core::Bit(level.layer);
+	}
+	return result;
+}
+
+}
+
+uint32_t TacticalMap::countSummaryNodes(int width_, int height_)
+{
+	return SummaryLevels(width_, height_).nodeCount;
+}
+
+TacticalMap::TileRect TacticalMap::getTileRect(Geometry::AABB const& box_) const
+{
+	// tile x covers [x - 0.5, x + 0.5) from the bottom left
+	Math::vec2 const lo = worldToLocal(box_.getMinExtent()) + Math::vec2(0.5f, 0.5f);
+	Math::vec2 const hi = worldToLocal(box_.getMaxExtent()) + Math::vec2(0.5f, 0.5f);
+	TileRect rect;
+	rect.x0 = (int) Math::clamp(std::floor(lo.x), 0.0f, (float) width);
+	rect.z0 = (int) Math::clamp(std::floor(lo.y), 0.0f, (float) height);
+	rect.x1 = (int) Math::clamp(std::floor(hi.x) + 1.0f, 0.0f, (float) width);
+	rect.z1 = (int) Math::clamp(std::floor(hi.y) + 1.0f, 0.0f, (float) height);
+	return rect;
+}
+
+void TacticalMap::updateSummary(TileRect const& rect_)
+{
+	assert(summary != nullptr);
+	if(rect_.empty()) return;
+
+	SummaryLevels const summaryLevels(width, height);
+
+	// blocks touched at the finest level, each level up halves them
+	int bx0 = rect_.x0 / SummaryBlockSize;
+	int bz0 = rect_.z0 / SummaryBlockSize;
+	int bx1 = (rect_.x1 - 1) / SummaryBlockSize;
+	int bz1 = (rect_.z1 - 1) / SummaryBlockSize;
+
+	for(auto bz = bz0; bz <= bz1; ++bz)
+	{
+		for(auto bx = bx0; bx <= bx1; ++bx)
+		{
+			TacticalMapAreaSummary node = EmptySummary();
+			int const xEnd = std::min<int>(width, (bx + 1) * SummaryBlockSize);
+			int const zEnd = std::min<int>(height, (bz + 1) * SummaryBlockSize);
+			for(auto z = bz * SummaryBlockSize; z < zEnd; ++z)
+			{
+				for(auto x = bx * SummaryBlockSize; x < xEnd; ++x)
+				{
+					Merge(node, SummariseTile(*this, getTile(x, z)));
+				}
+			}
+			summary[summaryLevels.offset[0] + (bz * summaryLevels.width[0]) + bx] = node;
+		}
+	}
+
+	for(auto summaryLevel = 1; summaryLevel < summaryLevels.count; ++summaryLevel)
+	{
+		bx0 /= 2; bz0 /= 2;
+		bx1 /= 2; bz1 /= 2;
+		int const childWidth = summaryLevels.width[summaryLevel - 1];
+		int const childHeight = summaryLevels.height[summaryLevel - 1];
+		TacticalMapAreaSummary const* children = summary + summaryLevels.offset[summaryLevel - 1];
+
+		for(auto bz = bz0; bz <= bz1; ++bz)
+		{
+			for(auto bx = bx0; bx <= bx1; ++bx)
+			{
+				TacticalMapAreaSummary node = EmptySummary();
+				for(auto cz = bz * 2; cz < std::min(childHeight, (bz * 2) + 2); ++cz)
+				{
+					for(auto cx = bx * 2; cx < std::min(childWidth, (bx * 2) + 2); ++cx)
+					{
+						Merge(node, children[(cz * childWidth) + cx]);
+					}
+				}
+				summary[summaryLevels.offset[summaryLevel] + (bz * summaryLevels.width[summaryLevel]) + bx] = node;
+			}
+		}
+	}
+}
+
+void TacticalMap::updateSummary(Geometry::AABB const& box_)
+{
+	updateSummary(getTileRect(box_));
+}
+
+template<typename NodeFunc, typename TileFunc>
+bool TacticalMap::visitSummary(TileRect const& rect_, NodeFunc&& node_, TileFunc&& tile_) const
+{
+	assert(summary != nullptr);
+	if(rect_.empty()) return true;
+
+	SummaryLevels const summaryLevels(width, height);
+
+	// each block popped pushes at most 4 children, so 3 per level plus the top is enough
+	struct Block { int level, x, z; };
+	std::array<Block, (MaxSummaryLevels * 3) + 1> stack;
+	size_t stackSize = 0;
+	stack[stackSize++] = Block{ summaryLevels.count - 1, 0, 0 };
+
+	while(stackSize > 0)
+	{
+		Block const block = stack[--stackSize];
+		int const size = SummaryBlockSize << block.level;
+		TileRect const blockRect{ block.x * size, block.z * size,
+								  std::min<int>(width, (block.x + 1) * size),
+								  std::min<int>(height, (block.z + 1) * size) };
+		TileRect const overlap{ std::max(blockRect.x0, rect_.x0), std::max(blockRect.z0, rect_.z0),
+								std::min(blockRect.x1, rect_.x1), std::min(blockRect.z1, rect_.z1) };
+		if(overlap.empty()) continue;
+
+		bool const whollyInRect = overlap.x0 == blockRect.x0 && overlap.z0 == blockRect.z0 &&
+								  overlap.x1 == blockRect.x1 && overlap.z1 == blockRect.z1;
+		TacticalMapAreaSummary const& node =
+				summary[summaryLevels.offset[block.level] + (block.z * summaryLevels.width[block.level]) + block.x];
+		SummaryVisit const visit = node_(node, whollyInRect);
+		if(visit == SummaryVisit::Stop) return false;
+		if(visit == SummaryVisit::Skip) continue;
+
+		if(block.level == 0)
+		{
+			for(auto z = overlap.z0; z < overlap.z1; ++z)
+			{
+				for(auto x = overlap.x0; x < overlap.x1; ++x)
+				{
+					if(!tile_(x, z)) return false;
+				}
+			}
+			continue;
+		}
+
+		int const childLevel = block.level - 1;
+		for(auto cz = block.z * 2; cz < std::min(summaryLevels.height[childLevel], (block.z * 2) + 2); ++cz)
+		{
+			for(auto cx = block.x * 2; cx < std::min(summaryLevels.width[childLevel], (block.x * 2) + 2); ++cx)
+			{
+				assert(stackSize < stack.size());
+				stack[stackSize++] = Block{ childLevel, cx, cz };
+			}
+		}
+	}
+	return true;
+}
+
+TacticalMapAreaSummary TacticalMap::summariseArea(Geometry::AABB const& box_) const
+{
+	TacticalMapAreaSummary result = EmptySummary();
+	visitSummary(getTileRect(box_),
+				 [&result](TacticalMapAreaSummary const& node_, bool const whollyInRect_)
+				 {
+					 if(node_.levelCount == 0) return SummaryVisit::Skip;
+					 if(!whollyInRect_) return SummaryVisit::Descend;
+					 Merge(result, node_);
+					 return SummaryVisit::Skip;
+				 },
+				 [this, &result](int x_, int z_)
+				 {
+					 Merge(result, SummariseTile(*this, getTile(x_, z_)));
+					 return true;
+				 });
+	return result;
+}
+
+bool TacticalMap::anyLevelInArea(Geometry::AABB const& box_, uint32_t const levelMask_) const
+{
+	float const ymin = box_.getMinExtent().y;
+	float const ymax = box_.getMaxExtent().y;
+
+	return !visitSummary(getTileRect(box_),
+						 [ymin, ymax, levelMask_](TacticalMapAreaSummary const& node_, bool const whollyInRect_)
+						 {
+							 // layerMask only has the layers of levels that aren't destroyed
+							 if((node_.layerMask & levelMask_) == 0) return SummaryVisit::Skip;
+							 if(node_.maxFloor < ymin || node_.minFloor > ymax) return SummaryVisit::Skip;
+							 // every level left is one being looked for
+							 if(whollyInRect_ && (node_.layerMask & ~levelMask_) == 0 &&
+								node_.minFloor >= ymin && node_.maxFloor <= ymax)
+							 {
+								 return SummaryVisit::Stop;
+							 }
+							 return SummaryVisit::Descend;
+						 },
+						 [this, ymin, ymax, levelMask_](int x_, int z_)
+						 {
+							 TacticalMapTile const& tile = getTile(x_, z_);
+							 for(auto levelIndex = 0u; levelIndex < tile.levelCount; ++levelIndex)
+							 {
+								 TacticalMapTileLevel const& level = getLevel(tile, levelIndex);
+								 if((Core::Bit(level.layer) & levelMask_) == 0) continue;
+								 float const floor = getLevelHeight(tile, level);
+								 if(floor < ymin || floor > ymax) continue;
+								 if(isLevelDestroyed(tile, levelIndex)) continue;
+								 return false;
+							 }
+							 return true;
+						 });
+}
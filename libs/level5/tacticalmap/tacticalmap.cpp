@@ -6,24 +6,108 @@
 #include "meshops/basicmeshops.h"
 #include "geometry/ray.h"
 #include "geometry/watertightray.h"
-#include "enkiTS/src/TaskScheduler.h"
+#include "core/sharedtasks.h"
 #include "meshops/layeredtexture.h"
 #include "builder.h"
 #include "stitcher.h"
+#include "pathfinder.h"
 #include "tacticalmap.h"
 #include "binny/bundle.h"
 #include "binny/bundlewriter.h"
+#include "binny/inplacebundle.h"
 #include <algorithm>
 #include <sstream>
 #include <array>
 #include <unordered_set>
+#include <map>
 #include <stack>
+#include <atomic>
+#include <fstream>
+#if PLATFORM == POSIX || PLATFORM == APPLE_MAC
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 namespace {
 using namespace Binny;
 static const uint32_t TacticalMapId = "TACM"_bundle_id;
+static const uint32_t TacticalMapSummaryId = "TMSU"_bundle_id;
+static const uint16_t SummaryMajorVersion = 1;
+static const uint16_t SummaryMinorVersion = 0;
+
+// the summary chunk, saved after the map chunk its for
+struct TacticalMapSummaryChunk
+{
+	uint16_t width, height;
+	uint32_t nodeCount;
+	TacticalMapAreaSummary* nodes;
+};
+
+// versions made by damageStructures keep the map they started from alive for its tiles and levels.
+// pages[i] is the copy of level data page i a version (or one of its parents) made, null if still the bases
+struct TacticalMapVersionDeleter
+{
+	std::shared_ptr<TacticalMap const> base;
+	std::vector<std::shared_ptr<uint8_t>> pages;
+
+	void operator()(TacticalMap* ptr_) const { free(ptr_); }
+};
+
+// batches with fewer queries than this aren't worth splitting across task threads
+static const size_t BatchQueriesPerTask = 2048;
+// batched queries are ordered by square blocks of this many tiles
+static const int BatchBlockSize = 8;
+
+// most floors and roofs are flat, so skip the octahedral decode for straight up and down
+Math::vec3 DecodeLevelNormal(int16_t const (&normal_)[2])
+{
+	if(normal_[0] == 0 && normal_[1] == 32767) return Math::vec3(0, 1, 0);
+	if(normal_[0] == 0 && normal_[1] == -32767) return Math::vec3(0, -1, 0);
+	return Math::DecodeOctahedral(normal_[0], normal_[1]);
+}
+
+void FillVolume(TacticalMapTile const& tile_, TacticalMapTileLevel const& level_, TacticalMapVolume* out_)
+{
+	out_->floorNormal = TacticalMap::getFloorNormal(level_);
+	out_->levelHeight = TacticalMap::getLevelHeight(tile_, level_);
+	out_->roofNormal = TacticalMap::getRoofNormal(level_);
+	out_->roofHeight = TacticalMap::getRoofHeight(tile_, level_);
+}
+
+// the layout maps were saved with before MajorVersion 8
+struct TacticalMapTileLevelV7
+{
+	Math::Plane floorPlane;
+	Math::Plane roofPlane;
+
+	float baseHeight;
+	float roofDeltaHeight;
+	uint32_t padd[2];
+};
+static_assert(sizeof(TacticalMapTileLevelV7) == 48);
+
+struct TacticalMapTileV7
+{
+	uint32_t levelCount;
+	uint32_t levelStartIndex;
+};
+static_assert(sizeof(TacticalMapTileV7) == 8);
+
+// before MajorVersion 11 levels had a byte of flags then the layer where the top flags are now
+void ConvertLevelFlagsFromVersion10(TacticalMapTileLevel* levels_, uint32_t const count_)
+{
+	for(auto i = 0u; i < count_; ++i)
+	{
+		auto const bytes = (uint8_t const*) &levels_[i];
+		uint8_t const flags = bytes[4];
+		uint8_t const layer = bytes[5];
+		levels_[i].flags = flags;
+		levels_[i].layer = layer;
+	}
+}
 }
-extern enki::TaskScheduler g_EnkiTS;
 
 ITacticalMapBuilder::Ptr TacticalMap::allocateBuilder(Math::vec2 const bottomLeft_, TileCoord_t width_,
 													  TileCoord_t height_, char const* name_)
@@ -36,6 +120,12 @@ ITacticalMapStitcher::Ptr TacticalMap::allocateStitcher(char const* name_)
 	return std::make_shared<TacticalMapStitcher>(name_);
 }
 
+ITacticalMapPathfinder::Ptr TacticalMap::allocatePathfinder(std::shared_ptr<TacticalMap const> map_,
+															TacticalMapPathSettings const& settings_)
+{
+	return std::make_shared<TacticalMapPathfinder>(std::move(map_), settings_);
+}
+
 TacticalMap::ConstLevelDataPair TacticalMap::lookupAtWorld(
 		Math::vec3 const& world_,
 		float const range_, uint32_t
@@ -44,36 +134,39 @@ TacticalMap::ConstLevelDataPair TacticalMap::lookupAtWorld(
 
 	TileCoord_t x, y;
 	worldToLocal(world_, x, y);
-	auto const& tile = map[y * getWidth() + x];
+	return lookupInTile(getTile(x, y), world_.y, range_, levelMask_);
+}
+
+TacticalMap::ConstLevelDataPair TacticalMap::lookupInTile(
+		TacticalMapTile const& tile,
+		float const y_,
+		float const range_,
+		uint32_t const levelMask_) const
+{
 	if(tile.levelCount == 0) { return {}; }
 
-	float const bottomY = world_.y - range_;
-	float const topY = world_.y + range_;
+	float const bottomY = y_ - range_;
+	float const topY = y_ + range_;
 
 	for(auto levelIndex = 0u; levelIndex < tile.levelCount; ++levelIndex)
 	{
 		TacticalMapTileLevel const& level = getLevel(tile, levelIndex);
-		TacticalMapLevelDataHeader const* levelData = getLevelData(tile, levelIndex);
 
-		if(levelData->flags & TacticalMapLevelFlags::Destroyed) continue;
-		if((Core::Bit(levelData->layer) & levelMask_) == 0) continue;
+		if(level.flags & TacticalMapLevelFlags::Destroyed) continue;
+		if((Core::Bit(level.layer) & levelMask_) == 0) continue;
 
-		assert(levelData->levelNum == levelIndex);
-		assert(!std::isnan(level.baseHeight));
-		assert(level.baseHeight < 1e6f);
+		assert(getLevelData(tile, levelIndex)->levelNum == levelIndex);
 
-		float const bottomLevel = level.baseHeight;
-		float const topLevel = (levelData->flags & TacticalMapLevelFlags::RoofValid) ?
-							   level.baseHeight + level.roofDeltaHeight : std::numeric_limits<float>::infinity();
+		float const bottomLevel = getLevelHeight(tile, level);
 
 		// level is above the search range, stop the search
 		if(topY < bottomLevel) return {};
 
 		// level is below the search range, continue search to next level
-		//		if (bottomY > topLevel ) continue;
+		//		if (bottomY > getRoofHeight(tile, level) ) continue;
 		if(bottomY > bottomLevel) continue;
 
-		return {&level, levelData};
+		return {&level, getLevelData(tile, levelIndex)};
 	}
 
 	// search range is beyond the top layer, shouldn't really happen i think...
@@ -101,20 +194,13 @@ bool TacticalMap::lookupVolumeAtWorld(
 {
 	assert(out_ != nullptr);
 
-	auto[level, levelData] = lookupAtWorld(world_, range_, levelMask_);
+	TileCoord_t x, y;
+	worldToLocal(world_, x, y);
+	TacticalMapTile const& tile = getTile(x, y);
+	auto[level, levelData] = lookupInTile(tile, world_.y, range_, levelMask_);
 	if(level == nullptr || levelData == nullptr) return false;
 
-	constexpr float finf = std::numeric_limits<float>::infinity();
-	float const bottomLevel = level->baseHeight;
-	float const topLevel = level->baseHeight +
-						   (levelData->flags & TacticalMapLevelFlags::RoofValid) ? level->roofDeltaHeight : finf;
-
-	out_->floorNormal = level->floorPlane.normal();
-	out_->levelHeight = bottomLevel;
-	out_->roofNormal = Math::vec3(0, 1, 0);
-	if(levelData->flags & TacticalMapLevelFlags::RoofValid) level->roofPlane.normal();
-
-	out_->roofHeight = topLevel;
+	FillVolume(tile, *level, out_);
 	return true;
 }
 
@@ -134,80 +220,441 @@ bool TacticalMap::lookupLevelDataAtWorld(
 	return true;
 }
 
-void TacticalMap::damageStructure(Geometry::AABB const& box)
+template<typename Func>
+void TacticalMap::visitLookupsAtWorld(
+		Math::vec3 const* points_,
+		size_t const count_,
+		float const range_,
+		uint32_t const levelMask_,
+		Func&& func_) const
+{
+	assert(points_ != nullptr || count_ == 0);
+	if(count_ == 0) return;
+
+	// bucket the queries by block of tiles, a counting sort so the cost stays linear
+	int const blocksWide = (getWidth() + BatchBlockSize - 1) / BatchBlockSize;
+	int const blocksHigh = (getHeight() + BatchBlockSize - 1) / BatchBlockSize;
+	// each point is converted to tile space once, the block is kept for the scatter pass
+	std::vector<uint32_t> tileIndices(count_);
+	std::vector<uint32_t> blockIndices(count_);
+	std::vector<uint32_t> blockStarts(size_t(blocksWide * blocksHigh) + 1, 0);
+	for(size_t i = 0; i < count_; ++i)
+	{
+		TileCoord_t x, y;
+		worldToLocal(points_[i], x, y);
+		tileIndices[i] = getTileIndex(x, y);
+		blockIndices[i] = uint32_t(((y / BatchBlockSize) * blocksWide) + (x / BatchBlockSize));
+		blockStarts[blockIndices[i] + 1]++;
+	}
+	for(size_t i = 1; i < blockStarts.size(); ++i)
+	{
+		blockStarts[i] += blockStarts[i - 1];
+	}
+	std::vector<uint32_t> order(count_);
+	for(size_t i = 0; i < count_; ++i)
+	{
+		order[blockStarts[blockIndices[i]]++] = uint32_t(i);
+	}
+
+	auto lookupRange = [this, points_, range_, levelMask_, &func_, &order, &tileIndices](size_t begin_, size_t end_)
+	{
+		for(size_t i = begin_; i < end_; ++i)
+		{
+			uint32_t const queryIndex = order[i];
+			TacticalMapTile const& tile = map[tileIndices[queryIndex]];
+			func_(queryIndex, tile, lookupInTile(tile, points_[queryIndex].y, range_, levelMask_));
+		}
+	};
+
+	// big batches are split across the task threads unless another thread is already submitting
+	Core::ParallelFor((uint32_t) count_, (uint32_t) BatchQueriesPerTask,
+					  [&lookupRange](uint32_t const begin_, uint32_t const end_, uint32_t)
+					  {
+						  lookupRange(begin_, end_);
+					  });
+}
+
+void TacticalMap::lookupAtWorldBatch(
+		Math::vec3 const* points_,
+		size_t const count_,
+		float const range_,
+		uint32_t const levelMask_,
+		ConstLevelDataPair* out_) const
+{
+	assert(out_ != nullptr || count_ == 0);
+	visitLookupsAtWorld(points_, count_, range_, levelMask_, [out_](size_t i, TacticalMapTile const&, ConstLevelDataPair const& found)
+	{
+		out_[i] = found;
+	});
+}
+
+size_t TacticalMap::lookupVolumeAtWorldBatch(
+		Math::vec3 const* points_,
+		size_t const count_,
+		float const range_,
+		uint32_t const levelMask_,
+		TacticalMapVolume* out_) const
 {
-	TileCoord_t ixmin, izmin;
-	TileCoord_t ixmax, izmax;
+	assert(out_ != nullptr || count_ == 0);
+	std::atomic<size_t> hits{ 0 };
+	visitLookupsAtWorld(points_, count_, range_, levelMask_, [out_, &hits](size_t i, TacticalMapTile const& tile, ConstLevelDataPair const& found)
+	{
+		auto const[level, levelData] = found;
+		if(level == nullptr || levelData == nullptr)
+		{
+			out_[i] = {};
+			out_[i].levelHeight = std::numeric_limits<float>::quiet_NaN();
+			return;
+		}
+		FillVolume(tile, *level, out_ + i);
+		hits.fetch_add(1, std::memory_order_relaxed);
+	});
+	return hits.load();
+}
+
+size_t TacticalMap::lookupLevelDataAtWorldBatch(
+		Math::vec3 const* points_,
+		size_t const count_,
+		float const range_,
+		uint32_t const levelMask_,
+		uint8_t* out_) const
+{
+	assert(out_ != nullptr || count_ == 0);
+	std::atomic<size_t> hits{ 0 };
+	visitLookupsAtWorld(points_, count_, range_, levelMask_, [this, out_, &hits](size_t i, TacticalMapTile const&, ConstLevelDataPair const& found)
+	{
+		uint8_t* const out = out_ + (i * sizeOfTacticalLevelData);
+		auto const[level, levelData] = found;
+		if(level == nullptr || levelData == nullptr)
+		{
+			std::memset(out, 0, sizeOfTacticalLevelData);
+			return;
+		}
+		std::memcpy(out, levelData, sizeOfTacticalLevelData);
+		hits.fetch_add(1, std::memory_order_relaxed);
+	});
+	return hits.load();
+}
+
+std::shared_ptr<TacticalMap> TacticalMap::allocate(
+		uint16_t const width_,
+		uint16_t const height_,
+		TacticalMapTileLayout const layout_,
+		uint32_t const levelCount_,
+		uint32_t const sizeOfLevelData_,
+		std::string_view name_)
+{
+	uint32_t const tileCount = countTiles(width_, height_, layout_);
+
+	size_t const levelMemorySize = sizeof(TacticalMapTileLevel) * levelCount_;
+	size_t const levelDataMemorySize = size_t(sizeOfLevelData_) * levelCount_;
+	size_t const mapMemorySize = sizeof(TacticalMapTile) * tileCount;
+	size_t const summaryMemorySize = sizeof(TacticalMapAreaSummary) * countSummaryNodes(width_, height_);
+	size_t const memorySize = sizeof(TacticalMap) +
+							  levelMemorySize +
+							  levelDataMemorySize +
+							  mapMemorySize +
+							  summaryMemorySize;
+
+	auto memory = (uint8_t*) malloc(memorySize);
+
+	auto const levels = (TacticalMapTileLevel*) (memory + sizeof(TacticalMap));
+	auto const levelDatasByte = ((uint8_t*) levels) + levelMemorySize;
+	auto const map = (TacticalMapTile*) (levelDatasByte + levelDataMemorySize);
+	auto const summary = (TacticalMapAreaSummary*) (((uint8_t*) map) + mapMemorySize);
+	assert(size_t((((uint8_t*) summary) + summaryMemorySize) - memory) == memorySize);
+
+	// padding tiles of partial morton blocks are never written by the builders
+	std::memset(map, 0, mapMemorySize);
+
+	TacticalMap* tmap = new(memory) TacticalMap();
+	tmap->width = width_;
+	tmap->height = height_;
+	tmap->tileLayout = layout_;
+	tmap->padd1 = 0;
+	tmap->levelCount = levelCount_;
+	tmap->bottomLeft = Math::vec2(0, 0);
+	tmap->minHeight = 0;
+	tmap->maxHeight = 0;
+	tmap->sizeOfTacticalMapTile = sizeof(TacticalMapTile);
+	tmap->sizeOfTacticalMapTileLevel = sizeof(TacticalMapTileLevel);
+	tmap->sizeOfTacticalLevelData = sizeOfLevelData_;
+	char* tname = (char*) malloc(name_.size() + 1);
+	std::memcpy(tname, name_.data(), name_.size());
+	tname[name_.size()] = '\0';
+	tmap->name = tname;
+
+	tmap->levels = levels;
+	tmap->map = map;
+	tmap->levelDataHeap = levelDatasByte;
+	tmap->summary = summary;
+
+	return std::shared_ptr<TacticalMap>(tmap,
+										[](TacticalMap* ptr)
+										{
+											if(ptr) free((void*) ptr->name);
+											free(ptr);
+										});
+}
+
+std::shared_ptr<TacticalMap> TacticalMap::convertFromVersion8(TacticalMap const* old_)
+{
+	// only the header grew, the tiles, levels and level data are unchanged
+	auto result = allocate(old_->width, old_->height, old_->tileLayout,
+						   old_->levelCount, old_->sizeOfTacticalLevelData, old_->name);
+	result->bottomLeft = old_->bottomLeft;
+	result->minHeight = old_->minHeight;
+	result->maxHeight = old_->maxHeight;
+	std::memcpy(result->levels, old_->levels, size_t(old_->levelCount) * sizeof(TacticalMapTileLevel));
+	ConvertLevelFlagsFromVersion10(result->levels, result->levelCount);
+	std::memcpy(result->map, old_->map, size_t(result->getTileCount()) * sizeof(TacticalMapTile));
+	std::memcpy(result->levelDataHeap, old_->levelDataHeap, size_t(old_->levelCount) * old_->sizeOfTacticalLevelData);
+	if(!result->convertBaseHeightsFromVersion11()) return nullptr;
+	result->updateSummary(TileRect{ 0, 0, result->width, result->height });
+	return result;
+}
+
+bool TacticalMap::convertBaseHeightsFromVersion11()
+{
+	int32_t const scale = TacticalMapTile::BaseHeightScale;
+	for(auto i = 0u; i < getTileCount(); ++i)
+	{
+		TacticalMapTile& tile = map[i];
+		// the old base rounded down to a whole step, the remainder goes on each level
+		int32_t const base = int32_t(std::floor(float(tile.baseHeight) / float(scale)));
+		int32_t const remainder = int32_t(tile.baseHeight) - base * scale;
+		tile.baseHeight = (int16_t) base;
+		for(auto levelIndex = 0u; levelIndex < tile.levelCount; ++levelIndex)
+		{
+			TacticalMapTileLevel& level = levels[tile.levelStartIndex + levelIndex];
+			int32_t const height = int32_t(level.height) + remainder;
+			if(height > 0xFFFF) return false;
+			level.height = (uint16_t) height;
+		}
+	}
+	return true;
+}
+
+std::shared_ptr<TacticalMap> TacticalMap::convertFromVersion7(TacticalMap const* old_)
+{
+	// the header is unchanged so only the levels and tiles need reinterpreting
+	auto const oldLevels = (TacticalMapTileLevelV7 const*) old_->levels;
+	auto const oldMap = (TacticalMapTileV7 const*) old_->map;
+
+	auto result = allocate(old_->width, old_->height, TacticalMapTileLayout::RowMajor,
+						   old_->levelCount, old_->sizeOfTacticalLevelData, old_->name);
+	result->bottomLeft = old_->bottomLeft;
+	result->minHeight = old_->minHeight;
+	result->maxHeight = old_->maxHeight;
+	std::memcpy(result->levelDataHeap, old_->levelDataHeap, size_t(old_->levelCount) * old_->sizeOfTacticalLevelData);
+
+	for(auto i = 0; i < old_->width * old_->height; ++i)
+	{
+		TacticalMapTileV7 const& oldTile = oldMap[i];
+		TacticalMapTile& tile = result->map[i];
+		tile.levelCount = (uint16_t) oldTile.levelCount;
+		tile.levelStartIndex = oldTile.levelStartIndex;
+		if(oldTile.levelCount == 0) continue;
+
+		float lowest = std::numeric_limits<float>::max();
+		for(auto levelIndex = 0u; levelIndex < oldTile.levelCount; ++levelIndex)
+		{
+			lowest = std::min(lowest, oldLevels[oldTile.levelStartIndex + levelIndex].baseHeight);
+		}
+		if(!encodeTileBaseHeight(lowest, tile.baseHeight)) return nullptr;
 
-	float const ymin = box.getMinExtent().y;
-	float const ymax = box.getMaxExtent().y;
+		for(auto levelIndex = 0u; levelIndex < oldTile.levelCount; ++levelIndex)
+		{
+			TacticalMapTileLevelV7 const& oldLevel = oldLevels[oldTile.levelStartIndex + levelIndex];
+			TacticalMapLevelDataHeader const* levelData = result->getLevelData(tile, levelIndex);
+			bool const okay = encodeLevel(tile.baseHeight,
+										  oldLevel.baseHeight, oldLevel.roofDeltaHeight,
+										  oldLevel.floorPlane.normal(), oldLevel.roofPlane.normal(),
+										  levelData->flags, levelData->layer,
+										  result->levels[oldTile.levelStartIndex + levelIndex]);
+			if(!okay) return nullptr;
+		}
+	}
+	result->updateSummary(TileRect{ 0, 0, result->width, result->height });
+	return result;
+}
 
-	worldToLocal(box.getMinExtent(), ixmin, izmin);
-	worldToLocal(box.getMaxExtent(), ixmax, izmax);
+bool TacticalMap::encodeTileBaseHeight(float const lowestLevelHeight_, int16_t& out_)
+{
+	float const step = TacticalMapTileLevel::HeightQuantum * float(TacticalMapTile::BaseHeightScale);
+	float const quantised = std::floor(lowestLevelHeight_ / step);
+	// !(a && b) so NaNs are rejected too
+	if(!(quantised >= (float) std::numeric_limits<int16_t>::min() &&
+		 quantised <= (float) std::numeric_limits<int16_t>::max()))
+	{
+		return false;
+	}
+	out_ = (int16_t) quantised;
+	return true;
+}
 
-	// fatten up slivers
-	if(ixmin == ixmax)
+bool TacticalMap::encodeLevel(
+		int16_t const tileBaseHeight_,
+		float const height_,
+		float const roofDeltaHeight_,
+		Math::vec3 const& floorNormal_,
+		Math::vec3 const& roofNormal_,
+		uint32_t const flags_,
+		uint8_t const layer_,
+		TacticalMapTileLevel& out_)
+{
+	float const quantum = TacticalMapTileLevel::HeightQuantum;
+
+	TacticalMapTileLevel level{};
+	float const floorQuantised = std::round(height_ / quantum);
+	float const height = floorQuantised - float(int32_t(tileBaseHeight_) * TacticalMapTile::BaseHeightScale);
+	if(!(height >= 0.0f && height <= 65535.0f)) return false;
+	level.height = (uint16_t) height;
+
+	if(flags_ & TacticalMapLevelFlags::RoofValid)
 	{
-		if(ixmin > 0) ixmin--;
-		else ixmax++;
+		// round the roof itself rather than the delta so it's as accurate as the floor
+		float const roofDelta = std::round((height_ + roofDeltaHeight_) / quantum) - floorQuantised;
+		if(!(roofDelta >= 0.0f && roofDelta < float(TacticalMapTileLevel::NoRoof))) return false;
+		level.roofDeltaHeight = (uint16_t) roofDelta;
 	}
-	if(izmin == izmax)
+	else
 	{
-		if(izmin > 0) izmin--;
-		else izmax++;
+		level.roofDeltaHeight = TacticalMapTileLevel::NoRoof;
 	}
 
-	ixmin = Math::clamp<TileCoord_t>(ixmin, 0, width);
-	izmin = Math::clamp<TileCoord_t>(izmin, 0, height);
-	ixmax = Math::clamp<TileCoord_t>(ixmax, 0, width);
-	izmax = Math::clamp<TileCoord_t>(izmax, 0, height);
+	assert(flags_ <= 0xFFFFFF);
+	level.flags = flags_;
+	level.layer = layer_;
+
+	auto const floorNormal = Math::EncodeOctahedral(floorNormal_);
+	level.floorNormal[0] = floorNormal[0];
+	level.floorNormal[1] = floorNormal[1];
+	auto const roofNormal = Math::EncodeOctahedral((flags_ & TacticalMapLevelFlags::RoofValid) ?
+														  roofNormal_ : Math::vec3(0, 1, 0));
+	level.roofNormal[0] = roofNormal[0];
+	level.roofNormal[1] = roofNormal[1];
+	out_ = level;
+	return true;
+}
+
+Math::vec3 TacticalMap::getFloorNormal(TacticalMapTileLevel const& level_)
+{
+	return DecodeLevelNormal(level_.floorNormal);
+}
+
+bool TacticalMap::isLevelDestroyed(TacticalMapTile const& tile_, uint32_t levelIndex_) const
+{
+	if(getLevel(tile_, levelIndex_).flags & TacticalMapLevelFlags::Destroyed) return true;
 
-	using CoordPair = std::pair<TileCoord_t, TileCoord_t>;
+	// damage wears structural integrity down rather than setting Destroyed
+	TacticalMapLevelDataHeader const* levelData = getLevelData(tile_, levelIndex_);
+	bool const structural = levelData->structuralType == StructuralType::Floor ||
+							levelData->structuralType == StructuralType::Wall;
+	return structural && levelData->structuralIntegrity < 2;
+}
 
-	std::stack<CoordPair> tileStack;
-	// find tiles inside the initial explosion box and place onto stack
-	for(auto z = izmin; z < izmax; ++z)
+Math::vec3 TacticalMap::getRoofNormal(TacticalMapTileLevel const& level_)
+{
+	return DecodeLevelNormal(level_.roofNormal);
+}
+
+template<typename WritableLevelData>
+TacticalMap::TileRect TacticalMap::applyDamage(Geometry::AABB const* boxes_, size_t count_,
+												WritableLevelData&& writableLevelData_) const
+{
+	using namespace Math;
+
+	// a tile a collapse has reached, ymin is the bottom of the blast that started it
+	struct DamagedTile
 	{
-		for(auto x = ixmin; x < ixmax; ++x)
+		TileCoord_t x, z;
+		float ymin;
+	};
+
+	// tiles any of the blasts hit, a tile in more than one is only damaged once by the lowest.
+	// ordered so the collapse is the same whatever order the boxes came in
+	std::map<uint64_t, DamagedTile> hitTiles;
+	for(size_t boxIndex = 0; boxIndex < count_; ++boxIndex)
+	{
+		Geometry::AABB const& box = boxes_[boxIndex];
+		TileCoord_t ixmin, izmin;
+		TileCoord_t ixmax, izmax;
+
+		float const ymin = box.getMinExtent().y;
+		float const ymax = box.getMaxExtent().y;
+
+		worldToLocal(box.getMinExtent(), ixmin, izmin);
+		worldToLocal(box.getMaxExtent(), ixmax, izmax);
+
+		// fatten up slivers
+		if(ixmin == ixmax)
 		{
-			auto const& tile = map[z * getWidth() + x];
-			auto levelIndex = 0u;
-			for(; levelIndex < tile.levelCount; ++levelIndex)
+			if(ixmin > 0) ixmin--;
+			else ixmax++;
+		}
+		if(izmin == izmax)
+		{
+			if(izmin > 0) izmin--;
+			else izmax++;
+		}
+
+		ixmin = Math::clamp<TileCoord_t>(ixmin, 0, width);
+		izmin = Math::clamp<TileCoord_t>(izmin, 0, height);
+		ixmax = Math::clamp<TileCoord_t>(ixmax, 0, width);
+		izmax = Math::clamp<TileCoord_t>(izmax, 0, height);
+
+		// find tiles inside the initial explosion box and place onto stack
+		for(auto z = izmin; z < izmax; ++z)
+		{
+			for(auto x = ixmin; x < ixmax; ++x)
 			{
-				TacticalMapTileLevel& level = getLevel(tile, levelIndex);
-				TacticalMapLevelDataHeader* levelData = getLevelData(tile, levelIndex);
+				auto const& tile = getTile(x, z);
+				auto levelIndex = 0u;
+				for(; levelIndex < tile.levelCount; ++levelIndex)
+				{
+					TacticalMapTileLevel const& level = getLevel(tile, levelIndex);
 
-				if(levelData->flags & TacticalMapLevelFlags::Destroyed) continue;
+					if(level.flags & TacticalMapLevelFlags::Destroyed) continue;
 
-				Math::vec3 const mincentre(0, ymin - level.baseHeight, 0);
-				Math::vec3 const maxcentre(0, ymax - level.baseHeight, 0);
+					float const levelHeight = getLevelHeight(tile, level);
+					Math::vec3 const mincentre(0, ymin - levelHeight, 0);
+					Math::vec3 const maxcentre(0, ymax - levelHeight, 0);
 
-				// distance from floor and roof
-				auto const& floorPlane = levels[levelIndex].floorPlane;
-				float const minFloorD = Math::DotPoint(floorPlane, mincentre);
-				float const maxFloorD = Math::DotPoint(floorPlane, maxcentre);
+					// distance from floor and roof, the floor passes through the level height
+					Math::vec3 const floorNormal = getFloorNormal(level);
+					Math::Plane const floorPlane(floorNormal.x, floorNormal.y, floorNormal.z, 0.0f);
+					float const minFloorD = Math::DotPoint(floorPlane, mincentre);
+					float const maxFloorD = Math::DotPoint(floorPlane, maxcentre);
 
-				// minimum above floor 
-				if(minFloorD >= 0.0f)
-				{
-					// but floor below maximum
-					if(maxFloorD < 0.0f)
+					// minimum above floor 
+					if(minFloorD >= 0.0f)
 					{
-						tileStack.push({x, z});
-						break;
+						// but floor below maximum
+						if(maxFloorD > 0.0f)
+						{
+							auto const [hit, added] = hitTiles.insert({MortonCurve(x, z), DamagedTile{ x, z, ymin }});
+							if(!added) hit->second.ymin = std::min(hit->second.ymin, ymin);
+							break;
+						}
 					}
 				}
 			}
 		}
 	}
 
-	using namespace Math;
+	std::stack<DamagedTile> tileStack;
+	for(auto const& [mXZ, hit] : hitTiles)
+	{
+		tileStack.push(hit);
+	}
 
+	TileRect damaged;
 	std::unordered_set<uint64_t> doneTiles;
 	// follow collapse chains up and around if structural integrity has failed	
 	while(!tileStack.empty())
 	{
-		auto[x, z] = tileStack.top();
+		auto[x, z, ymin] = tileStack.top();
 		tileStack.pop();
 		x = clamp(x, TileCoord_t(0), TileCoord_t(getWidth() - 1));
 		z = clamp(z, TileCoord_t(0), TileCoord_t(getHeight() - 1));
@@ -218,18 +665,19 @@ void TacticalMap::damageStructure(Geometry::AABB const& box)
 			continue;
 		else doneTiles.insert(mXZ);
 
-		auto const& tile = map[z * getWidth() + x];
+		auto const& tile = getTile(x, z);
 		auto levelIndex = 0u;
 		for(; levelIndex < tile.levelCount; ++levelIndex)
 		{
-			TacticalMapTileLevel& level = getLevel(tile, levelIndex);
-			TacticalMapLevelDataHeader* levelData = getLevelData(tile, levelIndex);
-			if(levelData->flags & TacticalMapLevelFlags::Destroyed) continue;
+			TacticalMapTileLevel const& level = getLevel(tile, levelIndex);
+			TacticalMapLevelDataHeader const* levelData = getLevelData(tile, levelIndex);
+			if(level.flags & TacticalMapLevelFlags::Destroyed) continue;
 
-			Math::vec3 const mincentre(0, ymin - level.baseHeight, 0);
+			Math::vec3 const mincentre(0, ymin - getLevelHeight(tile, level), 0);
 
-			// distance from floor and roof
-			auto const& floorPlane = levels[levelIndex].floorPlane;
+			// distance from floor and roof, the floor passes through the level height
+			Math::vec3 const floorNormal = getFloorNormal(level);
+			Math::Plane const floorPlane(floorNormal.x, floorNormal.y, floorNormal.z, 0.0f);
 			float const minFloorD = Math::DotPoint(floorPlane, mincentre);
 
 			// minimum above floor 
@@ -238,10 +686,12 @@ void TacticalMap::damageStructure(Geometry::AABB const& box)
 				if(levelData->structuralType == StructuralType::NotStructural) continue;
 				if(levelData->structuralType == StructuralType::World) continue;
 
-				levelData->structuralIntegrity--;
+				TacticalMapLevelDataHeader* damagedLevelData = writableLevelData_(tile.levelStartIndex + levelIndex);
+				damagedLevelData->structuralIntegrity--;
+				damaged.add(x, z);
 
 				// has structural integrity failed?
-				if(levelData->structuralIntegrity < 2)
+				if(damagedLevelData->structuralIntegrity < 2)
 				{
 
 					// test connected tiles
@@ -252,16 +702,16 @@ void TacticalMap::damageStructure(Geometry::AABB const& box)
 
 					if(auto const mXZ = MortonCurve(xm1, z);
 							doneTiles.find(mXZ) == doneTiles.end())
-						tileStack.push({xm1, z});
+						tileStack.push({xm1, z, ymin});
 					if(auto const mXZ = MortonCurve(xp1, z);
 							doneTiles.find(mXZ) == doneTiles.end())
-						tileStack.push({xp1, z});
+						tileStack.push({xp1, z, ymin});
 					if(auto const mXZ = MortonCurve(x, zm1);
 							doneTiles.find(mXZ) == doneTiles.end())
-						tileStack.push({x, zm1});
+						tileStack.push({x, zm1, ymin});
 					if(auto const mXZ = MortonCurve(x, zp1);
 							doneTiles.find(mXZ) == doneTiles.end())
-						tileStack.push({x, zp1});
+						tileStack.push({x, zp1, ymin});
 				} else
 				{
 					// stop further vertical collapse
@@ -270,6 +720,91 @@ void TacticalMap::damageStructure(Geometry::AABB const& box)
 			}
 		}
 	}
+	return damaged;
+}
+
+void TacticalMap::damageStructure(Geometry::AABB const& box)
+{
+	// versions share their level data pages with the map they came from, so only get damaged through damageStructures
+	assert(levelDataPages == nullptr);
+	TileRect const damaged = applyDamage(&box, 1, [this](uint32_t index_)
+	{
+		return (TacticalMapLevelDataHeader*) getLevelDataBytes(index_);
+	});
+	updateSummary(damaged);
+}
+
+std::shared_ptr<TacticalMap> TacticalMap::damageStructures(std::shared_ptr<TacticalMap const> const& map_,
+														   Geometry::AABB const* boxes_, size_t count_)
+{
+	assert(map_);
+
+	// a version shares the base maps tiles and levels, its deleter owns the pages it or its parents copied
+	auto const parent = std::get_deleter<TacticalMapVersionDeleter>(map_);
+	TacticalMapVersionDeleter deleter{};
+	deleter.base = parent ? parent->base : map_;
+	TacticalMap const* base = deleter.base.get();
+
+	uint32_t const pageMask = (1u << LevelDataPageShift) - 1;
+	uint32_t const pageCount = (map_->levelCount + pageMask) >> LevelDataPageShift;
+	size_t const pageSize = size_t(1u << LevelDataPageShift) * map_->sizeOfTacticalLevelData;
+	size_t const levelDataSize = size_t(map_->levelCount) * map_->sizeOfTacticalLevelData;
+	if(parent) deleter.pages = parent->pages;
+	else deleter.pages.resize(pageCount);
+
+	// header, page table and summaries are one allocation. the summaries are small next to the tiles
+	// so are copied whole rather than paged
+	size_t const summaryMemorySize = sizeof(TacticalMapAreaSummary) * countSummaryNodes(map_->width, map_->height);
+	auto memory = (uint8_t*) malloc(sizeof(TacticalMap) + (pageCount * sizeof(uint8_t*)) + summaryMemorySize);
+	TacticalMap* version = new(memory) TacticalMap(*map_);
+	auto const pages = (uint8_t**) (memory + sizeof(TacticalMap));
+	auto const summary = (TacticalMapAreaSummary*) (memory + sizeof(TacticalMap) + (pageCount * sizeof(uint8_t*)));
+	std::memcpy(summary, map_->summary, summaryMemorySize);
+	version->summary = summary;
+	for(auto i = 0u; i < pageCount; ++i)
+	{
+		pages[i] = deleter.pages[i] ? deleter.pages[i].get() : base->levelDataHeap + (i * pageSize);
+	}
+	version->levelDataHeap = nullptr;
+	version->levelDataPages = pages;
+
+	// pages are copied the first time this version writes to them
+	std::vector<bool> copied(pageCount, false);
+	auto writable = [&](uint32_t index_)
+	{
+		uint32_t const page = index_ >> LevelDataPageShift;
+		if(!copied[page])
+		{
+			std::shared_ptr<uint8_t> pageCopy((uint8_t*) malloc(pageSize), &free);
+			size_t const pageStart = size_t(page) * pageSize;
+			std::memcpy(pageCopy.get(), pages[page], std::min(pageSize, levelDataSize - pageStart));
+			pages[page] = pageCopy.get();
+			deleter.pages[page] = std::move(pageCopy);
+			copied[page] = true;
+		}
+		return (TacticalMapLevelDataHeader*) version->getLevelDataBytes(index_);
+	};
+
+	TileRect const damaged = version->applyDamage(boxes_, count_, writable);
+	version->updateSummary(damaged);
+
+	return std::shared_ptr<TacticalMap>(version, std::move(deleter));
+}
+
+void TacticalMap::copyLevelData(uint8_t* out_) const
+{
+	size_t const levelDataSize = size_t(levelCount) * sizeOfTacticalLevelData;
+	if(levelDataPages == nullptr)
+	{
+		std::memcpy(out_, levelDataHeap, levelDataSize);
+		return;
+	}
+
+	size_t const pageSize = size_t(1u << LevelDataPageShift) * sizeOfTacticalLevelData;
+	for(size_t offset = 0, page = 0; offset < levelDataSize; offset += pageSize, ++page)
+	{
+		std::memcpy(out_ + offset, levelDataPages[page], std::min(pageSize, levelDataSize - offset));
+	}
 }
 
 void TacticalMapTileLevel::write(Binny::WriteHelper& h)
@@ -278,12 +813,11 @@ void TacticalMapTileLevel::write(Binny::WriteHelper& h)
 	using namespace std::string_literals;
 
 
-	h.write(floorPlane.a, floorPlane.b, floorPlane.c, floorPlane.d, "Floor Plane"s);
-	h.write(roofPlane.a, roofPlane.b, roofPlane.c, roofPlane.d, "Roof Plane"s);
-	h.write(baseHeight, "Base Height");
-	h.write(roofDeltaHeight, "Roof Delta Height");
-	h.write_as<uint32_t>(0xDE, "Padd");
-	h.write_as<uint32_t>(0xDE, "Padd");
+	h.write_as<uint16_t>(height, "Height above tile base"s);
+	h.write_as<uint16_t>(roofDeltaHeight, "Roof Delta Height"s);
+	h.write_as<uint32_t>(uint32_t(flags) | (uint32_t(layer) << 24), "Flags and Layer"s);
+	h.write_as<int16_t>(floorNormal[0], floorNormal[1], "Floor Normal"s);
+	h.write_as<int16_t>(roofNormal[0], roofNormal[1], "Roof Normal"s);
 }
 
 void TacticalMapTile::write(Binny::WriteHelper& h, TacticalMapTileLevel* base_)
@@ -291,16 +825,18 @@ void TacticalMapTile::write(Binny::WriteHelper& h, TacticalMapTileLevel* base_)
 	using namespace Binny;
 	using namespace std::string_literals;
 
-	h.write(levelCount, "levels in this tile"s);
+	h.write_as<uint16_t>(levelCount, "levels in this tile"s);
+	h.write_as<int16_t>(baseHeight, "base height of this tiles levels"s);
 	h.write(levelStartIndex, "start index of this tiles level array"s);
 }
 
-bool TacticalMap::saveTo(uint64_t const regenMarker, std::vector<uint8_t>& result)
+bool TacticalMap::saveTo(uint64_t const regenMarker, std::vector<uint8_t>& result, bool const compress)
 {
 	using namespace Binny;
 	using namespace std::string_literals;
 	BundleWriter writer;
 	writer.setLogBinifyText();
+	if(!compress) writer.setStoreUncompressed();
 
 	bool okay;
 	okay = writer.addChunk(
@@ -334,8 +870,8 @@ bool TacticalMap::saveTo(uint64_t const regenMarker, std::vector<uint8_t>& resul
 									 "sizeof Tactical Level Data used for this map");
 				h.write_as<uint16_t>(width, "map width"s);
 				h.write_as<uint16_t>(height, "map height"s);
-				h.write_as<uint16_t>(0xDE, "padd0"s);
-				h.write_as<uint16_t>(0xDE, "padd0"s);
+				h.write_as<uint16_t>((uint16_t)tileLayout, "tile layout"s);
+				h.write_as<uint16_t>(0xDE, "padd1"s);
 
 				h.write(levelCount, "layer count"s);
 				h.write(bottomLeft.x, "bottom left x"s);
@@ -349,6 +885,8 @@ bool TacticalMap::saveTo(uint64_t const regenMarker, std::vector<uint8_t>& resul
 				h.use_label("Levels"s, ""s, true, true, "ptr to beginning of the level structures"s);
 				h.use_label("Map"s, ""s, true, true, "ptr to 2D tile map data"s);
 				h.use_label("LevelDataHeap"s, ""s, true, true, "ptr to heap used to store level data"s);
+				h.write_null_ptr("level data pages, only damaged versions have them"s);
+				h.write_null_ptr("summaries, from the TacticalMapSummary chunk when loaded"s);
 
 				h.align();
 				// levels
@@ -362,7 +900,7 @@ bool TacticalMap::saveTo(uint64_t const regenMarker, std::vector<uint8_t>& resul
 
 				h.align();
 				h.write_label("Map"s, false);
-				for(auto i = 0; i < width * height; ++i)
+				for(auto i = 0u; i < getTileCount(); ++i)
 				{
 					TacticalMapTile& tile = map[i];
 					tile.write(h, levels);
@@ -370,7 +908,37 @@ bool TacticalMap::saveTo(uint64_t const regenMarker, std::vector<uint8_t>& resul
 
 				h.align();
 				h.write_label("LevelDataHeap"s, false);
-				h.write_byte_array(levelDataHeap, levelCount * sizeOfTacticalLevelData);
+				std::vector<uint8_t> levelData(levelCount * sizeOfTacticalLevelData);
+				copyLevelData(levelData.data());
+				h.write_byte_array(levelData);
+			}
+	);
+	if(!okay) return false;
+
+	assert(summary != nullptr);
+	okay = writer.addChunk(
+			"TacticalMapSummary"s,
+			TacticalMapSummaryId,
+			SummaryMajorVersion,
+			SummaryMinorVersion,
+			0,
+			{},
+			[this](WriteHelper& h)
+			{
+				h.allow_nan(false);
+				h.allow_infinity(false);
+
+				uint32_t const nodeCount = countSummaryNodes(width, height);
+				h.write_as<uint16_t>(width, "map width"s);
+				h.write_as<uint16_t>(height, "map height"s);
+				h.write(nodeCount, "summary count"s);
+				h.align(8);
+				h.use_label("Summaries"s, ""s, true, true, "ptr to the summaries, finest first"s);
+
+				h.align();
+				h.write_label("Summaries"s, false);
+				// float max heights and 16 bit counts go as the bytes they are
+				h.write_byte_array((uint8_t const*) summary, nodeCount * sizeof(TacticalMapAreaSummary));
 			}
 	);
 	if(!okay) return false;
@@ -380,45 +948,124 @@ bool TacticalMap::saveTo(uint64_t const regenMarker, std::vector<uint8_t>& resul
 	return true;
 }
 
+bool TacticalMap::processChunk(uint16_t majorVersion_, uint16_t minorVersion_, std::shared_ptr<void> ptr_,
+							   std::vector<std::shared_ptr<TacticalMap>>& out_)
+{
+	auto tmap = std::static_pointer_cast<TacticalMap>(ptr_);
+
+	if(sizeof(TacticalMapLevelDataHeader) > tmap->sizeOfTacticalLevelData) return false;
+	if(majorVersion_ == 7)
+	{
+		if(sizeof(TacticalMapTileV7) != tmap->sizeOfTacticalMapTile) return false;
+		if(sizeof(TacticalMapTileLevelV7) != tmap->sizeOfTacticalMapTileLevel) return false;
+		// the converted map is a new allocation, the loaded chunk is released with tmap
+		tmap = convertFromVersion7(tmap.get());
+		if(!tmap) return false;
+	}
+	else if(majorVersion_ == 8 || majorVersion_ == 9)
+	{
+		if(sizeof(TacticalMapTile) != tmap->sizeOfTacticalMapTile) return false;
+		if(sizeof(TacticalMapTileLevel) != tmap->sizeOfTacticalMapTileLevel) return false;
+		tmap = convertFromVersion8(tmap.get());
+		if(!tmap) return false;
+	}
+	else
+	{
+		if(majorVersion_ < 10 || majorVersion_ > MajorVersion) return false;
+		if(minorVersion_ > MinorVersion) return false;
+		if(sizeof(TacticalMapTile) != tmap->sizeOfTacticalMapTile) return false;
+		if(sizeof(TacticalMapTileLevel) != tmap->sizeOfTacticalMapTileLevel) return false;
+		if(tmap->levelDataPages != nullptr) return false;
+		if(tmap->summary != nullptr) return false;
+		// only the levels flags and base heights moved so they're fixed where they lie
+		if(majorVersion_ == 10) ConvertLevelFlagsFromVersion10(tmap->levels, tmap->levelCount);
+		if(majorVersion_ < 12 && !tmap->convertBaseHeightsFromVersion11()) return false;
+	}
+
+	// verify remapping occured okay
+	for(auto y = 0; y < tmap->getHeight(); ++y)
+	{
+		for(auto x = 0; x < tmap->getWidth(); ++x)
+		{
+			TacticalMapTile const& tile = tmap->getTile(x, y);
+			for(auto levelChk = 0u; levelChk < tile.levelCount; levelChk++)
+			{
+				auto levelData = tmap->getLevelData(tile, levelChk);
+				if(levelData->levelNum != levelChk)
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	out_.emplace_back(tmap);
+
+	return true;
+}
+
+bool TacticalMap::processSummaryChunk(uint16_t majorVersion_, uint16_t minorVersion_, std::shared_ptr<void> ptr_,
+									  std::vector<std::shared_ptr<TacticalMap>>& out_)
+{
+	auto const chunk = (TacticalMapSummaryChunk*) ptr_.get();
+
+	// an unusable summary isn't fatal, the map gets its summaries rebuilt instead
+	if(out_.empty() || out_.back()->summary != nullptr) return true;
+	std::shared_ptr<TacticalMap> const& tmap = out_.back();
+	if(majorVersion_ != SummaryMajorVersion || minorVersion_ > SummaryMinorVersion ||
+	   chunk->width != tmap->width || chunk->height != tmap->height ||
+	   chunk->nodeCount != countSummaryNodes(tmap->width, tmap->height))
+	{
+		LOG_F(WARNING, "Tactical map %s summaries don't match, rebuilding them", tmap->getName());
+		return true;
+	}
+
+	out_.back() = attachSummary(tmap, ptr_, chunk->nodes);
+	return true;
+}
+
+void TacticalMap::buildMissingSummaries(std::vector<std::shared_ptr<TacticalMap>>& out_)
+{
+	for(auto& tmap : out_)
+	{
+		if(tmap->summary != nullptr) continue;
+
+		size_t const summaryMemorySize = sizeof(TacticalMapAreaSummary) * countSummaryNodes(tmap->width, tmap->height);
+		std::shared_ptr<void> memory(malloc(summaryMemorySize), &free);
+		tmap = attachSummary(tmap, memory, (TacticalMapAreaSummary*) memory.get());
+		tmap->updateSummary(TileRect{ 0, 0, tmap->width, tmap->height });
+	}
+}
+
+std::shared_ptr<TacticalMap> TacticalMap::attachSummary(std::shared_ptr<TacticalMap> const& map_,
+														std::shared_ptr<void> owner_, TacticalMapAreaSummary* summary_)
+{
+	using Owners = std::pair<std::shared_ptr<TacticalMap>, std::shared_ptr<void>>;
+	auto owners = std::make_shared<Owners>(map_, std::move(owner_));
+	map_->summary = summary_;
+	return std::shared_ptr<TacticalMap>(owners, map_.get());
+}
+
 bool TacticalMap::createFromStream(std::istream& in, std::vector<std::shared_ptr<TacticalMap>>& out_)
 {
 	using namespace Binny;
 	std::vector<IBundle::ChunkHandler> handlers = {
-			{{TacticalMapId, 0, 0,
-					 [&out_](std::string_view, int, uint16_t majorVersion_, uint16_t minorVersion_, size_t size_,
+			{TacticalMapId, 0, 0,
+					 [&out_](std::string_view, int, uint16_t majorVersion_, uint16_t minorVersion_, size_t,
+							 std::shared_ptr<void> ptr_) -> bool
+					 {
+						 return processChunk(majorVersion_, minorVersion_, ptr_, out_);
+					 },
+					 [](int, void*) {}
+			 },
+			{TacticalMapSummaryId, 0, 0,
+					 [&out_](std::string_view, int, uint16_t majorVersion_, uint16_t minorVersion_, size_t,
 							 std::shared_ptr<void> ptr_) -> bool
 					 {
-						 auto tmap = std::static_pointer_cast<TacticalMap>(ptr_);
-
-						 if(majorVersion_ != MajorVersion) return false;
-						 if(minorVersion_ > MinorVersion) return false;
-						 if(sizeof(TacticalMapTile) != tmap->sizeOfTacticalMapTile) return false;
-						 if(sizeof(TacticalMapTileLevel) != tmap->sizeOfTacticalMapTileLevel) return false;
-						 if(sizeof(TacticalMapLevelDataHeader) > tmap->sizeOfTacticalLevelData) return false;
-
-						 // verify remapping occured okay
-						 for(auto y = 0; y < tmap->getHeight(); ++y)
-						 {
-							 for(auto x = 0; x < tmap->getWidth(); ++x)
-							 {
-								 TacticalMapTile const& tile = tmap->getTile(x, y);
-								 for(auto levelChk = 0u; levelChk < tile.levelCount; levelChk++)
-								 {
-									 auto const& level = tmap->getLevel(tile, levelChk);
-									 auto levelData = tmap->getLevelData(tile, levelChk);
-									 if(levelData->levelNum != levelChk)
-									 {
-										 return false;
-									 }
-								 }
-							 }
-						 }
-
-						 out_.emplace_back(tmap);
-
-						 return true;
-					 }
-			 }}
+						 return processSummaryChunk(majorVersion_, minorVersion_, ptr_, out_);
+					 },
+					 [](int, void*) {}
+			 }
 	};
 
 	Bundle bundle(&malloc, &free, &malloc, &free, in);
@@ -428,6 +1075,75 @@ bool TacticalMap::createFromStream(std::istream& in, std::vector<std::shared_ptr
 		return false;
 	}
 
+	buildMissingSummaries(out_);
 	return true;
+}
 
+bool TacticalMap::createFromMemory(std::shared_ptr<void> owner_, uint8_t* memory_, size_t size_,
+								   std::vector<std::shared_ptr<TacticalMap>>& out_)
+{
+	using namespace Binny;
+	std::vector<IBundle::ChunkHandler> handlers = {
+			{TacticalMapId, 0, 0,
+					 [&out_](std::string_view, int, uint16_t majorVersion_, uint16_t minorVersion_, size_t,
+							 std::shared_ptr<void> ptr_) -> bool
+					 {
+						 return processChunk(majorVersion_, minorVersion_, ptr_, out_);
+					 },
+					 [](int, void*) {}
+			 },
+			{TacticalMapSummaryId, 0, 0,
+					 [&out_](std::string_view, int, uint16_t majorVersion_, uint16_t minorVersion_, size_t,
+							 std::shared_ptr<void> ptr_) -> bool
+					 {
+						 return processSummaryChunk(majorVersion_, minorVersion_, ptr_, out_);
+					 },
+					 [](int, void*) {}
+			 }
+	};
+
+	InPlaceBundle bundle(&malloc, &free, std::move(owner_), memory_, size_);
+	auto const ret = bundle.read({}, handlers);
+	if(ret.first != IBundle::ErrorCode::Okay)
+	{
+		return false;
+	}
+
+	buildMissingSummaries(out_);
+	return true;
+}
+
+bool TacticalMap::createFromFile(char const* fileName_, std::vector<std::shared_ptr<TacticalMap>>& out_)
+{
+#if PLATFORM == POSIX || PLATFORM == APPLE_MAC
+	int const fd = open(fileName_, O_RDONLY);
+	if(fd < 0) return false;
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size <= 0)
+	{
+		close(fd);
+		return false;
+	}
+	size_t const size = (size_t) st.st_size;
+	// private writable mapping, the fixups copy only the pages they patch and never touch the file
+	void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(mapped == MAP_FAILED) return false;
+
+	std::shared_ptr<void> owner(mapped, [size](void* ptr_) { munmap(ptr_, size); });
+	return createFromMemory(owner, (uint8_t*) mapped, size, out_);
+#else
+	std::ifstream in(fileName_, std::ios::in | std::ios::binary);
+	if(!in.is_open()) return false;
+	in.seekg(0, std::ios::end);
+	auto const size = (size_t) in.tellg();
+	in.seekg(0, std::ios::beg);
+	if(size == 0) return false;
+
+	std::shared_ptr<void> owner(malloc(size), &free);
+	if(!owner) return false;
+	in.read((char*) owner.get(), size);
+	if(!in) return false;
+	return createFromMemory(owner, (uint8_t*) owner.get(), size, out_);
+#endif
 }
\ No newline at end of file
@@ -9,9 +9,12 @@
 #include "math/vector_math.h"
 #include "geometry/aabb.h"
 #include "core/utils.h"
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <functional>
+#include <limits>
+#include <string_view>
 
 namespace MeshMod { class Mesh; using MeshPtr = std::shared_ptr<Mesh>; }
 namespace Binny { class Bundle; class WriteHelper; };
@@ -103,6 +106,25 @@ struct TacticalMapVolume
 	float roofHeight;
 };
 
+// shared with managed code, 6 floats
+struct TacticalMapSightQuery
+{
+	Math::vec3 from;
+	Math::vec3 to;
+};
+
+// shared with managed code. what the levels of a block of tiles span, heights are only of levels that
+// aren't destroyed. open roofs are float max, as are the mins (and the maxes float lowest) with no levels
+struct TacticalMapAreaSummary
+{
+	float minFloor, maxFloor;
+	float minRoof, maxRoof;
+	uint32_t layerMask;			// union of the layers of levels that aren't destroyed
+	uint16_t levelCount;		// saturates
+	uint16_t destroyedCount;	// saturates
+};
+static_assert(sizeof(TacticalMapAreaSummary) == 24);
+
 enum TacticalMapLevelFlags
 {
 	Destructable = Core::Bit(0),
@@ -127,30 +149,70 @@ struct TacticalMapLevelDataHeader
 };
 
 // native only structures
+// 16 bytes, heights are quantised above the tiles base height and normals are octahedral
+// encoded. flags and layer are copies of the level datas, so lookups only touch the
+// level data heap once they've found a level
 struct TacticalMapTileLevel
 {
-	Math::Plane floorPlane;
-	Math::Plane roofPlane;
+	// 1/32 covers 2048 units of levels above the tile base height
+	static constexpr float HeightQuantum = 1.0f / 32.0f;
+	static constexpr uint16_t NoRoof = 0xFFFF;
+
+	uint16_t height;			// above the tile base height in HeightQuantum units
+	uint16_t roofDeltaHeight;	// above height in HeightQuantum units, NoRoof if open to the sky
+	uint32_t flags : 24;		// TacticalMapLevelFlags, all 24 bits of the level datas
+	uint32_t layer : 8;
+	int16_t floorNormal[2];
+	int16_t roofNormal[2];
 
-	float baseHeight;
-	float roofDeltaHeight;
-	uint32_t padd[2];
 	void write(Binny::WriteHelper& helper);
 };
-static_assert(sizeof(TacticalMapTileLevel) == 48);
+static_assert(sizeof(TacticalMapTileLevel) == 16);
 
 struct TacticalMapTile
 {
-	uint32_t levelCount;
+	// the base height is in steps of this many level HeightQuantums, so whole units
+	static constexpr int32_t BaseHeightScale = 32;
+
+	uint16_t levelCount;
+	int16_t baseHeight;			// in BaseHeightScale * HeightQuantum units, covers +-32768 units of world height
 	uint32_t levelStartIndex;
 
 	void write(Binny::WriteHelper& h_, TacticalMapTileLevel* base_);
 };
 static_assert(sizeof(TacticalMapTile) == 8);
 
+enum class TacticalMapTileLayout : uint16_t
+{
+	RowMajor = 0,
+	// square blocks of tiles in row major order with the tiles in each block in
+	// morton order, so area queries touch fewer cache lines
+	MortonBlocks,
+};
 
 // interface and classes
 
+// where the last build spent its time, in seconds. The layer phases run a region per task so their times
+// are summed over the task threads, threadBusy is how long each thread spent on regions
+struct TacticalMapBuildStats
+{
+	double binTriangles = 0;
+	double insertSolidBoxes = 0;
+	double structuralBoxes = 0;
+	double layers = 0;				// wall time of all the layer phases
+	double writeMap = 0;			// heights, tiles, levels and summaries
+	double total = 0;
+
+	double fragments = 0;			// layer phase 1
+	double smoothing = 0;			// layer phase 2
+	double planes = 0;				// layer phase 3
+	double destruction = 0;			// layer phase 4
+	std::vector<double> threadBusy;
+
+	uint32_t regionsBuilt = 0;
+	size_t peakFragmentBytes = 0;	// the sum of each threads most fragment memory in use at once
+};
+
 // builder makes tactical map from mesha and boxes
 struct ITacticalMapBuilder
 {
@@ -161,9 +223,22 @@ struct ITacticalMapBuilder
 	virtual void setMinimumHeight(float height_) = 0;
 	virtual void setMaximumFloorInclination(float angleInRadians_) = 0;
 	virtual void setLevelDataSize(uint32_t size_) = 0;
-	virtual void addMeshAt(MeshMod::MeshPtr const& mesh, TacticalMapLevelDataHeader const* levelData, Math::mat4x4 const& transform) = 0;
-	virtual void addBoxAt(Geometry::AABB const& box, TacticalMapLevelDataHeader const* levelData, Math::mat4x4 const& transform) = 0;
+	// debug: also ray cast boxes and warn where the analytic box fragments differ
+	virtual void setValidateBoxFragments(bool validate_) = 0;
+	// the map is built in independent square regions of this many tiles, memory use scales with it
+	virtual void setRegionSize(uint32_t tiles_) = 0;
+	virtual void setTileLayout(TacticalMapTileLayout layout_) = 0;
+	// adds return a solid id for removeSolid and updateSolidTransform
+	virtual uint32_t addMeshAt(MeshMod::MeshPtr const& mesh, TacticalMapLevelDataHeader const* levelData, Math::mat4x4 const& transform) = 0;
+	virtual uint32_t addBoxAt(Geometry::AABB const& box, TacticalMapLevelDataHeader const* levelData, Math::mat4x4 const& transform) = 0;
+	virtual void removeSolid(uint32_t solidId_) = 0;
+	// replaces the transform the solid was added with
+	virtual void updateSolidTransform(uint32_t solidId_, Math::mat4x4 const& transform_) = 0;
+	// builds after the first only regenerate tiles near solids added, removed or moved since the last build.
+	// every build returns a new map, ones already returned are never changed. nullptr if a tiles lowest
+	// level is outside +-1024 or its levels and roofs reach more than 2048 above that
 	virtual std::shared_ptr<class TacticalMap> build() = 0;
+	virtual TacticalMapBuildStats const& getBuildStats() const = 0;
 };
 
 // tactical map stiches map/parcels together into one big map
@@ -174,6 +249,61 @@ struct ITacticalMapStitcher
 
 	virtual void addTacticalMapInstance(std::shared_ptr<class TacticalMap const> map_, Math::vec3 const position, int rotationInDegrees_, int mapParcelId_) = 0;
 	virtual std::shared_ptr<class TacticalMap> build() = 0;
+	// shares the parcels rather than copying them, see TacticalMapVirtualStitch in stitcher.h
+	virtual std::shared_ptr<class TacticalMapVirtualStitch const> buildVirtual() = 0;
+};
+
+struct TacticalMapPathSettings
+{
+	float maxStepHeight = 0.5f;		// largest floor height change between neighbouring tiles
+	float agentHeight = 1.8f;		// headroom needed under roofs
+	float lookupRange = 1.0f;		// range used to find the levels queries start and end on
+	uint32_t levelMask = ~0u;
+	uint32_t clusterSize = 16;		// tiles along a cluster side
+};
+
+struct TacticalMapPathQuery
+{
+	Math::vec3 start;
+	Math::vec3 goal;
+};
+
+struct TacticalMapPath
+{
+	bool found = false;
+	float cost = 0.0f;					// in tiles, diagonal steps cost sqrt 2
+	std::vector<Math::vec3> points;		// tile centres at floor height from start to goal
+};
+
+// a batch of async path queries, releasing it waits for any still running
+struct ITacticalMapPathBatch
+{
+	using Ptr = std::shared_ptr<ITacticalMapPathBatch>;
+	virtual ~ITacticalMapPathBatch() = default;
+
+	virtual bool isComplete() const = 0;
+	virtual void wait() = 0;
+};
+
+// hierarchical pathfinder. The map is split into square clusters joined by portals between walkable
+// levels either side of the cluster borders, long queries search the portal graph and only refine
+// within the clusters the path crosses
+struct ITacticalMapPathfinder
+{
+	using Ptr = std::shared_ptr<ITacticalMapPathfinder>;
+
+	virtual ~ITacticalMapPathfinder() = default;
+
+	virtual bool findPath(TacticalMapPathQuery const& query_, TacticalMapPath& out_) const = 0;
+	// runs the queries on the task scheduler, out_[i] is the path for queries_[i].
+	// both arrays must outlive the batch. the batch keeps searching the map it started with if updateMap is
+	// called while it runs
+	virtual ITacticalMapPathBatch::Ptr findPathsAsync(TacticalMapPathQuery const* queries_, size_t count_, TacticalMapPath* out_) const = 0;
+	// switches to a new version of the map (e.g. from damageStructures) and only rebuilds the portals of
+	// clusters whose walkable levels changed. returns the number of clusters rebuilt.
+	// all calls are safe from any thread
+	virtual uint32_t updateMap(std::shared_ptr<class TacticalMap const> map_) = 0;
+	virtual uint32_t getPortalCount() const = 0;
 };
 
 class TacticalMap
@@ -181,15 +311,28 @@ class TacticalMap
 public:
 	friend class TacticalMapBuilder;
 	friend class TacticalMapStitcher;
+	friend class TacticalMapPathGraph;
+	friend class TacticalMapVirtualStitch;
 
 	using TileCoord_t = int16_t;
 	using LevelDataPair = std::pair<TacticalMapTileLevel*, TacticalMapLevelDataHeader*>;
 	using ConstLevelDataPair = std::pair<TacticalMapTileLevel const*, TacticalMapLevelDataHeader const*>;
 
 	static bool createFromStream(std::istream& in, std::vector<std::shared_ptr<TacticalMap>>& out_);
+	// loads from a whole bundle already in memory, uncompressed maps are fixed up where they lie
+	// and keep owner_ alive rather than being copied. memory_ is modified so can only be loaded once
+	static bool createFromMemory(std::shared_ptr<void> owner_, uint8_t* memory_, size_t size_, std::vector<std::shared_ptr<TacticalMap>>& out_);
+	// maps the file (or reads it in one go where mapping isn't supported) and loads from that memory
+	static bool createFromFile(char const* fileName_, std::vector<std::shared_ptr<TacticalMap>>& out_);
 
 	static ITacticalMapBuilder::Ptr allocateBuilder(Math::vec2 const bottomLeft_, TileCoord_t width_, TileCoord_t height_, char const* name_);
 	static ITacticalMapStitcher::Ptr allocateStitcher(char const* name_);
+	static ITacticalMapPathfinder::Ptr allocatePathfinder(std::shared_ptr<TacticalMap const> map_, TacticalMapPathSettings const& settings_);
+
+	static const int MortonBlockSize = 8;
+	// the finest area summaries are of square blocks of this many tiles, each summary level above
+	// is a 2x2 reduction of the one below it up to a single summary of the whole map
+	static const int SummaryBlockSize = MortonBlockSize;
 
 	int getWidth() const { return (int)width; }
 	int getHeight() const { return (int)height; }
@@ -209,10 +352,63 @@ public:
 
 	bool lookupLevelDataAtWorld(Math::vec3 const& world_, float const range_, uint32_t const levelMask_, TacticalMapLevelDataHeader* out_) const;
 
+	// batched lookups give the same answers as the single ones, out_[i] is the answer for points_[i].
+	// queries are run in tile order so neighbouring agents share cache lines and large batches
+	// are split across the task scheduler
+	void lookupAtWorldBatch(Math::vec3 const* points_, size_t const count_, float const range_, uint32_t const levelMask_, ConstLevelDataPair* out_) const;
+	// misses have a NaN levelHeight, returns the number of hits
+	size_t lookupVolumeAtWorldBatch(Math::vec3 const* points_, size_t const count_, float const range_, uint32_t const levelMask_, TacticalMapVolume* out_) const;
+	// out_ is count_ level datas getSizeOfLevelData() bytes apart, misses are zeroed (nameCrc is never 0), returns the number of hits
+	size_t lookupLevelDataAtWorldBatch(Math::vec3 const* points_, size_t const count_, float const range_, uint32_t const levelMask_, uint8_t* out_) const;
+
+	// true if nothing solid is between from_ and to_. Space is open between a levels floor and roof planes
+	// and above a tiles top roof, and solid under its lowest floor and between a roof and the next floor up.
+	// Levels that are Destroyed or outside levelMask_ don't block, their space joins the level below. Tiles
+	// without levels and anywhere off the map are open. blockedAt_ gets how far along the segment the
+	// blocking tile starts
+	bool traceLineOfSight(Math::vec3 const& from_, Math::vec3 const& to_, uint32_t const levelMask_, float* blockedAt_ = nullptr) const;
+	// how much of an agentHeight_ tall agent standing at position_ is hidden from an eye at threat_,
+	// from 0 (all of it can be seen) to 1 (none of it can)
+	float queryCover(Math::vec3 const& position_, Math::vec3 const& threat_, float const agentHeight_, uint32_t const levelMask_) const;
+	// out_[i] is 1 where queries_[i] has line of sight, returns the number that do
+	size_t traceLineOfSightBatch(TacticalMapSightQuery const* queries_, size_t const count_, uint32_t const levelMask_, uint8_t* out_) const;
+	// queries_ are from the threats eye to the agents position, returns the number fully hidden
+	size_t queryCoverBatch(TacticalMapSightQuery const* queries_, size_t const count_, float const agentHeight_, uint32_t const levelMask_, float* out_) const;
+
+	// area queries walk the summaries down from the whole map, taking or skipping whole blocks where they
+	// can, so cost about the areas edge rather than its area. Tiles overlapping box_ in x and z are included
+	TacticalMapAreaSummary summariseArea(Geometry::AABB const& box_) const;
+	// true if a level that isn't destroyed and is in levelMask_ has its floor height in box_
+	bool anyLevelInArea(Geometry::AABB const& box_, uint32_t const levelMask_) const;
+	// damage and the builder keep the summaries up to date, anything else changing the levels (e.g. through
+	// mutateLookupAtWorld) should update them over the tiles it changed
+	void updateSummary(Geometry::AABB const& box_);
+
+	// Destroyed or its structure has failed
+	bool isLevelDestroyed(TacticalMapTile const& tile_, uint32_t levelIndex_) const;
+
+	uint32_t getSizeOfLevelData() const { return sizeOfTacticalLevelData; }
+
+	// damages in place, readers on other threads can see a partly damaged map. Not for versions made
+	// by damageStructures, their level data is shared with the map they came from
 	void damageStructure(Geometry::AABB const& box);
 
-	TacticalMapTile const& getTile(int x, int z) const { return map[z * width + x]; }
-	TacticalMapTile& getTile(int x, int z) { return map[z * width + x]; }
+	// returns a new version of map_ with the boxes damage applied. map_ is unchanged so readers holding it
+	// keep a consistent map, only the level data pages the damage writes are copied and everything else
+	// is shared with map_. A tile hit by more than one box is only damaged once
+	static std::shared_ptr<TacticalMap> damageStructures(std::shared_ptr<TacticalMap const> const& map_,
+														 Geometry::AABB const* boxes_, size_t count_);
+
+	// versions made by damageStructures copy level data in pages of this many levels
+	static const uint32_t LevelDataPageShift = 8;
+
+	TacticalMapTileLayout getTileLayout() const { return tileLayout; }
+	uint32_t getTileIndex(int x, int z) const;
+	// includes the padding tiles of partial morton blocks
+	uint32_t getTileCount() const;
+
+	TacticalMapTile const& getTile(int x, int z) const { return map[getTileIndex(x, z)]; }
+	TacticalMapTile& getTile(int x, int z) { return map[getTileIndex(x, z)]; }
 
 	TacticalMapTileLevel const& getLevel(TacticalMapTile const& tile_, uint32_t levelIndex_) const
 	{
@@ -226,8 +422,26 @@ public:
 		return levels[tile_.levelStartIndex + levelIndex_];
 	}
 
+	static float getLevelHeight(TacticalMapTile const& tile_, TacticalMapTileLevel const& level_)
+	{
+		return float(int32_t(tile_.baseHeight) * TacticalMapTile::BaseHeightScale + int32_t(level_.height)) *
+			   TacticalMapTileLevel::HeightQuantum;
+	}
+
+	// infinity if the level has no roof
+	static float getRoofHeight(TacticalMapTile const& tile_, TacticalMapTileLevel const& level_)
+	{
+		if(level_.roofDeltaHeight == TacticalMapTileLevel::NoRoof) return std::numeric_limits<float>::infinity();
+		return float(int32_t(tile_.baseHeight) * TacticalMapTile::BaseHeightScale + int32_t(level_.height) +
+					 int32_t(level_.roofDeltaHeight)) * TacticalMapTileLevel::HeightQuantum;
+	}
+
+	static Math::vec3 getFloorNormal(TacticalMapTileLevel const& level_);
+	static Math::vec3 getRoofNormal(TacticalMapTileLevel const& level_);
+
 	/// save to an empty byte vector
-	bool saveTo(uint64_t const regenMarker, std::vector<uint8_t>& result);
+	/// uncompressed maps are bigger but createFromMemory/createFromFile use them without a copy
+	bool saveTo(uint64_t const regenMarker, std::vector<uint8_t>& result, bool const compress = true);
 
 	Geometry::AABB getAABB() const {
 		return Geometry::AABB(Math::vec3(bottomLeft.x, minHeight, bottomLeft.y),
@@ -238,15 +452,105 @@ private:
 	TacticalMapLevelDataHeader* getLevelData(TacticalMapTile const& tile_, uint32_t levelIndex_)
 	{
 		assert(levelIndex_ < tile_.levelStartIndex + tile_.levelCount);
-		return (TacticalMapLevelDataHeader*) (levelDataHeap+((tile_.levelStartIndex + levelIndex_) * sizeOfTacticalLevelData));
+		return (TacticalMapLevelDataHeader*) getLevelDataBytes(tile_.levelStartIndex + levelIndex_);
 	}
 	TacticalMapLevelDataHeader const* getLevelData(TacticalMapTile const& tile_, uint32_t levelIndex_) const
 	{
 		assert(levelIndex_ < tile_.levelStartIndex + tile_.levelCount);
-		return (TacticalMapLevelDataHeader const*)(levelDataHeap + ((tile_.levelStartIndex + levelIndex_) * sizeOfTacticalLevelData));
+		return (TacticalMapLevelDataHeader const*) getLevelDataBytes(tile_.levelStartIndex + levelIndex_);
+	}
+	uint8_t* getLevelDataBytes(uint32_t index_) const
+	{
+		if(levelDataPages == nullptr) return levelDataHeap + (index_ * sizeOfTacticalLevelData);
+		uint32_t const pageMask = (1u << LevelDataPageShift) - 1;
+		return levelDataPages[index_ >> LevelDataPageShift] + ((index_ & pageMask) * sizeOfTacticalLevelData);
 	}
+	// copies the level data into a contiguous heap, versions have theirs spread over pages
+	void copyLevelData(uint8_t* out_) const;
+
+	static uint32_t countTiles(int width_, int height_, TacticalMapTileLayout layout_);
+
+	// tiles [x0, x1) by [z0, z1)
+	struct TileRect
+	{
+		int x0 = 0, z0 = 0, x1 = 0, z1 = 0;
 
-	static const uint16_t MajorVersion = 7;
+		bool empty() const { return x0 >= x1 || z0 >= z1; }
+		void add(int x_, int z_)
+		{
+			if(empty()) *this = TileRect{ x_, z_, x_ + 1, z_ + 1 };
+			else *this = TileRect{ std::min(x0, x_), std::min(z0, z_), std::max(x1, x_ + 1), std::max(z1, z_ + 1) };
+		}
+		void add(TileRect const& rect_)
+		{
+			if(rect_.empty()) return;
+			if(empty()) *this = rect_;
+			else *this = TileRect{ std::min(x0, rect_.x0), std::min(z0, rect_.z0), std::max(x1, rect_.x1), std::max(z1, rect_.z1) };
+		}
+	};
+	// the tiles overlapping box_ in x and z
+	TileRect getTileRect(Geometry::AABB const& box_) const;
+
+	// summaries of every level of the pyramid, finest first
+	static uint32_t countSummaryNodes(int width_, int height_);
+	// rebuilds the summaries of the blocks with tiles in rect_ and everything above them
+	void updateSummary(TileRect const& rect_);
+	enum class SummaryVisit { Skip, Descend, Stop };
+	// walks the summaries over rect_ from the top down, node_(summary, whollyInRect) says whether to look inside
+	// a block and tile_(x, z) is called for the tiles of the finest blocks it does. false if either stopped it
+	template<typename NodeFunc, typename TileFunc>
+	bool visitSummary(TileRect const& rect_, NodeFunc&& node_, TileFunc&& tile_) const;
+
+	// validates (and converts old versions of) a loaded chunk, shared by all the create paths
+	static bool processChunk(uint16_t majorVersion_, uint16_t minorVersion_, std::shared_ptr<void> ptr_,
+							 std::vector<std::shared_ptr<TacticalMap>>& out_);
+	// the summary chunk is saved after its map chunk so belongs to the last map loaded
+	static bool processSummaryChunk(uint16_t majorVersion_, uint16_t minorVersion_, std::shared_ptr<void> ptr_,
+									std::vector<std::shared_ptr<TacticalMap>>& out_);
+	// loaded maps without a summary chunk get theirs built
+	static void buildMissingSummaries(std::vector<std::shared_ptr<TacticalMap>>& out_);
+	// summaries that aren't in the maps own allocation are kept alive by the returned map
+	static std::shared_ptr<TacticalMap> attachSummary(std::shared_ptr<TacticalMap> const& map_,
+													  std::shared_ptr<void> owner_, TacticalMapAreaSummary* summary_);
+
+	// one allocation holding the map, its levels, level data heap, tiles and summaries.
+	// tiles are cleared, levels, level data and summaries are left for the caller to fill in
+	static std::shared_ptr<TacticalMap> allocate(uint16_t width_, uint16_t height_,
+												 TacticalMapTileLayout layout_,
+												 uint32_t levelCount_, uint32_t sizeOfLevelData_,
+												 std::string_view name_);
+	// maps before MajorVersion 8 had 48 byte float levels and were always row major
+	static std::shared_ptr<TacticalMap> convertFromVersion7(TacticalMap const* old_);
+	// MajorVersion 8 and 9 maps headers are missing levelDataPages or summary so can't be used where they lie.
+	// their levels, like MajorVersion 10s, only had 8 bits of flags
+	static std::shared_ptr<TacticalMap> convertFromVersion8(TacticalMap const* old_);
+	// before MajorVersion 12 tile base heights were in HeightQuantum units, false if a level can't be rebased
+	bool convertBaseHeightsFromVersion11();
+
+	// lowest height the tiles levels can be quantised above, false if it's outside what a base height covers
+	static bool encodeTileBaseHeight(float lowestLevelHeight_, int16_t& out_);
+	// roofDeltaHeight_ is ignored unless flags_ has RoofValid. false if the floor or roof are
+	// further above the tile base height than a level can hold
+	static bool encodeLevel(int16_t tileBaseHeight_,
+							float height_, float roofDeltaHeight_,
+							Math::vec3 const& floorNormal_, Math::vec3 const& roofNormal_,
+							uint32_t flags_, uint8_t layer_, TacticalMapTileLevel& out_);
+
+	// the level lookupAtWorld finds in a tile, the batched lookups use it as well
+	ConstLevelDataPair lookupInTile(TacticalMapTile const& tile_, float const y_, float const range_, uint32_t const levelMask_) const;
+	// is the straight line from a_ to b_, both over the tile at x_ z_, in open space
+	bool isOpenInTile(int x_, int z_, Math::vec3 const& a_, Math::vec3 const& b_, uint32_t const levelMask_) const;
+
+	// floods damage out from the tiles the boxes hit, writableLevelData_(levelIndex) returns the level data
+	// to change. returns the tiles whose level data was changed
+	template<typename WritableLevelData>
+	TileRect applyDamage(Geometry::AABB const* boxes_, size_t count_, WritableLevelData&& writableLevelData_) const;
+
+	// calls func_(queryIndex, tile, ConstLevelDataPair) for every query, in tile order
+	template<typename Func>
+	void visitLookupsAtWorld(Math::vec3 const* points_, size_t const count_, float const range_, uint32_t const levelMask_, Func&& func_) const;
+
+	static const uint16_t MajorVersion = 12;
 	static const uint16_t MinorVersion = 0;
 
 	TacticalMap() {};
@@ -257,7 +561,8 @@ private:
 	uint32_t sizeOfTacticalLevelData;
 
 	uint16_t width, height;
-	uint16_t padd0, padd1;
+	TacticalMapTileLayout tileLayout;
+	uint16_t padd1;
 
 	uint32_t levelCount = 0;
 	Math::vec2 bottomLeft;
@@ -267,6 +572,10 @@ private:
 	TacticalMapTileLevel* levels = nullptr;
 	TacticalMapTile* map  = nullptr;
 	uint8_t* levelDataHeap = nullptr;
+	// null unless this is a version made by damageStructures, then the level data is in these pages
+	uint8_t* const* levelDataPages = nullptr;
+	// countSummaryNodes of them, never null once a map is built or loaded
+	TacticalMapAreaSummary* summary = nullptr;
 };
 
 inline Math::vec2 TacticalMap::worldToLocal( Math::vec3 const& world ) const
@@ -282,6 +591,38 @@ inline void TacticalMap::worldToLocal(Math::vec3 const& world, TileCoord_t& outX
 	outY = (TileCoord_t) std::floor(local.y);
 }
 
+inline uint32_t TacticalMap::getTileIndex(int x, int z) const
+{
+	assert(x >= 0 && x < width);
+	assert(z >= 0 && z < height);
+	if(tileLayout == TacticalMapTileLayout::RowMajor) return uint32_t(z * width + x);
+
+	static_assert(MortonBlockSize == 8);
+	int const blocksWide = (width + MortonBlockSize - 1) / MortonBlockSize;
+	uint32_t const block = uint32_t((z / MortonBlockSize) * blocksWide + (x / MortonBlockSize));
+	// interleave the 3 bit coordinates within the block
+	uint32_t const bx = uint32_t(x & 7);
+	uint32_t const bz = uint32_t(z & 7);
+	uint32_t const morton = (bx & 1) | ((bz & 1) << 1) |
+							((bx & 2) << 1) | ((bz & 2) << 2) |
+							((bx & 4) << 2) | ((bz & 4) << 3);
+	return (block * MortonBlockSize * MortonBlockSize) + morton;
+}
+
+inline uint32_t TacticalMap::countTiles(int width_, int height_, TacticalMapTileLayout layout_)
+{
+	if(layout_ == TacticalMapTileLayout::RowMajor) return uint32_t(width_ * height_);
+
+	uint32_t const blocksWide = uint32_t((width_ + MortonBlockSize - 1) / MortonBlockSize);
+	uint32_t const blocksHigh = uint32_t((height_ + MortonBlockSize - 1) / MortonBlockSize);
+	return blocksWide * blocksHigh * MortonBlockSize * MortonBlockSize;
+}
+
+inline uint32_t TacticalMap::getTileCount() const
+{
+	return countTiles(width, height, tileLayout);
+}
+
 inline Math::vec3 TacticalMap::localToWorld(TileCoord_t const x, TileCoord_t const y) const
 {
 
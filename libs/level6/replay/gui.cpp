@@ -739,10 +739,13 @@ auto Gui::tacmapCallback(Item const& item_) -> bool
 	using namespace std::literals;
 	std::lock_guard lock(lockMutex);
 
-	std::istringstream stream(item_.data);
+	// the item keeps its data, the map is loaded in place from a single copy of it
+	std::shared_ptr<void> copy(malloc(item_.data.size()), &free);
+	if(!copy) return false;
+	std::memcpy(copy.get(), item_.data.data(), item_.data.size());
 
 	std::vector<std::shared_ptr<TacticalMap>> tactMaps;
-	bool okay = TacticalMap::createFromStream(stream, tactMaps);
+	bool okay = TacticalMap::createFromMemory(copy, (uint8_t*) copy.get(), item_.data.size(), tactMaps);
 	if(okay)
 	{
 		for(auto const& tmap : tactMaps)
@@ -789,12 +792,14 @@ auto Gui::tmapTileGenerateMesh(
 	for(auto i = 0u; i < tile.levelCount; ++i)
 	{
 		auto const& level = tmap_->getLevel(tile, i);
-		minHeight = std::min(minHeight, level.baseHeight);
-		maxHeight = std::max(maxHeight, level.baseHeight + level.roofDeltaHeight);
+		float const levelHeight = TacticalMap::getLevelHeight(tile, level);
+		minHeight = std::min(minHeight, levelHeight);
+		maxHeight = std::max(maxHeight, std::min(TacticalMap::getRoofHeight(tile, level),
+												 std::numeric_limits<float>::max()));
 
 		MeshOps::BasicMeshOps::combine(				
 				MeshOps::Shapes::CreateSquare(
-						{tilePos.x, level.baseHeight, tilePos.y},
+						{tilePos.x, levelHeight, tilePos.y},
 						{0.0f, 1.0f, 0.0f}
 				),
 				combinedMesh);
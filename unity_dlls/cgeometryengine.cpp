@@ -1,7 +1,9 @@
+#if !defined(USING_STATIC_LIBS)
 #define LOGURU_IMPLEMENTATION 1
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #define TINYGLTF_IMPLEMENTATION
+#endif
 
 #include "core/core.h"
 #include "crc32c/crc32c.h"
@@ -21,10 +23,31 @@
 #include "meshops/gltf.h"
 #include "meshops/basicmeshops.h"
 #include "meshops/convexhullcomputer.h"
+#include "meshops/convexdecomposer.h"
+#include "core/handletable.h"
+#include "core/sharedtasks.h"
+#include <mutex>
+#include <condition_variable>
+#include <cfloat>
+
+// unity job threads create and delete meshes, so the handles are generational and lock free
+static Core::HandleTable<MeshMod::Mesh> unityOwnedMeshes;
+// filled in by a decomposer worker, the handle keeps it alive if unity destroys it first
+struct PendingConvexHulls
+{
+	std::mutex mutex;
+	std::condition_variable ready;
+	bool done = false;
+	MeshOps::ConvexDecomposer::Hulls hulls;
+};
+static Core::HandleTable<PendingConvexHulls> unityOwnedConvexHullComputers;
+// views only hold a copy of the SimpleMesh struct, the arrays stay owned (and pinned) by unity
+static Core::HandleTable<SimpleMesh const> unityOwnedMeshViews;
 
-
-static std::vector<std::shared_ptr<MeshMod::Mesh>> unityOwnedMeshes;
-static std::vector<std::shared_ptr<MeshOps::ConvexHullComputer::ReturnType>> unityOwnedConvexHullComputers;
+#if !defined(USING_STATIC_LIBS)
+// this dll's share of the task threads, meshops fans its loops out on it too
+enki::TaskScheduler g_EnkiTS;
+#endif
 
 /*
  * 1) The unity Mesh approach
@@ -37,159 +60,455 @@ static int const MESH_TYPE_FULL_MAINTENANCE = 0;
 static int const MESH_TYPE_MAINTAIN_POINT_REP = 0x1;
 static int const MESH_TYPE_MAINTAIN_EDGE_CONNECTIONS = 0x2;
 
-// creates and returns a mesh handle to unity, just pass it back
-CAPI auto CGE_CreateMesh( int type, char *name ) -> MeshHandle
-{
+namespace {
+// vertices per task for bulk copies, smaller streams aren't worth waking task threads for
+static uint32_t const BulkVerticesPerTask = 16 * 1024;
 
-	size_t index = unityOwnedMeshes.size();
-
-	bool maintainPointRep = type & MESH_TYPE_MAINTAIN_POINT_REP;
-	bool maintainEdgeConnections = type & MESH_TYPE_MAINTAIN_EDGE_CONNECTIONS;
-	auto ptr = std::make_shared<MeshMod::Mesh>( name, maintainPointRep, maintainEdgeConnections);
-
-	unityOwnedMeshes.push_back(ptr);
-	return (uint64_t) index;
+// runs func_(begin, end) over [0, count_), big ranges are split across the shared task threads
+template<typename Func>
+void ParallelRanges(uint32_t const count_, Func&& func_)
+{
+	if(count_ >= 2 * BulkVerticesPerTask) Core::InitSharedTasks();
+	Core::ParallelFor(count_, BulkVerticesPerTask, [&func_](uint32_t const begin_, uint32_t const end_, uint32_t)
+	{
+		func_(begin_, end_);
+	});
 }
-// creates and returns a mesh handle to unity, just pass it back
-CAPI auto CGE_CreateMeshFromSimpleMesh( int type, char *name, SimpleMesh *simpleMesh ) -> MeshHandle
+
+template<MeshStreamFormat Format> struct StreamComponent;
+template<> struct StreamComponent<MeshStreamFormat::Float32> { using Type = float; static float decode(float v_) { return v_; } };
+template<> struct StreamComponent<MeshStreamFormat::Float16> { using Type = uint16_t; static float decode(uint16_t v_) { return Math::half2float(v_); } };
+template<> struct StreamComponent<MeshStreamFormat::UNorm8> { using Type = uint8_t; static float decode(uint8_t v_) { return float(v_) / 255.0f; } };
+template<> struct StreamComponent<MeshStreamFormat::SNorm8> { using Type = int8_t; static float decode(int8_t v_) { return std::max(float(v_) / 127.0f, -1.0f); } };
+template<> struct StreamComponent<MeshStreamFormat::UNorm16> { using Type = uint16_t; static float decode(uint16_t v_) { return float(v_) / 65535.0f; } };
+template<> struct StreamComponent<MeshStreamFormat::SNorm16> { using Type = int16_t; static float decode(int16_t v_) { return std::max(float(v_) / 32767.0f, -1.0f); } };
+
+// decodes count_ vertices of a stream to floats and hands them to write_(destination index, 4 floats)
+template<MeshStreamFormat Format, typename Write>
+void CopyTypedStream(MeshAttributeStream const& stream_, uint8_t const* first_, uint32_t const destination_,
+					 uint32_t const count_, Write&& write_)
 {
-	using namespace MeshMod;
-	bool maintainPointRep = type & MESH_TYPE_MAINTAIN_POINT_REP;
-	bool maintainEdgeConnections = type & MESH_TYPE_MAINTAIN_EDGE_CONNECTIONS;
+	using Component = StreamComponent<Format>;
+	uint32_t const dimension = std::min(stream_.dimension, 4u);
+	size_t const stride = stream_.stride != 0 ? stream_.stride : stream_.dimension * sizeof(typename Component::Type);
 
-	size_t index = unityOwnedMeshes.size();
-	auto mesh = std::make_shared<MeshMod::Mesh>( name, maintainPointRep, maintainEdgeConnections);
+	ParallelRanges(count_, [&](uint32_t const begin_, uint32_t const end_)
+	{
+		for(auto i = begin_; i < end_; ++i)
+		{
+			uint8_t const* src = first_ + (i * stride);
+			float values[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+			for(auto c = 0u; c < dimension; ++c)
+			{
+				// unity streams are interleaved so nothing is aligned
+				typename Component::Type raw;
+				std::memcpy(&raw, src + (c * sizeof(raw)), sizeof(raw));
+				values[c] = Component::decode(raw);
+			}
+			write_(MeshMod::VertexIndex(destination_ + i), values);
+		}
+	});
+}
 
-	Vertices& vertices = mesh->getVertices();
-	for(auto i = 0u; i < simpleMesh->positionCount; ++i)
+template<typename Write>
+bool CopyStream(MeshAttributeStream const& stream_, uint8_t const* first_, uint32_t const destination_,
+				uint32_t const count_, Write&& write_)
+{
+	switch(stream_.format)
 	{
-		vertices.add( simpleMesh->positions[(i * 3) + 0],
-					  simpleMesh->positions[(i * 3) + 1],
-					  simpleMesh->positions[(i * 3) + 2] );
+		case MeshStreamFormat::Float32: CopyTypedStream<MeshStreamFormat::Float32>(stream_, first_, destination_, count_, write_); return true;
+		case MeshStreamFormat::Float16: CopyTypedStream<MeshStreamFormat::Float16>(stream_, first_, destination_, count_, write_); return true;
+		case MeshStreamFormat::UNorm8: CopyTypedStream<MeshStreamFormat::UNorm8>(stream_, first_, destination_, count_, write_); return true;
+		case MeshStreamFormat::SNorm8: CopyTypedStream<MeshStreamFormat::SNorm8>(stream_, first_, destination_, count_, write_); return true;
+		case MeshStreamFormat::UNorm16: CopyTypedStream<MeshStreamFormat::UNorm16>(stream_, first_, destination_, count_, write_); return true;
+		case MeshStreamFormat::SNorm16: CopyTypedStream<MeshStreamFormat::SNorm16>(stream_, first_, destination_, count_, write_); return true;
+		default: return false;
 	}
+}
 
-	Polygons& polygons = mesh->getPolygons();
-	for(auto i = 0u; i < simpleMesh->triangleCount; ++i)
+// copies a stream into already allocated vertices [destination_, destination_ + count_)
+// elements are fetched or added up front so the copies only write into presized storage
+bool AddVertexStream(MeshMod::Mesh& mesh_, MeshAttributeStream const& stream_, uint8_t const* first_,
+					 uint32_t const destination_, uint32_t const count_)
+{
+	using namespace MeshMod;
+	Vertices& vertices = mesh_.getVertices();
+	assert(vertices.getCount() >= size_t(destination_) + count_);
+	VerticesElementsContainer& vertCon = vertices.getVerticesContainer();
+
+	switch(stream_.semantic)
 	{
-		VertexIndexContainer triIndices = {
-				VertexIndex(simpleMesh->triangleIndices[(i * 3) + 0]),
-				VertexIndex(simpleMesh->triangleIndices[(i * 3) + 2]),
-				VertexIndex(simpleMesh->triangleIndices[(i * 3) + 1])
-		};
-		mesh->getPolygons().addPolygon( triIndices );
+		case MeshStreamSemantic::Position:
+		{
+			auto& positions = vertices.positions();
+			auto& pointReps = vertices.getOrAddAttribute<VertexData::PointReps>();
+			return CopyStream(stream_, first_, destination_, count_,
+							  [&positions, &pointReps](VertexIndex i_, float const* v_)
+							  {
+								  positions[i_] = VertexData::Position(v_[0], v_[1], v_[2]);
+								  pointReps[i_] = VertexData::PointRep(i_);
+							  });
+		}
+		case MeshStreamSemantic::Normal:
+		{
+			auto& normals = *vertCon.getOrAddElement<VertexData::Normals>();
+			return CopyStream(stream_, first_, destination_, count_, [&normals](VertexIndex i_, float const* v_)
+			{
+				normals[i_] = VertexData::Normal(v_[0], v_[1], v_[2]);
+			});
+		}
+		case MeshStreamSemantic::Tangent:
+		{ // this is actually the binormal usually but whatever
+			auto& binormals = *vertCon.getOrAddElement<VertexData::Normals>("binormal");
+			return CopyStream(stream_, first_, destination_, count_, [&binormals](VertexIndex i_, float const* v_)
+			{
+				binormals[i_] = VertexData::Normal(v_[0], v_[1], v_[2]);
+			});
+		}
+		case MeshStreamSemantic::Colour:
+		{
+			auto& colours = *vertCon.getOrAddElement<VertexData::FloatRGBAColourVertexElements>();
+			return CopyStream(stream_, first_, destination_, count_, [&colours](VertexIndex i_, float const* v_)
+			{
+				colours[i_] = VertexData::FloatRGBAColour(v_[0], v_[1], v_[2], v_[3]);
+			});
+		}
+		case MeshStreamSemantic::UV0:
+		case MeshStreamSemantic::UV1:
+		{
+			auto& uvs = stream_.semantic == MeshStreamSemantic::UV0 ?
+						*vertCon.getOrAddElement<VertexData::UVs>() :
+						*vertCon.getOrAddElement<VertexData::UVs>("1");
+			return CopyStream(stream_, first_, destination_, count_, [&uvs](VertexIndex i_, float const* v_)
+			{
+				uvs[i_] = VertexData::UV(v_[0], v_[1]);
+			});
+		}
+		default: return false;
 	}
+}
 
-	mesh->updateFromEdits();
-
-	unityOwnedMeshes.push_back(mesh);
-	return (uint64_t) index;
+template<typename IndexType>
+uint32_t ReadIndex(MeshIndexStream const& stream_, size_t const i_)
+{
+	IndexType index;
+	std::memcpy(&index, (uint8_t const*) stream_.data + (i_ * sizeof(IndexType)), sizeof(IndexType));
+	return uint32_t(index) + stream_.baseVertex;
+}
 
+uint32_t ReadIndex(MeshIndexStream const& stream_, size_t const i_)
+{
+	return stream_.format == MeshIndexFormat::UInt16 ?
+		   ReadIndex<uint16_t>(stream_, i_) :
+		   ReadIndex<uint32_t>(stream_, i_);
 }
 
-// when you have finished with the mesh, this will clean up
-CAPI auto CGE_DeleteMesh( MeshHandle meshHandle ) -> void
+bool IsValidIndexStream(MeshIndexStream const& stream_, uint32_t const vertexCount_)
 {
-	assert( meshHandle < unityOwnedMeshes.size());
-	unityOwnedMeshes[(size_t) meshHandle].reset();
+	if(stream_.format != MeshIndexFormat::UInt16 && stream_.format != MeshIndexFormat::UInt32) return false;
+	if(stream_.indicesPerPolygon != 3 && stream_.indicesPerPolygon != 4) return false;
+	if(stream_.polygonCount == 0) return true;
+	if(stream_.data == nullptr) return false;
+
+	std::atomic<bool> valid{ true };
+	uint32_t const indexCount = stream_.polygonCount * stream_.indicesPerPolygon;
+	ParallelRanges(indexCount, [&stream_, vertexCount_, &valid](uint32_t const begin_, uint32_t const end_)
+	{
+		for(auto i = begin_; i < end_; ++i)
+		{
+			if(ReadIndex(stream_, i) >= vertexCount_)
+			{
+				valid.store(false, std::memory_order_relaxed);
+				return;
+			}
+		}
+	});
+	return valid.load();
 }
 
-// all vertex positions should be added before vertex data and before indices
-CAPI auto CGE_AddPositions( MeshHandle meshHandle, uint32_t count, intptr_t iptr ) -> uint32_t 
+// topology building isn't thread safe, so polygons go in one at a time
+void AddIndexStream(MeshMod::Mesh& mesh_, MeshIndexStream const& stream_)
 {
-	assert( meshHandle < unityOwnedMeshes.size());
-	assert( unityOwnedMeshes[(size_t) meshHandle] );
+	using namespace MeshMod;
+	// flip unitys winding as AddTriangles does
+	static uint32_t const triangleOrder[] = { 0, 2, 1 };
+	static uint32_t const quadOrder[] = { 0, 3, 2, 1 };
+	uint32_t const* order = stream_.indicesPerPolygon == 3 ? triangleOrder : quadOrder;
+
+	Polygons& polygons = mesh_.getPolygons();
+	VertexIndexContainer polygon(stream_.indicesPerPolygon);
+	for(auto i = 0u; i < stream_.polygonCount; ++i)
+	{
+		size_t const first = size_t(i) * stream_.indicesPerPolygon;
+		for(auto j = 0u; j < stream_.indicesPerPolygon; ++j)
+		{
+			polygon[j] = VertexIndex(ReadIndex(stream_, first + order[j]));
+		}
+		polygons.addPolygon(polygon);
+	}
+}
 
-	auto mesh = unityOwnedMeshes[(uint32_t) meshHandle];
-	auto startIndex = mesh->getVertices().getCount();
+// one bounded set of decomposition workers shared by every async hull request
+MeshOps::ConvexDecomposer& Decomposer()
+{
+	static MeshOps::ConvexDecomposer decomposer;
+	return decomposer;
+}
 
-	float *positions = reinterpret_cast<float *>(iptr);
-	for(auto i = 0u; i < count; ++i)
+MeshOps::ConvexHullParameters CopyParameters(MeshOps::ConvexHullParameters const* params_)
+{
+	MeshOps::ConvexHullParameters params;
+	if (params_ != nullptr)
 	{
-		mesh->getVertices().add(	positions[i * 3 + 0], 
-									positions[i * 3 + 1],
-									positions[i * 3 + 2] );
+		std::memcpy(&params, params_, sizeof(MeshOps::ConvexHullParameters));
 	}
-	return uint32_t(startIndex);
+	return params;
 }
 
-// add any optional vertex data after AddPositions
-CAPI auto CGE_AddVertexData( MeshHandle meshHandle, char *typeName, uint32_t startIndex, uint32_t count, intptr_t iptr ) -> void
+// adds the pending result first so the callback can be told its handle
+ConvexHullGeneratorHandle SubmitConvexHulls(MeshOps::ConvexDecomposer::Request request_,
+											ConvexHullsReadyCallback callback_, void* userData_)
 {
-	assert( meshHandle < unityOwnedMeshes.size());
-	assert( unityOwnedMeshes[(size_t) meshHandle] );
+	auto pending = std::make_shared<PendingConvexHulls>();
+	ConvexHullGeneratorHandle const handle = unityOwnedConvexHullComputers.add(pending);
+	request_.onComplete = [pending, handle, callback_, userData_](uint64_t, MeshOps::ConvexDecomposer::Hulls const& hulls_)
+	{
+		{
+			std::lock_guard<std::mutex> lock(pending->mutex);
+			pending->hulls = hulls_;
+			pending->done = true;
+		}
+		pending->ready.notify_all();
+		if(callback_) callback_(handle, userData_);
+	};
+	// picks up the cutils disk cache if its been opened (or closed) since last time
+	Decomposer().setDiskCache(GetDerivedDataCache());
+	std::vector<MeshOps::ConvexDecomposer::Request> batch;
+	batch.push_back(std::move(request_));
+	Decomposer().submit(std::move(batch));
+	return handle;
+}
 
+// returns a null mesh if the descriptor is bad
+std::shared_ptr<MeshMod::Mesh> BuildMesh(MeshBulkDescriptor const& desc_)
+{
 	using namespace MeshMod;
-	auto mesh = unityOwnedMeshes[(size_t) meshHandle];
-	assert( mesh->getVertices().getCount() >= (startIndex + count));
-
-	VerticesElementsContainer& vertCon = mesh->getVertices().getVerticesContainer();
 
-	switch(Core::QuickHash( std::string( typeName )))
+	bool hasPositions = false;
+	for(auto i = 0u; i < desc_.attributeStreamCount; ++i)
 	{
-		case "uvs"_hash:
+		MeshAttributeStream const& stream = desc_.attributeStreams[i];
+		if(stream.data == nullptr && desc_.vertexCount != 0)
 		{
-			auto uvEle = vertCon.getOrAddElement<VertexData::UVs>();
-			float *data = reinterpret_cast<float *>(iptr);
-			for(auto i = startIndex; i < startIndex + count; ++i)
-			{
-				(*uvEle)[VertexIndex(i)] = VertexData::UV( data[i * 2 + 0], data[i * 2 + 1] );
-			}
-			break;
+			LOG_F(WARNING, "Bulk mesh %s attribute stream %u has no data", desc_.name, i);
+			return {};
 		}
-		case "uvs_1"_hash:
+		hasPositions |= stream.semantic == MeshStreamSemantic::Position;
+	}
+	if(!hasPositions)
+	{
+		LOG_F(WARNING, "Bulk mesh %s has no position stream", desc_.name);
+		return {};
+	}
+
+	// bad indices would leave a half built mesh so check them all before building anything
+	for(auto i = 0u; i < desc_.indexStreamCount; ++i)
+	{
+		if(!IsValidIndexStream(desc_.indexStreams[i], desc_.vertexCount))
 		{
-			auto uvEle = vertCon.getOrAddElement<VertexData::UVs>( "1" );
-			float *data = reinterpret_cast<float *>(iptr);
-			for(auto i = startIndex; i < startIndex + count; ++i)
-			{
-				(*uvEle)[VertexIndex(i)] = VertexData::UV( data[i * 2 + 0], data[i * 2 + 1] );
-			}
-			break;
+			LOG_F(WARNING, "Bulk mesh %s index stream %u is invalid", desc_.name, i);
+			return {};
 		}
-		case "normals"_hash:
+	}
+
+	bool maintainPointRep = desc_.type & MESH_TYPE_MAINTAIN_POINT_REP;
+	bool maintainEdgeConnections = desc_.type & MESH_TYPE_MAINTAIN_EDGE_CONNECTIONS;
+	auto mesh = std::make_shared<MeshMod::Mesh>(desc_.name ? desc_.name : "", maintainPointRep, maintainEdgeConnections);
+
+	// all the vertices at once, the streams then write straight into each element
+	Vertices& vertices = mesh->getVertices();
+	vertices.getOrAddAttribute<VertexData::PointReps>();
+	vertices.getVerticesContainer().resize(desc_.vertexCount);
+
+	// topology edits throw away derived elements like normals, so everything but positions goes in after
+	auto const addStreams = [&desc_, &mesh](bool const positions_)
+	{
+		for(auto i = 0u; i < desc_.attributeStreamCount; ++i)
 		{
-			auto normEle = vertCon.getOrAddElement<VertexData::Normals>();
-			float *data = reinterpret_cast<float *>(iptr);
-			for(auto i = startIndex; i < startIndex + count; ++i)
+			MeshAttributeStream const& stream = desc_.attributeStreams[i];
+			if((stream.semantic == MeshStreamSemantic::Position) != positions_) continue;
+			if(!AddVertexStream(*mesh, stream, (uint8_t const*) stream.data, 0, desc_.vertexCount))
 			{
-				(*normEle)[VertexIndex(i)] = VertexData::Normal( data[i * 3 + 0], data[i * 3 + 1], data[i * 3 + 2] );
+				LOG_F(WARNING, "Bulk mesh %s attribute stream %u has an unknown semantic or format", desc_.name, i);
+				return false;
 			}
-			break;
 		}
-		case "tangents"_hash:
-		{ // this is actually the binormal usually but whatever
-			auto normEle = vertCon.getOrAddElement<VertexData::Normals>( "binormal" );
-			float *data = reinterpret_cast<float *>(iptr);
-			for(auto i = startIndex; i < startIndex + count; ++i)
-			{
-				(*normEle)[VertexIndex(i)] = VertexData::Normal( data[i * 3 + 0], data[i * 3 + 1], data[i * 3 + 2] );
-			}
-			break;
+		return true;
+	};
+	if(!addStreams(true)) return {};
+
+	for(auto i = 0u; i < desc_.indexStreamCount; ++i)
+	{
+		AddIndexStream(*mesh, desc_.indexStreams[i]);
+	}
+	mesh->updateEditState( MeshMod::Mesh::TopologyEdits );
+	mesh->updateFromEdits();
+
+	if(!addStreams(false)) return {};
+
+	return mesh;
+}
+
+
+// the arrays are unitys, so check the indices once up front and trust them after
+bool IsValidSimpleMesh(SimpleMesh const& simpleMesh_)
+{
+	if(simpleMesh_.positionCount != 0 && simpleMesh_.positions == nullptr) return false;
+	MeshIndexStream const indices{
+			MeshIndexFormat::UInt32, 3, simpleMesh_.triangleCount, 0, simpleMesh_.triangleIndices };
+	return IsValidIndexStream(indices, simpleMesh_.positionCount);
+}
+
+// a simple mesh is just one float3 stream and one triangle stream
+std::shared_ptr<MeshMod::Mesh> BuildMesh(int const type_, char const* name_, SimpleMesh const& simpleMesh_)
+{
+	MeshAttributeStream const positions{
+			MeshStreamSemantic::Position, MeshStreamFormat::Float32, 3, sizeof(float) * 3, simpleMesh_.positions };
+	MeshIndexStream const triangles{
+			MeshIndexFormat::UInt32, 3, simpleMesh_.triangleCount, 0, simpleMesh_.triangleIndices };
+	MeshBulkDescriptor const desc{
+			type_, name_, simpleMesh_.positionCount, 1, &positions, 1, &triangles };
+	return BuildMesh(desc);
+}
+
+// every valid polygon is fanned, returns the prefix offsets (in triangles) with the total at the back
+std::vector<uint32_t> TriangleFanOffsets(MeshMod::Polygons const& polygons_)
+{
+	using namespace MeshMod;
+	std::vector<uint32_t> offsets(polygons_.getCount() + 1);
+	uint32_t total = 0;
+	for(auto i = 0u; i < polygons_.getCount(); ++i)
+	{
+		offsets[i] = total;
+		if(!polygons_.isValid(PolygonIndex(i))) continue;
+		size_t const vertexCount = polygons_.getVertexCount(PolygonIndex(i));
+		if(vertexCount >= 3) total += uint32_t(vertexCount - 2);
+	}
+	offsets.back() = total;
+	return offsets;
+}
+
+// writes positions and fanned triangles straight into out_, which must be big enough
+void WriteSimpleMesh(MeshMod::Mesh const& mesh_, std::vector<uint32_t> const& offsets_, SimpleMesh& out_)
+{
+	using namespace MeshMod;
+	auto const& vertices = mesh_.getVertices();
+	auto const& polygons = mesh_.getPolygons();
+	auto const& positions = vertices.positions();
+
+	ParallelRanges(uint32_t(vertices.getCount()), [&positions, &out_](uint32_t const begin_, uint32_t const end_)
+	{
+		for(auto i = begin_; i < end_; ++i)
+		{
+			auto const& pos = positions[VertexIndex(i)];
+			out_.positions[(size_t(i) * 3) + 0] = pos.x;
+			out_.positions[(size_t(i) * 3) + 1] = pos.y;
+			out_.positions[(size_t(i) * 3) + 2] = pos.z;
 		}
-		case "colours"_hash:
-		{ // 4 x float
-			auto colEle = vertCon.getOrAddElement<VertexData::FloatRGBAColourVertexElements>();
-			float *data = reinterpret_cast<float *>(iptr);
-			for(auto i = startIndex; i < startIndex + count; ++i)
+	});
+
+	// back to unitys winding
+	ParallelRanges(uint32_t(polygons.getCount()), [&polygons, &offsets_, &out_](uint32_t const begin_, uint32_t const end_)
+	{
+		VertexIndexContainer vertexIndices;
+		for(auto i = begin_; i < end_; ++i)
+		{
+			if(offsets_[i] == offsets_[i + 1]) continue;
+			vertexIndices.clear();
+			polygons.getVertexIndices(PolygonIndex(i), vertexIndices);
+			uint32_t* indices = out_.triangleIndices + (size_t(offsets_[i]) * 3);
+			for(auto j = 1u; j + 1 < vertexIndices.size(); ++j)
 			{
-				(*colEle)[VertexIndex(i)] = VertexData::FloatRGBAColour(
-						data[i * 4 + 0], data[i * 4 + 1], data[i * 4 + 2], data[i * 4 + 3] );
+				*indices++ = (uint32_t) vertexIndices[0];
+				*indices++ = (uint32_t) vertexIndices[j + 1];
+				*indices++ = (uint32_t) vertexIndices[j];
 			}
-			break;
 		}
+	});
+}
+
+}
+
+// creates and returns a mesh handle to unity, just pass it back
+CAPI auto CGE_CreateMesh( int type, char *name ) -> MeshHandle
+{
+	bool maintainPointRep = type & MESH_TYPE_MAINTAIN_POINT_REP;
+	bool maintainEdgeConnections = type & MESH_TYPE_MAINTAIN_EDGE_CONNECTIONS;
+	auto ptr = std::make_shared<MeshMod::Mesh>( name, maintainPointRep, maintainEdgeConnections);
+
+	return unityOwnedMeshes.add(ptr);
+}
+// creates and returns a mesh handle to unity, just pass it back
+CAPI auto CGE_CreateMeshFromSimpleMesh( int type, char *name, SimpleMesh *simpleMesh ) -> MeshHandle
+{
+	assert(simpleMesh != nullptr);
+	auto mesh = BuildMesh(type, name ? name : "", *simpleMesh);
+	assert(mesh);
+
+	return unityOwnedMeshes.add(mesh);
+}
+
+// when you have finished with the mesh, this will clean up
+CAPI auto CGE_DeleteMesh( MeshHandle meshHandle ) -> void
+{
+	unityOwnedMeshes.erase(meshHandle);
+}
+
+// all vertex positions should be added before vertex data and before indices
+CAPI auto CGE_AddPositions( MeshHandle meshHandle, uint32_t count, intptr_t iptr ) -> uint32_t 
+{
+	auto mesh = unityOwnedMeshes.get(meshHandle);
+	assert(mesh);
+	auto& vertices = mesh->getVertices();
+	auto startIndex = vertices.getCount();
+
+	vertices.getOrAddAttribute<MeshMod::VertexData::PointReps>();
+	vertices.getVerticesContainer().resize(startIndex + count);
+	MeshAttributeStream const stream{ MeshStreamSemantic::Position, MeshStreamFormat::Float32, 3, 0, (void const*) iptr };
+	AddVertexStream(*mesh, stream, (uint8_t const*) iptr, uint32_t(startIndex), count);
+	return uint32_t(startIndex);
+}
+
+// add any optional vertex data after AddPositions
+CAPI auto CGE_AddVertexData( MeshHandle meshHandle, char *typeName, uint32_t startIndex, uint32_t count, intptr_t iptr ) -> void
+{
+	auto mesh = unityOwnedMeshes.get(meshHandle);
+	assert(mesh);
+
+	MeshAttributeStream stream{ MeshStreamSemantic::Position, MeshStreamFormat::Float32, 0, 0, (void const*) iptr };
+	switch(Core::QuickHash( std::string_view( typeName )))
+	{
+		case "uvs"_hash: stream.semantic = MeshStreamSemantic::UV0; stream.dimension = 2; break;
+		case "uvs_1"_hash: stream.semantic = MeshStreamSemantic::UV1; stream.dimension = 2; break;
+		case "normals"_hash: stream.semantic = MeshStreamSemantic::Normal; stream.dimension = 3; break;
+		case "tangents"_hash: stream.semantic = MeshStreamSemantic::Tangent; stream.dimension = 3; break;
+		case "colours"_hash: stream.semantic = MeshStreamSemantic::Colour; stream.dimension = 4; break; // 4 x float
 		default:
 			assert( false && "invalid typeName" );
+			return;
 	}
+
+	// the data is indexed from the start of the mesh not startIndex
+	uint8_t const* first = (uint8_t const*) iptr + (size_t(startIndex) * stream.dimension * sizeof(float));
+	AddVertexStream(*mesh, stream, first, startIndex, count);
 }
 
 
 CAPI auto CGE_AddTriangle( MeshHandle meshHandle, uint32_t i0, uint32_t i1, uint32_t i2 ) -> uint32_t
 {
-	assert( meshHandle < unityOwnedMeshes.size());
-	assert( unityOwnedMeshes[(size_t) meshHandle] );
-
 	using namespace MeshMod;
-	auto mesh = unityOwnedMeshes[(size_t) meshHandle];
+	auto mesh = unityOwnedMeshes.get(meshHandle);
+	assert(mesh);
 
 	VertexIndexContainer tri = {
 		VertexIndex(i0),
@@ -201,11 +520,9 @@ CAPI auto CGE_AddTriangle( MeshHandle meshHandle, uint32_t i0, uint32_t i1, uint
 
 CAPI auto CGE_AddQuad( MeshHandle meshHandle, uint32_t i0, uint32_t i1, uint32_t i2, uint32_t i3 ) -> uint32_t
 {
-	assert( meshHandle < unityOwnedMeshes.size());
-	assert( unityOwnedMeshes[(size_t) meshHandle] );
-
 	using namespace MeshMod;
-	auto mesh = unityOwnedMeshes[(size_t) meshHandle];
+	auto mesh = unityOwnedMeshes.get(meshHandle);
+	assert(mesh);
 
 	VertexIndexContainer quad = {
 		VertexIndex(i0),
@@ -219,11 +536,9 @@ CAPI auto CGE_AddQuad( MeshHandle meshHandle, uint32_t i0, uint32_t i1, uint32_t
 
 CAPI auto CGE_AddTriangles( MeshHandle meshHandle, uint32_t count, intptr_t indicesPtr ) -> uint32_t
 {
-	assert( meshHandle < unityOwnedMeshes.size());
-	assert( unityOwnedMeshes[(size_t) meshHandle] );
-
 	using namespace MeshMod;
-	auto mesh = unityOwnedMeshes[(size_t) meshHandle];
+	auto mesh = unityOwnedMeshes.get(meshHandle);
+	assert(mesh);
 	auto startFace = mesh->getPolygons().getCount();
 
 	uint32_t *indices = reinterpret_cast<uint32_t *>(indicesPtr);
@@ -243,11 +558,9 @@ CAPI auto CGE_AddTriangles( MeshHandle meshHandle, uint32_t count, intptr_t indi
 
 CAPI auto CGE_AddQuads( MeshHandle meshHandle, uint32_t count, intptr_t indicesPtr ) -> uint32_t
 {
-	assert( meshHandle < unityOwnedMeshes.size());
-	assert( unityOwnedMeshes[(size_t) meshHandle] );
-
 	using namespace MeshMod;
-	auto mesh = unityOwnedMeshes[(size_t) meshHandle];
+	auto mesh = unityOwnedMeshes.get(meshHandle);
+	assert(mesh);
 	auto startFace = mesh->getPolygons().getCount();
 
 	uint32_t *indices = reinterpret_cast<uint32_t *>(indicesPtr);
@@ -267,11 +580,9 @@ CAPI auto CGE_AddQuads( MeshHandle meshHandle, uint32_t count, intptr_t indicesP
 
 CAPI auto CGE_MeshCreationComplete( MeshHandle meshHandle ) -> void
 {
-	assert( meshHandle < unityOwnedMeshes.size());
-	assert( unityOwnedMeshes[(size_t) meshHandle] );
-
 	using namespace MeshMod;
-	auto mesh = unityOwnedMeshes[(size_t) meshHandle];
+	auto mesh = unityOwnedMeshes.get(meshHandle);
+	assert(mesh);
 
 	mesh->updateEditState( MeshMod::Mesh::TopologyEdits );
 	mesh->updateFromEdits();
@@ -279,11 +590,9 @@ CAPI auto CGE_MeshCreationComplete( MeshHandle meshHandle ) -> void
 
 CAPI auto CGE_GenerateConvexHulls(MeshHandle meshHandle, MeshOps::ConvexHullParameters* params_, MeshHandle* out) -> uint32_t
 {
-	assert( meshHandle < unityOwnedMeshes.size());
-	assert( unityOwnedMeshes[(size_t) meshHandle] );
-
 	using namespace MeshMod;
-	auto in = unityOwnedMeshes[(size_t) meshHandle];
+	auto in = unityOwnedMeshes.get(meshHandle);
+	assert(in);
 
 	MeshOps::ConvexHullParameters params;
 	if (params_ != nullptr)
@@ -303,21 +612,17 @@ CAPI auto CGE_GenerateConvexHulls(MeshHandle meshHandle, MeshOps::ConvexHullPara
 
 CAPI auto CGE_GenerateConvexHullInline(MeshHandle meshHandle) -> void
 {
-	assert( meshHandle < unityOwnedMeshes.size());
-	assert( unityOwnedMeshes[(size_t) meshHandle] );
-
 	using namespace MeshMod;
-	auto mesh = unityOwnedMeshes[(size_t) meshHandle];
+	auto mesh = unityOwnedMeshes.get(meshHandle);
+	assert(mesh);
 	MeshOps::ConvexHullComputer::generateInline(mesh);
 }
 
 CAPI auto CGE_ExportMeshToGLTF( MeshHandle meshHandle, char *filename ) -> void
 {
-	assert( meshHandle < unityOwnedMeshes.size());
-	assert( unityOwnedMeshes[(size_t) meshHandle] );
-
 	using namespace MeshMod;
-	auto mesh = unityOwnedMeshes[(size_t) meshHandle];
+	auto mesh = unityOwnedMeshes.get(meshHandle);
+	assert(mesh);
 
 	SceneNode::Ptr rootNode = std::make_shared<SceneNode>();
 	rootNode->addObject( mesh );
@@ -326,125 +631,262 @@ CAPI auto CGE_ExportMeshToGLTF( MeshHandle meshHandle, char *filename ) -> void
 
 CAPI auto CGE_MeshToSimpleMesh(MeshHandle meshHandle, SimpleMesh* out) -> bool
 {
-	assert( meshHandle < unityOwnedMeshes.size());
-	assert( unityOwnedMeshes[(size_t) meshHandle] );
-
 	using namespace MeshMod;
-	auto in = unityOwnedMeshes[(size_t) meshHandle];
+	auto in = unityOwnedMeshes.get(meshHandle);
+	assert(in);
 
-	auto const& vertices = in->getVertices();
-	auto const& polygons = in->getPolygons();
-
-	// todo add generic mesh tags to avoid performance sapping re-triangulation
-	MeshOps::BasicMeshOps::triangulate(in);
-
-	auto const& positions = vertices.positions();
+	// polygons are fanned on the way out so the mesh itself doesn't get re-triangulated
+	auto const offsets = TriangleFanOffsets(in->getPolygons());
 	if( out->positionCount == 0 ||
 		out->triangleCount == 0)
 	{
-		out->positionCount = uint32_t(vertices.getCount());
-		out->triangleCount = uint32_t(polygons.getCount());
+		out->positionCount = uint32_t(in->getVertices().getCount());
+		out->triangleCount = offsets.back();
 		return false;
 	}
 	assert(out->positions != nullptr);
 	assert(out->triangleIndices != nullptr);
-	assert(out->positionCount == uint32_t(vertices.getCount()));
-	assert(out->triangleCount == uint32_t(polygons.getCount()));
+	assert(out->positionCount == uint32_t(in->getVertices().getCount()));
+	assert(out->triangleCount == offsets.back());
+
+	WriteSimpleMesh(*in, offsets, *out);
+	return true;
+}
+
+// the whole batch is queued at once, each one gets its callback (on a worker thread) as it finishes
+CAPI auto CGE_CreateConvexHullsAsyncBatch(uint32_t count, MeshHandle const* meshHandles, MeshOps::ConvexHullParameters* params_,
+										  int32_t const* priorities, ConvexHullsReadyCallback callback, void* userData,
+										  ConvexHullGeneratorHandle* out) -> void
+{
+	using namespace MeshMod;
+	MeshOps::ConvexHullParameters const params = CopyParameters(params_);
 
-	float* points = out->positions;
-	for(auto const& pos : positions)
+	for(auto i = 0u; i < count; ++i)
 	{
-		size_t i = size_t(positions.distance(pos)) * 3;
-		points[i + 0] = pos.x;
-		points[i + 1] = pos.y;
-		points[i + 2] = pos.z;
+		auto mesh = unityOwnedMeshes.get(meshHandles[i]);
+		assert(mesh);
+		if(!mesh)
+		{
+			out[i] = MeshInvalidHandle;
+			continue;
+		}
+
+		// the flattened mesh is handed to the job rather than copied again
+		MeshOps::ConvexDecomposer::Request request;
+		MeshOps::ConvexHullComputer::gatherTriangles(*mesh, request.ownedPoints, request.ownedTriangles);
+		request.parameters = params;
+		request.priority = priorities ? priorities[i] : 0;
+		out[i] = SubmitConvexHulls(std::move(request), callback, userData);
 	}
+}
+
+CAPI auto CGE_CreateConvexHullsAsync(MeshHandle meshHandle, MeshOps::ConvexHullParameters* params_)->ConvexHullGeneratorHandle
+{
+	ConvexHullGeneratorHandle handle;
+	CGE_CreateConvexHullsAsyncBatch(1, &meshHandle, params_, nullptr, nullptr, nullptr, &handle);
+	return handle;
+}
+
+CAPI auto CGE_DestroyConvexHullsAsync(ConvexHullGeneratorHandle cvHandle)->void
+{
+	unityOwnedConvexHullComputers.erase(cvHandle);
+}
+
+CAPI auto CGE_ConvexHullAsyncIsReady(ConvexHullGeneratorHandle cvHandle)->bool
+{
+	auto pending = unityOwnedConvexHullComputers.get(cvHandle);
+	assert(pending);
+	if(!pending) return false;
+	std::lock_guard<std::mutex> lock(pending->mutex);
+	return pending->done;
+}
 
-	uint32_t* indices = out->triangleIndices;
-	VertexIndexContainer vertexIndices;
-	for(auto i = 0u; i < polygons.getCount(); ++i)
+CAPI auto CGE_ConvexHullAsyncGetResults(ConvexHullGeneratorHandle cvHandle, MeshHandle* out)->uint32_t
+{
+	auto pending = unityOwnedConvexHullComputers.get(cvHandle);
+	assert(pending);
+	if(!pending) return 0;
+
+	// blocks if called before its ready
+	std::unique_lock<std::mutex> lock(pending->mutex);
+	pending->ready.wait(lock, [&pending]() { return pending->done; });
+	for (auto i = 0u; i < pending->hulls.size(); ++i)
 	{
-		vertexIndices.clear();
-		polygons.getVertexIndices(PolygonIndex(i), vertexIndices );
-		assert(vertexIndices.size()==3);
+		out[i] = TakeOwnershipOfMesh(pending->hulls[i]);
+	}
+
+	return (uint32_t)pending->hulls.size();
+}
+
+// creates a whole mesh from typed strided streams in one go, the vertex streams are copied across threads
+CAPI auto CGE_CreateMeshBulk(MeshBulkDescriptor const* desc_) -> MeshHandle
+{
+	if(desc_ == nullptr) return MeshInvalidHandle;
+	auto mesh = BuildMesh(*desc_);
+	if(!mesh) return MeshInvalidHandle;
+	return unityOwnedMeshes.add(mesh);
+}
 
-		indices[i*3+0] = (uint32_t) vertexIndices[0];
-		indices[i*3+1] = (uint32_t) vertexIndices[2];
-		indices[i*3+2] = (uint32_t) vertexIndices[1];
+CAPI auto CGE_CreateMeshView(SimpleMesh const* simpleMesh) -> MeshViewHandle
+{
+	if(simpleMesh == nullptr) return MeshInvalidHandle;
+	if(!IsValidSimpleMesh(*simpleMesh))
+	{
+		LOG_F(WARNING, "CGE_CreateMeshView has missing positions or out of range indices");
+		return MeshInvalidHandle;
 	}
+	return unityOwnedMeshViews.add(std::make_shared<SimpleMesh const>(*simpleMesh));
+}
+
+CAPI auto CGE_DeleteMeshView(MeshViewHandle viewHandle) -> void
+{
+	unityOwnedMeshViews.erase(viewHandle);
+}
+
+CAPI auto CGE_MeshViewAABB(MeshViewHandle viewHandle, float* out) -> bool
+{
+	auto view = unityOwnedMeshViews.get(viewHandle);
+	assert(view);
+	assert(out != nullptr);
+	if(!view || view->positionCount == 0) return false;
+
+	// each range reduces on its own then they are merged under a lock, there are only a few ranges
+	std::mutex mergeMutex;
+	float minMax[6] = { FLT_MAX, FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	ParallelRanges(view->positionCount, [&view, &mergeMutex, &minMax](uint32_t const begin_, uint32_t const end_)
+	{
+		float local[6] = { FLT_MAX, FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for(auto i = begin_; i < end_; ++i)
+		{
+			float const* pos = view->positions + (size_t(i) * 3);
+			for(auto j = 0u; j < 3; ++j)
+			{
+				local[j] = std::min(local[j], pos[j]);
+				local[j + 3] = std::max(local[j + 3], pos[j]);
+			}
+		}
+		std::lock_guard<std::mutex> lock(mergeMutex);
+		for(auto j = 0u; j < 3; ++j)
+		{
+			minMax[j] = std::min(minMax[j], local[j]);
+			minMax[j + 3] = std::max(minMax[j + 3], local[j + 3]);
+		}
+	});
+	std::memcpy(out, minMax, sizeof(minMax));
 	return true;
 }
 
-CAPI auto CGE_CreateConvexHullsAsync(MeshHandle meshHandle, MeshOps::ConvexHullParameters* params_)->ConvexHullGeneratorHandle
+CAPI auto CGE_GenerateConvexHullsFromView(MeshViewHandle viewHandle, MeshOps::ConvexHullParameters* params_, MeshHandle* out) -> uint32_t
 {
-	auto meshPtr = UnityOwnedMesh(meshHandle);
+	auto view = unityOwnedMeshViews.get(viewHandle);
+	assert(view);
+	if(!view) return 0;
 
 	MeshOps::ConvexHullParameters params;
 	if (params_ != nullptr)
 	{
 		std::memcpy(&params, params_, sizeof(MeshOps::ConvexHullParameters));
 	}
+	// vhacd takes unitys arrays as they are, no mesh in between
+	auto convexHulls = MeshOps::ConvexHullComputer::generate(
+			view->positions, view->positionCount, view->triangleIndices, view->triangleCount, params);
 
-	auto ptr = MeshOps::ConvexHullComputer::createAsync(meshPtr, *params_);
+	for(auto i = 0u; i < convexHulls.size(); ++i)
+	{
+		out[i] = TakeOwnershipOfMesh(convexHulls[i]);
+	}
 
-	size_t index = unityOwnedConvexHullComputers.size();
-	unityOwnedConvexHullComputers.push_back(ptr);
-	return (uint64_t)index;
+	return (uint32_t)convexHulls.size();
 }
 
-CAPI auto CGE_DestroyConvexHullsAsync(ConvexHullGeneratorHandle cvHandle)->void
+CAPI auto CGE_CreateConvexHullsAsyncFromView(MeshViewHandle viewHandle, MeshOps::ConvexHullParameters* params_) -> ConvexHullGeneratorHandle
 {
-	assert(cvHandle < unityOwnedConvexHullComputers.size());
-	assert(unityOwnedConvexHullComputers[(size_t)cvHandle]);
-	unityOwnedConvexHullComputers[(size_t)cvHandle].reset();
-
+	auto view = unityOwnedMeshViews.get(viewHandle);
+	assert(view);
+	if(!view) return MeshInvalidHandle;
+
+	MeshOps::ConvexDecomposer::Request request;
+	request.points = view->positions;
+	request.pointCount = view->positionCount;
+	request.triangles = view->triangleIndices;
+	request.triangleCount = view->triangleCount;
+	request.parameters = CopyParameters(params_);
+	return SubmitConvexHulls(request, nullptr, nullptr);
 }
 
-CAPI auto CGE_ConvexHullAsyncIsReady(ConvexHullGeneratorHandle cvHandle)->bool
+CAPI auto CGE_GetSimpleMeshSize(MeshHandle meshHandle, uint32_t* positionCount, uint32_t* triangleCount) -> bool
 {
-	assert(cvHandle < unityOwnedConvexHullComputers.size());
-	assert(unityOwnedConvexHullComputers[(size_t)cvHandle]);
-	return MeshOps::ConvexHullComputer::isReady(unityOwnedConvexHullComputers[(size_t)cvHandle]);
+	auto mesh = unityOwnedMeshes.get(meshHandle);
+	assert(mesh);
+	if(!mesh) return false;
+
+	if(positionCount) *positionCount = uint32_t(mesh->getVertices().getCount());
+	if(triangleCount) *triangleCount = TriangleFanOffsets(mesh->getPolygons()).back();
+	return true;
 }
 
-CAPI auto CGE_ConvexHullAsyncGetResults(ConvexHullGeneratorHandle cvHandle, MeshHandle* out)->uint32_t
+CAPI auto CGE_WriteSimpleMesh(MeshHandle meshHandle, SimpleMesh* out) -> bool
 {
-	assert(cvHandle < unityOwnedConvexHullComputers.size());
-	assert(unityOwnedConvexHullComputers[(size_t)cvHandle]);
-	auto ptr = unityOwnedConvexHullComputers[(size_t)cvHandle];
-
-	auto convexHulls = MeshOps::ConvexHullComputer::getResults(ptr);
-	for (auto i = 0u; i < convexHulls.size(); ++i)
+	auto mesh = unityOwnedMeshes.get(meshHandle);
+	assert(mesh);
+	assert(out != nullptr);
+	if(!mesh) return false;
+
+	auto const offsets = TriangleFanOffsets(mesh->getPolygons());
+	uint32_t const positionCount = uint32_t(mesh->getVertices().getCount());
+	if(out->positionCount < positionCount || out->triangleCount < offsets.back() ||
+	   (positionCount != 0 && out->positions == nullptr) ||
+	   (offsets.back() != 0 && out->triangleIndices == nullptr))
 	{
-		out[i] = TakeOwnershipOfMesh(convexHulls[i]);
+		LOG_F(WARNING, "CGE_WriteSimpleMesh output is too small for %u positions and %u triangles", positionCount, offsets.back());
+		return false;
 	}
 
-	return (uint32_t)convexHulls.size();
+	WriteSimpleMesh(*mesh, offsets, *out);
+	out->positionCount = positionCount;
+	out->triangleCount = offsets.back();
+	return true;
 }
 
 CAPI static auto DestroyAll() -> void
 {
-	unityOwnedMeshes = {};
-	unityOwnedConvexHullComputers = {};
+	unityOwnedMeshes.clear();
+	unityOwnedConvexHullComputers.clear();
+	unityOwnedMeshViews.clear();
 }
 
 // for other native libraries to consume CGeometryEngine handles
 EXPORT_CPP auto UnityOwnedMesh(MeshHandle meshHandle) -> std::shared_ptr<MeshMod::Mesh>
 {
-	assert( meshHandle < unityOwnedMeshes.size());
-	assert( unityOwnedMeshes[(size_t) meshHandle] );
-	return unityOwnedMeshes[(size_t) meshHandle];
+	auto mesh = unityOwnedMeshes.get(meshHandle);
+	assert(mesh);
+	return mesh;
 }
 
 EXPORT_CPP auto TakeOwnershipOfMesh(std::shared_ptr<MeshMod::Mesh> mesh) -> MeshHandle
 {
-	size_t index = unityOwnedMeshes.size();
-	MeshMod::Mesh::Ptr ptr = unityOwnedMeshes.emplace_back(mesh);
-	return (uint64_t)index;
+	return unityOwnedMeshes.add(mesh);
+}
+
+EXPORT_CPP auto MeshFromView(MeshViewHandle viewHandle) -> std::shared_ptr<MeshMod::Mesh>
+{
+	auto view = unityOwnedMeshViews.get(viewHandle);
+	assert(view);
+	if(!view) return {};
+	// views were checked when they were made
+	return BuildMesh(MESH_TYPE_FULL_MAINTENANCE, "view", *view);
 }
 
 static CGeometryEngineInterface Interface;
 
+#if !defined(USING_STATIC_LIBS)
+// ncoproxy calls this before unloading us, hull jobs still running would call back into freed code
+EXPORT void ModuleUnloading()
+{
+	Decomposer().waitForAll();
+}
+#endif
+
 #if !defined(USING_STATIC_LIBS)
 EXPORT void* GetInterface()
 #else
@@ -473,6 +915,17 @@ CGeometryEngineInterface* CGeometryEngine()
 		Interface.CGE_DestroyConvexHullsAsync = &CGE_DestroyConvexHullsAsync;
 		Interface.CGE_ConvexHullAsyncIsReady = &CGE_ConvexHullAsyncIsReady;
 		Interface.CGE_ConvexHullAsyncGetResults = &CGE_ConvexHullAsyncGetResults;
+		Interface.CGE_CreateConvexHullsAsyncBatch = &CGE_CreateConvexHullsAsyncBatch;
+
+		Interface.CGE_CreateMeshBulk = &CGE_CreateMeshBulk;
+
+		Interface.CGE_CreateMeshView = &CGE_CreateMeshView;
+		Interface.CGE_DeleteMeshView = &CGE_DeleteMeshView;
+		Interface.CGE_MeshViewAABB = &CGE_MeshViewAABB;
+		Interface.CGE_GenerateConvexHullsFromView = &CGE_GenerateConvexHullsFromView;
+		Interface.CGE_CreateConvexHullsAsyncFromView = &CGE_CreateConvexHullsAsyncFromView;
+		Interface.CGE_GetSimpleMeshSize = &CGE_GetSimpleMeshSize;
+		Interface.CGE_WriteSimpleMesh = &CGE_WriteSimpleMesh;
 	}
 	return &Interface;
 }
\ No newline at end of file
@@ -8,6 +8,68 @@
 
 using MeshHandle = uint64_t;
 using ConvexHullGeneratorHandle = uint64_t;
+using MeshViewHandle = uint64_t;
+constexpr uint64_t MeshInvalidHandle = ~0;
+
+// called on a worker thread when an async hull request has its results
+using ConvexHullsReadyCallback = void (*)(ConvexHullGeneratorHandle cvHandle, void* userData);
+
+// bulk mesh creation, the enum values match Unitys VertexAttribute, VertexAttributeFormat and IndexFormat
+// so managed code can pass its own straight through
+enum class MeshStreamSemantic : uint32_t
+{
+	Position = 0,
+	Normal = 1,
+	Tangent = 2,
+	Colour = 3,
+	UV0 = 4,
+	UV1 = 5,
+};
+
+enum class MeshStreamFormat : uint32_t
+{
+	Float32 = 0,
+	Float16 = 1,
+	UNorm8 = 2,
+	SNorm8 = 3,
+	UNorm16 = 4,
+	SNorm16 = 5,
+};
+
+enum class MeshIndexFormat : uint32_t
+{
+	UInt16 = 0,
+	UInt32 = 1,
+};
+
+struct MeshAttributeStream
+{
+	MeshStreamSemantic semantic;
+	MeshStreamFormat format;
+	uint32_t dimension;				// components per vertex, missing ones are 0 (or 1 for alpha)
+	uint32_t stride;				// bytes between vertices, 0 if tightly packed
+	void const* data;				// first vertex, vertexCount of them
+};
+
+struct MeshIndexStream
+{
+	MeshIndexFormat format;
+	uint32_t indicesPerPolygon;		// 3 for triangles or 4 for quads, Unity winding
+	uint32_t polygonCount;
+	uint32_t baseVertex;			// added to every index
+	void const* data;
+};
+
+struct MeshBulkDescriptor
+{
+	int type;						// as CGE_CreateMesh
+	char const* name;
+	uint32_t vertexCount;
+	uint32_t attributeStreamCount;
+	MeshAttributeStream const* attributeStreams;	// must include a position stream
+	uint32_t indexStreamCount;
+	MeshIndexStream const* indexStreams;			// one per submesh
+};
 
 namespace MeshOps
 {
@@ -38,15 +100,40 @@ struct CGeometryEngineInterface
 	CAPI auto (*CGE_DestroyConvexHullsAsync)(ConvexHullGeneratorHandle cvHandle)->void;
 	CAPI auto (*CGE_ConvexHullAsyncIsReady)(ConvexHullGeneratorHandle cvHandle)->bool;
 	CAPI auto (*CGE_ConvexHullAsyncGetResults)(ConvexHullGeneratorHandle cvHandle, MeshHandle* out)->uint32_t;
+	// async requests share a fixed pool of workers, higher priorities start first (priorities and callback can be null).
+	// identical meshes with identical parameters are only decomposed once
+	CAPI auto (*CGE_CreateConvexHullsAsyncBatch)(uint32_t count, MeshHandle const* meshHandles, MeshOps::ConvexHullParameters* params_,
+			int32_t const* priorities, ConvexHullsReadyCallback callback, void* userData, ConvexHullGeneratorHandle* out) -> void;
+
+	// creates a complete mesh in one call, safe from any thread. returns MeshInvalidHandle if the descriptor is bad
+	CAPI auto (*CGE_CreateMeshBulk)(MeshBulkDescriptor const* desc) -> MeshHandle;
+
+	// views wrap a caller owned SimpleMesh without copying, for ops that don't change it.
+	// the arrays must stay pinned until CGE_DeleteMeshView. returns MeshInvalidHandle if the indices are bad
+	CAPI auto (*CGE_CreateMeshView)(SimpleMesh const* simpleMesh) -> MeshViewHandle;
+	CAPI auto (*CGE_DeleteMeshView)(MeshViewHandle viewHandle) -> void;
+	// min xyz then max xyz into out, false for an empty or invalid view
+	CAPI auto (*CGE_MeshViewAABB)(MeshViewHandle viewHandle, float* out) -> bool;
+	CAPI auto (*CGE_GenerateConvexHullsFromView)(MeshViewHandle viewHandle, MeshOps::ConvexHullParameters* params_, MeshHandle* out) -> uint32_t;
+	// the view can be unpinned as soon as this returns
+	CAPI auto (*CGE_CreateConvexHullsAsyncFromView)(MeshViewHandle viewHandle, MeshOps::ConvexHullParameters* params_) -> ConvexHullGeneratorHandle;
+
+	// size query then a write straight into caller memory (e.g. NativeArrays), the mesh itself isn't changed.
+	// polygons are fanned into triangles. out's counts are the capacities going in and what was written coming out
+	CAPI auto (*CGE_GetSimpleMeshSize)(MeshHandle meshHandle, uint32_t* positionCount, uint32_t* triangleCount) -> bool;
+	CAPI auto (*CGE_WriteSimpleMesh)(MeshHandle meshHandle, SimpleMesh* out) -> bool;
 
 };
 
 EXPORT_CPP std::shared_ptr<MeshMod::Mesh> UnityOwnedMesh(MeshHandle meshHandle);
 EXPORT_CPP MeshHandle TakeOwnershipOfMesh(std::shared_ptr<MeshMod::Mesh> mesh);
+// builds a mesh from a views arrays, for consumers that need to keep or change their own copy
+EXPORT_CPP std::shared_ptr<MeshMod::Mesh> MeshFromView(MeshViewHandle viewHandle);
 
 
 #if !defined(USING_STATIC_LIBS)
 EXPORT void* GetInterface();
+EXPORT void ModuleUnloading();
 #else
 CGeometryEngineInterface* CGeometryEngine();
 #endif
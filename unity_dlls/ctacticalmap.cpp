@@ -16,10 +16,11 @@
 #include "meshops/platonicsolids.h"
 #include "meshops/gltf.h"
 #include "meshops/shapes.h"
-#include "enkiTS/src/TaskScheduler.h"
+#include "core/sharedtasks.h"
 #include <limits>
 #include <fstream>
-#include "core/freelist.h"
+#include <mutex>
+#include "core/handletable.h"
 #include "core/blob.h"
 
 enki::TaskScheduler g_EnkiTS;
@@ -27,20 +28,30 @@ enki::TaskScheduler g_EnkiTS;
 
 #include "ctacticalmap.h"
 
-static Core::FreeList<std::shared_ptr<TacticalMap>, uint32_t> unityOwnedTacticalMap;
-static Core::FreeList<ITacticalMapBuilder::Ptr, uint32_t> unityOwnedTacticalMapBuilders;
-static Core::FreeList<ITacticalMapStitcher::Ptr, uint32_t> unityOwnedTacticalMapStitchers;
+// handles are generational and lock free so unity job threads can create and delete, stale handles look up null
+// and every entry point returns early on them
+static Core::HandleTable<TacticalMap> unityOwnedTacticalMap;
+static Core::HandleTable<ITacticalMapBuilder> unityOwnedTacticalMapBuilders;
+static Core::HandleTable<ITacticalMapStitcher> unityOwnedTacticalMapStitchers;
+static Core::HandleTable<ITacticalMapPathfinder> unityOwnedTacticalMapPathfinders;
+// damage publishes new versions of a map, one writer at a time
+static std::mutex tacticalMapDamageMutex;
+
+// lookups on other threads get whichever version of the map is current and keep it consistent while held
+static auto AcquireTacticalMap(TacticalMapHandle handle) -> std::shared_ptr<TacticalMap>
+{
+	return unityOwnedTacticalMap.get(handle);
+}
 
 CAPI auto CTM_Load(char const* fileName) -> TacticalMapHandle
 {
 	std::vector<std::shared_ptr<TacticalMap>> tactMaps;
-	std::ifstream in(fileName, std::ifstream::in | std::ifstream::binary);
-	TacticalMap::createFromStream(in, tactMaps);
+	TacticalMap::createFromFile(fileName, tactMaps);
 
 	if(tactMaps.empty()) return TacticalMapInvalidHandle;
 
 	// only handle the first tmap in a bundle currently
-	TacticalMapHandle handle = unityOwnedTacticalMap.push(tactMaps[0]);
+	TacticalMapHandle handle = unityOwnedTacticalMap.add(tactMaps[0]);
 
 	return handle;
 }
@@ -50,18 +61,40 @@ CAPI auto CTM_LoadFromBlob(Core::Blob* blob) -> TacticalMapHandle
 	if(blob->size == 0) return TacticalMapInvalidHandle;
 	if(blob->nativeData == nullptr) return TacticalMapInvalidHandle;
 
-	std::string str;
-	str.resize(blob->size);
-	std::memcpy(str.data(), blob->nativeData, blob->size);
-	std::istringstream stream(str);
+	// the blob stays with the caller so the map gets one copy, the load fixes that up in place
+	std::shared_ptr<void> copy(malloc(blob->size), &free);
+	if(!copy) return TacticalMapInvalidHandle;
+	std::memcpy(copy.get(), blob->nativeData, blob->size);
+
+	std::vector<std::shared_ptr<TacticalMap>> tactMaps;
+	bool okay = TacticalMap::createFromMemory(copy, (uint8_t*) copy.get(), blob->size, tactMaps);
+
+	if(!okay || tactMaps.empty()) return TacticalMapInvalidHandle;
+
+	// only handle the first tmap in a bundle currently
+	TacticalMapHandle handle = unityOwnedTacticalMap.add(tactMaps[0]);
+
+	return handle;
+}
+CAPI auto CTM_LoadFromBlobInPlace(Core::Blob* blob) -> TacticalMapHandle
+{
+	if(blob == nullptr) return TacticalMapInvalidHandle;
+	if(blob->size == 0) return TacticalMapInvalidHandle;
+	if(blob->nativeData == nullptr) return TacticalMapInvalidHandle;
+
+	// the map takes the blobs memory, the blob is emptied whether or not the load works
+	std::shared_ptr<void> owner(blob->nativeData, &free);
+	uint64_t const size = blob->size;
+	blob->nativeData = nullptr;
+	blob->size = 0;
 
 	std::vector<std::shared_ptr<TacticalMap>> tactMaps;
-	bool okay = TacticalMap::createFromStream(stream, tactMaps);
+	bool okay = TacticalMap::createFromMemory(owner, (uint8_t*) owner.get(), size, tactMaps);
 
 	if(!okay || tactMaps.empty()) return TacticalMapInvalidHandle;
 
 	// only handle the first tmap in a bundle currently
-	TacticalMapHandle handle = unityOwnedTacticalMap.push(tactMaps[0]);
+	TacticalMapHandle handle = unityOwnedTacticalMap.add(tactMaps[0]);
 
 	return handle;
 }
@@ -69,16 +102,17 @@ CAPI auto CTM_LoadFromBlob(Core::Blob* blob) -> TacticalMapHandle
 CAPI auto CTM_Delete(TacticalMapHandle ctmHandle) -> void
 {
 	if (ctmHandle == ~0) return;
-	unityOwnedTacticalMap.at((uint32_t)ctmHandle).reset();
+	unityOwnedTacticalMap.erase(ctmHandle);
 }
 CAPI auto CTM_Save(TacticalMapHandle ctmHandle, uint64_t userData, char const* fileName) -> bool
 {
 	if (ctmHandle == ~0) return false;
-	auto tm = unityOwnedTacticalMap.at((uint32_t)ctmHandle);
+	auto tm = AcquireTacticalMap(ctmHandle);
+	if(!tm) return false;
 
-	// write it out to a memory block
+	// write it out to a memory block, uncompressed so it loads in place
 	std::vector<uint8_t> rawBundle;
-	bool okay = tm->saveTo(userData, rawBundle);
+	bool okay = tm->saveTo(userData, rawBundle, false);
 	if(!okay) return false;
 
 	std::ofstream out(fileName, std::ofstream::out | std::ofstream::binary);
@@ -91,11 +125,12 @@ CAPI auto CTM_Save(TacticalMapHandle ctmHandle, uint64_t userData, char const* f
 CAPI auto CTM_SaveToBlob(TacticalMapHandle ctmHandle, uint64_t userData, Core::Blob* out) -> bool
 {
 	if (ctmHandle == ~0) return false;
-	auto tm = unityOwnedTacticalMap.at((uint32_t)ctmHandle);
+	auto tm = AcquireTacticalMap(ctmHandle);
+	if(!tm) return false;
 
-	// write it out to a memory block
+	// write it out to a memory block, uncompressed so it loads in place
 	std::vector<uint8_t> rawBundle;
-	bool okay = tm->saveTo(userData, rawBundle);
+	bool okay = tm->saveTo(userData, rawBundle, false);
 	if(!okay) return false;
 	okay = Core::Blob::Create(rawBundle.size(), out);
 	if(!okay) return false;
@@ -109,27 +144,165 @@ CAPI auto CTM_SaveToBlob(TacticalMapHandle ctmHandle, uint64_t userData, Core::B
 CAPI auto CTM_LookupVolumeAtWorld(TacticalMapHandle ctmHandle, float const* point, float const range, uint32_t const levelMask, TacticalMapVolume* out) -> bool
 {
 	if (ctmHandle == ~0) return false;
-	auto tm = unityOwnedTacticalMap.at((uint32_t)ctmHandle);
+	auto tm = AcquireTacticalMap(ctmHandle);
+	if(!tm) return false;
 	return tm->lookupVolumeAtWorld(Math::Vec3FromArray(point), range, levelMask, out);
 }
 
 CAPI auto CTM_LookupLevelDataAtWorld(TacticalMapHandle ctmHandle, float const* point, float const range, uint32_t const levelMask, TacticalMapLevelDataHeader* out) -> bool
 {
 	if (ctmHandle == ~0) return false;
-	auto tm = unityOwnedTacticalMap.at((uint32_t)ctmHandle);
+	auto tm = AcquireTacticalMap(ctmHandle);
+	if(!tm) return false;
 	return tm->lookupLevelDataAtWorld(Math::Vec3FromArray(point), range, levelMask, out);
 }
 
-CAPI auto CTM_DamageStructure(TacticalMapHandle ctmHandle, float const* center, float const* extent) -> void
+CAPI auto CTM_LookupVolumeAtWorldBatch(TacticalMapHandle ctmHandle, float const* points, uint32_t const count, float const range, uint32_t const levelMask, TacticalMapVolume* out) -> uint32_t
+{
+	static_assert(sizeof(Math::vec3) == sizeof(float) * 3);
+	if (ctmHandle == TacticalMapInvalidHandle) return 0;
+	auto tm = AcquireTacticalMap(ctmHandle);
+	if(!tm) return 0;
+	return (uint32_t) tm->lookupVolumeAtWorldBatch((Math::vec3 const*) points, count, range, levelMask, out);
+}
+
+CAPI auto CTM_LookupLevelDataAtWorldBatch(TacticalMapHandle ctmHandle, float const* points, uint32_t const count, float const range, uint32_t const levelMask, uint8_t* out) -> uint32_t
+{
+	static_assert(sizeof(Math::vec3) == sizeof(float) * 3);
+	if (ctmHandle == TacticalMapInvalidHandle) return 0;
+	auto tm = AcquireTacticalMap(ctmHandle);
+	if(!tm) return 0;
+	return (uint32_t) tm->lookupLevelDataAtWorldBatch((Math::vec3 const*) points, count, range, levelMask, out);
+}
+
+CAPI auto CTM_TraceLineOfSight(TacticalMapHandle ctmHandle, float const* from, float const* to, uint32_t const levelMask) -> bool
+{
+	if (ctmHandle == TacticalMapInvalidHandle) return false;
+	auto tm = AcquireTacticalMap(ctmHandle);
+	if(!tm) return false;
+	return tm->traceLineOfSight(Math::Vec3FromArray(from), Math::Vec3FromArray(to), levelMask);
+}
+
+CAPI auto CTM_TraceLineOfSightBatch(TacticalMapHandle ctmHandle, float const* queries, uint32_t const count, uint32_t const levelMask, uint8_t* out) -> uint32_t
+{
+	static_assert(sizeof(TacticalMapSightQuery) == sizeof(float) * 6);
+	if (ctmHandle == TacticalMapInvalidHandle) return 0;
+	auto tm = AcquireTacticalMap(ctmHandle);
+	if(!tm) return 0;
+	return (uint32_t) tm->traceLineOfSightBatch((TacticalMapSightQuery const*) queries, count, levelMask, out);
+}
+
+CAPI auto CTM_QueryCoverBatch(TacticalMapHandle ctmHandle, float const* queries, uint32_t const count, float const agentHeight, uint32_t const levelMask, float* out) -> uint32_t
+{
+	static_assert(sizeof(TacticalMapSightQuery) == sizeof(float) * 6);
+	if (ctmHandle == TacticalMapInvalidHandle) return 0;
+	auto tm = AcquireTacticalMap(ctmHandle);
+	if(!tm) return 0;
+	return (uint32_t) tm->queryCoverBatch((TacticalMapSightQuery const*) queries, count, agentHeight, levelMask, out);
+}
+
+CAPI auto CTM_SummariseArea(TacticalMapHandle ctmHandle, float const* min, float const* max, TacticalMapAreaSummary* out) -> void
+{
+	static_assert(sizeof(TacticalMapAreaSummary) == 24);
+	if (ctmHandle == TacticalMapInvalidHandle) return;
+	auto tm = AcquireTacticalMap(ctmHandle);
+	if(!tm) return;
+	*out = tm->summariseArea(Geometry::AABB(Math::Vec3FromArray(min), Math::Vec3FromArray(max)));
+}
+
+CAPI auto CTM_AnyLevelInArea(TacticalMapHandle ctmHandle, float const* min, float const* max, uint32_t const levelMask) -> bool
+{
+	if (ctmHandle == TacticalMapInvalidHandle) return false;
+	auto tm = AcquireTacticalMap(ctmHandle);
+	if(!tm) return false;
+	return tm->anyLevelInArea(Geometry::AABB(Math::Vec3FromArray(min), Math::Vec3FromArray(max)), levelMask);
+}
+
+CAPI auto CTM_DamageStructures(TacticalMapHandle ctmHandle, float const* centers, float const* extents, uint32_t count) -> void
 {
 	if (ctmHandle == ~0) return;
-	auto tm = unityOwnedTacticalMap.at((uint32_t)ctmHandle);
+	if (count == 0) return;
 
-	Math::vec3 vCenter = Math::Vec3FromArray(center);
-	Math::vec3 vHalfLength = Math::Vec3FromArray(extent);
-	vHalfLength *= 0.5f;
-	Geometry::AABB box = Geometry::AABB::fromCenterAndHalfLength(vCenter, vHalfLength);
-	tm->damageStructure(box);
+	std::vector<Geometry::AABB> boxes(count);
+	for(auto i = 0u; i < count; ++i)
+	{
+		Math::vec3 vCenter = Math::Vec3FromArray(centers + (i * 3));
+		Math::vec3 vHalfLength = Math::Vec3FromArray(extents + (i * 3));
+		vHalfLength *= 0.5f;
+		boxes[i] = Geometry::AABB::fromCenterAndHalfLength(vCenter, vHalfLength);
+	}
+
+	// the damage is applied to a new version, lookups carry on with the old one until its published
+	std::lock_guard lock(tacticalMapDamageMutex);
+	auto tm = AcquireTacticalMap(ctmHandle);
+	if(!tm) return;
+	auto damaged = TacticalMap::damageStructures(tm, boxes.data(), boxes.size());
+	unityOwnedTacticalMap.replace(ctmHandle, damaged);
+}
+
+CAPI auto CTM_DamageStructure(TacticalMapHandle ctmHandle, float const* center, float const* extent) -> void
+{
+	CTM_DamageStructures(ctmHandle, center, extent, 1);
+}
+
+//------------------------------------------------------//
+
+CAPI auto CTMP_CreatePathfinder(TacticalMapHandle ctmHandle, TacticalMapPathSettings const* settings) -> TacticalMapPathfinderHandle
+{
+	if (ctmHandle == TacticalMapInvalidHandle) return TacticalMapInvalidHandle;
+#if !defined(USING_STATIC_LIBS)
+	Core::InitSharedTasks();
+#endif
+
+	auto tm = AcquireTacticalMap(ctmHandle);
+	if(!tm) return TacticalMapInvalidHandle;
+	auto pathfinder = TacticalMap::allocatePathfinder(tm, settings ? *settings : TacticalMapPathSettings());
+	return unityOwnedTacticalMapPathfinders.add(pathfinder);
+}
+
+CAPI auto CTMP_UpdateMap(TacticalMapPathfinderHandle ctmpHandle, TacticalMapHandle ctmHandle) -> uint32_t
+{
+	if (ctmpHandle == TacticalMapInvalidHandle || ctmHandle == TacticalMapInvalidHandle) return 0;
+
+	auto const tmp = unityOwnedTacticalMapPathfinders.get(ctmpHandle);
+	if(!tmp) return 0;
+	auto const tm = AcquireTacticalMap(ctmHandle);
+	if(!tm) return 0;
+	return tmp->updateMap(tm);
+}
+
+CAPI auto CTMP_FindPaths(TacticalMapPathfinderHandle ctmpHandle, float const* queries, uint32_t count, uint32_t maxPoints, float* points, uint32_t* pointCounts, float* costs) -> uint32_t
+{
+	if (ctmpHandle == TacticalMapInvalidHandle) return 0;
+	auto const tmp = unityOwnedTacticalMapPathfinders.get(ctmpHandle);
+	if(!tmp) return 0;
+
+	std::vector<TacticalMapPathQuery> pathQueries(count);
+	for(auto i = 0u; i < count; ++i)
+	{
+		pathQueries[i].start = Math::Vec3FromArray(queries + (i * 6));
+		pathQueries[i].goal = Math::Vec3FromArray(queries + (i * 6) + 3);
+	}
+	std::vector<TacticalMapPath> paths(count);
+	tmp->findPathsAsync(pathQueries.data(), count, paths.data())->wait();
+
+	uint32_t found = 0;
+	for(auto i = 0u; i < count; ++i)
+	{
+		TacticalMapPath const& path = paths[i];
+		uint32_t const pointCount = (uint32_t) std::min<size_t>(path.points.size(), maxPoints);
+		std::memcpy(points + (i * maxPoints * 3), path.points.data(), pointCount * sizeof(Math::vec3));
+		pointCounts[i] = pointCount;
+		costs[i] = path.cost;
+		if(path.found) found++;
+	}
+	return found;
+}
+
+CAPI auto CTMP_Delete(TacticalMapPathfinderHandle ctmpHandle) -> void
+{
+	if (ctmpHandle == TacticalMapInvalidHandle) return;
+	unityOwnedTacticalMapPathfinders.erase(ctmpHandle);
 }
 
 //------------------------------------------------------//
@@ -144,34 +317,34 @@ CAPI auto CTMB_CreateBuilder(float* bounds2D, char const* name) -> TacticalMapBu
 	if (width <= 0 || height <= 0) return ~0;
 
 #if !defined(USING_STATIC_LIBS)
-	g_EnkiTS.Initialize();
+	Core::InitSharedTasks();
 #endif
 
 	Math::vec2 bounds(bounds2D[0], bounds2D[1]);
 
 	std::shared_ptr<ITacticalMapBuilder> builder = TacticalMap::allocateBuilder(bounds, width, height, name);
 
-	return unityOwnedTacticalMapBuilders.push(builder);
+	return unityOwnedTacticalMapBuilders.add(builder);
 }
 
 CAPI auto CTMB_Delete(TacticalMapBuilderHandle tmHandle) -> void
 {
 	if (tmHandle == ~0) return;
-	unityOwnedTacticalMapBuilders.at((uint32_t)tmHandle).reset();
+	unityOwnedTacticalMapBuilders.erase(tmHandle);
 }
 CAPI auto CTMB_SetMinimumHeight(TacticalMapBuilderHandle handle_, float const minHeight_) -> void
 {
 	if (handle_ == ~0) return;
-	assert(unityOwnedTacticalMapBuilders.at((uint32_t)handle_));
-	auto const ibuilder = unityOwnedTacticalMapBuilders[(uint32_t)handle_];
+	auto const ibuilder = unityOwnedTacticalMapBuilders.get(handle_);
+	if(!ibuilder) return;
 	ibuilder->setMinimumHeight(minHeight_);
 }
 
 CAPI auto CTMB_SetOpaqueLevelDataSize(TacticalMapBuilderHandle handle_, uint32_t const size_) -> void
 {
 	if (handle_ == ~0) return;
-	assert(unityOwnedTacticalMapBuilders.at((uint32_t)handle_));
-	auto const ibuilder = unityOwnedTacticalMapBuilders[(uint32_t)handle_];
+	auto const ibuilder = unityOwnedTacticalMapBuilders.get(handle_);
+	if(!ibuilder) return;
 	ibuilder->setLevelDataSize(size_);
 }
 
@@ -185,8 +358,8 @@ CAPI auto CTMB_ExportToGLTF(TacticalMapBuilderHandle tmHandle, char const* fileN
 {
 	using namespace MeshMod;
 
-	assert(unityOwnedTacticalMapBuilders.at((uint32_t)tmHandle) );
-	auto const ibuilder = unityOwnedTacticalMapBuilders[(uint32_t)tmHandle];
+	auto const ibuilder = unityOwnedTacticalMapBuilders.get(tmHandle);
+	if(!ibuilder) return nullptr;
 	auto const builder = std::dynamic_pointer_cast<TacticalMapBuilder>(ibuilder);
 	assert(builder);
 
@@ -205,12 +378,12 @@ CAPI auto CTMB_ExportToGLTF(TacticalMapBuilderHandle tmHandle, char const* fileN
 		for (auto x = 0; x < builder->getWidth(); ++x)
 		{
 			auto const& tileBuilder = builder->tileBuilders[y * builder->getWidth() + x];
-			for (auto const& [solidIndex, polygonIndex]: tileBuilder.polygons)
+			builder->visitTileTriangles(tileBuilder, [&](size_t solidIndex, PolygonIndex polygonIndex)
 			{
 				auto& [mesh, box, levelData] = builder->solids[solidIndex];
 
-				meshPolygons[mesh.get()].insert(polygonIndex.cbegin(), polygonIndex.cend());
-			}
+				meshPolygons[mesh.get()].insert(polygonIndex);
+			});
 			// expensive compares!
 			for (auto const& [solidIndex, box] : tileBuilder.boxes)
 			{
@@ -284,61 +457,97 @@ CAPI auto CTMB_ExportToGLTF(TacticalMapBuilderHandle tmHandle, char const* fileN
 CAPI auto CTMB_Build(TacticalMapBuilderHandle tmbHandle) -> TacticalMapHandle
 {
 	if (tmbHandle == ~0) return ~0;
-	assert(unityOwnedTacticalMapBuilders.at((uint32_t)tmbHandle));
 
-	auto const tmb = unityOwnedTacticalMapBuilders[(uint32_t)tmbHandle];
+	auto const tmb = unityOwnedTacticalMapBuilders.get(tmbHandle);
+	if(!tmb) return TacticalMapInvalidHandle;
+	// every build is a new map so gets its own handle, earlier ones stay valid until destroyed
 	auto tm = tmb->build();
 	if(!tm) return TacticalMapInvalidHandle;
 
-	return unityOwnedTacticalMap.push(tm);
+	return unityOwnedTacticalMap.add(tm);
 }
 
-CAPI auto CTMB_AddMeshAt(TacticalMapBuilderHandle handle, TacticalMapHandle meshHandle, TacticalMapLevelDataHeader const* levelData, float const* matrix) -> void
+CAPI auto CTMB_AddMeshAt(TacticalMapBuilderHandle handle, TacticalMapHandle meshHandle, TacticalMapLevelDataHeader const* levelData, float const* matrix) -> uint32_t
 {
-	if (handle == ~0) return;
+	if (handle == TacticalMapInvalidHandle) return ~0u;
 
-	assert(unityOwnedTacticalMapBuilders.at((uint32_t)handle));
 	assert(levelData);
-	auto const tmb = unityOwnedTacticalMapBuilders[(uint32_t)handle];
+	auto const tmb = unityOwnedTacticalMapBuilders.get(handle);
+	if(!tmb) return ~0u;
 	std::shared_ptr<MeshMod::Mesh> mesh(UnityOwnedMesh(meshHandle));
 
 	Math::mat4x4 transform = Math::Mat4x4FromArray(matrix);
-	tmb->addMeshAt(mesh, levelData, transform);
+	return tmb->addMeshAt(mesh, levelData, transform);
+}
+
+// solids keep their own mesh to transform, so the view is built into one natively rather than via a unity mesh
+CAPI auto CTMB_AddMeshViewAt(TacticalMapBuilderHandle handle, MeshViewHandle viewHandle, TacticalMapLevelDataHeader const* levelData, float const* matrix) -> uint32_t
+{
+	if (handle == TacticalMapInvalidHandle) return ~0u;
+
+	assert(levelData);
+	auto const tmb = unityOwnedTacticalMapBuilders.get(handle);
+	if(!tmb) return ~0u;
+	auto mesh = MeshFromView(viewHandle);
+	if(!mesh) return ~0u;
+
+	Math::mat4x4 transform = Math::Mat4x4FromArray(matrix);
+	return tmb->addMeshAt(mesh, levelData, transform);
 }
 
-CAPI auto CTMB_AddBoxAt(TacticalMapBuilderHandle handle, TacticalMapLevelDataHeader const* levelData, float const* center, float const* extent, float const* matrix) -> void
+CAPI auto CTMB_AddBoxAt(TacticalMapBuilderHandle handle, TacticalMapLevelDataHeader const* levelData, float const* center, float const* extent, float const* matrix) -> uint32_t
 {
-	if (handle == ~0) return;
+	if (handle == TacticalMapInvalidHandle) return ~0u;
 
-	assert(unityOwnedTacticalMapBuilders.at((uint32_t)handle) );
 	assert(levelData);
 
-	auto const tmb = unityOwnedTacticalMapBuilders[(uint32_t)handle];
+	auto const tmb = unityOwnedTacticalMapBuilders.get(handle);
+	if(!tmb) return ~0u;
 
 	Math::vec3 vCenter = Math::Vec3FromArray(center);
 	Math::vec3 vHalfLength= Math::Vec3FromArray(extent);
 	vHalfLength *= 0.5f;
 	Geometry::AABB box = Geometry::AABB::fromCenterAndHalfLength(vCenter, vHalfLength);
 	Math::mat4x4 transform = Math::Mat4x4FromArray(matrix);
-	tmb->addBoxAt(box, levelData, transform);
+	return tmb->addBoxAt(box, levelData, transform);
+}
+
+CAPI auto CTMB_RemoveSolid(TacticalMapBuilderHandle handle, uint32_t solidId) -> void
+{
+	if (handle == TacticalMapInvalidHandle) return;
+
+	auto const tmb = unityOwnedTacticalMapBuilders.get(handle);
+	if(!tmb) return;
+	tmb->removeSolid(solidId);
+}
+
+CAPI auto CTMB_UpdateSolidTransform(TacticalMapBuilderHandle handle, uint32_t solidId, float const* matrix) -> void
+{
+	if (handle == TacticalMapInvalidHandle) return;
+
+	auto const tmb = unityOwnedTacticalMapBuilders.get(handle);
+	if(!tmb) return;
+	Math::mat4x4 transform = Math::Mat4x4FromArray(matrix);
+	tmb->updateSolidTransform(solidId, transform);
 }
 
 CAPI auto CTMS_CreateStitcher(char const* name_) -> TacticalMapStitcherHandle
 {
 #if !defined(USING_STATIC_LIBS)
-	g_EnkiTS.Initialize();
+	Core::InitSharedTasks();
 #endif
 
 	auto builder = TacticalMap::allocateStitcher(name_);
-	return unityOwnedTacticalMapStitchers.push(builder);
+	return unityOwnedTacticalMapStitchers.add(builder);
 }
 
 CAPI auto CTMS_AddParcelInstances(TacticalMapStitcherHandle ctmsHandle, TacticalMapHandle tmHandle, ParcelInstances* instances) -> void
 {
 	if (ctmsHandle == ~0) return;
-	assert(unityOwnedTacticalMapStitchers[(uint32_t)ctmsHandle] );
-	auto const tms = unityOwnedTacticalMapStitchers.at((uint32_t)ctmsHandle);
-	auto const map = unityOwnedTacticalMap.at((uint32_t)tmHandle);
+	auto const tms = unityOwnedTacticalMapStitchers.get(ctmsHandle);
+	if(!tms) return;
+	auto const map = AcquireTacticalMap(tmHandle);
+	if(!map) return;
 
 	for(auto index = 0u; index < instances->count; ++index)
 	{
@@ -352,46 +561,47 @@ CAPI auto CTMS_AddParcelInstances(TacticalMapStitcherHandle ctmsHandle, Tactical
 CAPI auto CTMS_Stitch(TacticalMapStitcherHandle ctmsHandle) -> TacticalMapHandle
 {
 	if (ctmsHandle == ~0) return ~0;
-	assert( ctmsHandle < unityOwnedTacticalMapStitchers.size());
-	assert(unityOwnedTacticalMapStitchers[(uint32_t) ctmsHandle] );
-
-	auto const tms = unityOwnedTacticalMapStitchers[(uint32_t)ctmsHandle];
+	auto const tms = unityOwnedTacticalMapStitchers.get(ctmsHandle);
+	if(!tms) return TacticalMapInvalidHandle;
 	std::shared_ptr<TacticalMap> tm = tms->build();
 	if(!tm) return TacticalMapInvalidHandle;
 
-	return unityOwnedTacticalMap.push(tm);
+	return unityOwnedTacticalMap.add(tm);
 }
 
 CAPI auto CTMS_Delete(TacticalMapStitcherHandle ctmsHandle) -> void
 {
 	if (ctmsHandle == ~0) return;
-	assert(ctmsHandle < unityOwnedTacticalMapStitchers.size());
-	unityOwnedTacticalMapStitchers[(uint32_t)ctmsHandle].reset();
+	unityOwnedTacticalMapStitchers.erase(ctmsHandle);
 }
 
 CAPI static auto DestroyAll() -> void
 {
-	unityOwnedTacticalMap = {};
-	unityOwnedTacticalMapBuilders = {};
-	unityOwnedTacticalMapStitchers = {};
+	unityOwnedTacticalMap.clear();
+	unityOwnedTacticalMapBuilders.clear();
+	unityOwnedTacticalMapStitchers.clear();
+	unityOwnedTacticalMapPathfinders.clear();
 }
 
 EXPORT_CPP auto UnityOwnedTacticalMap(TacticalMapHandle tmHandle) -> std::shared_ptr<TacticalMap>
 {
-	assert(unityOwnedTacticalMap[(uint32_t)tmHandle]);
-	return unityOwnedTacticalMap.at((uint32_t)tmHandle);
+	auto tm = AcquireTacticalMap(tmHandle);
+	assert(tm);
+	return tm;
 }
 
 EXPORT_CPP auto UnityOwnedTacticalMapBuilder(TacticalMapBuilderHandle handle) -> std::shared_ptr<ITacticalMapBuilder> 
 {
-	assert(unityOwnedTacticalMapBuilders[(uint32_t)handle]);
-	return unityOwnedTacticalMapBuilders.at((uint32_t)handle);
+	auto builder = unityOwnedTacticalMapBuilders.get(handle);
+	assert(builder);
+	return builder;
 }
 
 EXPORT_CPP auto UnityOwnedTacticalMapStitcher(TacticalMapStitcherHandle handle) -> std::shared_ptr<ITacticalMapStitcher>
 {
-	assert(unityOwnedTacticalMapStitchers[(uint32_t)handle]);
-	return unityOwnedTacticalMapStitchers.at((uint32_t)handle);
+	auto stitcher = unityOwnedTacticalMapStitchers.get(handle);
+	assert(stitcher);
+	return stitcher;
 }
 
 static CTacticalMapInterface Interface;
@@ -427,6 +637,22 @@ CTacticalMapInterface* CTacticalMap()
 		Interface.CTMB_DebugExportToGLTF = &CTMB_DebugExportToGLTF;
 		Interface.CTMB_Build = &CTMB_Build;
 		Interface.CTMB_Delete = &CTMB_Delete;
+		Interface.CTMB_RemoveSolid = &CTMB_RemoveSolid;
+		Interface.CTMB_UpdateSolidTransform = &CTMB_UpdateSolidTransform;
+		Interface.CTM_LookupVolumeAtWorldBatch = &CTM_LookupVolumeAtWorldBatch;
+		Interface.CTM_LookupLevelDataAtWorldBatch = &CTM_LookupLevelDataAtWorldBatch;
+		Interface.CTM_LoadFromBlobInPlace = &CTM_LoadFromBlobInPlace;
+		Interface.CTM_DamageStructures = &CTM_DamageStructures;
+		Interface.CTMP_CreatePathfinder = &CTMP_CreatePathfinder;
+		Interface.CTMP_UpdateMap = &CTMP_UpdateMap;
+		Interface.CTMP_FindPaths = &CTMP_FindPaths;
+		Interface.CTMP_Delete = &CTMP_Delete;
+		Interface.CTM_TraceLineOfSight = &CTM_TraceLineOfSight;
+		Interface.CTM_TraceLineOfSightBatch = &CTM_TraceLineOfSightBatch;
+		Interface.CTM_QueryCoverBatch = &CTM_QueryCoverBatch;
+		Interface.CTM_SummariseArea = &CTM_SummariseArea;
+		Interface.CTM_AnyLevelInArea = &CTM_AnyLevelInArea;
+		Interface.CTMB_AddMeshViewAt = &CTMB_AddMeshViewAt;
 	}
 	return &Interface;
 }
\ No newline at end of file
@@ -15,6 +15,7 @@ namespace Core { struct Blob; }
 using TacticalMapHandle = uint64_t;
 using TacticalMapBuilderHandle = uint64_t;
 using TacticalMapStitcherHandle = uint64_t;
+using TacticalMapPathfinderHandle = uint64_t;
 constexpr uint64_t TacticalMapInvalidHandle = ~0;
 
 // stitcher API
@@ -48,11 +49,53 @@ struct CTacticalMapInterface
 	CAPI auto (*CTMB_CreateBuilder)(float* bounds2D, char const* name)->TacticalMapBuilderHandle;
 	CAPI auto (*CTMB_SetMinimumHeight)(TacticalMapBuilderHandle handle_, float const minHeight_) -> void;
 	CAPI auto (*CTMB_SetOpaqueLevelDataSize)(TacticalMapBuilderHandle handle_, uint32_t const size_) -> void;
-	CAPI auto (*CTMB_AddMeshAt)(TacticalMapBuilderHandle handle, TacticalMapHandle meshHandle, TacticalMapLevelDataHeader const* opaqueData, float const* matrix) -> void;
-	CAPI auto (*CTMB_AddBoxAt)(TacticalMapBuilderHandle handle, TacticalMapLevelDataHeader const* opaqueData, float const* center, float const* extent, float const* matrix) -> void;
+	// adds return a solid id for CTMB_RemoveSolid and CTMB_UpdateSolidTransform
+	CAPI auto (*CTMB_AddMeshAt)(TacticalMapBuilderHandle handle, TacticalMapHandle meshHandle, TacticalMapLevelDataHeader const* opaqueData, float const* matrix) -> uint32_t;
+	CAPI auto (*CTMB_AddBoxAt)(TacticalMapBuilderHandle handle, TacticalMapLevelDataHeader const* opaqueData, float const* center, float const* extent, float const* matrix) -> uint32_t;
 	CAPI auto (*CTMB_DebugExportToGLTF)(TacticalMapBuilderHandle ctmbHandle, char const* fileName) -> void;
 	CAPI auto (*CTMB_Build)(TacticalMapBuilderHandle ctmbHandle)->TacticalMapHandle;
 	CAPI auto (*CTMB_Delete)(TacticalMapBuilderHandle ctmbHandle) -> void;
+	// after the first CTMB_Build, builds only regenerate tiles near removed or moved solids
+	CAPI auto (*CTMB_RemoveSolid)(TacticalMapBuilderHandle ctmbHandle, uint32_t solidId) -> void;
+	CAPI auto (*CTMB_UpdateSolidTransform)(TacticalMapBuilderHandle ctmbHandle, uint32_t solidId, float const* matrix) -> void;
+
+	// batched lookups, points is 3 floats per query and out has count entries, both return the number of hits.
+	// volume misses have a NaN levelHeight, level data is the opaque level data size apart and zeroed on a miss
+	CAPI auto (*CTM_LookupVolumeAtWorldBatch)(TacticalMapHandle ctmHandle, float const* points, uint32_t count, float const range, uint32_t levelMask, TacticalMapVolume* out) -> uint32_t;
+	CAPI auto (*CTM_LookupLevelDataAtWorldBatch)(TacticalMapHandle ctmHandle, float const* points, uint32_t count, float const range, uint32_t levelMask, uint8_t* out) -> uint32_t;
+
+	// like CTM_LoadFromBlob but without the copy, the blob (which must be from AllocBlob) is taken
+	// by the map and left empty. The map is fixed up in the blobs memory
+	CAPI auto (*CTM_LoadFromBlobInPlace)(Core::Blob* blob)->TacticalMapHandle;
+
+	// centers and extents are 3 floats per box. Overlapping boxes are one blast, the damaged map replaces
+	// the handles map in one go so lookups on other threads see it all or none of it
+	CAPI auto (*CTM_DamageStructures)(TacticalMapHandle ctmHandle, float const* centers, float const* extents, uint32_t count) -> void;
+
+	// pathfinding API, the pathfinder uses the maps current version and CTMP_UpdateMap switches it to the
+	// latest after damage. returns the number of clusters whose portals were rebuilt
+	CAPI auto (*CTMP_CreatePathfinder)(TacticalMapHandle ctmHandle, TacticalMapPathSettings const* settings) -> TacticalMapPathfinderHandle;
+	CAPI auto (*CTMP_UpdateMap)(TacticalMapPathfinderHandle ctmpHandle, TacticalMapHandle ctmHandle) -> uint32_t;
+	// queries is 6 floats (start then goal) per query, run across the task threads. each path gets maxPoints
+	// 3 float points in points, pointCounts is 0 for no path and paths longer than maxPoints are cut short.
+	// returns the number of paths found
+	CAPI auto (*CTMP_FindPaths)(TacticalMapPathfinderHandle ctmpHandle, float const* queries, uint32_t count, uint32_t maxPoints, float* points, uint32_t* pointCounts, float* costs) -> uint32_t;
+	CAPI auto (*CTMP_Delete)(TacticalMapPathfinderHandle ctmpHandle) -> void;
+
+	// line of sight and cover over the maps levels (see TacticalMap::traceLineOfSight). queries are 6 floats,
+	// eye then target, and for cover the threats eye then the agents position. batches return the number
+	// with line of sight and the number fully in cover
+	CAPI auto (*CTM_TraceLineOfSight)(TacticalMapHandle ctmHandle, float const* from, float const* to, uint32_t levelMask) -> bool;
+	CAPI auto (*CTM_TraceLineOfSightBatch)(TacticalMapHandle ctmHandle, float const* queries, uint32_t count, uint32_t levelMask, uint8_t* out) -> uint32_t;
+	CAPI auto (*CTM_QueryCoverBatch)(TacticalMapHandle ctmHandle, float const* queries, uint32_t count, float agentHeight, uint32_t levelMask, float* out) -> uint32_t;
+
+	// area queries over the maps summaries (see TacticalMap::summariseArea), min and max are 3 floats and
+	// only their x and z are used by CTM_SummariseArea
+	CAPI auto (*CTM_SummariseArea)(TacticalMapHandle ctmHandle, float const* min, float const* max, TacticalMapAreaSummary* out) -> void;
+	CAPI auto (*CTM_AnyLevelInArea)(TacticalMapHandle ctmHandle, float const* min, float const* max, uint32_t levelMask) -> bool;
+
+	// like CTMB_AddMeshAt but from a CGeometryEngine mesh view, its arrays can be unpinned once this returns
+	CAPI auto (*CTMB_AddMeshViewAt)(TacticalMapBuilderHandle handle, uint64_t viewHandle, TacticalMapLevelDataHeader const* opaqueData, float const* matrix) -> uint32_t;
 };
 
 // cpp helpers
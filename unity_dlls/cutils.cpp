@@ -7,7 +7,11 @@
 #include "core/blob.h"
 #include "crc32c/crc32c.h"
 #include "binny/bundle.h"
+#include "resourcemanager/derivedcache.h"
 #include <fstream>
+#include <mutex>
+#include <cstring>
+#include <vector>
 #include "cutils.h"
 
 
@@ -61,6 +65,67 @@ CAPI void FreeBlob(Core::Blob* in_)
 	Core::Blob::Free(in_);
 }
 
+namespace {
+std::mutex derivedDataCacheMutex;
+std::shared_ptr<ResourceManager::DerivedDataCache> derivedDataCache;
+
+ResourceManager::DerivedDataCache::Key ToKey(DerivedDataKey const* key_)
+{
+	return { key_->opId, key_->opVersion, key_->inputHash, key_->parameterHash };
+}
+}
+
+CAPI bool OpenDerivedDataCache(char const* directory, uint64_t maxBytes)
+{
+	if(directory == nullptr) return false;
+	auto cache = std::make_shared<ResourceManager::DerivedDataCache>(directory, maxBytes);
+
+	std::lock_guard<std::mutex> lock(derivedDataCacheMutex);
+	derivedDataCache = cache;
+	return true;
+}
+
+CAPI void CloseDerivedDataCache()
+{
+	// anyone mid fetch keeps their reference till done
+	std::lock_guard<std::mutex> lock(derivedDataCacheMutex);
+	derivedDataCache.reset();
+}
+
+CAPI uint64_t DerivedDataKeyId(DerivedDataKey const* key)
+{
+	if(key == nullptr) return 0;
+	return ResourceManager::DerivedDataCache::getKeyId(ToKey(key));
+}
+
+CAPI bool FetchDerivedData(DerivedDataKey const* key, Core::Blob* out_)
+{
+	if(key == nullptr || out_ == nullptr) return false;
+	auto cache = GetDerivedDataCache();
+	if(!cache) return false;
+
+	std::vector<uint8_t> bundle;
+	if(!cache->get(ToKey(key), bundle)) return false;
+	if(!Core::Blob::Create(bundle.size(), out_)) return false;
+	std::memcpy(out_->nativeData, bundle.data(), bundle.size());
+	return true;
+}
+
+CAPI bool StoreDerivedData(DerivedDataKey const* key, uint8_t const* bundle, uint64_t size)
+{
+	if(key == nullptr || bundle == nullptr) return false;
+	auto cache = GetDerivedDataCache();
+	if(!cache) return false;
+
+	return cache->put(ToKey(key), std::vector<uint8_t>(bundle, bundle + size));
+}
+
+EXPORT_CPP auto GetDerivedDataCache() -> std::shared_ptr<ResourceManager::DerivedDataCache>
+{
+	std::lock_guard<std::mutex> lock(derivedDataCacheMutex);
+	return derivedDataCache;
+}
+
 static CUtilsInterface Interface;
 
 #if !defined(USING_STATIC_LIBS)
@@ -77,6 +142,11 @@ CUtilsInterface* CUtils()
 		Interface.FetchBundleUserData = &FetchBundleUserData;
 		Interface.AllocBlob = &AllocBlob;
 		Interface.FreeBlob = &FreeBlob;
+		Interface.OpenDerivedDataCache = &OpenDerivedDataCache;
+		Interface.CloseDerivedDataCache = &CloseDerivedDataCache;
+		Interface.DerivedDataKeyId = &DerivedDataKeyId;
+		Interface.FetchDerivedData = &FetchDerivedData;
+		Interface.StoreDerivedData = &StoreDerivedData;
 	}
 	return &Interface;
 }
\ No newline at end of file
@@ -6,7 +6,9 @@
 #define NATIVESNAPSHOT_CUTILS_H
 
 #include "core/core.h"
+#include <memory>
 namespace Core { struct Blob; }
+namespace ResourceManager { class DerivedDataCache; }
 
 // this structure is directly mappable in unity or native code
 // which for many mesh cases (collision etc.) is good enough
@@ -18,6 +20,15 @@ struct SimpleMesh
 	uint32_t *triangleIndices; // 3 * uint32_t per triangle
 };
 
+// same layout as ResourceManager::DerivedDataCache::Key
+struct DerivedDataKey
+{
+	uint32_t opId;
+	uint32_t opVersion;
+	uint64_t inputHash;
+	uint64_t parameterHash;
+};
+
 struct CUtilsInterface
 {
 	// crc32c functions
@@ -35,6 +46,17 @@ struct CUtilsInterface
 	// blob functions
 	CAPI bool(*AllocBlob)(uint64_t size_, Core::Blob *out_);
 	CAPI void(*FreeBlob)(Core::Blob *in_);
+
+	// derived data cache functions
+	// opens the process wide on disk cache of expensive results (convex hulls etc.)
+	// maxBytes of 0 never trims. anything cachable uses it once its open
+	CAPI bool(*OpenDerivedDataCache)(char const *directory, uint64_t maxBytes);
+	CAPI void(*CloseDerivedDataCache)();
+	// the bundle user data a stored bundle must have
+	CAPI uint64_t(*DerivedDataKeyId)(DerivedDataKey const *key);
+	// copies the cached bundle into a new blob (FreeBlob it), false if not cached
+	CAPI bool(*FetchDerivedData)(DerivedDataKey const *key, Core::Blob *out_);
+	CAPI bool(*StoreDerivedData)(DerivedDataKey const *key, uint8_t const *bundle, uint64_t size);
 };
 #if !defined(USING_STATIC_LIBS)
 EXPORT void* GetInterface();
@@ -42,4 +64,7 @@ EXPORT void* GetInterface();
 CUtilsInterface* CUtils();
 #endif
 
+// null if the cache isn't open
+EXPORT_CPP auto GetDerivedDataCache() -> std::shared_ptr<ResourceManager::DerivedDataCache>;
+
 #endif //NATIVESNAPSHOT_CUTILS_H
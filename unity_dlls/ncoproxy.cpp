@@ -1,5 +1,6 @@
 #include "core/core.h"
 #include "core/quick_hash.h"
+#include "ncoproxy.h"
 
 #if PLATFORM_OS == OSX
 #include "cppfs/cppfs.h"
@@ -12,75 +13,190 @@
 #endif
 #include <functional>
 #include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 #if PLATFORM != WINDOWS
 #include <dlfcn.h>
 #endif
 
 using DLLInterfaceFunc = void*(*)();
-
-// we don't want any lasting allocations, so use static blocks of memory instead of allocs
-constexpr int MaxModules = 16;
+using DLLUnloadingFunc = void(*)();
 
 namespace {
-	std::array<uint32_t, MaxModules> s_moduleNameHashs;
+	std::array<std::string, MaxModules> s_modulePaths;
 #if PLATFORM == WINDOWS
 	std::array<HMODULE, MaxModules> s_modules;
 #else
 	std::array<void*, MaxModules> s_modules;
 #endif
 	uint32_t s_maxModuleIndex = 0;
-} // anon namespace
+	// false after a reload that couldn't load every module, the paths are kept so the next one can retry
+	bool s_modulesLoaded = false;
 
-// we delibrately don't couple the interfaces so that this doesn't get rebuilt except when a
-// new library is added
-auto getInterface(char const * name_) -> void*
-{
-	DLLInterfaceFunc func = nullptr;
-	auto hash = Core::QuickHash(name_, strlen(name_));
-	for (size_t i = 0; i < s_maxModuleIndex; i++)
+	InterfaceTable s_table;
+	std::atomic<uint32_t> s_inFlight{ 0 };
+	std::atomic<bool> s_reloading{ false };
+	// Init, Finish and Reload one at a time
+	std::mutex s_reloadMutex;
+	// BeginCalls without an EndCalls on this thread, a reload from inside a call would wait on itself
+	thread_local uint32_t t_callDepth = 0;
+
+	void* FindSymbol(uint32_t index_, char const* name_)
+	{
+#if PLATFORM == WINDOWS
+		return (void*)GetProcAddress(s_modules[index_], name_);
+#else
+		return dlsym(s_modules[index_], name_);
+#endif
+	}
+
+	// the only place GetInterface is looked up, at load and reload
+	void PublishInterfaces()
+	{
+		uint32_t const count = s_modulesLoaded ? s_maxModuleIndex : 0;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			auto func = (DLLInterfaceFunc)FindSymbol(i, "GetInterface");
+			s_table.interfaces[i] = (func != nullptr) ? func() : nullptr;
+		}
+		s_table.moduleCount = count;
+	}
+
+	// stops new calls starting and waits for the ones in progress to leave, then gives each
+	// module a chance to finish any work of its own (async tasks etc.) before its unloaded
+	void Drain()
+	{
+		s_reloading.store(true);
+		s_table.version.fetch_add(1);
+		while (s_inFlight.load() != 0)
+		{
+			std::this_thread::yield();
+		}
+		for (uint32_t i = 0; s_modulesLoaded && i < s_maxModuleIndex; i++)
+		{
+			auto func = (DLLUnloadingFunc)FindSymbol(i, "ModuleUnloading");
+			if (func != nullptr) func();
+		}
+	}
+
+	void Undrain()
 	{
-		if (hash == s_moduleNameHashs[i])
+		s_table.version.fetch_add(1);
+		s_reloading.store(false);
+	}
+
+	void UnloadModules()
+	{
+		// reverse load order, a failed reload leaves gaps
+		for (uint32_t i = s_maxModuleIndex; i > 0; i--)
 		{
+			if (s_modules[i - 1] != 0)
+			{
 #if PLATFORM == WINDOWS
-			func = (DLLInterfaceFunc)GetProcAddress(s_modules[i], "GetInterface");
+				FreeLibrary(s_modules[i - 1]);
 #else
-			func = (DLLInterfaceFunc)dlsym(s_modules[i], "GetInterface");
+				dlclose(s_modules[i - 1]);
 #endif
- 			break;
+				s_modules[i - 1] = 0;
+			}
+			s_table.interfaces[i - 1] = nullptr;
 		}
+		s_modulesLoaded = false;
 	}
+} // anon namespace
 
-	if(func != nullptr)
+// we delibrately don't couple the interfaces so that this doesn't get rebuilt except when a
+// new library is added. the interfaces are fetched at load so this is just a search now, managed
+// code should still prefer GetModuleIndex + GetInterfaceTable and only do this once
+auto getInterface(char const * name_) -> void*
+{
+	if (s_reloading.load()) return nullptr;
+	auto hash = Core::QuickHash(name_, strlen(name_));
+	for (size_t i = 0; i < s_table.moduleCount; i++)
 	{
-		return func();
+		if (hash == s_table.nameHashes[i])
+		{
+			return s_table.interfaces[i];
+		}
 	}
 
 	return nullptr;
 }
 
-using InterfaceFunc = void*(*)(char const*);
+// stable for the life of the proxy, including across reloads
+EXPORT auto GetInterfaceTable() -> InterfaceTable const*
+{
+	return &s_table;
+}
+
+// -1 if there is no module of that name (the filename without .nco)
+EXPORT auto GetModuleIndex(char const * name_) -> int32_t
+{
+	if (s_reloading.load()) return -1;
+	auto hash = Core::QuickHash(name_, strlen(name_));
+	for (uint32_t i = 0; i < s_table.moduleCount; i++)
+	{
+		if (hash == s_table.nameHashes[i])
+		{
+			return int32_t(i);
+		}
+	}
+	return -1;
+}
 
-EXPORT auto Finish() -> void
+// brackets calls into the modules (a frames worth is fine), a reload waits till everyone has
+// left and anyone trying to enter waits for the reload. returns the table version to check
+// against any function pointers cached from the last time
+EXPORT auto BeginCalls() -> uint32_t
 {
-	for (size_t i = 0; i < s_maxModuleIndex; i++)
+	uint32_t version;
+	for (;;)
 	{
-#if PLATFORM == WINDOWS
-		FreeLibrary(s_modules[i]);
-#else
-		dlclose(s_modules[i]);
-#endif
+		while (s_reloading.load())
+		{
+			std::this_thread::yield();
+		}
+		s_inFlight.fetch_add(1);
+		// read before the check, a reload that starts after it bumps the version after this too
+		version = s_table.version.load();
+		if (!s_reloading.load()) break;
+		// lost the race with a reload, back out and wait for it
+		s_inFlight.fetch_sub(1);
 	}
-	s_maxModuleIndex = 0;
+	t_callDepth++;
+	return version;
+}
+
+EXPORT auto EndCalls() -> void
+{
+	assert(s_inFlight.load() != 0);
+	assert(t_callDepth != 0);
+	t_callDepth--;
+	s_inFlight.fetch_sub(1);
+}
 
+EXPORT auto Finish() -> void
+{
+	assert(t_callDepth == 0);
+	std::lock_guard<std::mutex> lock(s_reloadMutex);
+	Drain();
+	UnloadModules();
+	s_maxModuleIndex = 0;
+	s_table.moduleCount = 0;
+	Undrain();
 }
 
 auto LoadModule(std::string const& filename_, std::string const& path_) -> void
 {
+	if (s_maxModuleIndex >= MaxModules) return;
+
 	// 'allocate' and copy filename
 	std::string_view v = filename_;
 	v.remove_suffix(4);
-	s_moduleNameHashs[s_maxModuleIndex] = Core::QuickHash(v);
+	s_table.nameHashes[s_maxModuleIndex] = Core::QuickHash(v);
+	s_modulePaths[s_maxModuleIndex] = path_;
 #if PLATFORM == WINDOWS
 	s_modules[s_maxModuleIndex] = LoadLibrary(path_.c_str());
 #else
@@ -96,8 +212,13 @@ EXPORT auto Init() -> InterfaceFunc
 	// TODO mac and linux
 	using namespace std::string_literals;
 
+	assert(t_callDepth == 0);
+	std::lock_guard<std::mutex> lock(s_reloadMutex);
+
 	// clean up and previous runs where Finish was missed (stopping Unity for example)
-	Finish();
+	Drain();
+	UnloadModules();
+	s_maxModuleIndex = 0;
 
 #if PLATFORM_OS == OSX
 	using namespace cppfs;
@@ -126,7 +247,46 @@ EXPORT auto Init() -> InterfaceFunc
 		}
 	}
 #endif
+	s_modulesLoaded = true;
+	PublishInterfaces();
+	Undrain();
 
 	return &getInterface;
 }
 
+// unloads and reloads every module from where Init found them (the ones that link to others
+// have to go too anyway) then publishes the new interfaces in one go. modules are the same
+// slots so indices stay valid, but anything cached from the old interfaces must be refetched.
+// false if this thread is between BeginCalls and EndCalls (it would wait on itself) or any module
+// failed to load, in which case none are published until a later reload gets them all
+EXPORT auto Reload() -> bool
+{
+	if (t_callDepth != 0) return false;
+	std::lock_guard<std::mutex> lock(s_reloadMutex);
+	Drain();
+	UnloadModules();
+
+	uint32_t const count = s_maxModuleIndex;
+	bool okay = true;
+	for (uint32_t i = 0; i < count; i++)
+	{
+#if PLATFORM == WINDOWS
+		s_modules[i] = LoadLibrary(s_modulePaths[i].c_str());
+#else
+		s_modules[i] = dlopen(s_modulePaths[i].c_str(), RTLD_LAZY | RTLD_LOCAL);
+#endif
+		okay &= (s_modules[i] != 0);
+	}
+	if (okay)
+	{
+		s_modulesLoaded = true;
+	}
+	else
+	{
+		// a half set of modules is no use to anyone
+		UnloadModules();
+	}
+	PublishInterfaces();
+	Undrain();
+	return okay;
+}
@@ -0,0 +1,32 @@
+#ifndef NATIVESNAPSHOT_NCOPROXY_H
+#define NATIVESNAPSHOT_NCOPROXY_H
+
+#include "core/core.h"
+#include <atomic>
+
+// we don't want any lasting allocations, so use static blocks of memory instead of allocs
+constexpr int MaxModules = 16;
+
+// managed code binds to this once and indexes it, no name lookups per call.
+// version is odd during a reload and changes every reload, so anyone holding
+// function pointers out of an interface knows when to refetch them
+struct InterfaceTable
+{
+	std::atomic<uint32_t> version;
+	uint32_t moduleCount;
+	uint32_t nameHashes[MaxModules];
+	void* interfaces[MaxModules];
+};
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "InterfaceTable must be mappable from managed code");
+
+using InterfaceFunc = void*(*)(char const*);
+
+EXPORT auto Init() -> InterfaceFunc;
+EXPORT auto Finish() -> void;
+EXPORT auto Reload() -> bool;
+EXPORT auto GetInterfaceTable() -> InterfaceTable const*;
+EXPORT auto GetModuleIndex(char const * name_) -> int32_t;
+EXPORT auto BeginCalls() -> uint32_t;
+EXPORT auto EndCalls() -> void;
+
+#endif //NATIVESNAPSHOT_NCOPROXY_H